@@ -0,0 +1,20 @@
+/**
+ * Software auto-exposure assist for the OV2640.
+ *
+ * The built-in AEC takes seconds to follow a cloud passing over the apiary.
+ * When enabled, a QoS stage reads the luma DC terms of each analysed JPEG
+ * (entropy scan only, see jpeg_scan.h), runs the control law in
+ * ae_control.h and writes exposure/gain straight to the sensor, with the
+ * sensor's own AEC/AGC switched off. Disabling hands control back.
+ */
+#pragma once
+
+#include <stddef.h>
+#include "ae_control.h"
+
+void aeAssistInit();                          // registers the QoS stage
+void aeAssistEnable(bool on);
+bool aeAssistEnabled();
+void aeAssistSetConfig(const ae_config_t& cfg);
+ae_config_t aeAssistConfig();
+size_t aeAssistStatusJson(char* buf, size_t len);
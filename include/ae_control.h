@@ -0,0 +1,57 @@
+/**
+ * Software auto-exposure control law (sensor independent).
+ *
+ * Input is a histogram of block mean luma (e.g. JPEG DC terms, one entry per
+ * 8x8 block); output is a new exposure (sensor lines) and analog gain.
+ * Exposure is the product aec * (gain + 1); the controller moves it by a
+ * configurable fraction of the log-domain error per step, fills exposure
+ * first and gain second, pulls down when highlights clip, and waits a few
+ * frames after each change for the sensor to apply it.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define AE_HIST_BINS 64                 // 4 luma levels per bin
+
+struct ae_config_t {
+  uint8_t  target;          // mean luma target, 0..255
+  uint8_t  speed_pct;       // % of the exposure error corrected per step (1..100)
+  uint8_t  settle_frames;   // frames to skip after a change (sensor latency)
+  uint8_t  clip_pct;        // max % of blocks at >= 248 before pulling down
+  uint16_t aec_max;         // exposure ceiling (sensor lines)
+  uint8_t  gain_max;        // gain ceiling (sensor gain index, ~x(gain+1))
+};
+
+struct ae_stats_t {
+  uint32_t hist[AE_HIST_BINS];
+  uint32_t n;
+  uint32_t sum;
+};
+
+struct ae_state_t {
+  uint16_t aec;
+  uint8_t  gain;
+  uint8_t  wait;            // frames left before the next step
+  uint8_t  mean;            // last measured mean luma
+  uint8_t  clip_pct;        // last measured % of clipped blocks
+};
+
+ae_config_t aeDefaultConfig();
+
+static inline void aeStatsReset(ae_stats_t* s) {
+  for (int i = 0; i < AE_HIST_BINS; i++) s->hist[i] = 0;
+  s->n = s->sum = 0;
+}
+
+static inline void aeStatsAdd(ae_stats_t* s, int luma) {
+  if (luma < 0) luma = 0;
+  if (luma > 255) luma = 255;
+  s->hist[luma >> 2]++;
+  s->sum += luma;
+  s->n++;
+}
+
+// One control step per analysed frame. Returns true when aec/gain changed
+// and should be written to the sensor.
+bool aeStep(const ae_config_t& cfg, const ae_stats_t& stats, ae_state_t* st);
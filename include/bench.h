@@ -0,0 +1,22 @@
+/**
+ * On-device benchmarks, run from the serial console as `bench <name> [k=v ...]`.
+ *
+ *   fb     sizes=qvga,vga n=20   fb_get rate per framesize (needs an idle camera)
+ *   enc    fmt=rgb565 sizes=vga  encode rate of non-JPEG frames: frame2jpg vs. one
+ *                                and two cores of the strip encoder (idle camera)
+ *   jpeg   n=100                 JPEG size distribution of the stream profile
+ *   psram  kb=256                PSRAM read/write/copy bandwidth
+ *   wifi   kb=1024               UDP send rate to the strongest connected client
+ *
+ * Each benchmark prints one or more `BENCH <name> key=value ...` lines. Extra
+ * benchmarks that need main.cpp state (e.g. the OLED) register themselves.
+ */
+#pragma once
+
+// Result NULL on success, else a short reason (no spaces).
+typedef const char* (*bench_fn)(int argc, char** argv);
+
+// Register the built-in benchmarks and the "bench" console command.
+void benchInit();
+
+bool benchRegister(const char* name, const char* args, bench_fn fn);
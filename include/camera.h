@@ -0,0 +1,49 @@
+/**
+ * Camera ownership: init, profile switching and frame get/return.
+ *
+ * All frame grabs go through camFbGet()/camFbReturn() so a profile switch
+ * (JPEG stream <-> raw YUV/grayscale/RGB capture) can wait until no frame
+ * buffer is held before re-initializing the driver.
+ */
+#pragma once
+
+#include "esp_camera.h"
+
+// ======= STREAM DEFAULTS (max-ish quality) =======
+extern framesize_t STREAM_SIZE;   // 1600x1200 (needs PSRAM)
+extern int JPEG_QUALITY;          // lower = better image, bigger size
+extern int FB_COUNT;              // 2 with PSRAM, else 1
+
+struct cam_profile_t {
+  pixformat_t format;
+  framesize_t size;
+  int         quality;
+  int         fb_count;
+};
+
+// First init with the stream profile (JPEG, STREAM_SIZE or SVGA without PSRAM).
+esp_err_t cameraInit();
+
+// The profile /stream expects, and the one currently loaded.
+cam_profile_t cameraStreamProfile();
+cam_profile_t cameraProfile();
+
+// Re-initialize the driver with another profile. Blocks new grabs and waits
+// (up to timeout_ms) for held frames to be returned. On failure the previous
+// profile is restored.
+esp_err_t cameraSetProfile(const cam_profile_t& p, uint32_t timeout_ms = 3000);
+esp_err_t cameraRestoreStreamProfile();
+
+// One non-stream profile user at a time (/raw, /capture, fb benchmark).
+// Returns false if someone else holds the camera; *holder names them.
+bool cameraClaim(const char* owner, const char** holder = NULL);
+void cameraRelease();
+bool cameraClaimed();
+
+// Framesize by lowercase name ("96x96", "qvga", ..., "uxga"), FRAMESIZE_INVALID
+// if unknown; and the reverse.
+framesize_t cameraFramesize(const char* name);
+const char* cameraFramesizeName(framesize_t size);
+
+camera_fb_t* camFbGet();
+void         camFbReturn(camera_fb_t* fb);
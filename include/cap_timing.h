@@ -0,0 +1,58 @@
+/**
+ * Capture-side timing: where does irregular frame delivery come from?
+ *
+ * Three clocks are recorded separately:
+ *   sensor    every VSYNC edge, timestamped by an MCPWM capture unit listening
+ *             on the VSYNC pin (independent of the camera driver's own ISR)
+ *   DMA       per captured frame: the VSYNC edge that started it (matched via
+ *             fb->timestamp) and the next edge, where the driver hands the
+ *             finished frame to its queue
+ *   delivery  when camFbGet() handed the frame to the application
+ *
+ * Edges seen while the application held all fb_count buffers are overruns;
+ * every sensor frame that never became a delivered frame counts as skipped.
+ * Both rings are lock-free (ISR / any task write, readers copy and verify),
+ * so recording costs a few stores per frame.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_camera.h"
+
+#define CAP_TIMING_VSYNC_RING  128   // powers of two
+#define CAP_TIMING_FRAME_RING  64
+
+struct cap_timing_stats_t {
+  uint32_t window_ms;          // span of the edges below
+  uint32_t edges;              // VSYNC edges in the window
+  float    sensor_fps;
+  uint32_t period_us;          // mean VSYNC period
+  uint32_t jitter_us;          // standard deviation of the period
+  uint32_t period_min_us, period_max_us;
+  uint32_t frames;             // frames handed out by camFbGet() in the window
+  float    capture_fps;        // frames / window
+  uint32_t skipped;            // sensor frames between captured ones that were never delivered
+  float    skip_pct;
+  uint32_t overruns;           // edges while all frame buffers were held
+  float    overrun_pct;
+  uint32_t queue_avg_us;       // DMA done -> camFbGet()
+  uint32_t queue_max_us;
+  uint32_t total_edges;        // since boot
+  uint32_t total_overruns;
+};
+
+// Start VSYNC capture on the camera's VSYNC pin (after the camera driver init).
+void capTimingInit(int vsync_gpio);
+
+// Camera module hooks: frame-buffer accounting, delivered frames, and a
+// profile switch (statistics start over).
+void capTimingHeld(int held, int fb_count);
+void capTimingFrame(const camera_fb_t* fb);
+void capTimingReset();
+
+// Statistics over the recorded window. Returns false before the first edges.
+bool capTimingStats(cap_timing_stats_t* out);
+
+// Stats plus the last `frames` (0..32) per-frame records as a JSON object.
+size_t capTimingJson(char* buf, size_t len, int frames);
@@ -0,0 +1,27 @@
+/**
+ * DNS responder and junk-request fast path for the soft-AP.
+ *
+ * Replaces the wildcard DNSServer: only our names and the OS captive-check
+ * hosts resolve (dns_answer.h), everything else is NXDOMAIN with a one-hour
+ * negative TTL. HTTP requests that still arrive for unknown paths are
+ * settled before they cost more than a header parse: captive-check probes
+ * get a 302 to the UI, requests for foreign hosts a bare 404, and both
+ * connections are closed at once instead of being kept alive next to
+ * /stream. Everything that was turned away is counted (/dns).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+// Bind UDP port 53; ip is the AP address answered for our names.
+bool captiveDnsStart(const uint8_t ip[4]);
+
+// Answer pending queries; call from loop().
+void captiveDnsLoop();
+
+// 404/405 fast path (after httpd_start).
+void captiveHttpInstall(httpd_handle_t server);
+
+size_t captiveDnsJson(char* buf, size_t len);
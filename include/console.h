@@ -0,0 +1,36 @@
+/**
+ * Serial command console.
+ *
+ * loop() feeds received characters; complete lines are queued and run on a
+ * low-priority task, so long commands (benchmarks) never block loop() or the
+ * stream. Output is line based and machine-parseable:
+ *
+ *   BENCH <name> key=value ...      one result line (benchmarks)
+ *   STATUS key=value ...
+ *   OK <command>                    command finished
+ *   ERR <command> <reason>          command failed
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#define CONSOLE_MAX_CMDS  12
+#define CONSOLE_MAX_ARGS  8
+#define CONSOLE_LINE_MAX  96
+
+// Command handler: argv[0] is the command. Return NULL on success or a short
+// reason (no spaces) on failure.
+typedef const char* (*console_cmd_fn)(int argc, char** argv);
+
+// Start the console task (registers "help" and "status").
+void consoleInit();
+
+// Register a command (call from setup()).
+bool consoleRegister(const char* name, const char* help, console_cmd_fn fn);
+
+// Feed one received character (from loop(); never blocks).
+void consoleFeed(char c);
+
+// Value of a key=value argument, or def.
+const char* consoleArg(int argc, char** argv, const char* key, const char* def);
+int         consoleArgInt(int argc, char** argv, const char* key, int def);
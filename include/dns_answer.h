@@ -0,0 +1,50 @@
+/**
+ * DNS answers for the soft-AP: our own names only.
+ *
+ * A wildcard resolver sends every phone's background sync, push and
+ * telemetry traffic to port 80, where it competes with /stream. Instead,
+ * only the unit's own names and the OS captive-portal check hosts resolve
+ * (to the AP address); every other name gets NXDOMAIN with an SOA in the
+ * authority section, whose minimum field makes clients cache the negative
+ * answer (RFC 2308) instead of asking again every few seconds. Record types
+ * other than A for our names get an empty NOERROR answer (NODATA), again
+ * with the SOA, so AAAA/HTTPS lookups settle on the A record.
+ *
+ * The captive-check hosts are answered so the phone's probe reaches us and
+ * gets redirected to the UI (captive_dns.h): the OS then knows this network
+ * has no internet and keeps its own traffic on mobile data.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DNS_ANSWER_TTL     300       // s, A records of allowed names
+#define DNS_NEGATIVE_TTL   3600      // s, SOA minimum: how long NXDOMAIN is cached
+#define DNS_PACKET_MAX     512       // plain UDP DNS
+
+enum dns_name_class_t {
+  DNS_NAME_OTHER,                    // not ours: NXDOMAIN
+  DNS_NAME_OWN,                      // nozzlecam, nozzcam.local, ...
+  DNS_NAME_CAPTIVE,                  // connectivity check of some OS
+};
+
+enum dns_verdict_t {
+  DNS_V_ANSWER,                      // A record for an allowed name
+  DNS_V_NODATA,                      // allowed name, other record type
+  DNS_V_NXDOMAIN,
+  DNS_V_REFUSED,                     // not a standard query (opcode), NOTIMP sent
+  DNS_V_DROP,                        // malformed or a response: no reply
+};
+
+// Classify a host name (dotted, case-insensitive, optional trailing dot;
+// an HTTP Host header with ":port" works too).
+dns_name_class_t dnsClassifyName(const char* name);
+
+// Build the reply to one query packet. ip is the A record (network order
+// bytes a.b.c.d as ip[0..3]). Returns the reply length, 0 for DNS_V_DROP.
+// The query name is copied to qname (dotted, at most qname_len - 1 chars)
+// when qname is not NULL.
+size_t dnsAnswer(const uint8_t* q, size_t len, const uint8_t ip[4],
+                 uint8_t* out, size_t cap, dns_verdict_t* verdict,
+                 dns_name_class_t* cls, char* qname, size_t qname_len);
@@ -0,0 +1,28 @@
+/**
+ * Two-core JPEG encoding of non-JPEG frames.
+ *
+ * Stands in for frame2jpg() / fmt2jpg() for grayscale, YUV422, RGB565 and
+ * RGB888 sources. The frame is cut into two strips (jpeg_enc.h) that two
+ * encoder tasks, pinned to core 0 and core 1, encode at the same time; the
+ * pieces are joined behind one header into a single JPEG.
+ *
+ * Small frames, and calls while another two-core encode is in flight, are
+ * encoded on the calling task alone, so callers never wait for each other.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_camera.h"
+
+// Start the two encoder tasks. Without it every encode runs single-core.
+void encoderInit();
+
+// Like fmt2jpg(): *out is allocated here, free() it. strips: 0 = automatic,
+// 1 = calling task only, 2 = both cores when available (benchmarks).
+// Unlike fmt2jpg(), RGB888 is R, G, B in memory (fmt2jpg() reads B, G, R).
+bool encodeJpeg(const uint8_t* src, size_t len, int width, int height, pixformat_t format,
+                int quality, uint8_t** out, size_t* out_len, int strips = 0);
+
+// Like frame2jpg().
+bool encodeFrame(const camera_fb_t* fb, int quality, uint8_t** out, size_t* out_len);
@@ -0,0 +1,43 @@
+/**
+ * Shared latest-JPEG cache for snapshot pollers.
+ *
+ * Snapshot and long-poll clients (OctoPrint, Home Assistant, ...) read the
+ * latest frame from here instead of grabbing from the sensor. While an MJPEG
+ * stream runs it publishes its frames (only while pollers are around, the
+ * copy is not free); otherwise the first poller captures one frame and every
+ * concurrent poller gets that same frame.
+ *
+ * Frames live in a few refcounted slots, so slow readers never block the
+ * publisher (a frame is dropped when all slots are busy).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAME_CACHE_SLOTS 3
+
+struct frame_ref_t {
+  const uint8_t* buf;
+  size_t         len;
+  uint32_t       seq;       // increments per published frame
+  uint64_t       ts_us;     // capture timestamp
+  int            slot;
+};
+
+// Publish a JPEG (copied). Frames with the timestamp of the latest are skipped.
+void frameCachePublish(const uint8_t* jpg, size_t len, uint64_t ts_us);
+
+// Stream side, once per full-size frame sent: marks a publisher as active
+// and publishes the frame when pollers want one. Streams whose frames
+// aren't the camera picture (thumbnails, raw) don't call it.
+void frameCacheOffer(const uint8_t* jpg, size_t len, uint64_t ts_us);
+
+// Wait up to timeout_ms for a frame with seq > after that is at most
+// max_age_ms old; captures one itself when no publisher offered a frame lately.
+// On success the frame is held until frameCacheRelease().
+bool frameCacheAcquire(uint32_t after, uint32_t max_age_ms, uint32_t timeout_ms,
+                       frame_ref_t* out);
+void frameCacheRelease(const frame_ref_t& f);
+
+uint32_t frameCacheSeq();
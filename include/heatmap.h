@@ -0,0 +1,30 @@
+/**
+ * Long-term motion heatmap ("where does activity happen in the tube?").
+ *
+ * A low-priority QoS stage scans each analysed JPEG for per-block AC energy
+ * (jpeg_scan.h) and folds the changes into a PSRAM heatmap with exponential
+ * decay (heatmap_accum.h). Without a stream client a background task samples
+ * a couple of frames per second so the map keeps growing unattended.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+struct heatmap_config_t {
+  uint32_t half_life_s;      // decay half-life, 0 = never forget
+  uint16_t floor;            // per-cell energy change treated as noise
+};
+
+void heatmapModuleInit();
+void heatmapSetConfig(const heatmap_config_t& c);
+heatmap_config_t heatmapConfig();
+void heatmapReset();
+
+// Render the map as a JPEG, `zoom` times the cell grid (1 cell = 16x16 px).
+// `bg_jpg` (optional) is drawn dimmed underneath. *jpg is malloc'd.
+esp_err_t heatmapRenderJpeg(const uint8_t* bg_jpg, size_t bg_len, int zoom,
+                            uint8_t** jpg, size_t* len);
+
+size_t heatmapStatusJson(char* buf, size_t len);
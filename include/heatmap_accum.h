@@ -0,0 +1,55 @@
+/**
+ * Fixed-point block-activity heatmap from JPEG AC energy.
+ *
+ * The sum of |AC| over an 8x8 block measures its detail; when something moves
+ * through a block that sum changes. Per cell (2x2 luma blocks, 16x16 px) the
+ * frame-to-frame change of the AC energy, minus a noise floor, is added to a
+ * 32-bit heat value; heat decays exponentially with a configurable half-life,
+ * so the map shows where activity happened over the last hours.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HEATMAP_CELL_SHIFT 1           // cell = (1 << shift)^2 luma blocks
+
+struct heatmap_t {
+  uint16_t  cols, rows;
+  uint32_t* heat;                      // saturating, decays
+  uint16_t* prev;                      // last frame's energy per cell
+  uint16_t* cur;                       // filled by heatmapAddBlock()
+  uint32_t  frames;
+};
+
+// Memory for a cols x rows map (one zeroed allocation handed to heatmapInit).
+size_t heatmapBytes(int cols, int rows);
+void   heatmapInit(heatmap_t* h, int cols, int rows, void* mem);
+void   heatmapClear(heatmap_t* h);
+
+// Cell grid for a luma block grid (full cells only).
+static inline int heatmapCells(int blocks) { return blocks >> HEATMAP_CELL_SHIFT; }
+
+// Per luma block of the current frame (jpeg_scan callback order is fine).
+static inline void heatmapAddBlock(heatmap_t* h, int bx, int by, int ac_sum) {
+  int cx = bx >> HEATMAP_CELL_SHIFT, cy = by >> HEATMAP_CELL_SHIFT;
+  if (cx >= h->cols || cy >= h->rows) return;
+  uint16_t& c = h->cur[cy * h->cols + cx];
+  uint32_t v = (uint32_t)c + (uint32_t)ac_sum;
+  c = v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+}
+
+// Fold the current frame in: heat += max(0, |cur - prev| - floor). The first
+// frame only primes prev. Returns the frame's total activity.
+uint32_t heatmapUpdate(heatmap_t* h, uint16_t floor);
+
+// heat *= factor (Q16). heatmapDecayFactor() gives the factor for `elapsed_ms`
+// at a half-life of `half_life_s`.
+void     heatmapDecay(heatmap_t* h, uint32_t factor_q16);
+uint32_t heatmapDecayFactor(uint32_t elapsed_ms, uint32_t half_life_s);
+
+// RGB888 cols x rows image in R, G, B byte order (JPEG_ENC_RGB888), `zoom`
+// times enlarged (nearest). Heat is mapped black-red-yellow-white relative
+// to the hottest cell; `gray` (cols x rows, may be NULL) shows through where
+// the map is cold.
+void heatmapRender(const heatmap_t* h, const uint8_t* gray, int zoom, uint8_t* rgb);
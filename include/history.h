@@ -0,0 +1,29 @@
+/**
+ * On-device telemetry history.
+ *
+ * A 1 Hz sampler records stream fps, stream kB/s, AP clients, mean client
+ * RSSI, free internal heap and battery into a fixed-size ring of
+ * delta/varint-encoded blocks (history_codec.h). 256 KB in PSRAM holds
+ * about two days of typical use; without PSRAM a 16 KB ring in internal RAM
+ * keeps the last few hours. Times are seconds since boot.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Allocate the ring and start the sampler task.
+void historyInit();
+
+// Battery level for the next samples, 0..100; 255 = unknown (the default).
+void historySetBattery(uint8_t percent);
+
+uint32_t historyNow();
+
+// Output sink for historyQueryJson; return false to abort.
+typedef bool (*history_write_fn)(const char* buf, size_t len, void* ctx);
+
+// Stream the history in [from, to] (seconds since boot) as JSON, averaged
+// into step-second buckets. Returns false if the sink aborted.
+bool historyQueryJson(uint32_t from, uint32_t to, uint32_t step,
+                      history_write_fn fn, void* ctx);
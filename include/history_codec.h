@@ -0,0 +1,66 @@
+/**
+ * Delta/varint codec for the telemetry history.
+ *
+ * Samples are stored in self-contained blocks so the ring can drop the oldest
+ * block without touching the rest:
+ *
+ *   header   u32 t0 (first sample time, s), u16 count, u16 used bytes (LE)
+ *   first    all fields as zigzag varints
+ *   then     one tag byte per entry:
+ *              1nnnnnnn  previous sample repeated n more seconds (n = 1..127)
+ *              0gmmmmmm  m = mask of changed fields, g = time gap follows;
+ *                        [varint extra seconds] then one zigzag varint delta
+ *                        per changed field
+ *
+ * An idle second costs nothing once a run tag is open, a typical changing
+ * second 2..4 bytes.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum {
+  HIST_FPS_X10,      // delivered stream fps * 10
+  HIST_KBPS,         // stream kB/s
+  HIST_CLIENTS,      // stations on the AP
+  HIST_RSSI,         // mean station RSSI, dBm (0 = none)
+  HIST_HEAP_KB,      // free internal heap, KB
+  HIST_BATTERY,      // percent, 255 = unknown
+  HIST_FIELDS
+};
+
+#define HIST_BLOCK_HDR      8
+#define HIST_ENTRY_MAX      (1 + 5 + HIST_FIELDS * 5)   // worst-case bytes per sample
+
+struct hist_sample_t {
+  int32_t v[HIST_FIELDS];
+};
+
+struct hist_encoder_t {
+  uint8_t* buf;
+  size_t   cap;
+  size_t   used;
+  uint16_t count;
+  uint32_t t_last;
+  size_t   run_tag;          // offset of the open run tag, 0 = none
+  hist_sample_t last;
+};
+
+// Start a block at buf with its first sample. cap must hold the header plus
+// one full sample.
+void histBlockBegin(hist_encoder_t* e, uint8_t* buf, size_t cap, uint32_t t,
+                    const hist_sample_t& s);
+
+// Append a sample (t >= last t + 1). Returns false when the block is full;
+// the block is then complete as is.
+bool histBlockAppend(hist_encoder_t* e, uint32_t t, const hist_sample_t& s);
+
+// Block start time and sample count from the header.
+uint32_t histBlockT0(const uint8_t* buf);
+uint16_t histBlockCount(const uint8_t* buf);
+
+// Decode a block; fn is called once per second of history. Returns the
+// number of samples, or -1 if the block is malformed.
+typedef void (*hist_sample_fn)(uint32_t t, const hist_sample_t& s, void* ctx);
+int histBlockDecode(const uint8_t* buf, size_t cap, hist_sample_fn fn, void* ctx);
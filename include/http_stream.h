@@ -0,0 +1,55 @@
+/**
+ * Long-lived HTTP responses (MJPEG, SSE, raw) on their own tasks.
+ *
+ * esp_http_server runs every handler on one task, so a /stream loop used to
+ * block every other request. httpStreamDetach() writes the response head on
+ * the raw socket and hands the socket to a worker task; the handler returns
+ * at once. The httpd session stays registered (so the socket slot is
+ * accounted for) and a close hook keeps httpd from closing a socket a worker
+ * is still writing to.
+ */
+#pragma once
+
+#include <stddef.h>
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#define HTTP_STREAM_MAX 6
+
+// Worker body: runs until it returns; the socket is closed afterwards.
+// `arg` is whatever the handler passed in (the body owns it).
+typedef void (*http_stream_fn)(int fd, void* arg);
+
+// Hook into the server config (before httpd_start) and register the handle.
+void httpStreamInstall(httpd_config_t& cfg);
+void httpStreamSetServer(httpd_handle_t server);
+
+// Send "200 OK" with the given content type and start `fn` on a worker task.
+// With content_type NULL no head is sent: the worker decides the status and
+// writes it with httpStreamSendHead(). On error nothing has been sent and the
+// handler should answer normally.
+esp_err_t httpStreamDetach(httpd_req_t* req, const char* content_type,
+                           const char* name, http_stream_fn fn, void* arg,
+                           uint32_t stack = 8192, UBaseType_t prio = 5);
+
+// Response head ("200 OK", ...). content_length < 0 = until close; extra
+// headers, if any, are full "Name: value\r\n" lines.
+esp_err_t httpStreamSendHead(int fd, const char* status, const char* content_type,
+                             long content_length, const char* extra = NULL);
+
+// Blocking send of the whole buffer (5 s send timeout).
+esp_err_t httpStreamSend(int fd, const void* buf, size_t len);
+
+// True once the peer hung up (httpd saw the session close).
+bool httpStreamPeerClosed(int fd);
+
+// Number of detached responses currently running.
+int httpStreamActive();
+
+struct http_stream_info_t {
+  int         fd;
+  const char* name;               // as passed to httpStreamDetach
+};
+
+// The running detached responses (at most max). Returns the count.
+int httpStreamList(http_stream_info_t* out, int max);
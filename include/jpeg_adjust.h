@@ -0,0 +1,37 @@
+/**
+ * Brightness and contrast of a baseline JPEG without decoding it.
+ *
+ * Contrast scales the luma quantization table: every dequantized
+ * coefficient, DC included, grows by the same factor, so the image stretches
+ * around mid-grey (128). That is a header rewrite; the scan is copied as is.
+ *
+ * Brightness adds a constant to every luma DC. DC is coded as differences,
+ * so only the first DC of each restart interval (of the whole scan without
+ * DRI) changes: that one code is re-encoded and the rest of the interval's
+ * bits are copied shifted behind it. Finding the interval ends costs one
+ * entropy-only pass (jpeg_scan.h); no coefficient is touched otherwise.
+ *
+ * Both are exact up to the table's integer steps: the effective contrast
+ * per frequency is round(q * contrast) / q (1..255), and brightness moves
+ * in steps of q_dc / 8 levels. Components that share the luma table (rare)
+ * get the contrast too.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JPEG_ADJUST_ERR_SPACE  -4      // out too small
+
+#define JPEG_ADJUST_BRIGHTNESS_MAX  127        // levels, either way
+#define JPEG_ADJUST_CONTRAST_MIN    0.25f
+#define JPEG_ADJUST_CONTRAST_MAX    4.0f
+
+// y' = 128 + contrast * (y - 128) + brightness, on the luma plane. Returns
+// the new JPEG's length, or a JPEG_SCAN_ERR_* code / JPEG_ADJUST_ERR_SPACE.
+long jpegAdjust(const uint8_t* jpg, size_t len, int brightness, float contrast,
+                uint8_t* out, size_t cap);
+
+// Output buffer that fits any adjustment of a len-byte JPEG with at most one
+// restart interval per 64 bytes of scan (sensor frames have none).
+static inline size_t jpegAdjustBound(size_t len) { return len + len / 8 + 64; }
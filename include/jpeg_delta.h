@@ -0,0 +1,84 @@
+/**
+ * Conditional-replenishment patches between baseline JPEGs.
+ *
+ * A viewer holds a reference picture (the last keyframe, a plain JPEG) and
+ * the encoder keeps a small signature of what that viewer has for every
+ * MCU. Each new frame is compared MCU by MCU in the DCT domain; only MCUs
+ * whose coefficients moved beyond a threshold are sent, and the signatures
+ * of those are updated, so slow drift still gets sent once it adds up.
+ *
+ * The signature of a block is four dequantized numbers: DC, the first two
+ * AC terms (the block's horizontal and vertical gradient) and the AC
+ * energy sum |AC|. Dequantized, so a quality change from rate control
+ * doesn't count as motion. No IDCT: one random-access pass over the scan
+ * (jpeg_scan.h) finds the changed MCUs, a second decodes only those.
+ *
+ * A patch is a 16-byte header, the changed MCU indices, and the changed
+ * MCUs themselves as one small baseline JPEG ("strip"): their quantized
+ * coefficients copied unchanged, with the frame's own quantization tables
+ * and sampling, laid out in raster order cols MCUs wide. Any JPEG decoder
+ * (a browser's createImageBitmap included) decodes the strip; the client
+ * then copies MCU k of the strip to grid position index[k]. Little-endian:
+ *
+ *   0  "NZD1"
+ *   4  u16 mcus_x, u16 mcus_y   frame MCU grid
+ *   8  u8  mcu_w,  u8  mcu_h    pixels per MCU
+ *  10  u16 count                changed MCUs (0: nothing changed, no strip)
+ *  12  u16 cols                 strip width in MCUs (rows = ceil(count / cols))
+ *  14  u16 reserved
+ *  16  u16 index[count]         raster index into the frame grid, ascending
+ *      JPEG strip               SOI .. EOI, to the end of the patch
+ *
+ * Layouts as jpeg_rot.h: luma 1x1, 2x1, 1x2 or 2x2 with 1x1 chroma sharing
+ * one quantization table, or grayscale.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JPEG_DELTA_ERR_SPACE  -4       // out too small
+#define JPEG_DELTA_ERR_KEY    -5       // send a keyframe instead (see jpegDeltaPatch)
+
+#define JPEG_DELTA_HEADER     16
+#define JPEG_DELTA_MAX_BLOCKS 6        // 2x2 luma + Cb + Cr
+#define JPEG_DELTA_KEY_PCT    75       // a patch this big (% of the frame) isn't worth it
+
+struct jpeg_delta_t {
+  uint16_t mcus_cap;           // MCUs the memory was sized for
+  uint8_t  blocks_cap;         // blocks per MCU
+  uint8_t  threshold;          // levels (mean sample value); 0 = no slack
+  bool     keyed;              // reference holds a frame
+  uint16_t width, height;      // reference geometry
+  uint16_t mcus_x, mcus_y;
+  uint8_t  ncomp, h, v;        // luma sampling; chroma is 1x1
+  int16_t  (*sig)[4];          // mcus_cap * blocks_cap signatures
+  void*    pos;                // mcus_cap scan positions (jpeg_mcu_pos_t)
+};
+
+// Memory for frames of up to mcus MCUs of `blocks` blocks each (h * v + 2
+// for color, h * v for gray; JPEG_DELTA_MAX_BLOCKS covers every layout).
+size_t jpegDeltaBytes(int mcus, int blocks);
+void   jpegDeltaInit(jpeg_delta_t* d, int mcus, int blocks, int threshold, void* mem);
+
+// Take jpg as the viewer's new reference (it is sent as is). Returns
+// JPEG_SCAN_OK, or a JPEG_SCAN_ERR_* code (unsupported layout, or a frame
+// bigger than the memory): stream full frames then.
+int jpegDeltaKey(jpeg_delta_t* d, const uint8_t* jpg, size_t len);
+
+// Patch that brings the viewer from its reference to jpg. Returns the
+// patch length (JPEG_DELTA_HEADER when nothing changed), or
+//   JPEG_DELTA_ERR_KEY    no reference, the geometry changed, or the patch
+//                         would reach JPEG_DELTA_KEY_PCT of len;
+//   JPEG_DELTA_ERR_SPACE  out too small;
+//   a JPEG_SCAN_ERR_*     code for a broken frame.
+// After any error the reference is undefined until the next jpegDeltaKey.
+// *changed (may be NULL) gets the number of changed MCUs.
+long jpegDeltaPatch(jpeg_delta_t* d, const uint8_t* jpg, size_t len,
+                    uint8_t* out, size_t cap, int* changed);
+
+// Output buffer that fits any patch under JPEG_DELTA_KEY_PCT of a len-byte
+// frame of `mcus` MCUs.
+static inline size_t jpegDeltaBound(size_t len, int mcus) {
+  return len * JPEG_DELTA_KEY_PCT / 100 + 2 * (size_t)mcus + 1024;
+}
@@ -0,0 +1,92 @@
+/**
+ * Baseline JPEG encoder that works in horizontal strips.
+ *
+ * The image is cut into MCU rows (8 lines, or 16x8 MCUs for 4:2:2 color)
+ * and every row ends in a restart marker (DRI = one MCU row), so any run of
+ * rows can be entropy-coded on its own and the pieces simply concatenated:
+ *
+ *   jpegEncHeader()  +  jpegEncRows(0..k)  +  jpegEncRows(k..n)  +  EOI
+ *
+ * gives one valid JPEG no matter where the strips were split, which is what
+ * lets both cores encode half a frame each. The restart markers cost about
+ * two bytes per MCU row.
+ *
+ * Color input is converted with 16-bit fixed-point coefficients and
+ * subsampled 4:2:2 (H2V1, the sensor's own YUV layout); the DCT is the
+ * integer AAN one with its scale factors folded into the quantizer.
+ *
+ * The header writer and Huffman coder are also exposed at coefficient
+ * level for transcoders (jpeg_rot.h).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JPEG_ENC_HEADER_MAX 640        // SOI .. SOS for 3 components
+
+enum jpeg_enc_format_t {
+  JPEG_ENC_GRAY,                       // 1 byte per pixel
+  JPEG_ENC_YUV422,                     // Y0 U Y1 V
+  JPEG_ENC_RGB565,                     // big-endian, as the sensor sends it
+  JPEG_ENC_RGB888,                     // R G B
+};
+
+struct jpeg_enc_t {
+  uint16_t width, height;
+  uint8_t  format;                     // jpeg_enc_format_t
+  uint8_t  ncomp;                      // 1 or 3
+  uint8_t  mcu_w;                      // 8 (gray) or 16
+  uint16_t mcus_x, mcus_y;
+  uint8_t  qt[2][64];                  // luma / chroma, zigzag order (DQT)
+  int32_t  recip[2][64];               // natural order, Q18 reciprocal of the AAN-scaled step
+};
+
+// Set up an encoder for one frame geometry. quality 1..100 (IJG scale).
+bool jpegEncInit(jpeg_enc_t* e, int width, int height, jpeg_enc_format_t format, int quality);
+
+// SOI through SOS into out. Returns the length, 0 if cap is too small.
+size_t jpegEncHeader(const jpeg_enc_t* e, uint8_t* out, size_t cap);
+
+// Entropy-coded data for MCU rows [row0, row1) of src (the whole frame).
+// Every row except the image's last is closed with its RSTn marker. Returns
+// the length, or -1 when cap is exceeded or the line buffers can't be allocated.
+long jpegEncRows(const jpeg_enc_t* e, const uint8_t* src, int row0, int row1,
+                 uint8_t* out, size_t cap);
+
+// Bytes per pixel of a source format.
+int jpegEncBytesPerPixel(jpeg_enc_format_t format);
+
+// ---------- coefficient level ----------
+
+// Frame of already quantized blocks. Component 0 uses quantization table 0
+// and the luma Huffman tables, components 1 and 2 table 1 and chroma.
+struct jpeg_frame_t {
+  uint16_t       width, height;
+  uint8_t        ncomp;
+  uint8_t        h[3], v[3];           // sampling factors
+  const uint8_t* qt[2];                // zigzag order
+  uint16_t       restart_interval;     // MCUs, 0 = none
+};
+
+// SOI through SOS (standard Huffman tables). 0 if cap is too small.
+size_t jpegWriteHeader(const jpeg_frame_t* f, uint8_t* out, size_t cap);
+
+struct jpeg_bits_t {
+  uint8_t* p;
+  uint8_t* end;
+  uint32_t acc;
+  int      n;                          // pending bits in acc (< 8 between calls)
+  bool     overflow;                   // ran out of room; p stops advancing
+};
+
+void jpegBitsInit(jpeg_bits_t* bw, uint8_t* out, size_t cap);
+
+// Huffman-code one block of quantized coefficients (zigzag order).
+void jpegEncBlock(jpeg_bits_t* bw, const int16_t* zz, bool chroma, int* dc_pred);
+
+// Raw bits (size <= 24), byte-stuffed like coded data.
+void jpegPutBits(jpeg_bits_t* bw, uint32_t bits, int size);
+
+// Pad to a byte boundary; rst >= 0 then writes marker RST(rst & 7).
+void jpegBitsFlush(jpeg_bits_t* bw, int rst);
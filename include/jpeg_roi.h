@@ -0,0 +1,20 @@
+/**
+ * Grayscale region of interest straight from a baseline JPEG.
+ *
+ * Only the luma blocks that cover the region are dequantized and inverse
+ * transformed; the scan up to the region's last MCU row is entropy-decoded
+ * and skipped (jpeg_scan.h), chroma and everything below are never
+ * touched. At 1/scale each pixel is the mean of the full-size pixels it
+ * covers, like libjpeg's DCT scaling (DC alone at 1/8).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Luma of the 1/scale image (scale 1, 2, 4 or 8), pixels [x0, x0 + w) x
+// [y0, y0 + h), into gray with stride w. The region must lie inside the
+// scaled image, ceil(width / scale) x ceil(height / scale). Returns
+// JPEG_SCAN_OK or a JPEG_SCAN_ERR_* code.
+int jpegDecodeGray(const uint8_t* jpg, size_t len, int scale, int x0, int y0, int w, int h,
+                   uint8_t* gray);
@@ -0,0 +1,33 @@
+/**
+ * Lossless 90/180/270 degree rotation of baseline JPEGs.
+ *
+ * Works on the quantized DCT coefficients: every 8x8 block is transposed
+ * and/or has the signs of its odd horizontal or vertical frequencies
+ * flipped, blocks and MCUs move to their rotated positions, the
+ * quantization tables are transposed, and the result is Huffman-coded
+ * again with the standard tables. No IDCT and no requantization, so nothing
+ * is lost; a rotated frame decodes to the rotated original up to the
+ * decoder's own rounding.
+ *
+ * 4:2:2 (H2V1, the sensor's layout) becomes H1V2 at 90/270. MCUs that are
+ * only partly inside the image can't be moved losslessly and are trimmed
+ * (like jpegtran -trim); every sensor framesize is whole MCUs anyway.
+ *
+ * MCUs are read in rotated order through the random-access decoder
+ * (jpeg_scan.h): 16 bytes of index per MCU (240 kB at UXGA) instead of the
+ * whole coefficient image.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JPEG_ROT_ERR_SPACE  -4     // out too small; retry with a bigger buffer
+
+// degrees 90, 180 or 270 (clockwise). Returns the rotated JPEG's length, or
+// a JPEG_SCAN_ERR_* code / JPEG_ROT_ERR_SPACE.
+long jpegRotate(const uint8_t* jpg, size_t len, int degrees, uint8_t* out, size_t cap);
+
+// Output buffer that fits the rotation of a len-byte JPEG with standard
+// Huffman tables (sensor output); optimized-table sources may need a retry.
+static inline size_t jpegRotateBound(size_t len) { return len + len / 8 + 2048; }
@@ -0,0 +1,104 @@
+/**
+ * Entropy-only JPEG scanner.
+ *
+ * Parses the headers of a baseline JPEG and Huffman-decodes the scan without
+ * dequantizing AC, IDCT or color conversion. For every 8x8 block it reports
+ * the DC coefficient (dequantized, so 128 + dc / 8 is the block's mean
+ * sample value) and optionally the sum of |AC| (quantized) as a cheap
+ * detail/activity measure. Several times faster than a full decode, which
+ * makes per-frame statistics (exposure, motion, thumbnails) affordable.
+ *
+ * Handles 1 or 3 components, any sampling factors, restart intervals and
+ * JPEGs without DHT (motion-JPEG style; the standard tables are assumed).
+ *
+ * For transcoding (lossless rotation) there is also a random-access mode:
+ * one pass records the decoder state at the start of every MCU (16 bytes
+ * each), after which any MCU's quantized coefficients can be decoded on
+ * their own, in any order, without holding the whole coefficient image.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JPEG_SCAN_AC          0x01   // compute the |AC| sum per block
+#define JPEG_SCAN_LUMA_ONLY   0x02   // call back for component 0 only
+
+#define JPEG_SCAN_OK           0
+#define JPEG_SCAN_ERR_FORMAT  -1     // not a JPEG / broken headers
+#define JPEG_SCAN_ERR_UNSUPP  -2     // progressive, arithmetic, 12-bit, >3 components
+#define JPEG_SCAN_ERR_DATA    -3     // corrupt or truncated entropy data
+
+struct jpeg_info_t {
+  uint16_t width, height;
+  uint8_t  ncomp;
+  uint8_t  h[3], v[3];         // sampling factors per component
+  uint16_t mcus_x, mcus_y;
+  uint16_t blocks_x[3];        // block grid per component (whole MCUs)
+  uint16_t blocks_y[3];
+  uint16_t qdc[3];             // DC quantizer per component
+  uint16_t restart_interval;   // MCUs, 0 = none
+  size_t   scan_offset;        // first entropy-coded byte
+};
+
+// Per block, in decode order. bx/by index the component's block grid.
+typedef void (*jpeg_block_fn)(void* ctx, int comp, int bx, int by, int dc, int ac_sum);
+
+// Headers only (fills info). Returns JPEG_SCAN_OK or an error.
+int jpegScanHeaders(const uint8_t* jpg, size_t len, jpeg_info_t* info);
+
+// Headers + entropy scan. fn may be NULL (validation / timing).
+int jpegScan(const uint8_t* jpg, size_t len, uint32_t flags,
+             jpeg_block_fn fn, void* ctx, jpeg_info_t* info);
+
+// ---------- random access ----------
+
+struct jpeg_decoder_t;
+
+// Decoder state at the start of one MCU.
+struct jpeg_mcu_pos_t {
+  uint32_t offset;             // reader position in the file
+  uint32_t buf;                // bits already read ahead
+  uint8_t  bits;
+  uint8_t  marker;
+  int16_t  pred[3];            // DC predictors (quantized)
+};
+
+// Parse the headers. NULL on error (*err says why, may be NULL).
+jpeg_decoder_t* jpegDecoderOpen(const uint8_t* jpg, size_t len, jpeg_info_t* info, int* err);
+void jpegDecoderClose(jpeg_decoder_t* d);
+
+// Quantization table of a component, zigzag order.
+const uint16_t* jpegDecoderQuant(const jpeg_decoder_t* d, int comp);
+
+// Walk the scan once and fill pos[mcus_x * mcus_y] (raster order).
+int jpegDecoderIndex(jpeg_decoder_t* d, jpeg_mcu_pos_t* pos);
+
+// Quantized coefficients (zigzag order, DC absolute) of the blocks of one
+// MCU, in scan order: h*v blocks of component 0 row by row, then 1, then 2.
+int jpegDecodeMcu(const jpeg_decoder_t* d, const jpeg_mcu_pos_t* pos, int16_t (*zz)[64]);
+
+// Quantized luma coefficients (zigzag order, DC absolute) of the blocks in
+// block columns [bx0, bx1) and rows [by0, by1), in decode order. One
+// sequential pass: every other block is only skipped over, and the scan
+// stops after the MCU row holding block row by1 - 1.
+typedef void (*jpeg_coef_fn)(void* ctx, int bx, int by, const int16_t* zz);
+int jpegDecodeLuma(const jpeg_decoder_t* d, int bx0, int by0, int bx1, int by1,
+                   jpeg_coef_fn fn, void* ctx);
+
+// Layout of one restart interval (the whole scan without DRI) for DC
+// splicing (jpeg_adjust.h). Offsets are from the start of the file.
+struct jpeg_interval_t {
+  uint32_t start;              // first entropy-coded byte
+  uint32_t bits;               // coded bits up to the end of its last MCU (unstuffed)
+  int16_t  dc;                 // first luma DC (its difference from 0, quantized)
+  uint8_t  dc_bits;            // length of that DC code + magnitude bits
+};
+
+// Walk the scan once and fill iv[n]; n must be the interval count,
+// ceil(mcus_x * mcus_y / restart_interval), or 1 without DRI.
+int jpegDecoderIntervals(const jpeg_decoder_t* d, jpeg_interval_t* iv, int n);
+
+// Huffman code of DC category s (0..11) in a component's DC table.
+// Returns its length, 0 if the table has no such symbol.
+int jpegDecoderDcCode(const jpeg_decoder_t* d, int comp, int s, uint16_t* code);
@@ -0,0 +1,25 @@
+/**
+ * Minimal LZ4 block-format codec.
+ *
+ * Output is a standard LZ4 *block* (no frame header), so any LZ4 library's
+ * LZ4_decompress_safe() can read it as well as lz4Decompress() below.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LZ4_HASH_LOG      12
+#define LZ4_HASH_ENTRIES  (1u << LZ4_HASH_LOG)
+
+// Worst-case compressed size for n input bytes.
+static inline size_t lz4CompressBound(size_t n) { return n + n / 255 + 16; }
+
+// Compress src[0..n) into dst. `table` is caller-owned scratch of
+// LZ4_HASH_ENTRIES entries (contents need not be initialized).
+// Returns the compressed size, or 0 if dst is too small.
+size_t lz4Compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap, uint32_t* table);
+
+// Decompress one block. Returns the decoded size, or -1 on malformed input
+// or if the output would exceed cap.
+long lz4Decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap);
@@ -0,0 +1,24 @@
+/**
+ * 128x32 SSD1306 status display on I2C (SSID / IP / boot state).
+ *
+ * Under the Arduino core this draws with Adafruit_SSD1306 / GFX. Plain
+ * ESP-IDF builds use a small built-in driver instead (IDF I2C master, the
+ * classic 5x7 font in 6x8 cells, i.e. GFX text size 1), so both builds show
+ * the same screens.
+ */
+#pragma once
+
+#define OLED_WIDTH   128
+#define OLED_HEIGHT   32
+#define OLED_ADDR   0x3C
+
+// Bring up I2C and the panel and show the boot banner. False if no display
+// answered; the other calls are then no-ops.
+bool oledInit(int sda, int scl);
+
+// Two lines, each centred (line2 may be NULL). Remembered, so the screen can
+// be restored after `bench oled`.
+void oledShow(const char* line1, const char* line2 = nullptr);
+
+// `bench oled n=20`: frame-buffer render vs. I2C flush cost of one redraw.
+const char* oledBench(int argc, char** argv);
@@ -0,0 +1,26 @@
+/**
+ * Wi-Fi PHY mode / channel-width calibration for the soft-AP.
+ *
+ * Tries each candidate (802.11 protocol set + HT20/HT40), lets a connected
+ * client pull /probe under it, and keeps the candidate with the best measured
+ * goodput. The winner is stored in NVS, applied at the next boot and tried
+ * first by the next calibration.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Apply the stored winner (call once the AP is up).
+void phyInit();
+
+// Start a calibration run. Returns false if one is already running.
+bool phyStartCalibration();
+
+// Report one finished /probe transfer (measured on the device side).
+void phyRecordProbe(size_t bytes, uint32_t elapsed_us);
+
+// Deferred PHY switches and probe timeouts; call from loop().
+void phyLoop();
+
+size_t phyStatusJson(char* buf, size_t len);
@@ -0,0 +1,17 @@
+/**
+ * Large-buffer allocation: PSRAM when the board has it, internal heap otherwise.
+ */
+#pragma once
+
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+
+static inline void* psAlloc(size_t n) {
+  void* p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM);
+  return p ? p : malloc(n);
+}
+
+static inline void* psCalloc(size_t n, size_t size) {
+  void* p = heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM);
+  return p ? p : calloc(n, size);
+}
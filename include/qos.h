@@ -0,0 +1,50 @@
+/**
+ * Compute-budget QoS scheduler for analytics stages.
+ *
+ * Analytics consumers (motion, focus, counting, ...) register a stage with a
+ * priority and a per-frame CPU budget. The stream loop hands every delivered
+ * frame to qosRunStages(); the scheduler measures what each stage really
+ * costs and runs it only every Nth frame so that:
+ *   - its amortized cost per frame stays within its budget, and
+ *   - the stream keeps its target fps (lowest priority backs off first).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_camera.h"
+
+#define QOS_MAX_STAGES   8
+#define QOS_MAX_EVERY_N  64
+
+// Stage callback. Runs with the frame still held by the stream; must not keep fb.
+typedef void (*qos_stage_fn)(const camera_fb_t* fb, void* ctx);
+
+// Register a stage (call from setup()). Higher priority = backed off last.
+// budget_us 0 = the stage paces itself: it is offered every frame and never
+// backed off, for stages whose skipped frames would cost more than the time.
+// Returns false when fn is NULL or the table is full. Stages are kept sorted
+// by priority, so there is no stable index to hand back.
+bool qosRegisterStage(const char* name, uint8_t priority, uint32_t budget_us,
+                      qos_stage_fn fn, void* ctx);
+
+// Remove the stage registered with fn, for stages that only live while a
+// task needs them. Both calls wait for a running stage pass to finish, so
+// never call them from a stage. Returns false when fn isn't registered.
+bool qosUnregisterStage(qos_stage_fn fn);
+
+void  qosSetTargetFps(float fps);
+float qosTargetFps();
+
+// Stream side: account one frame that went out to a client.
+void qosFrameSent(const camera_fb_t* fb, size_t bytes);
+
+// Stream side: run the stages that are due on this frame (once per captured frame).
+void qosRunStages(const camera_fb_t* fb);
+
+// Delivered stream rate over the last full second.
+float    qosStreamFps();
+uint32_t qosStreamBytesPerSec();
+
+// JSON snapshot of stream fps and effective per-stage analytics rates.
+size_t qosStatusJson(char* buf, size_t len);
@@ -0,0 +1,62 @@
+/**
+ * Activity-driven capture rate: motion gate and idle/active policy.
+ *
+ * Motion is judged on the 1/8-scale luma image formed by the JPEG DC terms
+ * (one mean per 8x8 block, see jpeg_scan.h): a block counts as changed when
+ * its mean moved by more than `delta` levels after removing the global
+ * brightness shift (clouds, auto exposure). Enough changed blocks make a
+ * motion frame; the policy jumps to ACTIVE on one and returns to IDLE after
+ * `quiet_ms` without any, keeping time-in-mode for the duty-cycle report.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct rate_config_t {
+  float    idle_fps;         // sensor rate while quiet
+  uint32_t quiet_ms;         // no motion this long -> idle
+  uint8_t  delta;            // block mean change (levels) counted as motion
+  uint16_t min_blocks;       // changed blocks that make a motion frame
+};
+
+rate_config_t rateDefaultConfig();
+
+struct motion_grid_t {
+  uint8_t* prev;
+  uint8_t* cur;
+  uint16_t bw, bh;           // luma block grid
+  bool     primed;
+};
+
+// One allocation of motionGridBytes() for a bw x bh grid.
+size_t motionGridBytes(int bw, int bh);
+void   motionGridInit(motion_grid_t* g, int bw, int bh, void* mem);
+
+// jpeg_scan callback body: dequantized luma DC of block (bx, by).
+static inline void motionAddBlock(motion_grid_t* g, int bx, int by, int dc) {
+  if (bx >= g->bw || by >= g->bh) return;
+  int v = 128 + dc / 8;
+  g->cur[by * g->bw + bx] = v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+}
+
+// Changed blocks between the last two frames (0 for the first one).
+int motionCompare(motion_grid_t* g, uint8_t delta);
+
+enum rate_mode_t { RATE_ACTIVE, RATE_IDLE };
+
+struct rate_state_t {
+  rate_mode_t mode;
+  int64_t  mode_since_us;
+  int64_t  last_motion_us;
+  uint64_t active_us, idle_us;     // closed intervals per mode
+  uint32_t events;                 // IDLE -> ACTIVE transitions
+};
+
+void rateInit(rate_state_t* s, int64_t now_us);
+
+// One analysed frame. Returns true when the mode changed.
+bool rateStep(const rate_config_t& c, rate_state_t* s, bool motion, int64_t now_us);
+
+// Time spent per mode including the open interval.
+void rateDuty(const rate_state_t& s, int64_t now_us, uint64_t* active_us, uint64_t* idle_us);
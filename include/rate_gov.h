@@ -0,0 +1,25 @@
+/**
+ * Activity-driven capture rate governor (power saving).
+ *
+ * In auto mode the OV2640 idles at a low frame rate by dividing its internal
+ * clock (CLKRC), which also lowers the sensor's readout power. Every analysed
+ * frame goes through the DC motion gate in rate_control.h; on motion the
+ * full-rate clock is restored at once, so the next frame arrives one full-rate
+ * interval later. After a quiet period the sensor drops back to idle.
+ * Frames come from a QoS stage while a stream runs, or from a sampler task.
+ *
+ * Reports the duty cycle (time at full rate), an energy-per-hour estimate
+ * from it, and the event latency: the time from the frame that showed
+ * motion to the first frame at full rate.
+ */
+#pragma once
+
+#include <stddef.h>
+#include "rate_control.h"
+
+void rateGovInit();                      // registers the QoS stage + sampler
+void rateGovEnable(bool on);             // off = always full rate (default)
+bool rateGovEnabled();
+void rateGovSetConfig(const rate_config_t& c);
+rate_config_t rateGovConfig();
+size_t rateGovStatusJson(char* buf, size_t len);
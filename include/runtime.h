@@ -0,0 +1,50 @@
+/**
+ * The few things the firmware needs from the runtime it is built on.
+ *
+ * Two PlatformIO envs build the same sources: `ttgo-tjournal` on the Arduino
+ * core and `ttgo-tjournal-idf` on plain ESP-IDF (no Arduino loop task,
+ * Serial or WiFi classes; sdkconfig.defaults applies). Everything else in
+ * the tree already talks to ESP-IDF directly, so only the serial console,
+ * the soft-AP bring-up and mDNS differ, and only here and in oled.cpp.
+ * mDNS is the IDF component in both builds (ESPmDNS wraps the same one).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct runtime_ap_t {
+  const char* ssid;
+  const char* password;                 // empty -> open network
+  int         channel;
+  bool        hidden;
+  int         max_clients;
+};
+
+struct runtime_peer_t {
+  char     host[40];                    // without ".local"
+  uint8_t  ip[4];
+  uint16_t port;
+};
+
+// "arduino" or "esp-idf".
+const char* runtimeName();
+
+// UART0 console at 115200 baud; printf() goes there in both builds.
+void runtimeConsoleBegin();
+
+// Next received console byte, -1 if none is waiting (never blocks).
+int runtimeConsoleRead();
+
+// Soft-AP up (NVS, netif and Wi-Fi driver included on ESP-IDF); ip gets its address.
+bool runtimeApStart(const runtime_ap_t& ap, uint8_t ip[4]);
+
+// mDNS responder with this hostname, then services on it.
+bool runtimeMdnsStart(const char* host);
+bool runtimeMdnsService(const char* type, const char* proto, uint16_t port);
+
+// Browse for a service ("nozzlecam", "tcp"); blocks for up to timeout_ms.
+int runtimeMdnsQuery(const char* type, const char* proto, uint32_t timeout_ms,
+                     runtime_peer_t* out, int max);
+
+void runtimeDelayMs(uint32_t ms);
@@ -0,0 +1,65 @@
+/**
+ * Scrub-preview sprite sheets from JPEG DC luma.
+ *
+ * A ring of tiny grayscale tiles, one per sampled frame, each built from the
+ * frame's luma DC terms (the image at 1/8 scale, see jpeg_scan.h) box-filtered
+ * or stretched to the tile size. Adding a tile costs one entropy-only scan
+ * and a few adds per block; no IDCT, no pixel decode. A range of tiles is
+ * laid out row by row into one image for a player to show as hover/scrub
+ * previews.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct sprite_sheet_t {
+  uint16_t  tile_w, tile_h;
+  uint16_t  cap;               // tiles in the ring
+  uint16_t  count;             // tiles held (<= cap)
+  uint16_t  head;              // next slot to write
+  uint8_t*  tiles;             // cap * tile_w * tile_h
+  uint32_t* t_ms;              // capture time per slot
+  uint32_t* acc;               // tile being built: sum per pixel
+  uint16_t* hits;              //                   blocks per pixel
+  uint16_t  bw, bh;            // luma block grid of the frame being added
+};
+
+size_t spriteSheetBytes(int cap, int tile_w, int tile_h);
+void   spriteSheetInit(sprite_sheet_t* s, int cap, int tile_w, int tile_h, void* mem);
+void   spriteSheetClear(sprite_sheet_t* s);
+
+// Start a tile for a frame whose luma block grid is bw x bh.
+void spriteBegin(sprite_sheet_t* s, int bw, int bh);
+
+// jpeg_scan callback body: dequantized luma DC of block (bx, by).
+static inline void spriteAddBlock(sprite_sheet_t* s, int bx, int by, int dc) {
+  if (bx >= s->bw || by >= s->bh) return;
+  int v = 128 + dc / 8;
+  v = v < 0 ? 0 : v > 255 ? 255 : v;
+  // the block covers tile pixels [x0, x1) x [y0, y1): one when shrinking, several when stretching
+  int x0 = bx * s->tile_w / s->bw, x1 = (bx + 1) * s->tile_w / s->bw;
+  int y0 = by * s->tile_h / s->bh, y1 = (by + 1) * s->tile_h / s->bh;
+  if (x1 <= x0) x1 = x0 + 1;
+  if (y1 <= y0) y1 = y0 + 1;
+  for (int y = y0; y < y1; y++)
+    for (int x = x0; x < x1; x++) {
+      s->acc[y * s->tile_w + x] += v;
+      s->hits[y * s->tile_w + x]++;
+    }
+}
+
+// Finish the tile and push it into the ring (drops the oldest when full).
+void spriteCommit(sprite_sheet_t* s, uint32_t t_ms);
+
+// Tiles in chronological order: i = 0 is the oldest held.
+uint32_t spriteTime(const sprite_sheet_t* s, int i);
+
+// First tile (chronological index) taken at or after t_ms; count if none.
+int spriteFind(const sprite_sheet_t* s, uint32_t t_ms);
+
+// Tiles [first, first + n) into a grayscale sheet of cols columns, each
+// tile turned by rotate (0/90/180/270, clockwise) like the stream.
+// Sheet size: see spriteSheetSize(). Unused cells are black.
+void spriteSheetSize(const sprite_sheet_t* s, int n, int cols, int rotate, int* w, int* h);
+void spriteRender(const sprite_sheet_t* s, int first, int n, int cols, int rotate, uint8_t* out);
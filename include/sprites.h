@@ -0,0 +1,34 @@
+/**
+ * Scrub-preview sprite sheets for recordings.
+ *
+ * Recordings are made by the browser from /stream, so the device keeps the
+ * previews: a low-priority QoS stage turns one streamed frame every
+ * SPRITE_INTERVAL_S seconds into a 64x48 DC-luma tile (sprite_sheet.h) in
+ * a PSRAM ring. When a recording stops the page fetches the sheet for its
+ * duration once and scrubs through it locally. Frames between samples cost
+ * a clock read; a sample costs one entropy-only scan, and the QoS budget
+ * keeps even that off the stream's back under load.
+ *
+ * The sheet is a grayscale JPEG with its index in a COM segment:
+ *   {"tile":[w,h],"cols":c,"interval_ms":i,"now_ms":t,"t":[t0,t1,...]}
+ * (tile capture times in ms since boot, row by row).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define SPRITE_INTERVAL_S  5
+#define SPRITE_TILE_W      64
+#define SPRITE_TILE_H      48
+#define SPRITE_CAP         240        // 20 min at 5 s, 720 KB of PSRAM
+#define SPRITE_CAP_FALLBACK 12        // 1 min in internal RAM without PSRAM
+
+void spritesInit();                   // registers the QoS stage
+
+// Sheet of the tiles from the last `last_s` seconds (0 = all held), cols
+// per row, turned like a /stream?rotate= stream. *jpg is malloc'd.
+esp_err_t spritesRenderJpeg(uint32_t last_s, int cols, int rotate, uint8_t** jpg, size_t* len);
+
+size_t spritesStatusJson(char* buf, size_t len);
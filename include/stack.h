@@ -0,0 +1,30 @@
+/**
+ * Low-noise stills by stacking an RGB565 burst.
+ *
+ * Switches the sensor to RGB565 at the requested size, averages N frames in
+ * a PSRAM accumulator (stack_accum.h), restores the stream profile and only
+ * then encodes one JPEG, so the stream is back while the encoder runs.
+ * Sensor noise drops by about sqrt(N); anything that moves during the burst
+ * (a few hundred ms at VGA) blurs, so this is for static scenes.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_camera.h"
+#include "esp_err.h"
+
+struct stack_result_t {
+  uint8_t* jpg;            // free() when done
+  size_t   len;
+  int      frames;         // frames actually accumulated
+  uint16_t width, height;
+  uint32_t accum_us;       // mean accumulate time per frame
+  uint32_t grab_ms;        // burst wall time (sensor bound)
+  uint32_t encode_ms;
+};
+
+// Blocking; claims the camera for the burst. ESP_ERR_INVALID_STATE when the
+// camera is claimed elsewhere, ESP_ERR_NOT_SUPPORTED without PSRAM,
+// ESP_ERR_NO_MEM, ESP_FAIL on capture/encode errors.
+esp_err_t stackCapture(int frames, framesize_t size, int quality, stack_result_t* out);
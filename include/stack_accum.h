@@ -0,0 +1,22 @@
+/**
+ * Fixed-point frame stacking for RGB565 bursts.
+ *
+ * Each accumulator word holds all three channel sums of one pixel
+ * (SWAR: B in bits 0..8, G in 9..18, R in 19..27), so adding a frame is one
+ * load, three masks and one add per pixel. Fields are sized for up to
+ * STACK_MAX_FRAMES frames without carries between channels.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STACK_MAX_FRAMES 16
+
+// acc[i] += frame pixel i. `frame` is RGB565 in camera byte order (big endian),
+// 4-byte aligned (camera frame buffers are).
+void stackAccumulate(uint32_t* acc, const uint8_t* frame, size_t pixels);
+
+// Average `frames` frames into RGB888 (R, G, B byte order, JPEG_ENC_RGB888), rounded.
+// Works in place: `out` may alias `acc` (3 bytes written per 4 read).
+void stackFinish(const uint32_t* acc, size_t pixels, int frames, uint8_t* out);
@@ -0,0 +1,68 @@
+/**
+ * TCP transport statistics per viewer, read from the lwIP PCBs.
+ *
+ * A lagging viewer can be short of airtime (retransmissions, RTT), have a
+ * small receive window of its own (it isn't reading fast enough), or be
+ * starved on our side (send queue full, heap for pbufs running out). A 4 Hz
+ * sampler reads the PCB of every detached response (http_stream.h) on the
+ * tcpip thread while any is open, and lwIP's global TCP and memory use
+ * alongside, so the three can be told apart.
+ *
+ * lwIP's RTT / RTO estimate runs on its 500 ms slow timer, so srtt is coarse
+ * below a second. lwIP only counts consecutive retransmissions of the oldest
+ * segment (nrtx); retx adds up its increases between samples, a lower bound.
+ * With the ESP-IDF lwIP, pbufs and PCBs come from the internal heap rather
+ * than fixed pools, so heap is the pool that runs out; per-pool counters are
+ * added when the build has LWIP_STATS.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TCP_STATS_PERIOD_MS  250
+
+struct tcp_conn_stats_t {
+  int         fd;
+  const char* name;            // http_stream worker ("stream", "raw", ...)
+  uint32_t    remote_ip;       // network order
+  uint16_t    remote_port;
+  uint8_t     state;           // lwIP tcp_state (4 = ESTABLISHED)
+  uint16_t    mss;
+  uint32_t    cwnd, ssthresh;  // bytes
+  uint32_t    peer_wnd;        // viewer's advertised receive window
+  uint32_t    rcv_wnd;         // ours
+  uint32_t    queued;          // bytes in lwIP's send queue (unsent + unacked)
+  uint32_t    in_flight;       // sent, not yet acked
+  uint32_t    snd_buf_free;
+  uint16_t    snd_queuelen;    // pbufs queued
+  uint32_t    srtt_ms, rttvar_ms, rto_ms;
+  uint8_t     nrtx;            // current consecutive retransmissions
+  bool        recovery;        // in fast recovery
+  uint32_t    retx;            // since the connection was first sampled (lower bound)
+  uint32_t    samples;
+  uint32_t    small_wnd;       // samples with peer_wnd < 2 MSS
+  uint32_t    full_queue;      // samples with the send buffer or pbuf queue at its limit
+};
+
+struct tcp_global_stats_t {
+  uint16_t active_pcbs, time_wait_pcbs;
+  uint32_t queued_bytes;       // all active PCBs
+  uint32_t queued_pbufs;
+  uint16_t ooseq_pcbs;         // holding out-of-order segments
+  uint32_t heap_free, heap_largest, heap_min;   // internal RAM
+};
+
+// Start the sampler and register the "tcp" console command.
+void tcpStatsInit();
+
+// Latest sample of every open detached response. Returns the count.
+int tcpStatsConns(tcp_conn_stats_t* out, int max);
+
+// Sampled now (runs on the tcpip thread).
+bool tcpStatsGlobal(tcp_global_stats_t* out);
+
+// Both as JSON. Connections from the same address as viewer_fd (the
+// requesting socket, -1 = none) get "you":true, so a page can pick out its
+// own stream.
+size_t tcpStatsJson(char* buf, size_t len, int viewer_fd);
@@ -0,0 +1,19 @@
+/**
+ * Cheap JPEG thumbnails from DC coefficients.
+ *
+ * Every 8x8 block's DC coefficient is its mean, so the DC values of a JPEG
+ * are the image at 1/8 scale. jpegScan() reads them without IDCT, which
+ * makes a UXGA -> 200x150 thumbnail several times cheaper than a scaled
+ * decode. Chroma comes from the chroma DCs (nearest neighbour), extra
+ * halvings average 2x2 DC blocks.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// RGB888 thumbnail at 1/(8 << shift) scale (shift 0..3), malloc'd into *rgb.
+// R, G, B byte order (JPEG_ENC_RGB888).
+// Returns false for unsupported JPEGs or out of memory.
+bool thumbFromJpeg(const uint8_t* jpg, size_t len, int shift,
+                   uint8_t** rgb, int* width, int* height);
@@ -0,0 +1,37 @@
+/**
+ * Sub-pixel nozzle tip localization.
+ *
+ * Works on a grayscale ROI: either cropped straight from a grayscale frame or
+ * decoded from the JPEG at 1/2..1/8 scale (only the luma blocks under the ROI,
+ * jpeg_roi.h), handed to the locator in tip_locate.h. Coordinates are full-frame
+ * pixels in Q8 fixed point.
+ *
+ * The ROI must frame the nozzle tip against a clean background (the nozzle
+ * entering from the top).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct tip_result_t {
+  uint32_t seq;          // increments with every located (or lost) result
+  uint64_t frame_us;     // capture timestamp of the analysed frame
+  bool     found;
+  int32_t  x_q8, y_q8;   // full-frame pixels, Q8
+  uint16_t strength;     // peak edge magnitude at the tip
+  uint32_t cost_us;      // time spent on this frame
+};
+
+// ROI in permille of the frame (0..1000), decode scale 1, 2, 4 or 8.
+struct tip_config_t {
+  uint16_t x0, y0, x1, y1;
+  uint8_t  scale;
+  uint8_t  min_strength;  // edge threshold floor (Sobel |gx|+|gy|, 0..255 scale)
+};
+
+void tipInit();                     // registers the QoS stage
+void tipSetConfig(const tip_config_t& cfg);
+tip_config_t tipConfig();
+tip_result_t tipLatest();
+size_t tipResultJson(const tip_result_t& r, char* buf, size_t len);
@@ -0,0 +1,21 @@
+/**
+ * Sub-pixel tip locator on a grayscale ROI.
+ *
+ * Edges come from a fixed-point Sobel (|gx|+|gy|); the tip is the lowest edge
+ * point of a silhouette entering from the top (median of 3 columns against
+ * speckle, the centre of the run for a flat tip), refined by parabolic fits
+ * through the edge magnitude, vertically in the tip column and horizontally
+ * through the refined rows of its neighbours. Coordinates are ROI pixels in
+ * Q8 fixed point.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TIP_MAX_W 512                      // ROI columns handled per call
+
+// Locator on an 8-bit gray image; `mag` is w*h scratch. Returns true and
+// fills x_q8/y_q8/strength (image coordinates) when a tip was found.
+bool tipLocate(const uint8_t* gray, int w, int h, int stride, uint8_t min_strength,
+               uint8_t* mag, int32_t* x_q8, int32_t* y_q8, uint16_t* strength);
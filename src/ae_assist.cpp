@@ -0,0 +1,157 @@
+/**
+ * Software auto-exposure assist (see ae_assist.h).
+ */
+#include "ae_assist.h"
+
+#include <stdio.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "jpeg_scan.h"
+#include "qos.h"
+
+static portMUX_TYPE      ae_mux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t sensor_lock = NULL;  // SCCB writes: stage vs. HTTP enable/disable
+static bool        enabled = false;
+static ae_config_t config;
+static ae_state_t  state;
+static uint32_t    steps = 0, scan_errors = 0, cost_us = 0;
+
+// OV2640 sensor-bank registers (bank bit 0x100 for get_reg)
+#define REG_GAIN   0x100
+#define REG_COM1   0x104    // AEC[1:0]
+#define REG_AEC    0x110    // AEC[9:2]
+#define REG_45     0x145    // AEC[15:10]
+
+// Current exposure/gain as the built-in AEC left them, so enabling does not jump.
+static void readSensor(sensor_t* s, ae_state_t* st) {
+  st->aec = s->status.aec_value ? s->status.aec_value : 300;
+  st->gain = s->status.agc_gain;
+  if (!s->get_reg) return;
+  int aec = (s->get_reg(s, REG_45, 0x3F) << 10) | (s->get_reg(s, REG_AEC, 0xFF) << 2) |
+            s->get_reg(s, REG_COM1, 0x03);
+  int g = s->get_reg(s, REG_GAIN, 0xFF);
+  if (aec < 0 || g < 0) return;
+  float mult = (1 + (g >> 7 & 1)) * (1 + (g >> 6 & 1)) * (1 + (g >> 5 & 1)) * (1 + (g >> 4 & 1)) *
+               (1 + (g & 15) / 16.0f);
+  int idx = (int)(mult + 0.5f) - 1;
+  st->aec = aec < 1 ? 1 : aec > 1200 ? 1200 : aec;
+  st->gain = idx < 0 ? 0 : idx > 30 ? 30 : idx;
+}
+
+// Manual mode is re-asserted with every write: a camera profile switch
+// (e.g. /raw) re-initializes the sensor with AEC/AGC back on.
+static void writeSensor(sensor_t* s, uint16_t aec, uint8_t gain) {
+  s->set_exposure_ctrl(s, 0);
+  s->set_gain_ctrl(s, 0);
+  s->set_aec_value(s, aec);
+  s->set_agc_gain(s, gain);
+}
+
+static void blockLuma(void* ctx, int comp, int bx, int by, int dc, int ac) {
+  (void)comp; (void)bx; (void)by; (void)ac;
+  aeStatsAdd((ae_stats_t*)ctx, 128 + dc / 8);
+}
+
+static void aeStage(const camera_fb_t* fb, void* ctx) {
+  (void)ctx;
+  if (!enabled || fb->format != PIXFORMAT_JPEG) return;
+  int64_t t0 = esp_timer_get_time();
+
+  ae_stats_t stats;
+  aeStatsReset(&stats);
+  int r = jpegScan(fb->buf, fb->len, JPEG_SCAN_LUMA_ONLY, blockLuma, &stats, NULL);
+
+  portENTER_CRITICAL(&ae_mux);
+  bool changed = false;
+  ae_state_t st = state;
+  if (r == JPEG_SCAN_OK && enabled) {
+    changed = aeStep(config, stats, &state);
+    st = state;
+    if (changed) steps++;
+  } else if (r != JPEG_SCAN_OK) {
+    scan_errors++;
+  }
+  portEXIT_CRITICAL(&ae_mux);
+
+  if (changed && xSemaphoreTake(sensor_lock, 0) == pdTRUE) {
+    sensor_t* s = esp_camera_sensor_get();
+    if (s && enabled) writeSensor(s, st.aec, st.gain);
+    xSemaphoreGive(sensor_lock);
+  }
+  cost_us = (uint32_t)(esp_timer_get_time() - t0);
+}
+
+void aeAssistInit() {
+  config = aeDefaultConfig();
+  sensor_lock = xSemaphoreCreateMutex();
+  // High priority: exposure matters to every consumer of the image, but the
+  // entropy scan is the most expensive stage, so its budget lets QoS thin it out.
+  qosRegisterStage("ae", 220, 20000, aeStage, NULL);
+}
+
+void aeAssistEnable(bool on) {
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s || !sensor_lock) return;
+  xSemaphoreTake(sensor_lock, portMAX_DELAY);
+  if (on && !enabled) {
+    ae_state_t st = {};
+    readSensor(s, &st);
+    writeSensor(s, st.aec, st.gain);
+    portENTER_CRITICAL(&ae_mux);
+    state = st;
+    enabled = true;
+    portEXIT_CRITICAL(&ae_mux);
+  } else if (!on && enabled) {
+    portENTER_CRITICAL(&ae_mux);
+    enabled = false;
+    portEXIT_CRITICAL(&ae_mux);
+    s->set_exposure_ctrl(s, 1);
+    s->set_gain_ctrl(s, 1);
+  }
+  xSemaphoreGive(sensor_lock);
+  printf("ae: assist %s\n", on ? "on" : "off");
+}
+
+bool aeAssistEnabled() {
+  return enabled;
+}
+
+void aeAssistSetConfig(const ae_config_t& cfg) {
+  ae_config_t c = cfg;
+  if (!c.speed_pct) c.speed_pct = 1;
+  if (c.speed_pct > 100) c.speed_pct = 100;
+  if (c.target < 16) c.target = 16;
+  if (c.target > 240) c.target = 240;
+  if (c.aec_max > 1200) c.aec_max = 1200;
+  if (c.gain_max > 30) c.gain_max = 30;
+  portENTER_CRITICAL(&ae_mux);
+  config = c;
+  portEXIT_CRITICAL(&ae_mux);
+}
+
+ae_config_t aeAssistConfig() {
+  portENTER_CRITICAL(&ae_mux);
+  ae_config_t c = config;
+  portEXIT_CRITICAL(&ae_mux);
+  return c;
+}
+
+size_t aeAssistStatusJson(char* buf, size_t len) {
+  portENTER_CRITICAL(&ae_mux);
+  ae_config_t c = config;
+  ae_state_t st = state;
+  bool on = enabled;
+  uint32_t n = steps, errs = scan_errors;
+  portEXIT_CRITICAL(&ae_mux);
+  int w = snprintf(buf, len,
+    "{\"enabled\":%s,\"target\":%u,\"speed\":%u,\"settle\":%u,\"clip_pct_max\":%u,"
+    "\"aec_max\":%u,\"gain_max\":%u,\"mean\":%u,\"clip_pct\":%u,\"aec\":%u,\"gain\":%u,"
+    "\"steps\":%u,\"scan_errors\":%u,\"cost_us\":%u}",
+    on ? "true" : "false", c.target, c.speed_pct, c.settle_frames, c.clip_pct, c.aec_max,
+    c.gain_max, st.mean, st.clip_pct, st.aec, st.gain, (unsigned)n, (unsigned)errs,
+    (unsigned)cost_us);
+  return w < (int)len ? w : len - 1;
+}
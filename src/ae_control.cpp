@@ -0,0 +1,68 @@
+/**
+ * Software auto-exposure control law (see ae_control.h).
+ */
+#include "ae_control.h"
+
+#include <math.h>
+
+#define AE_GAMMA       2.2f     // luma ~ exposure^(1/2.2) on the sensor's output curve
+#define AE_DEADBAND    0.06f    // +-6% exposure error is left alone (no hunting)
+#define AE_MAX_STEP    8.0f     // per-step exposure ratio limit
+#define AE_CLIP_STEP   0.7f     // exposure ratio while highlights clip
+
+ae_config_t aeDefaultConfig() {
+  ae_config_t c;
+  c.target = 110;
+  c.speed_pct = 60;
+  c.settle_frames = 2;
+  c.clip_pct = 3;
+  c.aec_max = 1200;
+  c.gain_max = 15;
+  return c;
+}
+
+bool aeStep(const ae_config_t& cfg, const ae_stats_t& stats, ae_state_t* st) {
+  if (!stats.n) return false;
+  float mean = (float)stats.sum / stats.n;
+  uint32_t clipped = stats.hist[AE_HIST_BINS - 2] + stats.hist[AE_HIST_BINS - 1];
+  st->mean = (uint8_t)(mean + 0.5f);
+  st->clip_pct = (uint8_t)(clipped * 100 / stats.n);
+  if (st->wait) { st->wait--; return false; }
+
+  // Exposure ratio that would bring the mean onto target, through the
+  // output gamma. Dark frames measure badly (noise floor), so floor them.
+  float m = mean < 2.0f ? 2.0f : mean;
+  float ratio = powf(cfg.target / m, AE_GAMMA);
+  if (st->clip_pct > cfg.clip_pct && ratio > AE_CLIP_STEP) ratio = AE_CLIP_STEP;
+  if (fabsf(logf(ratio)) < logf(1.0f + AE_DEADBAND)) return false;
+
+  // Correct only part of the log error per step.
+  float speed = (cfg.speed_pct ? cfg.speed_pct : 1) / 100.0f;
+  ratio = expf(logf(ratio) * speed);
+  if (ratio > AE_MAX_STEP) ratio = AE_MAX_STEP;
+  if (ratio < 1.0f / AE_MAX_STEP) ratio = 1.0f / AE_MAX_STEP;
+
+  float e = (float)st->aec * (st->gain + 1) * ratio;
+  float e_max = (float)cfg.aec_max * (cfg.gain_max + 1);
+  if (e < 1.0f) e = 1.0f;
+  if (e > e_max) e = e_max;
+
+  // Exposure first (less noise), then gain.
+  uint16_t aec;
+  uint8_t gain;
+  if (e <= cfg.aec_max) {
+    aec = (uint16_t)(e + 0.5f);
+    gain = 0;
+  } else {
+    gain = (uint8_t)ceilf(e / cfg.aec_max) - 1;
+    if (gain > cfg.gain_max) gain = cfg.gain_max;
+    aec = (uint16_t)(e / (gain + 1) + 0.5f);
+    if (aec > cfg.aec_max) aec = cfg.aec_max;
+  }
+  if (aec < 1) aec = 1;
+  if (aec == st->aec && gain == st->gain) return false;
+  st->aec = aec;
+  st->gain = gain;
+  st->wait = cfg.settle_frames;
+  return true;
+}
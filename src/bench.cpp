@@ -0,0 +1,390 @@
+/**
+ * On-device benchmarks (see bench.h).
+ *
+ * Everything runs on the console task (priority 1), so the stream keeps its
+ * CPU share; wall-clock timings include whatever preemption the stream causes,
+ * which is the number that matters on a busy unit.
+ */
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "img_converters.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/etharp.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "lwip/sockets.h"
+
+#include "camera.h"
+#include "console.h"
+#include "encoder.h"
+#include "http_stream.h"
+#include "qos.h"
+
+#define BENCH_MAX       8
+#define JPEG_MAX_N      256
+
+struct BenchEntry {
+  const char* name;
+  const char* args;
+  bench_fn    fn;
+};
+
+static BenchEntry benches[BENCH_MAX];
+static int        num_benches = 0;
+
+bool benchRegister(const char* name, const char* args, bench_fn fn) {
+  if (num_benches >= BENCH_MAX) return false;
+  benches[num_benches++] = { name, args, fn };
+  return true;
+}
+
+static int cmpU32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+// ---------- fb: fb_get rate per framesize ----------
+
+static const char* benchFb(int argc, char** argv) {
+  if (httpStreamActive()) return "camera_busy";     // stream/raw/SSE client connected
+  if (!cameraClaim("bench")) return "camera_busy";
+  bool psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+  char sizes[64];
+  strncpy(sizes, consoleArg(argc, argv, "sizes", psram ? "qvga,vga,svga,uxga" : "qvga,vga,svga"),
+          sizeof(sizes) - 1);
+  sizes[sizeof(sizes) - 1] = 0;
+  int n = consoleArgInt(argc, argv, "n", 20);
+  if (n < 1) n = 1;
+
+  const char* err = NULL;
+  char* save = NULL;
+  for (char* name = strtok_r(sizes, ",", &save); name && !err; name = strtok_r(NULL, ",", &save)) {
+    framesize_t size = cameraFramesize(name);
+    if (size == FRAMESIZE_INVALID) { err = "bad_size"; break; }
+    cam_profile_t p = cameraStreamProfile();
+    p.size = size;
+    if (cameraSetProfile(p) != ESP_OK) { err = "profile_switch_failed"; break; }
+
+    for (int i = 0; i < 2; i++) camFbReturn(camFbGet());     // let AE/AWB settle
+    uint32_t get_max = 0, got = 0;
+    uint64_t get_sum = 0, bytes = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < n; i++) {
+      int64_t g0 = esp_timer_get_time();
+      camera_fb_t* fb = camFbGet();
+      uint32_t g = (uint32_t)(esp_timer_get_time() - g0);
+      if (!fb) continue;
+      got++;
+      get_sum += g;
+      if (g > get_max) get_max = g;
+      bytes += fb->len;
+      camFbReturn(fb);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    printf("BENCH fb size=%s w=%u h=%u n=%u fps=%.2f get_avg_us=%u get_max_us=%u bytes_avg=%u\n",
+           name, resolution[size].width, resolution[size].height, (unsigned)got,
+           us ? got * 1e6f / us : 0.0f, got ? (unsigned)(get_sum / got) : 0,
+           (unsigned)get_max, got ? (unsigned)(bytes / got) : 0);
+  }
+  cameraRestoreStreamProfile();
+  cameraRelease();
+  return err;
+}
+
+// ---------- enc: JPEG encode rate of non-JPEG frames ----------
+// One frame per size is grabbed and encoded n times by each path: the
+// esp32-camera encoder (frame2jpg, one core), our strip encoder on the
+// calling task, and the strip encoder split over both cores.
+
+static pixformat_t benchPixformat(const char* name) {
+  if (!strcmp(name, "rgb565")) return PIXFORMAT_RGB565;
+  if (!strcmp(name, "yuv")) return PIXFORMAT_YUV422;
+  if (!strcmp(name, "gray")) return PIXFORMAT_GRAYSCALE;
+  return PIXFORMAT_JPEG;                          // = invalid here
+}
+
+static const char* benchEnc(int argc, char** argv) {
+  if (httpStreamActive()) return "camera_busy";
+  bool psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+  char sizes[64];
+  strncpy(sizes, consoleArg(argc, argv, "sizes", psram ? "qvga,vga,svga" : "qqvga,qvga"),
+          sizeof(sizes) - 1);
+  sizes[sizeof(sizes) - 1] = 0;
+  const char* fmt_name = consoleArg(argc, argv, "fmt", "rgb565");
+  pixformat_t fmt = benchPixformat(fmt_name);
+  if (fmt == PIXFORMAT_JPEG) return "bad_fmt";
+  int n = consoleArgInt(argc, argv, "n", 5);
+  if (n < 1) n = 1;
+  int q = consoleArgInt(argc, argv, "q", 80);
+  if (!cameraClaim("bench")) return "camera_busy";
+
+  const char* err = NULL;
+  char* save = NULL;
+  for (char* name = strtok_r(sizes, ",", &save); name && !err; name = strtok_r(NULL, ",", &save)) {
+    framesize_t size = cameraFramesize(name);
+    if (size == FRAMESIZE_INVALID) { err = "bad_size"; break; }
+    cam_profile_t p = { fmt, size, JPEG_QUALITY, 1 };
+    if (cameraSetProfile(p) != ESP_OK) { err = "profile_switch_failed"; break; }
+    for (int i = 0; i < 2; i++) camFbReturn(camFbGet());     // let AE/AWB settle
+    camera_fb_t* fb = camFbGet();
+    if (!fb) { err = "no_frame"; break; }
+
+    float fps[3];
+    size_t bytes[3] = { 0, 0, 0 };
+    for (int path = 0; path < 3 && !err; path++) {
+      int64_t t0 = esp_timer_get_time();
+      for (int i = 0; i < n && !err; i++) {
+        uint8_t* jpg = NULL;
+        size_t len = 0;
+        bool ok = path == 0 ? frame2jpg(fb, q, &jpg, &len)
+                            : encodeJpeg(fb->buf, fb->len, fb->width, fb->height, fb->format,
+                                         q, &jpg, &len, path);
+        if (!ok) err = "encode_failed";
+        bytes[path] = len;
+        free(jpg);
+      }
+      int64_t us = esp_timer_get_time() - t0;
+      fps[path] = us > 0 ? n * 1e6f / us : 0;
+    }
+    if (!err)
+      printf("BENCH enc size=%s fmt=%s w=%u h=%u q=%d n=%d frame2jpg_fps=%.2f one_core_fps=%.2f "
+             "two_core_fps=%.2f speedup=%.2f frame2jpg_bytes=%u bytes=%u\n",
+             name, fmt_name, (unsigned)fb->width, (unsigned)fb->height, q, n, fps[0], fps[1], fps[2],
+             fps[0] > 0 ? fps[2] / fps[0] : 0.0f, (unsigned)bytes[0], (unsigned)bytes[2]);
+    camFbReturn(fb);
+  }
+  cameraRestoreStreamProfile();
+  cameraRelease();
+  return err;
+}
+
+// ---------- jpeg: size distribution ----------
+// With a stream running the frames are tapped from the QoS stage loop (no
+// extra grabs); otherwise the benchmark grabs stream-profile frames itself.
+
+static portMUX_TYPE tap_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t*    tap_buf = NULL;
+static int          tap_want = 0, tap_got = 0;
+
+static void jpegTap(const camera_fb_t* fb, void*) {
+  portENTER_CRITICAL(&tap_mux);
+  if (tap_buf && tap_got < tap_want) tap_buf[tap_got++] = fb->len;
+  portEXIT_CRITICAL(&tap_mux);
+}
+
+static const char* benchJpeg(int argc, char** argv) {
+  int n = consoleArgInt(argc, argv, "n", 100);
+  if (n < 1) n = 1;
+  if (n > JPEG_MAX_N) n = JPEG_MAX_N;
+  uint32_t* sizes = (uint32_t*)malloc(n * sizeof(uint32_t));
+  if (!sizes) return "no_memory";
+
+  bool tapped = qosStreamFps() > 0;
+  int got = 0;
+  if (tapped) {
+    // a QoS stage only for the run: it sees every streamed frame, and
+    // nothing else pays for it (or loses a table slot) the rest of the time
+    if (!qosRegisterStage("bench", 0, 100, jpegTap, NULL)) { free(sizes); return "qos_full"; }
+    portENTER_CRITICAL(&tap_mux);
+    tap_buf = sizes; tap_want = n; tap_got = 0;
+    portEXIT_CRITICAL(&tap_mux);
+    int64_t deadline = esp_timer_get_time() + 60 * 1000000LL;
+    while (esp_timer_get_time() < deadline) {
+      portENTER_CRITICAL(&tap_mux);
+      got = tap_got;
+      portEXIT_CRITICAL(&tap_mux);
+      if (got >= n) break;
+      vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    portENTER_CRITICAL(&tap_mux);
+    got = tap_got;
+    tap_buf = NULL;
+    portEXIT_CRITICAL(&tap_mux);
+    qosUnregisterStage(jpegTap);
+  } else {
+    if (cameraProfile().format != PIXFORMAT_JPEG) { free(sizes); return "camera_busy"; }
+    while (got < n) {
+      camera_fb_t* fb = camFbGet();
+      if (!fb) break;
+      sizes[got++] = fb->len;
+      camFbReturn(fb);
+    }
+  }
+  if (!got) { free(sizes); return "no_frames"; }
+
+  qsort(sizes, got, sizeof(uint32_t), cmpU32);
+  uint64_t sum = 0;
+  for (int i = 0; i < got; i++) sum += sizes[i];
+  cam_profile_t p = cameraProfile();
+  printf("BENCH jpeg source=%s size=%s quality=%d n=%d min=%u p10=%u p50=%u p90=%u p99=%u max=%u mean=%u\n",
+         tapped ? "stream" : "direct", cameraFramesizeName(p.size), p.quality, got,
+         (unsigned)sizes[0], (unsigned)sizes[got / 10], (unsigned)sizes[got / 2],
+         (unsigned)sizes[got * 9 / 10], (unsigned)sizes[got * 99 / 100], (unsigned)sizes[got - 1],
+         (unsigned)(sum / got));
+  free(sizes);
+  return NULL;
+}
+
+// ---------- psram: bandwidth ----------
+
+#define PSRAM_CHUNK  (32 * 1024)
+#define PSRAM_PASSES 16
+
+static float mbps(uint64_t bytes, int64_t us) {
+  return us > 0 ? bytes / (float)us : 0.0f;      // bytes/us == MB/s
+}
+
+static const char* benchPsram(int argc, char** argv) {
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) return "no_psram";
+  size_t bytes = (size_t)consoleArgInt(argc, argv, "kb", 256) * 1024;
+  if (bytes < PSRAM_CHUNK) bytes = PSRAM_CHUNK;
+  bytes -= bytes % PSRAM_CHUNK;
+
+  uint8_t* a = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  uint8_t* b = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  uint8_t* in = (uint8_t*)heap_caps_malloc(PSRAM_CHUNK, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!a || !b || !in) {
+    heap_caps_free(a); heap_caps_free(b); heap_caps_free(in);
+    return "no_memory";
+  }
+  memset(in, 0x5A, PSRAM_CHUNK);
+
+  // Time chunk by chunk and yield in between, so a running stream keeps its
+  // share of the PSRAM bus; only the copy time is counted.
+  enum { WRITE, READ, COPY_PP, COPY_PI, COPY_IP, MODES };
+  static const char* NAMES[MODES] = { "write", "read", "copy_psram_psram", "copy_psram_int", "copy_int_psram" };
+  int64_t us[MODES] = { 0 };
+  volatile uint32_t sink = 0;
+  for (int pass = 0; pass < PSRAM_PASSES; pass++) {
+    for (size_t off = 0; off < bytes; off += PSRAM_CHUNK) {
+      int64_t t = esp_timer_get_time();
+      memset(a + off, pass, PSRAM_CHUNK);
+      int64_t t1 = esp_timer_get_time();
+      const uint32_t* w = (const uint32_t*)(a + off);
+      uint32_t s = 0;
+      for (size_t i = 0; i < PSRAM_CHUNK / 4; i++) s += w[i];
+      sink += s;
+      int64_t t2 = esp_timer_get_time();
+      memcpy(b + off, a + off, PSRAM_CHUNK);
+      int64_t t3 = esp_timer_get_time();
+      memcpy(in, b + off, PSRAM_CHUNK);
+      int64_t t4 = esp_timer_get_time();
+      memcpy(a + off, in, PSRAM_CHUNK);
+      int64_t t5 = esp_timer_get_time();
+      us[WRITE] += t1 - t; us[READ] += t2 - t1; us[COPY_PP] += t3 - t2;
+      us[COPY_PI] += t4 - t3; us[COPY_IP] += t5 - t4;
+      taskYIELD();
+    }
+  }
+  uint64_t total = (uint64_t)bytes * PSRAM_PASSES;
+  for (int m = 0; m < MODES; m++)
+    printf("BENCH psram mode=%s bytes=%llu us=%lld mbps=%.1f\n", NAMES[m],
+           (unsigned long long)total, (long long)us[m], mbps(total, us[m]));
+  (void)sink;
+  heap_caps_free(a); heap_caps_free(b); heap_caps_free(in);
+  return NULL;
+}
+
+// ---------- wifi: UDP send rate to a client ----------
+// The station's IP comes from the lwIP ARP table (matched against the AP's
+// station list by MAC); datagrams go to the discard port.
+
+#define WIFI_DGRAM 1460
+
+struct ArpLookup {
+  struct tcpip_api_call_data base;
+  uint8_t  mac[6];
+  uint32_t ip;
+};
+
+static err_t arpLookup(struct tcpip_api_call_data* call) {
+  ArpLookup* l = (ArpLookup*)call;
+  for (size_t i = 0; i < ARP_TABLE_SIZE; i++) {
+    ip4_addr_t* ip;
+    struct netif* nif;
+    struct eth_addr* eth;
+    if (etharp_get_entry(i, &ip, &nif, &eth) && !memcmp(eth->addr, l->mac, 6)) {
+      l->ip = ip->addr;
+      return ERR_OK;
+    }
+  }
+  return ERR_VAL;
+}
+
+static const char* benchWifi(int argc, char** argv) {
+  size_t total = (size_t)consoleArgInt(argc, argv, "kb", 1024) * 1024;
+  wifi_sta_list_t sta;
+  if (esp_wifi_ap_get_sta_list(&sta) != ESP_OK || sta.num == 0) return "no_client";
+  int best = 0;
+  for (int i = 1; i < sta.num; i++) if (sta.sta[i].rssi > sta.sta[best].rssi) best = i;
+
+  ArpLookup l;
+  memset(&l, 0, sizeof(l));
+  memcpy(l.mac, sta.sta[best].mac, 6);
+  if (tcpip_api_call(arpLookup, &l.base) != ERR_OK) return "client_not_in_arp";
+
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  if (s < 0) return "socket";
+  struct sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons(9);                       // discard
+  to.sin_addr.s_addr = l.ip;
+
+  static uint8_t dgram[WIFI_DGRAM];
+  size_t sent = 0;
+  uint32_t stalls = 0;
+  int64_t t0 = esp_timer_get_time();
+  while (sent < total) {
+    if (sendto(s, dgram, WIFI_DGRAM, 0, (struct sockaddr*)&to, sizeof(to)) == WIFI_DGRAM) {
+      sent += WIFI_DGRAM;
+    } else if (++stalls > 10000) {
+      break;
+    } else {
+      vTaskDelay(1);                            // out of pbufs / tx queue full
+    }
+  }
+  int64_t us = esp_timer_get_time() - t0;
+  close(s);
+
+  uint32_t ip = ntohl(l.ip);
+  printf("BENCH wifi dst=%u.%u.%u.%u rssi=%d bytes=%u ms=%u kbps=%u stalls=%u\n",
+         (unsigned)(ip >> 24), (unsigned)(ip >> 16 & 0xFF), (unsigned)(ip >> 8 & 0xFF), (unsigned)(ip & 0xFF),
+         sta.sta[best].rssi, (unsigned)sent, (unsigned)(us / 1000),
+         us > 0 ? (unsigned)(sent * 8000ULL / us) : 0, (unsigned)stalls);
+  return sent < total ? "send_failed" : NULL;
+}
+
+// ---------- console command ----------
+
+static const char* benchCmd(int argc, char** argv) {
+  if (argc < 2) {
+    for (int i = 0; i < num_benches; i++) printf("  bench %-6s %s\n", benches[i].name, benches[i].args);
+    return NULL;
+  }
+  for (int i = 0; i < num_benches; i++) {
+    if (strcmp(argv[1], benches[i].name)) continue;
+    int64_t t0 = esp_timer_get_time();
+    const char* err = benches[i].fn(argc - 1, argv + 1);
+    printf("BENCH %s done=%d ms=%u\n", benches[i].name, err ? 0 : 1,
+           (unsigned)((esp_timer_get_time() - t0) / 1000));
+    return err;
+  }
+  return "unknown_bench";
+}
+
+void benchInit() {
+  benchRegister("fb", "sizes=qvga,vga n=20", benchFb);
+  benchRegister("enc", "fmt=rgb565 sizes=qvga,vga n=5 q=80", benchEnc);
+  benchRegister("jpeg", "n=100", benchJpeg);
+  benchRegister("psram", "kb=256", benchPsram);
+  benchRegister("wifi", "kb=1024", benchWifi);
+  consoleRegister("bench", "run a benchmark (no args: list)", benchCmd);
+}
@@ -0,0 +1,245 @@
+/**
+ * Camera ownership (see camera.h). TTGO T-Journal pinout.
+ */
+#include "camera.h"
+
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "cap_timing.h"
+
+// ======= STREAM DEFAULTS (max-ish quality) =======
+framesize_t STREAM_SIZE = FRAMESIZE_UXGA; // 1600x1200 (needs PSRAM)
+int JPEG_QUALITY = 10;                    // lower = better image, bigger size
+int FB_COUNT     = 2;                     // 2 with PSRAM, else 1
+
+// ======= CAMERA PINS: TTGO T-JOURNAL =======
+#define PWDN_GPIO_NUM  32
+#define RESET_GPIO_NUM 15
+#define XCLK_GPIO_NUM  27
+#define SIOD_GPIO_NUM  25
+#define SIOC_GPIO_NUM  23
+#define Y9_GPIO_NUM    19
+#define Y8_GPIO_NUM    36
+#define Y7_GPIO_NUM    18
+#define Y6_GPIO_NUM    39
+#define Y5_GPIO_NUM     5
+#define Y4_GPIO_NUM    34
+#define Y3_GPIO_NUM    35
+#define Y2_GPIO_NUM    17
+#define VSYNC_GPIO_NUM 22
+#define HREF_GPIO_NUM  26
+#define PCLK_GPIO_NUM  21
+
+static camera_config_t config;
+static cam_profile_t   current;
+static SemaphoreHandle_t profile_lock = NULL;
+
+static portMUX_TYPE cam_mux = portMUX_INITIALIZER_UNLOCKED;
+static int  held = 0;                 // frames out of the driver
+static bool switching = false;        // profile switch pending/in progress
+static const char* claimed_by = NULL; // non-stream profile user
+
+static bool hasPsram() {
+  return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+}
+
+static void applySensorDefaults(const cam_profile_t& p) {
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s) return;
+  s->set_framesize(s, p.size);
+  s->set_quality(s, p.quality);
+  if (s->set_colorbar) s->set_colorbar(s, 0);
+  if (s->set_gain_ctrl)     s->set_gain_ctrl(s, 1);
+  if (s->set_exposure_ctrl) s->set_exposure_ctrl(s, 1);
+  if (s->set_whitebal)      s->set_whitebal(s, 1);
+  if (s->set_awb_gain)      s->set_awb_gain(s, 1);
+}
+
+static esp_err_t initWith(const cam_profile_t& p) {
+  config.pixel_format = p.format;
+  config.frame_size   = p.size;
+  config.jpeg_quality = p.quality;
+  config.fb_count     = p.fb_count;
+  esp_err_t err = esp_camera_init(&config);
+  if (err == ESP_OK) {
+    current = p;
+    applySensorDefaults(p);
+  }
+  return err;
+}
+
+cam_profile_t cameraStreamProfile() {
+  cam_profile_t p;
+  p.format = PIXFORMAT_JPEG;
+  if (hasPsram()) {
+    p.size     = STREAM_SIZE;      // UXGA
+    p.quality  = JPEG_QUALITY;     // 10
+    p.fb_count = FB_COUNT;
+  } else {
+    p.size     = FRAMESIZE_SVGA;   // safer without PSRAM
+    p.quality  = 12;
+    p.fb_count = 1;
+  }
+  return p;
+}
+
+cam_profile_t cameraProfile() { return current; }
+
+esp_err_t cameraInit() {
+  if (!profile_lock) profile_lock = xSemaphoreCreateMutex();
+
+  // Ensure sensor is powered up (PWDN LOW)
+  gpio_set_direction((gpio_num_t)PWDN_GPIO_NUM, GPIO_MODE_OUTPUT);
+  gpio_set_level((gpio_num_t)PWDN_GPIO_NUM, 0);
+
+  config.ledc_channel = LEDC_CHANNEL_0;
+  config.ledc_timer   = LEDC_TIMER_0;
+  config.pin_d0       = Y2_GPIO_NUM;
+  config.pin_d1       = Y3_GPIO_NUM;
+  config.pin_d2       = Y4_GPIO_NUM;
+  config.pin_d3       = Y5_GPIO_NUM;
+  config.pin_d4       = Y6_GPIO_NUM;
+  config.pin_d5       = Y7_GPIO_NUM;
+  config.pin_d6       = Y8_GPIO_NUM;
+  config.pin_d7       = Y9_GPIO_NUM;
+  config.pin_xclk     = XCLK_GPIO_NUM;
+  config.pin_pclk     = PCLK_GPIO_NUM;
+  config.pin_vsync    = VSYNC_GPIO_NUM;
+  config.pin_href     = HREF_GPIO_NUM;
+  config.pin_sccb_sda = SIOD_GPIO_NUM;
+  config.pin_sccb_scl = SIOC_GPIO_NUM;
+  config.pin_pwdn     = PWDN_GPIO_NUM;
+  config.pin_reset    = RESET_GPIO_NUM;
+  config.xclk_freq_hz = 16500000;
+  config.fb_location  = hasPsram() ? CAMERA_FB_IN_PSRAM : CAMERA_FB_IN_DRAM;
+
+  esp_err_t err = initWith(cameraStreamProfile());
+  if (err == ESP_OK) capTimingInit(VSYNC_GPIO_NUM);
+  return err;
+}
+
+esp_err_t cameraSetProfile(const cam_profile_t& p, uint32_t timeout_ms) {
+  if (!profile_lock) return ESP_ERR_INVALID_STATE;
+  xSemaphoreTake(profile_lock, portMAX_DELAY);
+
+  cam_profile_t prev = current;
+  if (p.format == prev.format && p.size == prev.size && p.fb_count == prev.fb_count) {
+    // same buffers: quality is a sensor register, no re-init needed
+    sensor_t* s = esp_camera_sensor_get();
+    if (s && p.quality != prev.quality) s->set_quality(s, p.quality);
+    current.quality = p.quality;
+    xSemaphoreGive(profile_lock);
+    return ESP_OK;
+  }
+
+  portENTER_CRITICAL(&cam_mux);
+  switching = true;
+  portEXIT_CRITICAL(&cam_mux);
+
+  // wait for every held frame to come back
+  TickType_t start = xTaskGetTickCount();
+  for (;;) {
+    portENTER_CRITICAL(&cam_mux);
+    int h = held;
+    portEXIT_CRITICAL(&cam_mux);
+    if (h == 0) break;
+    if ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS > timeout_ms) {
+      portENTER_CRITICAL(&cam_mux);
+      switching = false;
+      portEXIT_CRITICAL(&cam_mux);
+      xSemaphoreGive(profile_lock);
+      return ESP_ERR_TIMEOUT;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+
+  esp_camera_deinit();
+  esp_err_t err = initWith(p);
+  if (err != ESP_OK) initWith(prev);
+  capTimingHeld(0, current.fb_count);
+  capTimingReset();
+
+  portENTER_CRITICAL(&cam_mux);
+  switching = false;
+  portEXIT_CRITICAL(&cam_mux);
+  xSemaphoreGive(profile_lock);
+  return err;
+}
+
+esp_err_t cameraRestoreStreamProfile() {
+  return cameraSetProfile(cameraStreamProfile());
+}
+
+bool cameraClaim(const char* owner, const char** holder) {
+  portENTER_CRITICAL(&cam_mux);
+  const char* cur = claimed_by;
+  if (!cur) claimed_by = owner;
+  portEXIT_CRITICAL(&cam_mux);
+  if (holder) *holder = cur;
+  return cur == NULL;
+}
+
+void cameraRelease() {
+  portENTER_CRITICAL(&cam_mux);
+  claimed_by = NULL;
+  portEXIT_CRITICAL(&cam_mux);
+}
+
+bool cameraClaimed() {
+  return claimed_by != NULL;
+}
+
+static const struct { const char* name; framesize_t size; } SIZE_NAMES[] = {
+  {"96x96", FRAMESIZE_96X96}, {"qqvga", FRAMESIZE_QQVGA}, {"qcif", FRAMESIZE_QCIF},
+  {"hqvga", FRAMESIZE_HQVGA}, {"240x240", FRAMESIZE_240X240}, {"qvga", FRAMESIZE_QVGA},
+  {"cif", FRAMESIZE_CIF}, {"hvga", FRAMESIZE_HVGA}, {"vga", FRAMESIZE_VGA},
+  {"svga", FRAMESIZE_SVGA}, {"xga", FRAMESIZE_XGA}, {"hd", FRAMESIZE_HD},
+  {"sxga", FRAMESIZE_SXGA}, {"uxga", FRAMESIZE_UXGA},
+};
+
+framesize_t cameraFramesize(const char* name) {
+  for (auto& e : SIZE_NAMES) if (!strcmp(name, e.name)) return e.size;
+  return FRAMESIZE_INVALID;
+}
+
+const char* cameraFramesizeName(framesize_t size) {
+  for (auto& e : SIZE_NAMES) if (e.size == size) return e.name;
+  return "?";
+}
+
+camera_fb_t* camFbGet() {
+  for (;;) {
+    portENTER_CRITICAL(&cam_mux);
+    bool ok = !switching;
+    if (ok) held++;
+    portEXIT_CRITICAL(&cam_mux);
+    if (ok) capTimingHeld(held, current.fb_count);
+    if (ok) break;
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+
+  camera_fb_t* fb = esp_camera_fb_get();
+  if (!fb) {
+    portENTER_CRITICAL(&cam_mux);
+    held--;
+    portEXIT_CRITICAL(&cam_mux);
+    capTimingHeld(held, current.fb_count);
+  } else {
+    capTimingFrame(fb);
+  }
+  return fb;
+}
+
+void camFbReturn(camera_fb_t* fb) {
+  if (!fb) return;
+  esp_camera_fb_return(fb);
+  portENTER_CRITICAL(&cam_mux);
+  held--;
+  portEXIT_CRITICAL(&cam_mux);
+  capTimingHeld(held, current.fb_count);
+}
@@ -0,0 +1,246 @@
+/**
+ * Capture-side timing (see cap_timing.h).
+ *
+ * The VSYNC ring has a single writer (the capture ISR) and publishes by
+ * bumping vs_head. The frame ring can be written by any task: a slot is
+ * claimed with an atomic increment and its seq is set last, so readers
+ * drop slots that were being rewritten while they copied them.
+ *
+ * fb->timestamp comes from gettimeofday(), which runs on the esp_timer
+ * clock since boot as long as nothing sets the time (no SNTP on the AP).
+ */
+#include "cap_timing.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "driver/mcpwm.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#define APB_TICKS_PER_US  80
+#define READ_MARGIN       8       // edges the ISR may add while a reader copies
+#define MATCH_SLACK_US    5000    // driver timestamps a frame shortly after its edge
+
+struct VsyncEdge {
+  int64_t  t_us;
+  uint32_t ticks;                 // capture timer (APB clock), exact period
+  bool     all_held;
+};
+
+struct FrameRec {
+  uint32_t seq;                   // ring index + 1 once complete, 0 while written
+  int64_t  start_us;              // fb->timestamp
+  int64_t  got_us;
+};
+
+static VsyncEdge vs_ring[CAP_TIMING_VSYNC_RING];
+static volatile uint32_t vs_head = 0;
+static volatile uint32_t vs_overruns = 0;
+static volatile int fb_held = 0;
+static volatile int fb_total = 1;
+
+static FrameRec fr_ring[CAP_TIMING_FRAME_RING];
+static uint32_t fr_head = 0;
+
+static volatile int64_t since_us = 0;     // last reset (profile switch)
+static bool started = false;
+
+static bool IRAM_ATTR onVsync(mcpwm_unit_t unit, mcpwm_capture_channel_id_t ch,
+                              const cap_event_data_t* ev, void* arg) {
+  (void)unit; (void)ch; (void)arg;
+  uint32_t h = vs_head;
+  VsyncEdge& e = vs_ring[h & (CAP_TIMING_VSYNC_RING - 1)];
+  e.t_us = esp_timer_get_time();
+  e.ticks = ev->cap_value;
+  e.all_held = fb_held >= fb_total;
+  if (e.all_held) vs_overruns++;
+  __atomic_store_n(&vs_head, h + 1, __ATOMIC_RELEASE);
+  return false;
+}
+
+void capTimingInit(int vsync_gpio) {
+  if (started) return;
+  mcpwm_capture_config_t c = {};
+  c.cap_edge = MCPWM_NEG_EDGE;              // the edge the driver starts a frame on
+  c.cap_prescale = 1;
+  c.capture_cb = onVsync;
+  c.user_data = NULL;
+  esp_err_t err = mcpwm_gpio_init(MCPWM_UNIT_0, MCPWM_CAP_0, vsync_gpio);
+  if (err == ESP_OK) err = mcpwm_capture_enable_channel(MCPWM_UNIT_0, MCPWM_SELECT_CAP0, &c);
+  started = err == ESP_OK;
+  since_us = esp_timer_get_time();
+  printf("cap_timing: VSYNC capture on GPIO%d %s\n", vsync_gpio, started ? "ok" : esp_err_to_name(err));
+}
+
+void capTimingHeld(int held, int fb_count) {
+  fb_held = held;
+  fb_total = fb_count > 0 ? fb_count : 1;
+}
+
+void capTimingFrame(const camera_fb_t* fb) {
+  uint32_t i = __atomic_fetch_add(&fr_head, 1, __ATOMIC_RELAXED);
+  FrameRec& r = fr_ring[i & (CAP_TIMING_FRAME_RING - 1)];
+  __atomic_store_n(&r.seq, 0, __ATOMIC_RELAXED);
+  r.start_us = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+  r.got_us = esp_timer_get_time();
+  __atomic_store_n(&r.seq, i + 1, __ATOMIC_RELEASE);
+}
+
+void capTimingReset() {
+  since_us = esp_timer_get_time();
+}
+
+// ---------- snapshot + analysis ----------
+
+struct Snapshot {
+  VsyncEdge edge[CAP_TIMING_VSYNC_RING];
+  int       nedge;
+  FrameRec  frame[CAP_TIMING_FRAME_RING];
+  int       nframe;
+  int       match[CAP_TIMING_FRAME_RING];    // edge index that started the frame, -1 = none
+};
+
+static void takeSnapshot(Snapshot* s) {
+  int64_t since = since_us;
+
+  uint32_t h = __atomic_load_n(&vs_head, __ATOMIC_ACQUIRE);
+  uint32_t n = h < CAP_TIMING_VSYNC_RING - READ_MARGIN ? h : CAP_TIMING_VSYNC_RING - READ_MARGIN;
+  s->nedge = 0;
+  for (uint32_t i = h - n; i != h; i++) {
+    const VsyncEdge& e = vs_ring[i & (CAP_TIMING_VSYNC_RING - 1)];
+    if (e.t_us >= since) s->edge[s->nedge++] = e;
+  }
+  if (__atomic_load_n(&vs_head, __ATOMIC_ACQUIRE) - h > READ_MARGIN) s->nedge = 0;   // lapped, give up
+
+  uint32_t fh = __atomic_load_n(&fr_head, __ATOMIC_ACQUIRE);
+  uint32_t fn = fh < CAP_TIMING_FRAME_RING ? fh : CAP_TIMING_FRAME_RING;
+  s->nframe = 0;
+  for (uint32_t i = fh - fn; i != fh; i++) {
+    const FrameRec& r = fr_ring[i & (CAP_TIMING_FRAME_RING - 1)];
+    if (__atomic_load_n(&r.seq, __ATOMIC_ACQUIRE) != i + 1) continue;
+    FrameRec copy = r;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&r.seq, __ATOMIC_RELAXED) != i + 1 || copy.got_us < since) continue;
+    s->frame[s->nframe++] = copy;
+  }
+
+  // Match each frame to the last edge at or shortly before its timestamp.
+  for (int f = 0; f < s->nframe; f++) {
+    s->match[f] = -1;
+    int64_t t = s->frame[f].start_us;
+    for (int e = s->nedge - 1; e >= 0; e--) {
+      if (s->edge[e].t_us > t + MATCH_SLACK_US) continue;
+      if (t - s->edge[e].t_us < MATCH_SLACK_US) s->match[f] = e;
+      break;
+    }
+  }
+}
+
+static void analyse(const Snapshot* s, cap_timing_stats_t* o) {
+  memset(o, 0, sizeof(*o));
+  o->total_edges = vs_head;
+  o->total_overruns = vs_overruns;
+  if (s->nedge < 2) return;
+
+  uint64_t sum = 0, sq = 0;
+  uint32_t pmin = UINT32_MAX, pmax = 0;
+  for (int i = 1; i < s->nedge; i++) {
+    uint32_t p = (s->edge[i].ticks - s->edge[i - 1].ticks) / APB_TICKS_PER_US;
+    sum += p;
+    sq += (uint64_t)p * p;
+    if (p < pmin) pmin = p;
+    if (p > pmax) pmax = p;
+    if (s->edge[i].all_held) o->overruns++;
+  }
+  uint32_t np = s->nedge - 1;
+  int64_t span = s->edge[s->nedge - 1].t_us - s->edge[0].t_us;
+  float mean = (float)sum / np;
+  float var = (float)sq / np - mean * mean;
+  o->window_ms = (uint32_t)(span / 1000);
+  o->edges = s->nedge;
+  o->period_us = (uint32_t)mean;
+  o->jitter_us = (uint32_t)sqrtf(var > 0 ? var : 0);
+  o->period_min_us = pmin;
+  o->period_max_us = pmax;
+  o->sensor_fps = mean > 0 ? 1e6f / mean : 0;
+
+  int first = -1, last = -1, matched = 0;
+  uint64_t qsum = 0;
+  uint32_t qn = 0;
+  for (int f = 0; f < s->nframe; f++) {
+    const FrameRec& r = s->frame[f];
+    if (r.got_us >= s->edge[0].t_us && r.got_us <= s->edge[s->nedge - 1].t_us) o->frames++;
+    int e = s->match[f];
+    if (e < 0) continue;
+    matched++;
+    if (first < 0 || e < first) first = e;
+    if (e > last) last = e;
+    if (e + 1 < s->nedge && r.got_us >= s->edge[e + 1].t_us) {
+      uint32_t q = (uint32_t)(r.got_us - s->edge[e + 1].t_us);
+      qsum += q;
+      qn++;
+      if (q > o->queue_max_us) o->queue_max_us = q;
+    }
+  }
+  if (matched && last - first + 1 > matched) {
+    o->skipped = last - first + 1 - matched;
+    o->skip_pct = 100.0f * o->skipped / (last - first + 1);
+  }
+  o->overrun_pct = 100.0f * o->overruns / np;
+  o->queue_avg_us = qn ? (uint32_t)(qsum / qn) : 0;
+  o->capture_fps = span > 0 ? o->frames * 1e6f / span : 0;
+}
+
+bool capTimingStats(cap_timing_stats_t* out) {
+  Snapshot* s = (Snapshot*)malloc(sizeof(Snapshot));
+  if (!s) return false;
+  takeSnapshot(s);
+  analyse(s, out);
+  bool ok = s->nedge >= 2;
+  free(s);
+  return ok;
+}
+
+size_t capTimingJson(char* buf, size_t len, int frames) {
+  Snapshot* s = (Snapshot*)malloc(sizeof(Snapshot));
+  if (!s) return snprintf(buf, len, "{\"error\":\"no_mem\"}");
+  takeSnapshot(s);
+  cap_timing_stats_t st;
+  analyse(s, &st);
+
+  int n = snprintf(buf, len,
+    "{\"vsync_capture\":%s,\"window_ms\":%u,\"edges\":%u,\"sensor_fps\":%.2f,"
+    "\"period_us\":%u,\"jitter_us\":%u,\"period_min_us\":%u,\"period_max_us\":%u,"
+    "\"frames\":%u,\"capture_fps\":%.2f,\"skipped\":%u,\"skip_pct\":%.1f,"
+    "\"overruns\":%u,\"overrun_pct\":%.1f,\"queue_avg_us\":%u,\"queue_max_us\":%u,"
+    "\"total_edges\":%u,\"total_overruns\":%u",
+    started ? "true" : "false", (unsigned)st.window_ms, (unsigned)st.edges, st.sensor_fps,
+    (unsigned)st.period_us, (unsigned)st.jitter_us, (unsigned)st.period_min_us,
+    (unsigned)st.period_max_us, (unsigned)st.frames, st.capture_fps, (unsigned)st.skipped,
+    st.skip_pct, (unsigned)st.overruns, st.overrun_pct,
+    (unsigned)st.queue_avg_us, (unsigned)st.queue_max_us,
+    (unsigned)st.total_edges, (unsigned)st.total_overruns);
+
+  if (frames > 32) frames = 32;
+  if (frames > 0 && n < (int)len) {
+    n += snprintf(buf + n, len - n, ",\"recent\":[");
+    int f0 = s->nframe > frames ? s->nframe - frames : 0;
+    int prev = f0 > 0 ? s->match[f0 - 1] : -1;
+    for (int f = f0; f < s->nframe && n < (int)len; f++) {
+      const FrameRec& r = s->frame[f];
+      int e = s->match[f];
+      long long done = e >= 0 && e + 1 < s->nedge ? s->edge[e + 1].t_us : -1;
+      n += snprintf(buf + n, len - n, "%s{\"start_us\":%lld,\"done_us\":%lld,\"got_us\":%lld,\"skipped_before\":%d}",
+                    f > f0 ? "," : "", (long long)(e >= 0 ? s->edge[e].t_us : r.start_us), done,
+                    (long long)r.got_us, e >= 0 && prev >= 0 && e > prev ? e - prev - 1 : 0);
+      if (e >= 0) prev = e;
+    }
+    if (n < (int)len) n += snprintf(buf + n, len - n, "]");
+  }
+  if (n < (int)len) n += snprintf(buf + n, len - n, "}");
+  free(s);
+  return n < (int)len ? n : len - 1;
+}
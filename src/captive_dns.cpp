@@ -0,0 +1,161 @@
+/**
+ * Selective DNS responder + HTTP fast path (see captive_dns.h).
+ *
+ * The socket is non-blocking and drained from loop(), like the DNSServer it
+ * replaces. Counters have one writer per group (loop() for DNS, the httpd
+ * task for HTTP); the blocked-name table is shared with the JSON reader
+ * under a spinlock.
+ */
+#include "captive_dns.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+
+#include "dns_answer.h"
+
+#define DNS_PORT         53
+#define DRAIN_MAX        8          // queries answered per loop() pass
+#define BLOCKED_SLOTS    8          // most-asked NXDOMAIN names kept for /dns
+#define NAME_MAX_SHOWN   48
+
+struct DnsCounters {
+  uint32_t queries;
+  uint32_t answered, nodata, nxdomain, refused, dropped;
+  uint32_t captive;                 // answered for a captive-check host
+  uint32_t http_captive;            // probes redirected to the UI
+  uint32_t http_rejected;           // foreign-host requests closed at once
+};
+
+struct BlockedName {
+  char     name[NAME_MAX_SHOWN];
+  uint32_t count;
+};
+
+static int          sock = -1;
+static uint8_t      ap_ip[4];
+static char         ap_ip_str[16];
+static DnsCounters  ctr;
+static BlockedName  blocked[BLOCKED_SLOTS];
+static portMUX_TYPE blocked_mux = portMUX_INITIALIZER_UNLOCKED;
+
+bool captiveDnsStart(const uint8_t ip[4]) {
+  memcpy(ap_ip, ip, 4);
+  snprintf(ap_ip_str, sizeof(ap_ip_str), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) return false;
+  struct sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(DNS_PORT);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(sock, (struct sockaddr*)&a, sizeof(a)) < 0) {
+    close(sock);
+    sock = -1;
+    return false;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+  return true;
+}
+
+// Count a refused name. A new name takes over the least-asked slot and its
+// count + 1 (space-saving: the busiest names stay, counts are upper bounds).
+static void noteBlocked(const char* name) {
+  portENTER_CRITICAL(&blocked_mux);
+  int victim = 0;
+  for (int i = 0; i < BLOCKED_SLOTS; i++) {
+    if (blocked[i].count && !strcmp(blocked[i].name, name)) {
+      blocked[i].count++;
+      portEXIT_CRITICAL(&blocked_mux);
+      return;
+    }
+    if (blocked[i].count < blocked[victim].count) victim = i;
+  }
+  strncpy(blocked[victim].name, name, NAME_MAX_SHOWN - 1);
+  blocked[victim].name[NAME_MAX_SHOWN - 1] = 0;
+  blocked[victim].count++;
+  portEXIT_CRITICAL(&blocked_mux);
+}
+
+void captiveDnsLoop() {
+  if (sock < 0) return;
+  uint8_t q[DNS_PACKET_MAX], out[DNS_PACKET_MAX];
+  for (int i = 0; i < DRAIN_MAX; i++) {
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    int n = recvfrom(sock, q, sizeof(q), MSG_DONTWAIT, (struct sockaddr*)&from, &from_len);
+    if (n <= 0) return;
+
+    dns_verdict_t v;
+    dns_name_class_t cls;
+    char name[NAME_MAX_SHOWN];
+    size_t len = dnsAnswer(q, n, ap_ip, out, sizeof(out), &v, &cls, name, sizeof(name));
+    ctr.queries++;
+    switch (v) {
+      case DNS_V_ANSWER:   ctr.answered++; if (cls == DNS_NAME_CAPTIVE) ctr.captive++; break;
+      case DNS_V_NODATA:   ctr.nodata++; break;
+      case DNS_V_NXDOMAIN: ctr.nxdomain++; noteBlocked(name); break;
+      case DNS_V_REFUSED:  ctr.refused++; break;
+      case DNS_V_DROP:     ctr.dropped++; break;
+    }
+    if (len) sendto(sock, out, len, 0, (struct sockaddr*)&from, from_len);
+  }
+}
+
+// ---------- HTTP fast path ----------
+
+static esp_err_t onUnknown(httpd_req_t* req, httpd_err_code_t err) {
+  char host[64] = "";
+  httpd_req_get_hdr_value_str(req, "Host", host, sizeof(host));
+  size_t ip_len = strlen(ap_ip_str);
+  bool ours = !host[0] || (!strncmp(host, ap_ip_str, ip_len) && (!host[ip_len] || host[ip_len] == ':'));
+  dns_name_class_t cls = ours ? DNS_NAME_OWN : dnsClassifyName(host);
+
+  if (cls == DNS_NAME_OWN) {                  // a real 404/405 from our own UI
+    httpd_resp_send_err(req, err, NULL);
+    return ESP_OK;
+  }
+  httpd_resp_set_hdr(req, "Connection", "close");
+  if (cls == DNS_NAME_CAPTIVE) {
+    ctr.http_captive++;
+    httpd_resp_set_status(req, "302 Found");
+    httpd_resp_set_hdr(req, "Location", "http://nozzlecam/");
+  } else {
+    ctr.http_rejected++;
+    httpd_resp_set_status(req, "404 Not Found");
+  }
+  httpd_resp_send(req, NULL, 0);
+  return ESP_FAIL;                            // close the socket now
+}
+
+void captiveHttpInstall(httpd_handle_t server) {
+  httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, onUnknown);
+  httpd_register_err_handler(server, HTTPD_405_METHOD_NOT_ALLOWED, onUnknown);
+}
+
+size_t captiveDnsJson(char* buf, size_t len) {
+  DnsCounters c = ctr;
+  int n = snprintf(buf, len,
+    "{\"running\":%s,\"queries\":%u,\"answered\":%u,\"captive\":%u,\"nodata\":%u,"
+    "\"nxdomain\":%u,\"refused\":%u,\"dropped\":%u,\"negative_ttl_s\":%d,"
+    "\"http_captive\":%u,\"http_rejected\":%u,\"blocked\":[",
+    sock >= 0 ? "true" : "false", (unsigned)c.queries, (unsigned)c.answered, (unsigned)c.captive,
+    (unsigned)c.nodata, (unsigned)c.nxdomain, (unsigned)c.refused, (unsigned)c.dropped,
+    DNS_NEGATIVE_TTL, (unsigned)c.http_captive, (unsigned)c.http_rejected);
+
+  BlockedName snap[BLOCKED_SLOTS];
+  portENTER_CRITICAL(&blocked_mux);
+  memcpy(snap, blocked, sizeof(snap));
+  portEXIT_CRITICAL(&blocked_mux);
+  bool first = true;
+  for (int i = 0; i < BLOCKED_SLOTS && n < (int)len; i++) {
+    if (!snap[i].count) continue;
+    for (char* p = snap[i].name; *p; p++)      // names are raw bytes from the network
+      if (*p == '"' || *p == '\\' || (unsigned char)*p < 0x20 || (unsigned char)*p > 0x7E) *p = '_';
+    n += snprintf(buf + n, len - n, "%s{\"name\":\"%s\",\"count\":%u}", first ? "" : ",",
+                  snap[i].name, (unsigned)snap[i].count);
+    first = false;
+  }
+  if (n < (int)len) n += snprintf(buf + n, len - n, "]}");
+  return n < (int)len ? n : len - 1;
+}
@@ -0,0 +1,112 @@
+/**
+ * Serial command console (see console.h).
+ */
+#include "console.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "http_stream.h"
+#include "qos.h"
+
+struct ConsoleCmd {
+  const char*    name;
+  const char*    help;
+  console_cmd_fn fn;
+};
+
+static ConsoleCmd    cmds[CONSOLE_MAX_CMDS];
+static int           num_cmds = 0;
+static QueueHandle_t lines = NULL;
+static char          rx[CONSOLE_LINE_MAX];
+static size_t        rx_len = 0;
+static bool          rx_overflow = false;
+
+bool consoleRegister(const char* name, const char* help, console_cmd_fn fn) {
+  if (num_cmds >= CONSOLE_MAX_CMDS) return false;
+  cmds[num_cmds++] = { name, help, fn };
+  return true;
+}
+
+const char* consoleArg(int argc, char** argv, const char* key, const char* def) {
+  size_t n = strlen(key);
+  for (int i = 1; i < argc; i++)
+    if (!strncmp(argv[i], key, n) && argv[i][n] == '=') return argv[i] + n + 1;
+  return def;
+}
+
+int consoleArgInt(int argc, char** argv, const char* key, int def) {
+  const char* v = consoleArg(argc, argv, key, NULL);
+  return v ? atoi(v) : def;
+}
+
+void consoleFeed(char c) {
+  if (c == '\r' || c == '\n') {
+    if (rx_overflow) printf("ERR - line_too_long\n");
+    else if (rx_len && lines) {
+      rx[rx_len] = 0;
+      if (xQueueSend(lines, rx, 0) != pdTRUE) printf("ERR - busy\n");
+    }
+    rx_len = 0;
+    rx_overflow = false;
+  } else if (c == '\b' || c == 0x7F) {
+    if (rx_len) rx_len--;
+  } else if (rx_len < CONSOLE_LINE_MAX - 1) {
+    rx[rx_len++] = c;
+  } else {
+    rx_overflow = true;
+  }
+}
+
+static const char* helpCmd(int, char**) {
+  for (int i = 0; i < num_cmds; i++) printf("  %-8s %s\n", cmds[i].name, cmds[i].help);
+  return NULL;
+}
+
+static const char* statusCmd(int, char**) {
+  printf("STATUS uptime_s=%u heap=%u heap_min=%u psram_free=%u fps=%.1f kBps=%u streams=%d\n",
+         (unsigned)(esp_timer_get_time() / 1000000),
+         (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+         (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+         (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+         qosStreamFps(), (unsigned)(qosStreamBytesPerSec() / 1024), httpStreamActive());
+  return NULL;
+}
+
+static void run(char* line) {
+  char* argv[CONSOLE_MAX_ARGS];
+  int argc = 0;
+  for (char* tok = strtok(line, " \t"); tok && argc < CONSOLE_MAX_ARGS; tok = strtok(NULL, " \t"))
+    argv[argc++] = tok;
+  if (!argc) return;
+
+  for (int i = 0; i < num_cmds; i++) {
+    if (strcmp(argv[0], cmds[i].name)) continue;
+    const char* err = cmds[i].fn(argc, argv);
+    if (err) printf("ERR %s %s\n", argv[0], err);
+    else printf("OK %s\n", argv[0]);
+    return;
+  }
+  printf("ERR %s unknown_command\n", argv[0]);
+}
+
+static void consoleTask(void*) {
+  char line[CONSOLE_LINE_MAX];
+  for (;;) {
+    if (xQueueReceive(lines, line, portMAX_DELAY) == pdTRUE) run(line);
+  }
+}
+
+void consoleInit() {
+  consoleRegister("help", "list commands", helpCmd);
+  consoleRegister("status", "uptime, heap, stream rate", statusCmd);
+  lines = xQueueCreate(4, CONSOLE_LINE_MAX);
+  // Priority 1: only idle is lower, so the stream and httpd always win.
+  xTaskCreate(consoleTask, "console", 6144, NULL, 1, NULL);
+}
@@ -0,0 +1,168 @@
+/**
+ * Selective DNS answers (see dns_answer.h).
+ *
+ * Replies copy the header ID, the RD flag and the question verbatim; EDNS
+ * OPT records in the query are ignored (the reply has none, which every
+ * resolver accepts). Names are never compressed in the query we parse, and
+ * the only pointer we emit is 0xC00C to the question name.
+ */
+#include "dns_answer.h"
+
+#include <string.h>
+
+#define TYPE_A     1
+#define TYPE_SOA   6
+#define TYPE_ANY   255
+#define CLASS_IN   1
+
+#define RCODE_NOERROR   0
+#define RCODE_FORMERR   1
+#define RCODE_NXDOMAIN  3
+#define RCODE_NOTIMP    4
+
+static const char* const OWN_NAMES[] = {
+  "nozzlecam", "nozzlecam.local", "nozzcam", "nozzcam.local",
+};
+
+// Hosts the common OSes probe to detect captive portals / internet access.
+static const char* const CAPTIVE_NAMES[] = {
+  "connectivitycheck.gstatic.com", "connectivitycheck.android.com",
+  "clients1.google.com", "clients3.google.com", "www.google.com",     // Android, ChromeOS
+  "captive.apple.com", "www.apple.com", "www.appleiphonecell.com",    // iOS, macOS
+  "www.msftconnecttest.com", "www.msftncsi.com", "dns.msftncsi.com",   // Windows
+  "ipv6.msftconnecttest.com",
+  "detectportal.firefox.com",                                          // Firefox
+  "nmcheck.gnome.org", "network-test.debian.org",                      // NetworkManager
+  "connectivity-check.ubuntu.com",
+};
+
+static bool nameEquals(const char* name, size_t n, const char* ref) {
+  size_t i = 0;
+  for (; i < n && ref[i]; i++) {
+    char c = name[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    if (c != ref[i]) return false;
+  }
+  return i == n && !ref[i];
+}
+
+dns_name_class_t dnsClassifyName(const char* name) {
+  size_t n = 0;
+  while (name[n] && name[n] != ':') n++;
+  if (n && name[n - 1] == '.') n--;
+  for (const char* own : OWN_NAMES)
+    if (nameEquals(name, n, own)) return DNS_NAME_OWN;
+  for (const char* cap : CAPTIVE_NAMES)
+    if (nameEquals(name, n, cap)) return DNS_NAME_CAPTIVE;
+  return DNS_NAME_OTHER;
+}
+
+static inline uint8_t* put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+  return p + 2;
+}
+
+static inline uint8_t* put32(uint8_t* p, uint32_t v) {
+  p = put16(p, (uint16_t)(v >> 16));
+  return put16(p, (uint16_t)v);
+}
+
+// SOA for the root zone: tells the client how long to cache the negative answer.
+static uint8_t* putSoa(uint8_t* base, uint8_t* p) {
+  static const uint8_t MNAME[] = { 9, 'n', 'o', 'z', 'z', 'l', 'e', 'c', 'a', 'm', 0 };
+  *p++ = 0;                                   // owner: root
+  p = put16(p, TYPE_SOA);
+  p = put16(p, CLASS_IN);
+  p = put32(p, DNS_NEGATIVE_TTL);
+  p = put16(p, (uint16_t)(sizeof(MNAME) + 2 + 5 * 4));
+  uint16_t mname_at = (uint16_t)(p - base);
+  memcpy(p, MNAME, sizeof(MNAME));            // primary server
+  p += sizeof(MNAME);
+  p = put16(p, 0xC000 | mname_at);            // responsible mailbox: same name
+  p = put32(p, 1);                            // serial
+  p = put32(p, 3600);                         // refresh
+  p = put32(p, 600);                          // retry
+  p = put32(p, 86400);                        // expire
+  return put32(p, DNS_NEGATIVE_TTL);          // minimum = negative TTL
+}
+
+#define SOA_BYTES (1 + 10 + 11 + 2 + 5 * 4)
+
+size_t dnsAnswer(const uint8_t* q, size_t len, const uint8_t ip[4],
+                 uint8_t* out, size_t cap, dns_verdict_t* verdict,
+                 dns_name_class_t* cls, char* qname, size_t qname_len) {
+  *verdict = DNS_V_DROP;
+  *cls = DNS_NAME_OTHER;
+  if (qname && qname_len) qname[0] = 0;
+  if (len < 12 || (q[2] & 0x80)) return 0;    // too short, or a response
+
+  uint8_t opcode = (q[2] >> 3) & 0x0F;
+  uint16_t qdcount = (uint16_t)(q[4] << 8 | q[5]);
+
+  // Question: labels up to the root, then type and class.
+  char name[256];
+  size_t nlen = 0, i = 12;
+  bool ok = qdcount == 1;
+  while (ok && i < len && q[i]) {
+    uint8_t l = q[i++];
+    ok = l < 64 && i + l <= len && nlen + l + 1 < sizeof(name);
+    for (uint8_t k = 0; ok && k < l; k++) {
+      char c = (char)q[i + k];
+      name[nlen++] = c == '.' || c == 0 ? '_' : c;
+    }
+    name[nlen++] = '.';
+    i += l;
+  }
+  ok = ok && i + 5 <= len;
+  size_t qend = i + 5;                        // root label + type + class
+  if (nlen) nlen--;                           // no trailing dot
+  name[nlen] = 0;
+  if (qname && qname_len) {
+    size_t n = nlen < qname_len - 1 ? nlen : qname_len - 1;
+    memcpy(qname, name, n);
+    qname[n] = 0;
+  }
+
+  size_t need = (ok ? qend : 12) + 16 + SOA_BYTES;
+  if (cap < need) return 0;
+  memcpy(out, q, 12);
+  out[2] = (uint8_t)(0x80 | (opcode << 3) | 0x04 | (q[2] & 0x01));   // QR, AA, RD echoed
+  out[3] = 0;                                 // RA = 0
+  memset(out + 6, 0, 6);                      // AN, NS, AR
+
+  if (opcode != 0 || !ok) {
+    out[3] = opcode != 0 ? RCODE_NOTIMP : RCODE_FORMERR;
+    out[4] = out[5] = 0;                      // no question echoed
+    *verdict = DNS_V_REFUSED;
+    return 12;
+  }
+
+  memcpy(out + 12, q + 12, qend - 12);
+  uint8_t* p = out + qend;
+  uint16_t qtype = (uint16_t)(q[i + 1] << 8 | q[i + 2]);
+  uint16_t qclass = (uint16_t)(q[i + 3] << 8 | q[i + 4]);
+  *cls = dnsClassifyName(name);
+
+  if (*cls == DNS_NAME_OTHER) {
+    out[3] = RCODE_NXDOMAIN;
+    out[9] = 1;                               // NSCOUNT
+    p = putSoa(out, p);
+    *verdict = DNS_V_NXDOMAIN;
+  } else if ((qtype == TYPE_A || qtype == TYPE_ANY) && qclass == CLASS_IN) {
+    out[7] = 1;                               // ANCOUNT
+    p = put16(p, 0xC00C);                     // -> question name
+    p = put16(p, TYPE_A);
+    p = put16(p, CLASS_IN);
+    p = put32(p, DNS_ANSWER_TTL);
+    p = put16(p, 4);
+    memcpy(p, ip, 4);
+    p += 4;
+    *verdict = DNS_V_ANSWER;
+  } else {
+    out[9] = 1;
+    p = putSoa(out, p);
+    *verdict = DNS_V_NODATA;
+  }
+  return (size_t)(p - out);
+}
@@ -0,0 +1,140 @@
+/**
+ * Two-core JPEG encoding (see encoder.h).
+ *
+ * Both strips go to the pinned encoder tasks (the caller only waits), so the
+ * split lands on both cores whichever core the caller happens to run on.
+ * Core 0 also runs Wi-Fi and lwIP, so its strip can finish a little later;
+ * the split stays at half the MCU rows each, restart markers make any split
+ * valid but the output order fixed.
+ */
+#include "encoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "jpeg_enc.h"
+#include "psram.h"
+
+#define MIN_SPLIT_ROWS  16          // MCU rows; below that (QQVGA and smaller) the hand-off doesn't pay
+#define WORKER_STACK    3072
+#define WORKER_PRIO     5           // same as the stream tasks
+
+struct Strip {
+  const jpeg_enc_t* enc;
+  const uint8_t*    src;
+  int               row0, row1;
+  uint8_t*          buf;
+  long              len;            // -1 = failed
+};
+
+static TaskHandle_t      workers[2] = { NULL, NULL };
+static SemaphoreHandle_t done[2];
+static SemaphoreHandle_t busy = NULL;     // one two-core encode at a time
+static Strip             jobs[2];
+
+// Typical frames need well under 1/2 byte per pixel; retry with room for
+// noise at top quality rather than reserving that up front.
+static void encodeStrip(Strip* s) {
+  size_t px = (size_t)(s->row1 - s->row0) * 8 * s->enc->width;
+  const size_t caps[2] = { px / 2 + 1024, px * 3 + 1024 };
+  s->len = -1;
+  for (int i = 0; i < 2 && s->len < 0; i++) {
+    s->buf = (uint8_t*)psAlloc(caps[i]);
+    if (!s->buf) return;
+    s->len = jpegEncRows(s->enc, s->src, s->row0, s->row1, s->buf, caps[i]);
+    if (s->len < 0) { free(s->buf); s->buf = NULL; }
+  }
+}
+
+static void workerTask(void* arg) {
+  int id = (int)(intptr_t)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    encodeStrip(&jobs[id]);
+    xSemaphoreGive(done[id]);
+  }
+}
+
+void encoderInit() {
+  if (busy) return;
+  busy = xSemaphoreCreateMutex();
+  for (int i = 0; i < 2; i++) {
+    done[i] = xSemaphoreCreateBinary();
+    char name[12];
+    snprintf(name, sizeof(name), "jpeg_enc%d", i);
+    if (xTaskCreatePinnedToCore(workerTask, name, WORKER_STACK, (void*)(intptr_t)i,
+                                WORKER_PRIO, &workers[i], i) != pdPASS) {
+      workers[i] = NULL;
+    }
+  }
+}
+
+static bool encFormat(pixformat_t format, jpeg_enc_format_t* out) {
+  switch (format) {
+    case PIXFORMAT_GRAYSCALE: *out = JPEG_ENC_GRAY;   return true;
+    case PIXFORMAT_YUV422:    *out = JPEG_ENC_YUV422; return true;
+    case PIXFORMAT_RGB565:    *out = JPEG_ENC_RGB565; return true;
+    case PIXFORMAT_RGB888:    *out = JPEG_ENC_RGB888; return true;
+    default:                  return false;
+  }
+}
+
+bool encodeJpeg(const uint8_t* src, size_t len, int width, int height, pixformat_t format,
+                int quality, uint8_t** out, size_t* out_len, int strips) {
+  *out = NULL;
+  *out_len = 0;
+  jpeg_enc_format_t f;
+  jpeg_enc_t enc;
+  if (!encFormat(format, &f) || !jpegEncInit(&enc, width, height, f, quality)) return false;
+  if (len < (size_t)width * height * jpegEncBytesPerPixel(f)) return false;
+
+  bool split = (strips == 2 || (strips == 0 && enc.mcus_y >= MIN_SPLIT_ROWS)) &&
+               workers[0] && workers[1] && enc.mcus_y >= 2 &&
+               xSemaphoreTake(busy, 0) == pdTRUE;
+  Strip part[2];
+  int n = split ? 2 : 1;
+  if (split) {
+    int mid = enc.mcus_y / 2;
+    jobs[0] = { &enc, src, 0, mid, NULL, -1 };
+    jobs[1] = { &enc, src, mid, enc.mcus_y, NULL, -1 };
+    xTaskNotifyGive(workers[0]);
+    xTaskNotifyGive(workers[1]);
+    xSemaphoreTake(done[0], portMAX_DELAY);
+    xSemaphoreTake(done[1], portMAX_DELAY);
+    part[0] = jobs[0];
+    part[1] = jobs[1];
+    xSemaphoreGive(busy);
+  } else {
+    part[0] = { &enc, src, 0, enc.mcus_y, NULL, -1 };
+    encodeStrip(&part[0]);
+  }
+
+  bool ok = true;
+  size_t total = JPEG_ENC_HEADER_MAX + 2;
+  for (int i = 0; i < n; i++) {
+    if (part[i].len < 0) ok = false;
+    else total += part[i].len;
+  }
+  uint8_t* jpg = ok ? (uint8_t*)psAlloc(total) : NULL;
+  if (jpg) {
+    size_t pos = jpegEncHeader(&enc, jpg, JPEG_ENC_HEADER_MAX);
+    for (int i = 0; i < n; i++) {
+      memcpy(jpg + pos, part[i].buf, part[i].len);
+      pos += part[i].len;
+    }
+    jpg[pos++] = 0xFF;                      // EOI
+    jpg[pos++] = 0xD9;
+    *out = jpg;
+    *out_len = pos;
+  }
+  for (int i = 0; i < n; i++) free(part[i].buf);
+  return jpg != NULL;
+}
+
+bool encodeFrame(const camera_fb_t* fb, int quality, uint8_t** out, size_t* out_len) {
+  return encodeJpeg(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, out, out_len);
+}
@@ -0,0 +1,148 @@
+/**
+ * Shared latest-JPEG cache (see frame_cache.h).
+ */
+#include "frame_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "camera.h"
+#include "encoder.h"
+#include "psram.h"
+
+#define WANTED_FOR_US   (10 * 1000000LL)    // stream keeps publishing this long after a poll
+#define OFFERED_FOR_US  (1000000LL)          // a publisher this recent will deliver the next frame
+
+struct CacheSlot {
+  uint8_t* buf;
+  size_t   cap, len;
+  uint32_t seq;
+  uint64_t ts_us;
+  int64_t  published_us;
+  int      refs;
+  bool     writing;
+};
+
+static portMUX_TYPE cache_mux = portMUX_INITIALIZER_UNLOCKED;
+static CacheSlot    slots[FRAME_CACHE_SLOTS];
+static int          latest = -1;
+static uint32_t     seq = 0;
+static int64_t      wanted_until = 0;
+static int64_t      offered_us = 0;          // last frameCacheOffer()
+static bool         capturing = false;
+
+uint32_t frameCacheSeq() {
+  portENTER_CRITICAL(&cache_mux);
+  uint32_t s = seq;
+  portEXIT_CRITICAL(&cache_mux);
+  return s;
+}
+
+void frameCachePublish(const uint8_t* jpg, size_t len, uint64_t ts_us) {
+  int s = -1;
+  portENTER_CRITICAL(&cache_mux);
+  bool dup = latest >= 0 && slots[latest].ts_us == ts_us;    // same frame from another stream
+  for (int i = 0; i < FRAME_CACHE_SLOTS && !dup; i++) {
+    if (i != latest && !slots[i].refs && !slots[i].writing) { s = i; break; }
+  }
+  if (s >= 0) slots[s].writing = true;
+  portEXIT_CRITICAL(&cache_mux);
+  if (s < 0) return;
+
+  CacheSlot& c = slots[s];
+  if (c.cap < len) {
+    free(c.buf);
+    c.cap = len + len / 4;                    // headroom for the next, bigger frame
+    c.buf = (uint8_t*)psAlloc(c.cap);
+    if (!c.buf) c.cap = 0;
+  }
+  if (c.buf) memcpy(c.buf, jpg, len);
+
+  portENTER_CRITICAL(&cache_mux);
+  c.writing = false;
+  if (c.buf) {
+    c.len = len;
+    c.ts_us = ts_us;
+    c.seq = ++seq;
+    c.published_us = esp_timer_get_time();
+    latest = s;
+  }
+  portEXIT_CRITICAL(&cache_mux);
+}
+
+void frameCacheOffer(const uint8_t* jpg, size_t len, uint64_t ts_us) {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&cache_mux);
+  offered_us = now;
+  bool wanted = now < wanted_until;
+  portEXIT_CRITICAL(&cache_mux);
+  if (wanted) frameCachePublish(jpg, len, ts_us);
+}
+
+// One frame straight from the sensor (no publisher running).
+static bool captureOne() {
+  camera_fb_t* fb = camFbGet();
+  if (!fb) return false;
+  uint64_t ts = (uint64_t)fb->timestamp.tv_sec * 1000000ULL + fb->timestamp.tv_usec;
+  bool ok = true;
+  if (fb->format == PIXFORMAT_JPEG) {
+    frameCachePublish(fb->buf, fb->len, ts);
+  } else {
+    uint8_t* jpg = NULL;
+    size_t jpg_len = 0;
+    ok = encodeFrame(fb, JPEG_QUALITY, &jpg, &jpg_len);
+    if (ok) frameCachePublish(jpg, jpg_len, ts);
+    free(jpg);
+  }
+  camFbReturn(fb);
+  return ok;
+}
+
+bool frameCacheAcquire(uint32_t after, uint32_t max_age_ms, uint32_t timeout_ms,
+                       frame_ref_t* out) {
+  int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+  for (;;) {
+    int64_t now = esp_timer_get_time();
+    bool self = false;
+    portENTER_CRITICAL(&cache_mux);
+    wanted_until = now + WANTED_FOR_US;
+    if (latest >= 0) {
+      CacheSlot& c = slots[latest];
+      if (c.seq > after && (uint64_t)(now - c.published_us) <= (uint64_t)max_age_ms * 1000) {
+        c.refs++;
+        *out = { c.buf, c.len, c.seq, c.ts_us, latest };
+        portEXIT_CRITICAL(&cache_mux);
+        return true;
+      }
+    }
+    // A publishing stream will deliver (it sees the poll now); otherwise
+    // one poller captures and the others wait for its frame. Streams that
+    // don't publish (thumbnails, /raw) count in qosStreamFps() all the
+    // same, so that is no use here.
+    bool expired = now > deadline;
+    bool publisher = offered_us && now - offered_us < OFFERED_FOR_US;
+    if (!expired && !capturing && !publisher) capturing = self = true;
+    portEXIT_CRITICAL(&cache_mux);
+    if (expired) return false;
+
+    if (self) {
+      bool ok = captureOne();
+      portENTER_CRITICAL(&cache_mux);
+      capturing = false;
+      portEXIT_CRITICAL(&cache_mux);
+      if (!ok) return false;
+      continue;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+void frameCacheRelease(const frame_ref_t& f) {
+  portENTER_CRITICAL(&cache_mux);
+  if (f.slot >= 0 && f.slot < FRAME_CACHE_SLOTS && slots[f.slot].refs > 0) slots[f.slot].refs--;
+  portEXIT_CRITICAL(&cache_mux);
+}
@@ -0,0 +1,176 @@
+/**
+ * Long-term motion heatmap (see heatmap.h).
+ */
+#include "heatmap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "camera.h"
+#include "encoder.h"
+#include "heatmap_accum.h"
+#include "http_stream.h"
+#include "jpeg_scan.h"
+#include "psram.h"
+#include "qos.h"
+#include "thumb.h"
+
+#define DECAY_STEP_MS     1000
+#define IDLE_SAMPLE_MS    500        // background sampling without a stream
+#define RENDER_QUALITY    80
+
+static SemaphoreHandle_t hm_lock = NULL;
+static heatmap_t hm;
+static void*     hm_mem = NULL;
+static uint16_t  hm_width = 0, hm_height = 0;    // frame size the grid belongs to
+static heatmap_config_t config = { 3600, 24 };
+static int64_t   last_decay_us = 0;
+static uint32_t  cost_us = 0, last_activity = 0, scan_errors = 0;
+
+static void blockEnergy(void* ctx, int comp, int bx, int by, int dc, int ac) {
+  (void)comp; (void)dc;
+  heatmapAddBlock((heatmap_t*)ctx, bx, by, ac);
+}
+
+// Under hm_lock: (re)allocate the grid for this frame size.
+static bool ensureGrid(int width, int height) {
+  if (hm_mem && width == hm_width && height == hm_height) return true;
+  int cols = heatmapCells((width + 7) / 8), rows = heatmapCells((height + 7) / 8);
+  free(hm_mem);
+  hm_mem = psCalloc(1, heatmapBytes(cols, rows));
+  hm_width = hm_height = 0;
+  if (!hm_mem) return false;
+  heatmapInit(&hm, cols, rows, hm_mem);
+  hm_width = width;
+  hm_height = height;
+  last_decay_us = esp_timer_get_time();
+  printf("heatmap: %dx%d cells for %dx%d\n", cols, rows, width, height);
+  return true;
+}
+
+static void processFrame(const camera_fb_t* fb) {
+  if (fb->format != PIXFORMAT_JPEG) return;
+  int64_t t0 = esp_timer_get_time();
+  jpeg_info_t info;
+  if (jpegScanHeaders(fb->buf, fb->len, &info) != JPEG_SCAN_OK) { scan_errors++; return; }
+
+  xSemaphoreTake(hm_lock, portMAX_DELAY);
+  if (ensureGrid(info.width, info.height)) {
+    if (jpegScan(fb->buf, fb->len, JPEG_SCAN_AC | JPEG_SCAN_LUMA_ONLY, blockEnergy, &hm, NULL) == JPEG_SCAN_OK) {
+      last_activity = heatmapUpdate(&hm, config.floor);
+    } else {
+      memset(hm.cur, 0, (size_t)hm.cols * hm.rows * sizeof(uint16_t));
+      scan_errors++;
+    }
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = (uint32_t)((now - last_decay_us) / 1000);
+    if (elapsed_ms >= DECAY_STEP_MS) {
+      heatmapDecay(&hm, heatmapDecayFactor(elapsed_ms, config.half_life_s));
+      last_decay_us = now;
+    }
+  }
+  xSemaphoreGive(hm_lock);
+  cost_us = (uint32_t)(esp_timer_get_time() - t0);
+}
+
+static void heatmapStage(const camera_fb_t* fb, void* ctx) {
+  (void)ctx;
+  processFrame(fb);
+}
+
+// Keeps the map growing while nobody watches. Any open stream (including
+// /raw and SSE) or camera claim is left alone: it feeds the stage or owns
+// the frames.
+static void idleTask(void* arg) {
+  (void)arg;
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(IDLE_SAMPLE_MS));
+    if (qosStreamFps() > 0 || httpStreamActive() || cameraClaimed()) continue;
+    camera_fb_t* fb = camFbGet();
+    if (!fb) continue;
+    processFrame(fb);
+    camFbReturn(fb);
+  }
+}
+
+void heatmapModuleInit() {
+  hm_lock = xSemaphoreCreateMutex();
+  // Lowest analytics priority: the map is a long-term average, skipping
+  // frames under load costs nothing. tools/heatmap_bench puts one UXGA frame
+  // at 6.6-6.9 ms end to end (three runs on a desktop; nearly all of it the
+  // scan). Hosts differ, so the budget is a ratio of that run: 6.8 ms / 4 =
+  // 1.7 ms, i.e. every 4th UXGA frame at most and every frame up to SVGA
+  // (1.7 ms) on the same machine. The device is slower per frame, and qos
+  // scales every_n with its measured cost.
+  qosRegisterStage("heatmap", 40, 1700, heatmapStage, NULL);
+  xTaskCreate(idleTask, "heatmap", 4096, NULL, 1, NULL);
+}
+
+void heatmapSetConfig(const heatmap_config_t& c) {
+  xSemaphoreTake(hm_lock, portMAX_DELAY);
+  config = c;
+  xSemaphoreGive(hm_lock);
+}
+
+heatmap_config_t heatmapConfig() {
+  return config;
+}
+
+void heatmapReset() {
+  xSemaphoreTake(hm_lock, portMAX_DELAY);
+  if (hm_mem) heatmapClear(&hm);
+  xSemaphoreGive(hm_lock);
+}
+
+esp_err_t heatmapRenderJpeg(const uint8_t* bg_jpg, size_t bg_len, int zoom,
+                            uint8_t** jpg, size_t* len) {
+  if (zoom < 1) zoom = 1;
+  if (zoom > 8) zoom = 8;
+  uint8_t* bg = NULL;
+  int bw = 0, bh = 0;
+  if (bg_jpg) thumbFromJpeg(bg_jpg, bg_len, HEATMAP_CELL_SHIFT, &bg, &bw, &bh);
+
+  xSemaphoreTake(hm_lock, portMAX_DELAY);
+  if (!hm_mem) {
+    xSemaphoreGive(hm_lock);
+    free(bg);
+    return ESP_ERR_INVALID_STATE;
+  }
+  const int cols = hm.cols, rows = hm.rows;
+  uint8_t* gray = NULL;
+  if (bg && bw == cols && bh == rows) {         // same frame size: RGB -> luma in place
+    gray = bg;
+    for (int i = 0; i < cols * rows; i++)
+      gray[i] = (uint8_t)((bg[3 * i] * 77 + bg[3 * i + 1] * 150 + bg[3 * i + 2] * 29) >> 8);
+  }
+  const int w = cols * zoom, h = rows * zoom;
+  uint8_t* rgb = (uint8_t*)psAlloc((size_t)w * h * 3);
+  if (rgb) heatmapRender(&hm, gray, zoom, rgb);
+  xSemaphoreGive(hm_lock);
+  free(bg);
+  if (!rgb) return ESP_ERR_NO_MEM;
+
+  bool ok = encodeJpeg(rgb, (size_t)w * h * 3, w, h, PIXFORMAT_RGB888, RENDER_QUALITY, jpg, len);
+  free(rgb);
+  return ok ? ESP_OK : ESP_FAIL;
+}
+
+size_t heatmapStatusJson(char* buf, size_t len) {
+  xSemaphoreTake(hm_lock, portMAX_DELAY);
+  uint32_t mx = 0;
+  if (hm_mem) for (int i = 0; i < hm.cols * hm.rows; i++) if (hm.heat[i] > mx) mx = hm.heat[i];
+  int n = snprintf(buf, len,
+    "{\"cols\":%u,\"rows\":%u,\"frame\":\"%ux%u\",\"frames\":%u,\"max\":%u,\"last_activity\":%u,"
+    "\"cost_us\":%u,\"scan_errors\":%u,\"half_life_s\":%u,\"floor\":%u}",
+    hm_mem ? hm.cols : 0, hm_mem ? hm.rows : 0, hm_width, hm_height,
+    hm_mem ? (unsigned)hm.frames : 0, (unsigned)mx, (unsigned)last_activity,
+    (unsigned)cost_us, (unsigned)scan_errors, (unsigned)config.half_life_s, config.floor);
+  xSemaphoreGive(hm_lock);
+  return n < (int)len ? n : len - 1;
+}
@@ -0,0 +1,91 @@
+/**
+ * Block-activity heatmap (see heatmap_accum.h).
+ */
+#include "heatmap_accum.h"
+
+#include <math.h>
+#include <string.h>
+
+size_t heatmapBytes(int cols, int rows) {
+  size_t n = (size_t)cols * rows;
+  return n * (sizeof(uint32_t) + 2 * sizeof(uint16_t));
+}
+
+void heatmapInit(heatmap_t* h, int cols, int rows, void* mem) {
+  size_t n = (size_t)cols * rows;
+  h->cols = cols;
+  h->rows = rows;
+  h->heat = (uint32_t*)mem;
+  h->prev = (uint16_t*)(h->heat + n);
+  h->cur = h->prev + n;
+  h->frames = 0;
+}
+
+void heatmapClear(heatmap_t* h) {
+  memset(h->heat, 0, heatmapBytes(h->cols, h->rows));
+  h->frames = 0;
+}
+
+uint32_t heatmapUpdate(heatmap_t* h, uint16_t floor) {
+  const size_t n = (size_t)h->cols * h->rows;
+  uint32_t* heat = h->heat;
+  uint16_t* prev = h->prev;
+  uint16_t* cur = h->cur;
+  uint32_t total = 0;
+  if (h->frames++ == 0) {
+    memcpy(prev, cur, n * sizeof(uint16_t));
+    memset(cur, 0, n * sizeof(uint16_t));
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    int d = (int)cur[i] - (int)prev[i];
+    if (d < 0) d = -d;
+    prev[i] = cur[i];
+    cur[i] = 0;
+    if (d <= floor) continue;
+    uint32_t a = (uint32_t)(d - floor);
+    uint32_t v = heat[i] + a;
+    heat[i] = v < a ? UINT32_MAX : v;
+    total += a;
+  }
+  return total;
+}
+
+void heatmapDecay(heatmap_t* h, uint32_t factor_q16) {
+  const size_t n = (size_t)h->cols * h->rows;
+  for (size_t i = 0; i < n; i++) h->heat[i] = (uint32_t)(((uint64_t)h->heat[i] * factor_q16) >> 16);
+}
+
+uint32_t heatmapDecayFactor(uint32_t elapsed_ms, uint32_t half_life_s) {
+  if (!half_life_s) return 65536;
+  return (uint32_t)(65536.0f * exp2f(-(float)elapsed_ms / (1000.0f * half_life_s)) + 0.5f);
+}
+
+static inline void hot(int t, uint8_t* c) {         // t 0..255 -> black, red, yellow, white
+  c[0] = t < 85 ? t * 3 : 255;
+  c[1] = t < 85 ? 0 : t < 170 ? (t - 85) * 3 : 255;
+  c[2] = t < 170 ? 0 : (t - 170) * 3;
+}
+
+void heatmapRender(const heatmap_t* h, const uint8_t* gray, int zoom, uint8_t* rgb) {
+  const int cols = h->cols, rows = h->rows;
+  uint32_t mx = 1;
+  for (size_t i = 0; i < (size_t)cols * rows; i++) if (h->heat[i] > mx) mx = h->heat[i];
+  const int w = cols * zoom;
+  for (int y = 0; y < rows; y++) {
+    uint8_t* line = rgb + (size_t)y * zoom * w * 3;
+    for (int x = 0; x < cols; x++) {
+      uint32_t v = h->heat[y * cols + x];
+      int t = (int)(sqrtf((float)v / mx) * 255.0f);  // sqrt: faint paths stay visible
+      uint8_t c[3];
+      hot(t, c);
+      if (gray) {
+        int g = gray[y * cols + x] * (255 - t) / 512;   // dimmed background where cold
+        for (int k = 0; k < 3; k++) c[k] = (uint8_t)(c[k] + g > 255 ? 255 : c[k] + g);
+      }
+      uint8_t* o = line + (size_t)x * zoom * 3;
+      for (int z = 0; z < zoom; z++, o += 3) { o[0] = c[0]; o[1] = c[1]; o[2] = c[2]; }
+    }
+    for (int z = 1; z < zoom; z++) memcpy(line + (size_t)z * w * 3, line, (size_t)w * 3);
+  }
+}
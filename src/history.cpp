@@ -0,0 +1,204 @@
+/**
+ * On-device telemetry history (see history.h).
+ *
+ * The ring is a sequence of fixed-size blocks; block `seq` lives at slot
+ * seq % nblocks, so the oldest block is overwritten as a whole. Readers copy
+ * one block at a time under the lock and decode it outside, so a slow HTTP
+ * client never stalls the sampler.
+ */
+#include "history.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "history_codec.h"
+#include "psram.h"
+#include "qos.h"
+
+#define HIST_BLOCK_BYTES     1024
+#define HIST_RING_BYTES      (256 * 1024)
+#define HIST_RING_FALLBACK   (16 * 1024)
+
+static portMUX_TYPE    hist_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t*        ring = NULL;
+static uint32_t        nblocks = 0;
+static uint32_t        head = 0;             // seq of the block being written
+static bool            started = false;
+static hist_encoder_t  enc;
+static volatile uint8_t battery = 255;
+
+uint32_t historyNow() {
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+void historySetBattery(uint8_t percent) {
+  battery = percent > 100 && percent != 255 ? 100 : percent;
+}
+
+static uint8_t* blockAt(uint32_t seq) {
+  return ring + (seq % nblocks) * HIST_BLOCK_BYTES;
+}
+
+static void append(uint32_t t, const hist_sample_t& s) {
+  portENTER_CRITICAL(&hist_mux);
+  if (!started) {
+    histBlockBegin(&enc, blockAt(head), HIST_BLOCK_BYTES, t, s);
+    started = true;
+  } else if (!histBlockAppend(&enc, t, s)) {
+    head++;
+    histBlockBegin(&enc, blockAt(head), HIST_BLOCK_BYTES, t, s);
+  }
+  portEXIT_CRITICAL(&hist_mux);
+}
+
+static void collect(hist_sample_t* s) {
+  memset(s, 0, sizeof(*s));
+  s->v[HIST_FPS_X10] = (int32_t)(qosStreamFps() * 10.0f + 0.5f);
+  s->v[HIST_KBPS]    = (int32_t)(qosStreamBytesPerSec() / 1024);
+
+  wifi_sta_list_t sta;
+  if (esp_wifi_ap_get_sta_list(&sta) == ESP_OK && sta.num > 0) {
+    int sum = 0;
+    for (int i = 0; i < sta.num; i++) sum += sta.sta[i].rssi;
+    s->v[HIST_CLIENTS] = sta.num;
+    s->v[HIST_RSSI]    = sum / sta.num;
+  }
+  s->v[HIST_HEAP_KB] = (int32_t)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024);
+  s->v[HIST_BATTERY] = battery;
+}
+
+static void samplerTask(void*) {
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000));
+    hist_sample_t s;
+    collect(&s);
+    append(historyNow(), s);
+  }
+}
+
+void historyInit() {
+  size_t bytes = HIST_RING_BYTES;
+  ring = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  if (!ring) {
+    bytes = HIST_RING_FALLBACK;
+    ring = (uint8_t*)psAlloc(bytes);
+  }
+  if (!ring) {
+    printf("history: no memory\n");
+    return;
+  }
+  nblocks = bytes / HIST_BLOCK_BYTES;
+  printf("history: %u KB ring\n", (unsigned)(bytes / 1024));
+  xTaskCreate(samplerTask, "history", 3072, NULL, 1, NULL);
+}
+
+// ---------- query ----------
+
+struct Query {
+  uint32_t from, to, step;
+  history_write_fn fn;
+  void* ctx;
+  bool ok;
+  // current bucket
+  uint32_t bucket;
+  uint32_t n;
+  int64_t  sum[HIST_FIELDS];
+  int32_t  clients_max, heap_min, battery_last;
+  uint32_t rssi_n;
+  // output
+  char     out[768];
+  size_t   pos;
+  bool     first_row;
+};
+
+static void flush(Query* q) {
+  if (q->pos && q->ok) q->ok = q->fn(q->out, q->pos, q->ctx);
+  q->pos = 0;
+}
+
+static void emitRow(Query* q) {
+  if (!q->n) return;
+  if (q->pos > sizeof(q->out) - 96) flush(q);
+  int32_t fps10 = (int32_t)(q->sum[HIST_FPS_X10] / q->n);
+  int32_t rssi = q->rssi_n ? (int32_t)(q->sum[HIST_RSSI] / (int32_t)q->rssi_n) : 0;
+  q->pos += snprintf(q->out + q->pos, sizeof(q->out) - q->pos, "%s[%u,%d.%d,%d,%d,%d,%d,%d]",
+                     q->first_row ? "" : ",", (unsigned)q->bucket, (int)(fps10 / 10), (int)(fps10 % 10),
+                     (int)(q->sum[HIST_KBPS] / q->n), (int)q->clients_max, (int)rssi,
+                     (int)q->heap_min, (int)q->battery_last);
+  q->first_row = false;
+  q->n = 0;
+  q->rssi_n = 0;
+  memset(q->sum, 0, sizeof(q->sum));
+}
+
+static void onSample(uint32_t t, const hist_sample_t& s, void* ctx) {
+  Query* q = (Query*)ctx;
+  if (t < q->from || t > q->to || !q->ok) return;
+  uint32_t b = q->from + (t - q->from) / q->step * q->step;
+  if (b != q->bucket) emitRow(q);
+  if (!q->n) {
+    q->bucket = b;
+    q->clients_max = 0;
+    q->heap_min = INT32_MAX;
+  }
+  q->n++;
+  for (int f = 0; f < HIST_FIELDS; f++) if (f != HIST_RSSI) q->sum[f] += s.v[f];
+  if (s.v[HIST_CLIENTS]) { q->sum[HIST_RSSI] += s.v[HIST_RSSI]; q->rssi_n++; }
+  if (s.v[HIST_CLIENTS] > q->clients_max) q->clients_max = s.v[HIST_CLIENTS];
+  if (s.v[HIST_HEAP_KB] < q->heap_min) q->heap_min = s.v[HIST_HEAP_KB];
+  q->battery_last = s.v[HIST_BATTERY];
+}
+
+bool historyQueryJson(uint32_t from, uint32_t to, uint32_t step,
+                      history_write_fn fn, void* ctx) {
+  Query* q = (Query*)calloc(1, sizeof(Query));
+  uint8_t* copy = (uint8_t*)malloc(HIST_BLOCK_BYTES);
+  if (!q || !copy) { free(q); free(copy); return false; }
+  q->from = from; q->to = to; q->step = step ? step : 1;
+  q->fn = fn; q->ctx = ctx; q->ok = true; q->first_row = true;
+
+  uint32_t first = 0, last = 0, oldest_t = 0;
+  bool any;
+  portENTER_CRITICAL(&hist_mux);
+  any = started;
+  if (any) {
+    last = head;
+    first = head >= nblocks ? head - nblocks + 1 : 0;
+    oldest_t = histBlockT0(blockAt(first));
+  }
+  portEXIT_CRITICAL(&hist_mux);
+
+  q->pos = snprintf(q->out, sizeof(q->out),
+    "{\"now\":%u,\"from\":%u,\"to\":%u,\"step\":%u,\"oldest\":%u,\"ring_kb\":%u,"
+    "\"fields\":[\"t\",\"fps\",\"kBps\",\"clients\",\"rssi\",\"heap_kb\",\"battery\"],\"rows\":[",
+    (unsigned)historyNow(), (unsigned)from, (unsigned)to, (unsigned)q->step, (unsigned)oldest_t,
+    (unsigned)(nblocks * HIST_BLOCK_BYTES / 1024));
+
+  for (uint32_t seq = first; any && seq <= last && q->ok; seq++) {
+    bool valid, skip = false;
+    portENTER_CRITICAL(&hist_mux);
+    valid = head < nblocks || seq > head - nblocks;            // not overwritten meanwhile
+    if (valid && seq < head) skip = histBlockT0(blockAt(seq + 1)) <= from;
+    if (valid && !skip) memcpy(copy, blockAt(seq), HIST_BLOCK_BYTES);
+    portEXIT_CRITICAL(&hist_mux);
+    if (!valid || skip) continue;
+    if (histBlockT0(copy) > to) break;
+    histBlockDecode(copy, HIST_BLOCK_BYTES, onSample, q);
+  }
+  emitRow(q);
+  if (q->pos > sizeof(q->out) - 4) flush(q);
+  q->pos += snprintf(q->out + q->pos, sizeof(q->out) - q->pos, "]}");
+  flush(q);
+
+  bool ok = q->ok;
+  free(copy);
+  free(q);
+  return ok;
+}
@@ -0,0 +1,131 @@
+/**
+ * Delta/varint codec for the telemetry history (see history_codec.h).
+ */
+#include "history_codec.h"
+
+#include <string.h>
+
+#define TAG_RUN      0x80
+#define TAG_GAP      0x40
+#define RUN_MAX      127
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+static size_t putVarint(uint8_t* p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// Returns bytes read, 0 on overrun.
+static size_t getVarint(const uint8_t* p, const uint8_t* end, uint32_t* v) {
+  uint32_t r = 0;
+  for (size_t n = 0; n < 5 && p + n < end; n++) {
+    r |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+    if (!(p[n] & 0x80)) { *v = r; return n + 1; }
+  }
+  return 0;
+}
+
+static void putHeader(hist_encoder_t* e, uint32_t t0) {
+  uint8_t* h = e->buf;
+  h[0] = t0; h[1] = t0 >> 8; h[2] = t0 >> 16; h[3] = t0 >> 24;
+  h[4] = e->count; h[5] = e->count >> 8;
+  h[6] = e->used;  h[7] = e->used >> 8;
+}
+
+uint32_t histBlockT0(const uint8_t* b) {
+  return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+uint16_t histBlockCount(const uint8_t* b) {
+  return b[4] | (b[5] << 8);
+}
+
+void histBlockBegin(hist_encoder_t* e, uint8_t* buf, size_t cap, uint32_t t,
+                    const hist_sample_t& s) {
+  e->buf = buf;
+  e->cap = cap > 0xFFFF ? 0xFFFF : cap;
+  e->used = HIST_BLOCK_HDR;
+  for (int f = 0; f < HIST_FIELDS; f++) e->used += putVarint(buf + e->used, zigzag(s.v[f]));
+  e->count = 1;
+  e->t_last = t;
+  e->run_tag = 0;
+  e->last = s;
+  putHeader(e, t);
+}
+
+bool histBlockAppend(hist_encoder_t* e, uint32_t t, const hist_sample_t& s) {
+  if (e->count == 0xFFFF) return false;
+  uint32_t gap = t > e->t_last ? t - e->t_last - 1 : 0;
+  bool same = memcmp(&s, &e->last, sizeof(s)) == 0;
+
+  if (same && gap == 0 && e->run_tag && (e->buf[e->run_tag] & RUN_MAX) < RUN_MAX) {
+    e->buf[e->run_tag]++;                                  // extend the open run
+  } else if (same && gap == 0) {
+    if (e->used + 1 > e->cap) return false;
+    e->run_tag = e->used;
+    e->buf[e->used++] = TAG_RUN | 1;
+  } else {
+    if (e->used + HIST_ENTRY_MAX > e->cap) return false;
+    uint8_t mask = 0;
+    for (int f = 0; f < HIST_FIELDS; f++) if (s.v[f] != e->last.v[f]) mask |= 1 << f;
+    size_t tag = e->used++;
+    e->buf[tag] = mask | (gap ? TAG_GAP : 0);
+    if (gap) e->used += putVarint(e->buf + e->used, gap);
+    for (int f = 0; f < HIST_FIELDS; f++)
+      if (mask & (1 << f)) e->used += putVarint(e->buf + e->used, zigzag(s.v[f] - e->last.v[f]));
+    e->run_tag = 0;
+    e->last = s;
+  }
+  e->count++;
+  e->t_last = t;
+  putHeader(e, histBlockT0(e->buf));
+  return true;
+}
+
+int histBlockDecode(const uint8_t* buf, size_t cap, hist_sample_fn fn, void* ctx) {
+  if (cap < HIST_BLOCK_HDR) return -1;
+  uint32_t t = histBlockT0(buf);
+  int count = histBlockCount(buf);
+  size_t used = buf[6] | (buf[7] << 8);
+  if (used > cap || count == 0) return -1;
+
+  const uint8_t* p = buf + HIST_BLOCK_HDR;
+  const uint8_t* end = buf + used;
+  hist_sample_t s;
+  uint32_t u;
+  size_t n;
+  for (int f = 0; f < HIST_FIELDS; f++) {
+    if (!(n = getVarint(p, end, &u))) return -1;
+    s.v[f] = unzigzag(u);
+    p += n;
+  }
+  fn(t, s, ctx);
+  int done = 1;
+
+  while (done < count && p < end) {
+    uint8_t tag = *p++;
+    if (tag & TAG_RUN) {
+      for (int r = tag & RUN_MAX; r > 0 && done < count; r--, done++) fn(++t, s, ctx);
+      continue;
+    }
+    uint32_t gap = 0;
+    if (tag & TAG_GAP) {
+      if (!(n = getVarint(p, end, &gap))) return -1;
+      p += n;
+    }
+    for (int f = 0; f < HIST_FIELDS; f++) {
+      if (!(tag & (1 << f))) continue;
+      if (!(n = getVarint(p, end, &u))) return -1;
+      s.v[f] += unzigzag(u);
+      p += n;
+    }
+    t += 1 + gap;
+    fn(t, s, ctx);
+    done++;
+  }
+  return done == count ? count : -1;
+}
@@ -0,0 +1,172 @@
+/**
+ * Detached long-lived HTTP responses (see http_stream.h).
+ *
+ * Socket ownership:
+ *   - worker finishes first:  mark done, ask httpd to close the session;
+ *                             the close hook then really closes the fd.
+ *   - peer/httpd closes first: the close hook only flags the slot; the
+ *                             worker notices (send error or flag), then
+ *                             closes the fd itself.
+ * Either way the fd is closed exactly once and never while a worker uses it.
+ */
+#include "http_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+
+struct StreamSlot {
+  bool in_use;
+  bool done;          // worker finished, waiting for httpd to drop the session
+  bool peer_closed;   // httpd dropped the session, worker still running
+  int  fd;
+  const char* name;
+  http_stream_fn fn;
+  void* arg;
+};
+
+static StreamSlot     slots[HTTP_STREAM_MAX];
+static portMUX_TYPE   slot_mux = portMUX_INITIALIZER_UNLOCKED;
+static httpd_handle_t server = NULL;
+
+static StreamSlot* findSlot(int fd) {
+  for (int i = 0; i < HTTP_STREAM_MAX; i++)
+    if (slots[i].in_use && slots[i].fd == fd) return &slots[i];
+  return NULL;
+}
+
+static void onSessionClose(httpd_handle_t hd, int fd) {
+  (void)hd;
+  bool close_now = true;
+  portENTER_CRITICAL(&slot_mux);
+  StreamSlot* s = findSlot(fd);
+  if (s) {
+    if (s->done) s->in_use = false;                        // worker is gone
+    else { s->peer_closed = true; close_now = false; }     // worker closes it
+  }
+  portEXIT_CRITICAL(&slot_mux);
+  if (close_now) close(fd);
+}
+
+static void streamTask(void* p) {
+  StreamSlot* s = (StreamSlot*)p;
+  s->fn(s->fd, s->arg);
+
+  int fd = s->fd;
+  bool close_now;
+  portENTER_CRITICAL(&slot_mux);
+  close_now = s->peer_closed;
+  if (close_now) s->in_use = false;
+  else s->done = true;
+  portEXIT_CRITICAL(&slot_mux);
+
+  if (close_now) close(fd);
+  else httpd_sess_trigger_close(server, fd);
+  vTaskDelete(NULL);
+}
+
+void httpStreamInstall(httpd_config_t& cfg) {
+  cfg.close_fn = onSessionClose;
+}
+
+void httpStreamSetServer(httpd_handle_t h) {
+  server = h;
+}
+
+esp_err_t httpStreamDetach(httpd_req_t* req, const char* content_type,
+                           const char* name, http_stream_fn fn, void* arg,
+                           uint32_t stack, UBaseType_t prio) {
+  int fd = httpd_req_to_sockfd(req);
+  if (fd < 0 || !server) return ESP_FAIL;
+
+  StreamSlot* s = NULL;
+  portENTER_CRITICAL(&slot_mux);
+  for (int i = 0; i < HTTP_STREAM_MAX; i++) {
+    if (!slots[i].in_use) {
+      s = &slots[i];
+      memset(s, 0, sizeof(*s));
+      s->in_use = true;
+      s->fd = fd;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&slot_mux);
+  if (!s) return ESP_ERR_NO_MEM;
+
+  struct timeval tv = { 5, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  s->name = name;
+  s->fn = fn;
+  s->arg = arg;
+  if ((content_type && httpStreamSendHead(fd, "200 OK", content_type, -1) != ESP_OK) ||
+      xTaskCreate(streamTask, name, stack, s, prio, NULL) != pdPASS) {
+    portENTER_CRITICAL(&slot_mux);
+    s->in_use = false;
+    portEXIT_CRITICAL(&slot_mux);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+esp_err_t httpStreamSendHead(int fd, const char* status, const char* content_type,
+                             long content_length, const char* extra) {
+  char head[384];
+  int n = snprintf(head, sizeof(head),
+    "HTTP/1.1 %s\r\n"
+    "Content-Type: %s\r\n"
+    "Cache-Control: no-store\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: close\r\n", status, content_type);
+  if (content_length >= 0 && n < (int)sizeof(head))
+    n += snprintf(head + n, sizeof(head) - n, "Content-Length: %ld\r\n", content_length);
+  if (extra && n < (int)sizeof(head))
+    n += snprintf(head + n, sizeof(head) - n, "%s", extra);
+  if (n + 2 >= (int)sizeof(head)) return ESP_FAIL;
+  memcpy(head + n, "\r\n", 2);
+  return httpStreamSend(fd, head, n + 2);
+}
+
+esp_err_t httpStreamSend(int fd, const void* buf, size_t len) {
+  const uint8_t* p = (const uint8_t*)buf;
+  while (len) {
+    int n = send(fd, p, len, 0);
+    if (n <= 0) return ESP_FAIL;
+    p += n;
+    len -= n;
+  }
+  return ESP_OK;
+}
+
+bool httpStreamPeerClosed(int fd) {
+  portENTER_CRITICAL(&slot_mux);
+  StreamSlot* s = findSlot(fd);
+  bool closed = !s || s->peer_closed;
+  portEXIT_CRITICAL(&slot_mux);
+  return closed;
+}
+
+int httpStreamActive() {
+  int n = 0;
+  portENTER_CRITICAL(&slot_mux);
+  for (int i = 0; i < HTTP_STREAM_MAX; i++)
+    if (slots[i].in_use && !slots[i].done && !slots[i].peer_closed) n++;
+  portEXIT_CRITICAL(&slot_mux);
+  return n;
+}
+
+int httpStreamList(http_stream_info_t* out, int max) {
+  int n = 0;
+  portENTER_CRITICAL(&slot_mux);
+  for (int i = 0; i < HTTP_STREAM_MAX && n < max; i++) {
+    if (!slots[i].in_use || slots[i].done || slots[i].peer_closed) continue;
+    out[n].fd = slots[i].fd;
+    out[n].name = slots[i].name;
+    n++;
+  }
+  portEXIT_CRITICAL(&slot_mux);
+  return n;
+}
@@ -0,0 +1,150 @@
+/**
+ * Compressed-domain brightness / contrast (see jpeg_adjust.h).
+ */
+#include "jpeg_adjust.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_enc.h"
+#include "jpeg_scan.h"
+
+#define DC_MAX  2047                  // largest DC difference baseline can code
+
+static inline uint16_t be16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+// Reads the unstuffed bits of an entropy-coded segment.
+struct Unstuffer {
+  const uint8_t* p;
+  const uint8_t* end;
+  uint32_t acc;
+  int      n;
+};
+
+static inline uint32_t getBits(Unstuffer* u, int k) {
+  while (u->n < k) {
+    uint8_t b = u->p < u->end ? *u->p++ : 0;
+    if (b == 0xFF && u->p < u->end && *u->p == 0x00) u->p++;
+    u->acc = u->acc << 8 | b;
+    u->n += 8;
+  }
+  u->n -= k;
+  return (u->acc >> u->n) & ((1u << k) - 1);
+}
+
+// Luma quantization table id (from SOF), or -1.
+static int lumaTable(const uint8_t* jpg, size_t scan_offset) {
+  for (size_t pos = 2; pos + 4 <= scan_offset; ) {
+    uint8_t m = jpg[pos + 1];
+    if (m == 0xFF) { pos++; continue; }
+    size_t seg = be16(jpg + pos + 2);
+    if ((m == 0xC0 || m == 0xC1) && seg >= 11) return jpg[pos + 4 + 8] & 3;
+    pos += 2 + seg;
+  }
+  return -1;
+}
+
+// Copy the headers, scaling the luma DQT. Returns the header length (0 if
+// cap is too small) and the new luma DC quantizer in *q0.
+static size_t copyHeaders(const uint8_t* jpg, size_t scan_offset, int tq, float contrast,
+                          uint8_t* out, size_t cap, int* q0) {
+  if (cap < scan_offset) return 0;
+  memcpy(out, jpg, scan_offset);
+  *q0 = 1;
+  for (size_t pos = 2; pos + 4 <= scan_offset; ) {
+    uint8_t m = jpg[pos + 1];
+    if (m == 0xFF) { pos++; continue; }
+    size_t seg = be16(jpg + pos + 2);
+    if (m == 0xDB) {
+      uint8_t* p = out + pos + 4;
+      uint8_t* end = out + pos + 2 + seg;
+      while (p < end) {
+        int pq = *p >> 4, id = *p & 3, step = pq ? 2 : 1;
+        p++;
+        if (p + 64 * step > end) break;
+        for (int k = 0; id == tq && k < 64; k++) {
+          int q = pq ? be16(p + 2 * k) : p[k];
+          int s = (int)lroundf(q * contrast);
+          int lim = pq ? 65535 : 255;
+          s = s < 1 ? 1 : s > lim ? lim : s;
+          if (pq) { p[2 * k] = (uint8_t)(s >> 8); p[2 * k + 1] = (uint8_t)s; }
+          else p[k] = (uint8_t)s;
+          if (!k) *q0 = s;
+        }
+        p += 64 * step;
+      }
+    }
+    pos += 2 + seg;
+  }
+  return scan_offset;
+}
+
+long jpegAdjust(const uint8_t* jpg, size_t len, int brightness, float contrast,
+                uint8_t* out, size_t cap) {
+  if (brightness > JPEG_ADJUST_BRIGHTNESS_MAX) brightness = JPEG_ADJUST_BRIGHTNESS_MAX;
+  if (brightness < -JPEG_ADJUST_BRIGHTNESS_MAX) brightness = -JPEG_ADJUST_BRIGHTNESS_MAX;
+  if (!(contrast >= JPEG_ADJUST_CONTRAST_MIN)) contrast = JPEG_ADJUST_CONTRAST_MIN;   // also NaN
+  if (contrast > JPEG_ADJUST_CONTRAST_MAX) contrast = JPEG_ADJUST_CONTRAST_MAX;
+
+  int err;
+  jpeg_info_t info;
+  jpeg_decoder_t* d = jpegDecoderOpen(jpg, len, &info, &err);
+  if (!d) return err;
+  int tq = lumaTable(jpg, info.scan_offset), q0 = 1;
+  size_t hdr = tq >= 0 ? copyHeaders(jpg, info.scan_offset, tq, contrast, out, cap, &q0) : 0;
+  if (!hdr) {
+    jpegDecoderClose(d);
+    return tq < 0 ? JPEG_SCAN_ERR_FORMAT : JPEG_ADJUST_ERR_SPACE;
+  }
+
+  // brightness in quantized DC units under the new table
+  const int k = (int)lroundf(8.0f * brightness / q0);
+  if (!k) {                                   // contrast only: the scan is unchanged
+    jpegDecoderClose(d);
+    if (cap - hdr < len - hdr) return JPEG_ADJUST_ERR_SPACE;
+    memcpy(out + hdr, jpg + hdr, len - hdr);
+    return (long)len;
+  }
+
+  const int total = info.mcus_x * info.mcus_y;
+  const int ri = info.restart_interval ? info.restart_interval : total;
+  const int n = (total + ri - 1) / ri;
+  jpeg_interval_t* iv = (jpeg_interval_t*)malloc((size_t)n * sizeof(jpeg_interval_t));
+  err = iv ? jpegDecoderIntervals(d, iv, n) : JPEG_SCAN_ERR_DATA;
+
+  jpeg_bits_t bw;
+  jpegBitsInit(&bw, out + hdr, cap - hdr);
+  Unstuffer u = { NULL, jpg + len, 0, 0 };
+  for (int i = 0; i < n && err == JPEG_SCAN_OK; i++) {
+    int dc = iv[i].dc + k;
+    dc = dc > DC_MAX ? DC_MAX : dc < -DC_MAX ? -DC_MAX : dc;
+    int mag = dc < 0 ? -dc : dc, s = 0;
+    while (mag >> s) s++;
+    uint16_t code;
+    int code_len = jpegDecoderDcCode(d, 0, s, &code);
+    if (!code_len) { err = JPEG_SCAN_ERR_UNSUPP; break; }     // optimized table without that category
+    jpegPutBits(&bw, code, code_len);
+    if (s) jpegPutBits(&bw, (uint32_t)(dc < 0 ? dc - 1 : dc) & ((1u << s) - 1), s);
+
+    u.p = jpg + iv[i].start;
+    u.acc = 0;
+    u.n = 0;
+    uint32_t left = iv[i].bits - iv[i].dc_bits;
+    for (int skip = iv[i].dc_bits; skip > 0; skip -= 16) getBits(&u, skip > 16 ? 16 : skip);
+    for (; left >= 16; left -= 16) jpegPutBits(&bw, getBits(&u, 16), 16);
+    if (left) jpegPutBits(&bw, getBits(&u, left), left);
+    jpegBitsFlush(&bw, i + 1 < n ? i : -1);                  // RSTn keep their numbers
+  }
+  free(iv);
+  jpegDecoderClose(d);
+  if (err != JPEG_SCAN_OK) return err;
+
+  // whatever follows the last interval (EOI, trailing bytes) is copied as is
+  const uint8_t* tail = u.p;
+  while (tail + 1 < jpg + len && !(tail[0] == 0xFF && tail[1] != 0x00 && tail[1] != 0xFF)) tail++;
+  size_t rest = (size_t)(jpg + len - tail);
+  if (bw.overflow || (size_t)(bw.end - bw.p) < rest) return JPEG_ADJUST_ERR_SPACE;
+  memcpy(bw.p, tail, rest);
+  return (long)(bw.p + rest - out);
+}
@@ -0,0 +1,206 @@
+/**
+ * Conditional-replenishment patches (see jpeg_delta.h).
+ *
+ * A block counts as changed when, in dequantized units (8 per level of the
+ * mean), its DC moved by more than 8 * threshold, its two gradient terms
+ * together by more than that, or its AC energy by more than the threshold
+ * plus a quarter of the reference's (texture that merely shimmers, like
+ * sensor noise on a detailed area, scales with the detail; threshold 0
+ * drops that slack too). An MCU is sent when any of its blocks changed.
+ * Changes the signature can't see (a higher term that moved while the
+ * energy stayed put) wait for the next keyframe.
+ */
+#include "jpeg_delta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_enc.h"
+#include "jpeg_scan.h"
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+
+static inline int16_t clamp16(int v) { return (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v); }
+
+static void signature(const int16_t* zz, const uint16_t* q, int16_t* s) {
+  int e = 0;
+  for (int k = 1; k < 64; k++) e += abs(zz[k]) * q[k];
+  s[0] = clamp16(zz[0] * q[0]);
+  s[1] = clamp16(zz[1] * q[1]);
+  s[2] = clamp16(zz[2] * q[2]);
+  s[3] = clamp16(e / 8);
+}
+
+static bool moved(const int16_t* ref, const int16_t* now, int t) {
+  return abs(now[0] - ref[0]) > 8 * t ||
+         abs(now[1] - ref[1]) + abs(now[2] - ref[2]) > 8 * t ||
+         abs(now[3] - ref[3]) > (t ? t + ref[3] / 4 : 0);
+}
+
+size_t jpegDeltaBytes(int mcus, int blocks) {
+  return (size_t)mcus * blocks * sizeof(int16_t[4]) + (size_t)mcus * sizeof(jpeg_mcu_pos_t);
+}
+
+void jpegDeltaInit(jpeg_delta_t* d, int mcus, int blocks, int threshold, void* mem) {
+  memset(d, 0, sizeof(*d));
+  d->mcus_cap = (uint16_t)mcus;
+  d->blocks_cap = (uint8_t)blocks;
+  d->threshold = (uint8_t)(threshold < 0 ? 0 : threshold > 255 ? 255 : threshold);
+  d->pos = mem;                                              // 16-byte entries first, keeps alignment
+  d->sig = (int16_t(*)[4])((uint8_t*)mem + (size_t)mcus * sizeof(jpeg_mcu_pos_t));
+}
+
+// Open jpg and index its scan into d->pos. NULL on error (*err says why).
+static jpeg_decoder_t* openFrame(jpeg_delta_t* d, const uint8_t* jpg, size_t len,
+                                 jpeg_info_t* info, const uint16_t** q, int* err) {
+  jpeg_decoder_t* dec = jpegDecoderOpen(jpg, len, info, err);
+  if (!dec) return NULL;
+  const int h = info->h[0], v = info->v[0];
+  bool ok = h <= 2 && v <= 2 && (int)info->mcus_x * info->mcus_y <= d->mcus_cap &&
+            h * v + info->ncomp - 1 <= d->blocks_cap;
+  for (int c = 1; c < info->ncomp; c++) ok &= info->h[c] == 1 && info->v[c] == 1;
+  q[0] = jpegDecoderQuant(dec, 0);
+  q[1] = info->ncomp == 3 ? jpegDecoderQuant(dec, 1) : q[0];
+  if (info->ncomp == 3) ok &= q[1] == jpegDecoderQuant(dec, 2);
+  for (int k = 0; ok && k < 64; k++) ok &= q[0][k] <= 255 && q[1][k] <= 255;
+  *err = ok ? jpegDecoderIndex(dec, (jpeg_mcu_pos_t*)d->pos) : JPEG_SCAN_ERR_UNSUPP;
+  if (*err != JPEG_SCAN_OK) {
+    jpegDecoderClose(dec);
+    return NULL;
+  }
+  return dec;
+}
+
+int jpegDeltaKey(jpeg_delta_t* d, const uint8_t* jpg, size_t len) {
+  d->keyed = false;
+  int err;
+  jpeg_info_t info;
+  const uint16_t* q[2];
+  jpeg_decoder_t* dec = openFrame(d, jpg, len, &info, q, &err);
+  if (!dec) return err;
+
+  const int luma = info.h[0] * info.v[0], blocks = luma + info.ncomp - 1;
+  const int mcus = info.mcus_x * info.mcus_y;
+  const jpeg_mcu_pos_t* pos = (const jpeg_mcu_pos_t*)d->pos;
+  int16_t zz[JPEG_DELTA_MAX_BLOCKS][64];
+  for (int m = 0; m < mcus && err == JPEG_SCAN_OK; m++) {
+    err = jpegDecodeMcu(dec, &pos[m], zz);
+    for (int b = 0; err == JPEG_SCAN_OK && b < blocks; b++)
+      signature(zz[b], q[b >= luma], d->sig[m * d->blocks_cap + b]);
+  }
+  jpegDecoderClose(dec);
+  if (err != JPEG_SCAN_OK) return err;
+
+  d->width = info.width;
+  d->height = info.height;
+  d->mcus_x = info.mcus_x;
+  d->mcus_y = info.mcus_y;
+  d->ncomp = info.ncomp;
+  d->h = info.h[0];
+  d->v = info.v[0];
+  d->keyed = true;
+  return JPEG_SCAN_OK;
+}
+
+long jpegDeltaPatch(jpeg_delta_t* d, const uint8_t* jpg, size_t len,
+                    uint8_t* out, size_t cap, int* changed) {
+  if (changed) *changed = 0;
+  if (!d->keyed) return JPEG_DELTA_ERR_KEY;
+  d->keyed = false;                                          // until this patch is complete
+  int err;
+  jpeg_info_t info;
+  const uint16_t* q[2];
+  jpeg_decoder_t* dec = openFrame(d, jpg, len, &info, q, &err);
+  if (!dec) return err;
+  if (info.width != d->width || info.height != d->height || info.ncomp != d->ncomp ||
+      info.h[0] != d->h || info.v[0] != d->v) {
+    jpegDecoderClose(dec);
+    return JPEG_DELTA_ERR_KEY;
+  }
+
+  const int luma = d->h * d->v, blocks = luma + d->ncomp - 1;
+  const int mcus = d->mcus_x * d->mcus_y;
+  const size_t limit = len * JPEG_DELTA_KEY_PCT / 100;
+  if (cap < JPEG_DELTA_HEADER + 2 * (size_t)mcus) {
+    jpegDecoderClose(dec);
+    return JPEG_DELTA_ERR_SPACE;
+  }
+
+  // pass 1: signatures; changed MCUs go into the index and take the new
+  // signature (it's what the viewer will have)
+  const jpeg_mcu_pos_t* pos = (const jpeg_mcu_pos_t*)d->pos;
+  int16_t zz[JPEG_DELTA_MAX_BLOCKS][64], now[JPEG_DELTA_MAX_BLOCKS][4];
+  int count = 0;
+  for (int m = 0; m < mcus && err == JPEG_SCAN_OK; m++) {
+    err = jpegDecodeMcu(dec, &pos[m], zz);
+    if (err != JPEG_SCAN_OK) break;
+    int16_t (*ref)[4] = &d->sig[m * d->blocks_cap];
+    bool hit = false;
+    for (int b = 0; b < blocks; b++) {
+      signature(zz[b], q[b >= luma], now[b]);
+      hit = hit || moved(ref[b], now[b], d->threshold);
+    }
+    if (!hit) continue;
+    memcpy(ref, now, sizeof(now[0]) * blocks);
+    put16(out + JPEG_DELTA_HEADER + 2 * count++, (uint16_t)m);
+  }
+  if (err == JPEG_SCAN_OK && (size_t)count * 100 >= (size_t)mcus * JPEG_DELTA_KEY_PCT)
+    err = JPEG_DELTA_ERR_KEY;                                // most of the frame: cheaper as a keyframe
+  if (changed) *changed = count;
+
+  const int cols = count < d->mcus_x ? count : d->mcus_x;
+  memcpy(out, "NZD1", 4);
+  put16(out + 4, d->mcus_x);
+  put16(out + 6, d->mcus_y);
+  out[8] = (uint8_t)(8 * d->h);
+  out[9] = (uint8_t)(8 * d->v);
+  put16(out + 10, (uint16_t)count);
+  put16(out + 12, (uint16_t)cols);
+  put16(out + 14, 0);
+  size_t n = JPEG_DELTA_HEADER + 2 * (size_t)count;
+  if (err != JPEG_SCAN_OK || !count) {
+    jpegDecoderClose(dec);
+    if (err == JPEG_SCAN_OK) d->keyed = true;
+    return err == JPEG_SCAN_OK ? (long)n : err;
+  }
+
+  // pass 2: the changed MCUs again, coefficients as they are, into the strip
+  const int rows = (count + cols - 1) / cols;
+  uint8_t qt[2][64];
+  for (int t = 0; t < 2; t++)
+    for (int k = 0; k < 64; k++) qt[t][k] = (uint8_t)q[t][k];
+  jpeg_frame_t f;
+  memset(&f, 0, sizeof(f));
+  f.width = (uint16_t)(cols * 8 * d->h);
+  f.height = (uint16_t)(rows * 8 * d->v);
+  f.ncomp = d->ncomp;
+  for (int c = 0; c < 3; c++) f.h[c] = f.v[c] = 1;
+  f.h[0] = d->h;
+  f.v[0] = d->v;
+  f.qt[0] = qt[0];
+  f.qt[1] = qt[1];
+  const size_t room = (limit < cap ? limit : cap);
+  size_t hdr = room > n ? jpegWriteHeader(&f, out + n, room - n) : 0;
+  jpeg_bits_t bw;
+  if (hdr) jpegBitsInit(&bw, out + n + hdr, room - n - hdr);
+  int pred[3] = { 0, 0, 0 };
+  static const int16_t ZERO[64] = { 0 };
+  for (int k = 0; hdr && k < rows * cols && !bw.overflow; k++) {
+    if (k < count) {
+      const uint8_t* ix = out + JPEG_DELTA_HEADER + 2 * k;
+      err = jpegDecodeMcu(dec, &pos[ix[0] | ix[1] << 8], zz);
+      if (err != JPEG_SCAN_OK) break;
+    }
+    for (int b = 0; b < blocks; b++)                         // padding after the last: flat grey
+      jpegEncBlock(&bw, k < count ? zz[b] : ZERO, b >= luma, &pred[b < luma ? 0 : b - luma + 1]);
+  }
+  jpegDecoderClose(dec);
+  if (err != JPEG_SCAN_OK) return err;
+  if (hdr) jpegBitsFlush(&bw, -1);
+  if (!hdr || bw.overflow || (size_t)(out + room - bw.p) < 2)
+    return room < cap ? JPEG_DELTA_ERR_KEY : JPEG_DELTA_ERR_SPACE;
+  *bw.p++ = 0xFF;                                            // EOI
+  *bw.p++ = 0xD9;
+  d->keyed = true;
+  return (long)(bw.p - out);
+}
@@ -0,0 +1,449 @@
+/**
+ * Strip JPEG encoder (see jpeg_enc.h).
+ *
+ * Per MCU row the source lines are first converted into planar Y / Cb / Cr
+ * line buffers (one tight loop per format), then each 8x8 block goes through
+ * the AAN forward DCT, quantization by reciprocal multiply and the standard
+ * Huffman tables.
+ */
+#include "jpeg_enc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_tables.h"
+
+#define RECIP_BITS  18
+#define AAN_BITS    8                // fixed-point precision of the DCT rotations
+
+static const uint8_t ZIGZAG[64] = {    // zigzag index -> natural index
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static const uint8_t STD_QT[2][64] = {    // Annex K.1, natural order
+  { 16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99 },
+  { 17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99 },
+};
+
+// AAN output scale per frequency: cos(k*pi/16) * sqrt(2), 1 for DC
+static const double AAN_SCALE[8] = {
+  1.0, 1.387039845, 1.306562965, 1.175875602, 1.0, 0.785694958, 0.541196100, 0.275899379,
+};
+
+// ---------- Huffman code tables ----------
+
+struct HuffCodes {
+  uint16_t code[256];
+  uint8_t  size[256];
+};
+
+static HuffCodes dc_codes[2], ac_codes[2];
+static bool      codes_built = false;
+
+static void buildCodes(HuffCodes* h, const uint8_t* bits, const uint8_t* vals) {
+  memset(h, 0, sizeof(*h));
+  uint16_t code = 0;
+  int k = 0;
+  for (int len = 1; len <= 16; len++) {
+    for (int i = 0; i < bits[len - 1]; i++, k++, code++) {
+      h->code[vals[k]] = code;
+      h->size[vals[k]] = len;
+    }
+    code <<= 1;
+  }
+}
+
+// Called from jpegEncInit(); concurrent first calls write identical tables.
+static void buildAllCodes() {
+  if (codes_built) return;
+  for (int i = 0; i < 2; i++) {
+    buildCodes(&dc_codes[i], STD_DC_BITS[i], STD_DC_VALS);
+    buildCodes(&ac_codes[i], STD_AC_BITS[i], STD_AC_VALS[i]);
+  }
+  codes_built = true;
+}
+
+// ---------- setup + headers ----------
+
+int jpegEncBytesPerPixel(jpeg_enc_format_t format) {
+  switch (format) {
+    case JPEG_ENC_GRAY:   return 1;
+    case JPEG_ENC_RGB888: return 3;
+    default:              return 2;
+  }
+}
+
+bool jpegEncInit(jpeg_enc_t* e, int width, int height, jpeg_enc_format_t format, int quality) {
+  if (width < 1 || height < 1 || width > 0xFFFF || height > 0xFFFF) return false;
+  if (format < JPEG_ENC_GRAY || format > JPEG_ENC_RGB888) return false;
+  if (quality < 1) quality = 1;
+  if (quality > 100) quality = 100;
+  buildAllCodes();
+
+  memset(e, 0, sizeof(*e));
+  e->width = width;
+  e->height = height;
+  e->format = format;
+  e->ncomp = format == JPEG_ENC_GRAY ? 1 : 3;
+  e->mcu_w = format == JPEG_ENC_GRAY ? 8 : 16;
+  e->mcus_x = (width + e->mcu_w - 1) / e->mcu_w;
+  e->mcus_y = (height + 7) / 8;
+
+  int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+  for (int t = 0; t < 2; t++) {
+    for (int i = 0; i < 64; i++) {
+      int q = (STD_QT[t][i] * scale + 50) / 100;
+      q = q < 1 ? 1 : q > 255 ? 255 : q;
+      // the DCT below leaves coefficient (u,v) scaled by 8 * s(u) * s(v)
+      double step = q * AAN_SCALE[i >> 3] * AAN_SCALE[i & 7] * 8.0;
+      e->recip[t][i] = (int32_t)((1 << RECIP_BITS) / step + 0.5);
+    }
+    for (int k = 0; k < 64; k++) {
+      int q = (STD_QT[t][ZIGZAG[k]] * scale + 50) / 100;
+      e->qt[t][k] = q < 1 ? 1 : q > 255 ? 255 : q;
+    }
+  }
+  return true;
+}
+
+static uint8_t* put16(uint8_t* p, unsigned v) {
+  *p++ = v >> 8;
+  *p++ = v & 0xFF;
+  return p;
+}
+
+static uint8_t* putDht(uint8_t* p, int cls, int id, const uint8_t* bits, const uint8_t* vals) {
+  int n = 0;
+  for (int i = 0; i < 16; i++) n += bits[i];
+  p = put16(p, 0xFFC4);
+  p = put16(p, 2 + 1 + 16 + n);
+  *p++ = (uint8_t)(cls << 4 | id);
+  memcpy(p, bits, 16);
+  memcpy(p + 16, vals, n);
+  return p + 16 + n;
+}
+
+size_t jpegWriteHeader(const jpeg_frame_t* f, uint8_t* out, size_t cap) {
+  if (cap < JPEG_ENC_HEADER_MAX || (f->ncomp != 1 && f->ncomp != 3)) return 0;
+  static const uint8_t JFIF[] = { 0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                  0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00 };
+  uint8_t* p = out;
+  memcpy(p, JFIF, sizeof(JFIF));
+  p += sizeof(JFIF);
+
+  int tables = f->ncomp == 1 ? 1 : 2;
+  for (int t = 0; t < tables; t++) {
+    p = put16(p, 0xFFDB);
+    p = put16(p, 2 + 1 + 64);
+    *p++ = (uint8_t)t;
+    memcpy(p, f->qt[t], 64);
+    p += 64;
+  }
+
+  p = put16(p, 0xFFC0);                       // SOF0
+  p = put16(p, 8 + 3 * f->ncomp);
+  *p++ = 8;
+  p = put16(p, f->height);
+  p = put16(p, f->width);
+  *p++ = f->ncomp;
+  for (int c = 0; c < f->ncomp; c++) {
+    *p++ = (uint8_t)(c + 1);
+    *p++ = (uint8_t)(f->h[c] << 4 | f->v[c]);
+    *p++ = c ? 1 : 0;
+  }
+
+  for (int t = 0; t < tables; t++) {
+    p = putDht(p, 0, t, STD_DC_BITS[t], STD_DC_VALS);
+    p = putDht(p, 1, t, STD_AC_BITS[t], STD_AC_VALS[t]);
+  }
+
+  if (f->restart_interval) {
+    p = put16(p, 0xFFDD);                     // DRI
+    p = put16(p, 4);
+    p = put16(p, f->restart_interval);
+  }
+
+  p = put16(p, 0xFFDA);                       // SOS
+  p = put16(p, 6 + 2 * f->ncomp);
+  *p++ = f->ncomp;
+  for (int c = 0; c < f->ncomp; c++) {
+    *p++ = (uint8_t)(c + 1);
+    *p++ = c ? 0x11 : 0x00;
+  }
+  *p++ = 0;
+  *p++ = 63;
+  *p++ = 0;
+  return p - out;
+}
+
+size_t jpegEncHeader(const jpeg_enc_t* e, uint8_t* out, size_t cap) {
+  jpeg_frame_t f;
+  memset(&f, 0, sizeof(f));
+  f.width = e->width;
+  f.height = e->height;
+  f.ncomp = e->ncomp;
+  for (int c = 0; c < 3; c++) f.h[c] = f.v[c] = 1;
+  if (e->ncomp == 3) f.h[0] = 2;             // 4:2:2
+  f.qt[0] = e->qt[0];
+  f.qt[1] = e->qt[1];
+  f.restart_interval = e->mcus_x;            // one MCU row
+  return jpegWriteHeader(&f, out, cap);
+}
+
+// ---------- color conversion ----------
+// One source line -> Y (padded to the MCU grid) and, for color, Cb/Cr at
+// half horizontal resolution. Chroma of a pixel pair is computed from the
+// summed R, G, B (one multiply set per pair, the same as averaging).
+
+#define FIX_Y(r, g, b)   ((19595 * (r) + 38470 * (g) + 7471 * (b) + 32768) >> 16)
+#define FIX_CB(r, g, b)  ((-11059 * (r) - 21709 * (g) + 32768 * (b) + (128 << 17) + 65535) >> 17)
+#define FIX_CR(r, g, b)  ((32768 * (r) - 27439 * (g) - 5329 * (b) + (128 << 17) + 65535) >> 17)
+
+static void convertRgb888(const uint8_t* s, int w, uint8_t* y, uint8_t* cb, uint8_t* cr) {
+  int pairs = w / 2;
+  for (int i = 0; i < pairs; i++, s += 6) {
+    int r0 = s[0], g0 = s[1], b0 = s[2], r1 = s[3], g1 = s[4], b1 = s[5];
+    y[2 * i]     = (uint8_t)FIX_Y(r0, g0, b0);
+    y[2 * i + 1] = (uint8_t)FIX_Y(r1, g1, b1);
+    cb[i] = (uint8_t)FIX_CB(r0 + r1, g0 + g1, b0 + b1);
+    cr[i] = (uint8_t)FIX_CR(r0 + r1, g0 + g1, b0 + b1);
+  }
+  if (w & 1) {
+    int r = s[0], g = s[1], b = s[2];
+    y[w - 1] = (uint8_t)FIX_Y(r, g, b);
+    cb[pairs] = (uint8_t)FIX_CB(2 * r, 2 * g, 2 * b);
+    cr[pairs] = (uint8_t)FIX_CR(2 * r, 2 * g, 2 * b);
+  }
+}
+
+static inline void unpack565(const uint8_t* s, int& r, int& g, int& b) {
+  unsigned p = (unsigned)s[0] << 8 | s[1];
+  r = (p >> 8 & 0xF8) | (p >> 13);
+  g = (p >> 3 & 0xFC) | (p >> 9 & 0x03);
+  b = (p << 3 & 0xF8) | (p >> 2 & 0x07);
+}
+
+static void convertRgb565(const uint8_t* s, int w, uint8_t* y, uint8_t* cb, uint8_t* cr) {
+  int pairs = w / 2;
+  int r0, g0, b0, r1, g1, b1;
+  for (int i = 0; i < pairs; i++, s += 4) {
+    unpack565(s, r0, g0, b0);
+    unpack565(s + 2, r1, g1, b1);
+    y[2 * i]     = (uint8_t)FIX_Y(r0, g0, b0);
+    y[2 * i + 1] = (uint8_t)FIX_Y(r1, g1, b1);
+    cb[i] = (uint8_t)FIX_CB(r0 + r1, g0 + g1, b0 + b1);
+    cr[i] = (uint8_t)FIX_CR(r0 + r1, g0 + g1, b0 + b1);
+  }
+  if (w & 1) {
+    unpack565(s, r0, g0, b0);
+    y[w - 1] = (uint8_t)FIX_Y(r0, g0, b0);
+    cb[pairs] = (uint8_t)FIX_CB(2 * r0, 2 * g0, 2 * b0);
+    cr[pairs] = (uint8_t)FIX_CR(2 * r0, 2 * g0, 2 * b0);
+  }
+}
+
+static void convertYuv422(const uint8_t* s, int w, uint8_t* y, uint8_t* cb, uint8_t* cr) {
+  int pairs = w / 2;
+  for (int i = 0; i < pairs; i++, s += 4) {
+    y[2 * i] = s[0];
+    cb[i] = s[1];
+    y[2 * i + 1] = s[2];
+    cr[i] = s[3];
+  }
+  if (w & 1) {
+    y[w - 1] = s[0];
+    cb[pairs] = s[1];
+    cr[pairs] = s[3];
+  }
+}
+
+// ---------- forward DCT (AAN, integer) ----------
+
+#define MUL(v, c)  (((v) * (c)) >> AAN_BITS)
+#define C_0_382683433  98
+#define C_0_541196100  139
+#define C_0_707106781  181
+#define C_1_306562965  334
+
+static inline void fdct1d(int32_t* d, int stride) {
+  int32_t t0 = d[0] + d[7 * stride], t7 = d[0] - d[7 * stride];
+  int32_t t1 = d[stride] + d[6 * stride], t6 = d[stride] - d[6 * stride];
+  int32_t t2 = d[2 * stride] + d[5 * stride], t5 = d[2 * stride] - d[5 * stride];
+  int32_t t3 = d[3 * stride] + d[4 * stride], t4 = d[3 * stride] - d[4 * stride];
+
+  int32_t t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+  d[0] = t10 + t11;
+  d[4 * stride] = t10 - t11;
+  int32_t z1 = MUL(t12 + t13, C_0_707106781);
+  d[2 * stride] = t13 + z1;
+  d[6 * stride] = t13 - z1;
+
+  t10 = t4 + t5;
+  t11 = t5 + t6;
+  t12 = t6 + t7;
+  int32_t z5 = MUL(t10 - t12, C_0_382683433);
+  int32_t z2 = MUL(t10, C_0_541196100) + z5;
+  int32_t z4 = MUL(t12, C_1_306562965) + z5;
+  int32_t z3 = MUL(t11, C_0_707106781);
+  int32_t z11 = t7 + z3, z13 = t7 - z3;
+  d[5 * stride] = z13 + z2;
+  d[3 * stride] = z13 - z2;
+  d[stride] = z11 + z4;
+  d[7 * stride] = z11 - z4;
+}
+
+// ---------- entropy coding ----------
+
+static inline void putBits(jpeg_bits_t* bw, uint32_t bits, int size) {
+  bw->acc = (bw->acc << size) | bits;
+  bw->n += size;
+  while (bw->n >= 8) {
+    uint8_t b = (uint8_t)(bw->acc >> (bw->n - 8));
+    bw->n -= 8;
+    if (bw->end - bw->p < 2) { bw->overflow = true; continue; }
+    *bw->p++ = b;
+    if (b == 0xFF) *bw->p++ = 0;           // byte stuffing
+  }
+}
+
+static inline int bitLength(int v) {
+  return v ? 32 - __builtin_clz((unsigned)v) : 0;
+}
+
+static inline void entropyBlock(jpeg_bits_t* bw, const int16_t* zz, int* dc_pred,
+                                const HuffCodes* dc, const HuffCodes* ac) {
+  int diff = zz[0] - *dc_pred;
+  *dc_pred = zz[0];
+  int mag = diff < 0 ? -diff : diff;
+  int nb = bitLength(mag);
+  putBits(bw, dc->code[nb], dc->size[nb]);
+  if (nb) putBits(bw, (uint32_t)(diff < 0 ? diff - 1 : diff) & ((1u << nb) - 1), nb);
+
+  int run = 0;
+  for (int k = 1; k < 64; k++) {
+    int v = zz[k];
+    if (!v) { run++; continue; }
+    while (run > 15) {
+      putBits(bw, ac->code[0xF0], ac->size[0xF0]);      // ZRL
+      run -= 16;
+    }
+    mag = v < 0 ? -v : v;
+    nb = bitLength(mag);
+    int sym = run << 4 | nb;
+    putBits(bw, ac->code[sym], ac->size[sym]);
+    putBits(bw, (uint32_t)(v < 0 ? v - 1 : v) & ((1u << nb) - 1), nb);
+    run = 0;
+  }
+  if (run) putBits(bw, ac->code[0x00], ac->size[0x00]);  // EOB
+}
+
+static void encodeBlock(jpeg_bits_t* bw, const uint8_t* src, int stride, const int32_t* recip,
+                        int* dc_pred, const HuffCodes* dc, const HuffCodes* ac) {
+  int32_t d[64];
+  for (int y = 0; y < 8; y++, src += stride)
+    for (int x = 0; x < 8; x++) d[y * 8 + x] = (int32_t)src[x] - 128;
+  for (int i = 0; i < 8; i++) fdct1d(d + i * 8, 1);
+  for (int i = 0; i < 8; i++) fdct1d(d + i, 8);
+
+  int16_t zz[64];
+  for (int k = 0; k < 64; k++) {
+    int i = ZIGZAG[k];
+    int32_t v = d[i];
+    int32_t m = (int32_t)(((uint32_t)(v < 0 ? -v : v) * (uint32_t)recip[i] + (1u << (RECIP_BITS - 1))) >> RECIP_BITS);
+    zz[k] = (int16_t)(v < 0 ? -m : m);
+  }
+  entropyBlock(bw, zz, dc_pred, dc, ac);
+}
+
+void jpegBitsInit(jpeg_bits_t* bw, uint8_t* out, size_t cap) {
+  buildAllCodes();
+  *bw = { out, out + cap, 0, 0, false };
+}
+
+void jpegEncBlock(jpeg_bits_t* bw, const int16_t* zz, bool chroma, int* dc_pred) {
+  entropyBlock(bw, zz, dc_pred, &dc_codes[chroma], &ac_codes[chroma]);
+}
+
+void jpegPutBits(jpeg_bits_t* bw, uint32_t bits, int size) {
+  putBits(bw, bits, size);
+}
+
+void jpegBitsFlush(jpeg_bits_t* bw, int rst) {
+  if (bw->n) putBits(bw, (1u << (8 - bw->n)) - 1, 8 - bw->n);
+  if (rst < 0) return;
+  if (bw->end - bw->p < 2) { bw->overflow = true; return; }
+  *bw->p++ = 0xFF;
+  *bw->p++ = (uint8_t)(0xD0 + (rst & 7));
+}
+
+long jpegEncRows(const jpeg_enc_t* e, const uint8_t* src, int row0, int row1,
+                 uint8_t* out, size_t cap) {
+  if (row0 < 0) row0 = 0;
+  if (row1 > e->mcus_y) row1 = e->mcus_y;
+  const int yw = e->mcus_x * e->mcu_w;           // padded line widths
+  const int cw = e->mcus_x * 8;
+  const int bpp = jpegEncBytesPerPixel((jpeg_enc_format_t)e->format);
+  const size_t line_bytes = (size_t)e->width * bpp;
+  uint8_t* lines = (uint8_t*)malloc((size_t)8 * (yw + (e->ncomp == 3 ? 2 * cw : 0)));
+  if (!lines) return -1;
+  uint8_t* Y = lines;
+  uint8_t* Cb = Y + 8 * yw;
+  uint8_t* Cr = Cb + 8 * cw;
+
+  jpeg_bits_t bw = { out, out + cap, 0, 0, false };
+  const int cw_used = (e->width + 1) / 2;
+  for (int row = row0; row < row1 && !bw.overflow; row++) {
+    for (int j = 0; j < 8; j++) {
+      int sy = row * 8 + j;
+      if (sy >= e->height) sy = e->height - 1;    // replicate the last line
+      const uint8_t* s = src + sy * line_bytes;
+      uint8_t* y = Y + j * yw;
+      uint8_t* cb = Cb + j * cw;
+      uint8_t* cr = Cr + j * cw;
+      switch (e->format) {
+        case JPEG_ENC_GRAY:   memcpy(y, s, e->width); break;
+        case JPEG_ENC_YUV422: convertYuv422(s, e->width, y, cb, cr); break;
+        case JPEG_ENC_RGB565: convertRgb565(s, e->width, y, cb, cr); break;
+        default:              convertRgb888(s, e->width, y, cb, cr); break;
+      }
+      memset(y + e->width, y[e->width - 1], yw - e->width);
+      if (e->ncomp == 3) {
+        memset(cb + cw_used, cb[cw_used - 1], cw - cw_used);
+        memset(cr + cw_used, cr[cw_used - 1], cw - cw_used);
+      }
+    }
+
+    int pred[3] = { 0, 0, 0 };
+    for (int m = 0; m < e->mcus_x; m++) {
+      if (e->ncomp == 1) {
+        encodeBlock(&bw, Y + m * 8, yw, e->recip[0], &pred[0], &dc_codes[0], &ac_codes[0]);
+        continue;
+      }
+      encodeBlock(&bw, Y + m * 16, yw, e->recip[0], &pred[0], &dc_codes[0], &ac_codes[0]);
+      encodeBlock(&bw, Y + m * 16 + 8, yw, e->recip[0], &pred[0], &dc_codes[0], &ac_codes[0]);
+      encodeBlock(&bw, Cb + m * 8, cw, e->recip[1], &pred[1], &dc_codes[1], &ac_codes[1]);
+      encodeBlock(&bw, Cr + m * 8, cw, e->recip[1], &pred[2], &dc_codes[1], &ac_codes[1]);
+    }
+
+    jpegBitsFlush(&bw, row + 1 < e->mcus_y ? row : -1);
+  }
+  free(lines);
+  return bw.overflow ? -1 : (long)(bw.p - out);
+}
@@ -0,0 +1,89 @@
+/**
+ * Grayscale ROI decode (see jpeg_roi.h).
+ *
+ * At 1/scale a block gives n = 8 / scale pixels per side, each the mean of
+ * the scale x scale pixels the full IDCT would produce there. Averaging is
+ * linear, so it folds into the 1-D basis: t[x][u] is the 8-point IDCT basis
+ * of frequency u averaged over output group x. Dropping the high
+ * frequencies instead (an n-point IDCT of the low coefficients) rings by
+ * 20+ levels at a sharp edge, which is where the locator looks. n = 1
+ * leaves the DC term alone (every AC basis averages to 0 over a block).
+ */
+#include "jpeg_roi.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "jpeg_scan.h"
+
+static const uint8_t ZIGZAG[64] = {    // zigzag index -> natural index
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+struct RoiCtx {
+  int             n;                  // output pixels per block side
+  int             x0, y0, w, h;
+  uint8_t*        gray;
+  const uint16_t* q;                  // luma quantizers, zigzag order
+  float           t[8][8];            // t[x][u]: 8-point basis averaged over group x
+};
+
+static void putBlock(void* arg, int bx, int by, const int16_t* zz) {
+  RoiCtx* c = (RoiCtx*)arg;
+  const int n = c->n;
+  float rows[8][8];                   // rows[v][x]: horizontal pass, frequency v
+  memset(rows, 0, sizeof(rows));
+  for (int k = 0; k < 64; k++) {
+    if (!zz[k]) continue;
+    int nat = ZIGZAG[k], u = nat & 7, v = nat >> 3;
+    float f = (float)(zz[k] * c->q[k]);
+    for (int x = 0; x < n; x++) rows[v][x] += c->t[x][u] * f;
+  }
+
+  int xs = bx * n, ys = by * n;
+  for (int y = 0; y < n; y++) {
+    int py = ys + y - c->y0;
+    if (py < 0 || py >= c->h) continue;
+    uint8_t* dst = c->gray + (size_t)py * c->w;
+    for (int x = 0; x < n; x++) {
+      int px = xs + x - c->x0;
+      if (px < 0 || px >= c->w) continue;
+      float s = 128.5f;
+      for (int v = 0; v < 8; v++) s += c->t[y][v] * rows[v][x];
+      dst[px] = (uint8_t)(s < 0 ? 0 : s > 255 ? 255 : (int)s);
+    }
+  }
+}
+
+int jpegDecodeGray(const uint8_t* jpg, size_t len, int scale, int x0, int y0, int w, int h,
+                   uint8_t* gray) {
+  if (scale != 1 && scale != 2 && scale != 4 && scale != 8) return JPEG_SCAN_ERR_UNSUPP;
+  int err;
+  jpeg_info_t info;
+  jpeg_decoder_t* dec = jpegDecoderOpen(jpg, len, &info, &err);
+  if (!dec) return err;
+  int sw = (info.width + scale - 1) / scale, sh = (info.height + scale - 1) / scale;
+  if (x0 < 0 || y0 < 0 || w <= 0 || h <= 0 || x0 + w > sw || y0 + h > sh) {
+    jpegDecoderClose(dec);
+    return JPEG_SCAN_ERR_FORMAT;
+  }
+
+  RoiCtx c;
+  c.n = 8 / scale;
+  c.x0 = x0; c.y0 = y0; c.w = w; c.h = h;
+  c.gray = gray;
+  c.q = jpegDecoderQuant(dec, 0);
+  for (int x = 0; x < c.n; x++)
+    for (int u = 0; u < 8; u++) {
+      float sum = 0;
+      for (int i = x * scale; i < (x + 1) * scale; i++) sum += cosf((2 * i + 1) * u * (float)M_PI / 16);
+      c.t[x][u] = sqrtf((u ? 2.0f : 1.0f) / 8) * sum / scale;
+    }
+  err = jpegDecodeLuma(dec, x0 / c.n, y0 / c.n, (x0 + w + c.n - 1) / c.n, (y0 + h + c.n - 1) / c.n,
+                       putBlock, &c);
+  jpegDecoderClose(dec);
+  return err;
+}
@@ -0,0 +1,138 @@
+/**
+ * Lossless JPEG rotation (see jpeg_rot.h).
+ *
+ * Coefficient (u, v) = (horizontal, vertical frequency) of a block maps as
+ *   90   transpose, then mirror x:  D(u, v) = (-1)^u S(v, u)
+ *   270  transpose, then mirror y:  D(u, v) = (-1)^v S(v, u)
+ *   180  mirror both:               D(u, v) = (-1)^(u+v) S(u, v)
+ * and the same mapping, applied to block and MCU coordinates, says where
+ * each source block lands.
+ */
+#include "jpeg_rot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_enc.h"
+#include "jpeg_scan.h"
+
+#define MAX_BLOCKS 6                  // 2x2 luma + Cb + Cr
+
+static const uint8_t ZIGZAG[64] = {    // zigzag index -> natural index
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+struct CoefMap {
+  uint8_t src[64];                    // destination zigzag index -> source zigzag index
+  bool    neg[64];
+};
+
+static void buildMap(int degrees, CoefMap* m) {
+  uint8_t unzig[64];
+  for (int k = 0; k < 64; k++) unzig[ZIGZAG[k]] = (uint8_t)k;
+  for (int k = 0; k < 64; k++) {
+    int n = ZIGZAG[k], u = n & 7, v = n >> 3;
+    m->src[k] = unzig[degrees == 180 ? n : u * 8 + v];
+    m->neg[k] = (degrees == 90 ? u : degrees == 270 ? v : u + v) & 1;
+  }
+}
+
+static inline void transform(const CoefMap* m, const int16_t* s, int16_t* d) {
+  for (int k = 0; k < 64; k++) {
+    int16_t c = s[m->src[k]];
+    d[k] = m->neg[k] ? (int16_t)-c : c;
+  }
+}
+
+long jpegRotate(const uint8_t* jpg, size_t len, int degrees, uint8_t* out, size_t cap) {
+  if (degrees != 90 && degrees != 180 && degrees != 270) return JPEG_SCAN_ERR_UNSUPP;
+  int err;
+  jpeg_info_t info;
+  jpeg_decoder_t* d = jpegDecoderOpen(jpg, len, &info, &err);
+  if (!d) return err;
+
+  // luma 1x1, 2x1, 1x2 or 2x2 with 1x1 chroma sharing one table
+  const int h = info.h[0], v = info.v[0];
+  bool ok = h <= 2 && v <= 2;
+  for (int c = 1; c < info.ncomp; c++) ok &= info.h[c] == 1 && info.v[c] == 1;
+  if (info.ncomp == 3) ok &= jpegDecoderQuant(d, 1) == jpegDecoderQuant(d, 2);
+  const bool swap = degrees != 180;
+  uint8_t qt[2][64];
+  for (int t = 0; ok && t < (info.ncomp == 3 ? 2 : 1); t++) {
+    const uint16_t* q = jpegDecoderQuant(d, t);
+    CoefMap m;
+    buildMap(swap ? 90 : 180, &m);            // tables only move, signs don't apply
+    for (int k = 0; k < 64; k++) {
+      ok &= q[m.src[k]] <= 255;
+      qt[t][k] = (uint8_t)q[m.src[k]];
+    }
+  }
+  const int mx_n = info.width / (8 * h), my_n = info.height / (8 * v);    // whole MCUs
+  if (!ok || !mx_n || !my_n) {
+    jpegDecoderClose(d);
+    return JPEG_SCAN_ERR_UNSUPP;
+  }
+
+  jpeg_mcu_pos_t* pos = (jpeg_mcu_pos_t*)malloc((size_t)info.mcus_x * info.mcus_y * sizeof(jpeg_mcu_pos_t));
+  if (!pos) {
+    jpegDecoderClose(d);
+    return JPEG_SCAN_ERR_DATA;
+  }
+  err = jpegDecoderIndex(d, pos);
+
+  jpeg_frame_t f;
+  memset(&f, 0, sizeof(f));
+  f.width = swap ? my_n * 8 * v : mx_n * 8 * h;
+  f.height = swap ? mx_n * 8 * h : my_n * 8 * v;
+  f.ncomp = info.ncomp;
+  for (int c = 0; c < 3; c++) f.h[c] = f.v[c] = 1;
+  f.h[0] = swap ? v : h;
+  f.v[0] = swap ? h : v;
+  f.qt[0] = qt[0];
+  f.qt[1] = qt[1];
+  size_t hdr = err == JPEG_SCAN_OK ? jpegWriteHeader(&f, out, cap) : 0;
+  if (err == JPEG_SCAN_OK && !hdr) err = JPEG_ROT_ERR_SPACE;
+
+  CoefMap map;
+  buildMap(degrees, &map);
+  jpeg_bits_t bw;
+  jpegBitsInit(&bw, out + hdr, cap - hdr - (cap > hdr + 2 ? 2 : 0));
+  int pred[3] = { 0, 0, 0 };
+  int16_t src[MAX_BLOCKS][64], blk[64];
+  const int dmx = swap ? my_n : mx_n, dmy = swap ? mx_n : my_n;
+  const int dh = f.h[0], dv = f.v[0];
+
+  for (int dy = 0; dy < dmy && err == JPEG_SCAN_OK && !bw.overflow; dy++) {
+    for (int dx = 0; dx < dmx; dx++) {
+      int sx = degrees == 90 ? dy : degrees == 270 ? mx_n - 1 - dy : mx_n - 1 - dx;
+      int sy = degrees == 90 ? my_n - 1 - dx : degrees == 270 ? dx : my_n - 1 - dy;
+      err = jpegDecodeMcu(d, &pos[sy * info.mcus_x + sx], src);
+      if (err != JPEG_SCAN_OK) break;
+
+      for (int j = 0; j < dv; j++) {
+        for (int i = 0; i < dh; i++) {
+          int si = degrees == 90 ? j : degrees == 270 ? h - 1 - j : h - 1 - i;
+          int sj = degrees == 90 ? v - 1 - i : degrees == 270 ? i : v - 1 - j;
+          transform(&map, src[sj * h + si], blk);
+          jpegEncBlock(&bw, blk, false, &pred[0]);
+        }
+      }
+      for (int c = 1; c < info.ncomp; c++) {
+        transform(&map, src[h * v + c - 1], blk);
+        jpegEncBlock(&bw, blk, true, &pred[c]);
+      }
+    }
+  }
+  jpegBitsFlush(&bw, -1);
+  free(pos);
+  jpegDecoderClose(d);
+
+  if (err != JPEG_SCAN_OK) return err;
+  if (bw.overflow || cap - (bw.p - out) < 2) return JPEG_ROT_ERR_SPACE;
+  *bw.p++ = 0xFF;                               // EOI
+  *bw.p++ = 0xD9;
+  return (long)(bw.p - out);
+}
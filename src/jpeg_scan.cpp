@@ -0,0 +1,494 @@
+/**
+ * Entropy-only JPEG scanner (see jpeg_scan.h).
+ */
+#include "jpeg_scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_tables.h"
+
+#define HUFF_FAST_BITS  8
+#define HUFF_IDS        2            // baseline allows 4; nobody uses more than 2
+
+struct HuffTable {
+  bool     present;
+  uint16_t fast[1 << HUFF_FAST_BITS];   // (len << 8) | symbol, 0 = slow path
+  int32_t  maxcode[18];
+  int32_t  valptr[17];
+  int32_t  mincode[17];
+  uint8_t  vals[256];
+};
+
+struct ScanState {
+  HuffTable dc[HUFF_IDS], ac[HUFF_IDS];
+  uint8_t   comp_id[3];
+  uint8_t   comp_tq[3];
+  uint8_t   comp_td[3], comp_ta[3];
+  uint16_t  qt[4][64];                  // zigzag order
+};
+
+struct BitReader {
+  const uint8_t* p;
+  const uint8_t* end;
+  uint32_t buf;
+  int      bits;
+  bool     marker;      // hit a marker: feed zeros until restart
+  bool     overrun;     // ran off the end of the buffer
+  uint32_t fed;         // bytes shifted into buf (unstuffed), for bit positions
+};
+
+// ---------- Huffman tables ----------
+
+static bool buildTable(HuffTable* t, const uint8_t* bits, const uint8_t* vals) {
+  int total = 0;
+  for (int i = 0; i < 16; i++) total += bits[i];
+  if (total > 256) return false;
+  memcpy(t->vals, vals, total);
+  memset(t->fast, 0, sizeof(t->fast));
+
+  int32_t code = 0;
+  int k = 0;
+  for (int len = 1; len <= 16; len++) {
+    int n = bits[len - 1];
+    t->valptr[len] = k;
+    t->mincode[len] = code;
+    for (int i = 0; i < n; i++, k++, code++) {
+      if (len <= HUFF_FAST_BITS) {
+        int shift = HUFF_FAST_BITS - len;
+        for (int j = 0; j < (1 << shift); j++)
+          t->fast[(code << shift) | j] = (uint16_t)((len << 8) | t->vals[k]);
+      }
+    }
+    t->maxcode[len] = n ? code - 1 : -1;
+    if (code > (1 << len)) return false;        // over-subscribed
+    code <<= 1;
+  }
+  t->maxcode[17] = 0x7FFFFFFF;
+  t->present = true;
+  return true;
+}
+
+// ---------- bit reader ----------
+
+static inline void fill(BitReader* br) {
+  while (br->bits <= 24) {
+    uint32_t b = 0;
+    if (!br->marker) {
+      if (br->p < br->end) {
+        b = *br->p++;
+        if (b == 0xFF) {
+          if (br->p < br->end && *br->p == 0x00) br->p++;    // stuffed byte
+          else { br->marker = true; br->p--; b = 0; }         // leave p on the marker
+        }
+      } else {
+        br->overrun = true;
+      }
+    }
+    br->buf |= b << (24 - br->bits);
+    br->bits += 8;
+    br->fed++;
+  }
+}
+
+static inline int decodeSym(BitReader* br, const HuffTable* t) {
+  fill(br);
+  uint16_t f = t->fast[br->buf >> (32 - HUFF_FAST_BITS)];
+  if (f) {
+    int len = f >> 8;
+    br->buf <<= len;
+    br->bits -= len;
+    return f & 0xFF;
+  }
+  for (int len = HUFF_FAST_BITS + 1; len <= 16; len++) {
+    int32_t code = (int32_t)(br->buf >> (32 - len));
+    if (code <= t->maxcode[len]) {
+      br->buf <<= len;
+      br->bits -= len;
+      return t->vals[t->valptr[len] + code - t->mincode[len]];
+    }
+  }
+  return -1;
+}
+
+static inline int receiveExtend(BitReader* br, int s) {
+  if (!s) return 0;
+  fill(br);
+  int v = (int)(br->buf >> (32 - s));
+  br->buf <<= s;
+  br->bits -= s;
+  return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+// Skip to just past the next RSTn marker and reset the reader.
+static bool restart(BitReader* br) {
+  br->buf = 0;
+  br->bits = 0;
+  br->marker = false;
+  while (br->p + 1 < br->end) {
+    if (br->p[0] == 0xFF && br->p[1] >= 0xD0 && br->p[1] <= 0xD7) {
+      br->p += 2;
+      return true;
+    }
+    br->p++;
+  }
+  return false;
+}
+
+// ---------- headers ----------
+
+static inline uint16_t be16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+static int parseHeaders(const uint8_t* jpg, size_t len, jpeg_info_t* info, ScanState* st) {
+  memset(info, 0, sizeof(*info));
+  if (len < 4 || jpg[0] != 0xFF || jpg[1] != 0xD8) return JPEG_SCAN_ERR_FORMAT;
+  bool have_sof = false, have_dht = false;
+  size_t pos = 2;
+
+  while (pos + 4 <= len) {
+    if (jpg[pos] != 0xFF) return JPEG_SCAN_ERR_FORMAT;
+    uint8_t m = jpg[pos + 1];
+    if (m == 0xFF) { pos++; continue; }                      // fill byte
+    size_t seg = be16(jpg + pos + 2);
+    const uint8_t* p = jpg + pos + 4;
+    if (seg < 2 || pos + 2 + seg > len) return JPEG_SCAN_ERR_FORMAT;
+    const uint8_t* end = jpg + pos + 2 + seg;
+
+    if (m == 0xDB) {                                         // DQT
+      while (p < end) {
+        int pq = *p >> 4, tq = *p & 3;
+        p++;
+        for (int k = 0; k < 64 && p + (pq ? 2 * k + 1 : k) < end; k++)
+          st->qt[tq][k] = pq ? be16(p + 2 * k) : p[k];
+        p += pq ? 128 : 64;
+      }
+    } else if (m == 0xC0 || m == 0xC1) {                     // SOF0/1 (baseline/extended Huffman)
+      if (p[0] != 8) return JPEG_SCAN_ERR_UNSUPP;
+      info->height = be16(p + 1);
+      info->width = be16(p + 3);
+      info->ncomp = p[5];
+      if (info->ncomp != 1 && info->ncomp != 3) return JPEG_SCAN_ERR_UNSUPP;
+      for (int c = 0; c < info->ncomp; c++) {
+        st->comp_id[c] = p[6 + c * 3];
+        info->h[c] = p[7 + c * 3] >> 4;
+        info->v[c] = p[7 + c * 3] & 15;
+        st->comp_tq[c] = p[8 + c * 3] & 3;
+        if (!info->h[c] || !info->v[c]) return JPEG_SCAN_ERR_FORMAT;
+      }
+      have_sof = true;
+    } else if ((m >= 0xC2 && m <= 0xCB && m != 0xC4 && m != 0xC8) || (m >= 0xCD && m <= 0xCF)) {
+      return JPEG_SCAN_ERR_UNSUPP;                           // progressive / lossless / arithmetic
+    } else if (m == 0xC4) {                                  // DHT
+      while (p + 17 <= end) {
+        int tc = *p >> 4, th = *p & 15;
+        const uint8_t* bits = p + 1;
+        int total = 0;
+        for (int i = 0; i < 16; i++) total += bits[i];
+        if (p + 17 + total > end) return JPEG_SCAN_ERR_FORMAT;
+        if (th < HUFF_IDS && !buildTable(tc ? &st->ac[th] : &st->dc[th], bits, p + 17))
+          return JPEG_SCAN_ERR_FORMAT;
+        p += 17 + total;
+      }
+      have_dht = true;
+    } else if (m == 0xDD) {                                  // DRI
+      info->restart_interval = be16(p);
+    } else if (m == 0xDA) {                                  // SOS
+      if (!have_sof || p[0] != info->ncomp) return JPEG_SCAN_ERR_UNSUPP;
+      for (int i = 0; i < info->ncomp; i++) {
+        uint8_t id = p[1 + i * 2], tbl = p[2 + i * 2];
+        int c = 0;
+        while (c < info->ncomp && st->comp_id[c] != id) c++;
+        if (c == info->ncomp || c != i) return JPEG_SCAN_ERR_FORMAT;
+        st->comp_td[c] = tbl >> 4;
+        st->comp_ta[c] = tbl & 15;
+        if (st->comp_td[c] >= HUFF_IDS || st->comp_ta[c] >= HUFF_IDS) return JPEG_SCAN_ERR_UNSUPP;
+      }
+      info->scan_offset = pos + 2 + seg;
+      break;
+    } else if (m == 0xD9) {
+      return JPEG_SCAN_ERR_FORMAT;
+    }
+    pos += 2 + seg;
+  }
+  if (!info->scan_offset) return JPEG_SCAN_ERR_FORMAT;
+
+  if (!have_dht) {                                           // MJPEG style: standard tables
+    for (int i = 0; i < 2; i++) {
+      buildTable(&st->dc[i], STD_DC_BITS[i], STD_DC_VALS);
+      buildTable(&st->ac[i], STD_AC_BITS[i], STD_AC_VALS[i]);
+    }
+  }
+
+  int hmax = 1, vmax = 1;
+  for (int c = 0; c < info->ncomp; c++) {
+    if (info->h[c] > hmax) hmax = info->h[c];
+    if (info->v[c] > vmax) vmax = info->v[c];
+  }
+  if (info->ncomp == 1) { info->h[0] = info->v[0] = 1; hmax = vmax = 1; }
+  info->mcus_x = (info->width + 8 * hmax - 1) / (8 * hmax);
+  info->mcus_y = (info->height + 8 * vmax - 1) / (8 * vmax);
+  for (int c = 0; c < info->ncomp; c++) {
+    info->blocks_x[c] = info->mcus_x * info->h[c];
+    info->blocks_y[c] = info->mcus_y * info->v[c];
+    info->qdc[c] = st->qt[st->comp_tq[c]][0];
+    if (!info->qdc[c]) info->qdc[c] = 1;
+  }
+  return JPEG_SCAN_OK;
+}
+
+int jpegScanHeaders(const uint8_t* jpg, size_t len, jpeg_info_t* info) {
+  ScanState* st = (ScanState*)calloc(1, sizeof(ScanState));
+  if (!st) return JPEG_SCAN_ERR_DATA;
+  int r = parseHeaders(jpg, len, info, st);
+  free(st);
+  return r;
+}
+
+// ---------- entropy scan ----------
+
+// One block: DC into *pred, AC either summed (|AC|), stored (zz, zigzag order,
+// must be zeroed by the caller) or skipped. Returns false on corrupt data.
+static inline bool decodeBlock(BitReader* br, const HuffTable* dc, const HuffTable* act,
+                               int* pred, int* ac_sum, int16_t* zz) {
+  int t = decodeSym(br, dc);
+  if (t < 0 || t > 11) return false;
+  *pred += receiveExtend(br, t);
+  if (zz) zz[0] = (int16_t)*pred;
+
+  int ac = 0;
+  for (int k = 1; k < 64; k++) {
+    int rs = decodeSym(br, act);
+    if (rs < 0) return false;
+    int s = rs & 15, run = rs >> 4;
+    if (!s) {
+      if (run != 15) break;                        // EOB
+      k += 15;                                     // ZRL
+      continue;
+    }
+    k += run;
+    if (k > 63) return false;
+    if (zz) zz[k] = (int16_t)receiveExtend(br, s);
+    else if (ac_sum) ac += abs(receiveExtend(br, s));
+    else { fill(br); br->buf <<= s; br->bits -= s; }
+  }
+  if (ac_sum) *ac_sum = ac;
+  return true;
+}
+
+int jpegScan(const uint8_t* jpg, size_t len, uint32_t flags,
+             jpeg_block_fn fn, void* ctx, jpeg_info_t* info) {
+  ScanState* st = (ScanState*)calloc(1, sizeof(ScanState));
+  if (!st) return JPEG_SCAN_ERR_DATA;
+  jpeg_info_t local;
+  if (!info) info = &local;
+  int r = parseHeaders(jpg, len, info, st);
+  if (r != JPEG_SCAN_OK) { free(st); return r; }
+
+  const HuffTable* dct[3];
+  const HuffTable* act[3];
+  for (int c = 0; c < info->ncomp; c++) {
+    dct[c] = &st->dc[st->comp_td[c]];
+    act[c] = &st->ac[st->comp_ta[c]];
+    if (!dct[c]->present || !act[c]->present) { free(st); return JPEG_SCAN_ERR_FORMAT; }
+  }
+
+  BitReader br = { jpg + info->scan_offset, jpg + len, 0, 0, false, false, 0 };
+  int pred[3] = { 0, 0, 0 };
+  bool want_ac = flags & JPEG_SCAN_AC;
+  int report = (flags & JPEG_SCAN_LUMA_ONLY) ? 1 : info->ncomp;
+  uint16_t ri = info->restart_interval, left = ri;
+  r = JPEG_SCAN_OK;
+
+  for (int my = 0; my < info->mcus_y && r == JPEG_SCAN_OK; my++) {
+    for (int mx = 0; mx < info->mcus_x; mx++) {
+      if (ri) {
+        if (!left) {
+          if (!restart(&br)) { r = JPEG_SCAN_ERR_DATA; break; }
+          pred[0] = pred[1] = pred[2] = 0;
+          left = ri;
+        }
+        left--;
+      }
+      for (int c = 0; c < info->ncomp; c++) {
+        for (int j = 0; j < info->v[c]; j++) {
+          for (int i = 0; i < info->h[c]; i++) {
+            int ac = 0;
+            if (!decodeBlock(&br, dct[c], act[c], &pred[c], want_ac ? &ac : NULL, NULL)) {
+              r = JPEG_SCAN_ERR_DATA;
+              goto out;
+            }
+            if (fn && c < report)
+              fn(ctx, c, mx * info->h[c] + i, my * info->v[c] + j, pred[c] * info->qdc[c], ac);
+          }
+        }
+      }
+      if (br.overrun) { r = JPEG_SCAN_ERR_DATA; goto out; }
+    }
+  }
+out:
+  free(st);
+  return r;
+}
+
+// ---------- random access ----------
+
+struct jpeg_decoder_t {
+  ScanState        st;
+  jpeg_info_t      info;
+  const uint8_t*   jpg;
+  size_t           len;
+  const HuffTable* dct[3];
+  const HuffTable* act[3];
+};
+
+jpeg_decoder_t* jpegDecoderOpen(const uint8_t* jpg, size_t len, jpeg_info_t* info, int* err) {
+  jpeg_decoder_t* d = (jpeg_decoder_t*)calloc(1, sizeof(jpeg_decoder_t));
+  int r = d ? parseHeaders(jpg, len, &d->info, &d->st) : JPEG_SCAN_ERR_DATA;
+  for (int c = 0; r == JPEG_SCAN_OK && c < d->info.ncomp; c++) {
+    d->dct[c] = &d->st.dc[d->st.comp_td[c]];
+    d->act[c] = &d->st.ac[d->st.comp_ta[c]];
+    if (!d->dct[c]->present || !d->act[c]->present) r = JPEG_SCAN_ERR_FORMAT;
+  }
+  if (err) *err = r;
+  if (r != JPEG_SCAN_OK) {
+    free(d);
+    return NULL;
+  }
+  d->jpg = jpg;
+  d->len = len;
+  if (info) *info = d->info;
+  return d;
+}
+
+void jpegDecoderClose(jpeg_decoder_t* d) {
+  free(d);
+}
+
+const uint16_t* jpegDecoderQuant(const jpeg_decoder_t* d, int comp) {
+  return d->st.qt[d->st.comp_tq[comp]];
+}
+
+int jpegDecoderIndex(jpeg_decoder_t* d, jpeg_mcu_pos_t* pos) {
+  const jpeg_info_t& info = d->info;
+  BitReader br = { d->jpg + info.scan_offset, d->jpg + d->len, 0, 0, false, false, 0 };
+  int pred[3] = { 0, 0, 0 };
+  uint16_t ri = info.restart_interval, left = ri;
+
+  for (int m = 0; m < info.mcus_x * info.mcus_y; m++) {
+    if (ri) {
+      if (!left) {
+        if (!restart(&br)) return JPEG_SCAN_ERR_DATA;
+        pred[0] = pred[1] = pred[2] = 0;
+        left = ri;
+      }
+      left--;
+    }
+    jpeg_mcu_pos_t& p = pos[m];
+    p.offset = (uint32_t)(br.p - d->jpg);
+    p.buf = br.buf;
+    p.bits = (uint8_t)br.bits;
+    p.marker = br.marker;
+    for (int c = 0; c < 3; c++) p.pred[c] = (int16_t)pred[c];
+
+    for (int c = 0; c < info.ncomp; c++)
+      for (int b = 0; b < info.h[c] * info.v[c]; b++)
+        if (!decodeBlock(&br, d->dct[c], d->act[c], &pred[c], NULL, NULL)) return JPEG_SCAN_ERR_DATA;
+    if (br.overrun) return JPEG_SCAN_ERR_DATA;
+  }
+  return JPEG_SCAN_OK;
+}
+
+int jpegDecodeMcu(const jpeg_decoder_t* d, const jpeg_mcu_pos_t* pos, int16_t (*zz)[64]) {
+  const jpeg_info_t& info = d->info;
+  BitReader br = { d->jpg + pos->offset, d->jpg + d->len, pos->buf, pos->bits, pos->marker != 0, false, 0 };
+  int n = 0;
+  for (int c = 0; c < info.ncomp; c++) {
+    int pred = pos->pred[c];
+    for (int b = 0; b < info.h[c] * info.v[c]; b++, n++) {
+      memset(zz[n], 0, sizeof(zz[n]));
+      if (!decodeBlock(&br, d->dct[c], d->act[c], &pred, NULL, zz[n])) return JPEG_SCAN_ERR_DATA;
+    }
+  }
+  return br.overrun ? JPEG_SCAN_ERR_DATA : JPEG_SCAN_OK;
+}
+
+int jpegDecodeLuma(const jpeg_decoder_t* d, int bx0, int by0, int bx1, int by1,
+                   jpeg_coef_fn fn, void* ctx) {
+  const jpeg_info_t& info = d->info;
+  BitReader br = { d->jpg + info.scan_offset, d->jpg + d->len, 0, 0, false, false, 0 };
+  int pred[3] = { 0, 0, 0 };
+  uint16_t ri = info.restart_interval, left = ri;
+  const int h = info.h[0], v = info.v[0];
+  const int rows = (by1 + v - 1) / v < info.mcus_y ? (by1 + v - 1) / v : info.mcus_y;
+  int16_t zz[64];
+
+  for (int my = 0; my < rows; my++) {
+    for (int mx = 0; mx < info.mcus_x; mx++) {
+      if (ri) {
+        if (!left) {
+          if (!restart(&br)) return JPEG_SCAN_ERR_DATA;
+          pred[0] = pred[1] = pred[2] = 0;
+          left = ri;
+        }
+        left--;
+      }
+      for (int c = 0; c < info.ncomp; c++) {
+        for (int j = 0; j < info.v[c]; j++) {
+          for (int i = 0; i < info.h[c]; i++) {
+            int bx = mx * h + i, by = my * v + j;
+            bool want = !c && bx >= bx0 && bx < bx1 && by >= by0 && by < by1;
+            if (want) memset(zz, 0, sizeof(zz));
+            if (!decodeBlock(&br, d->dct[c], d->act[c], &pred[c], NULL, want ? zz : NULL))
+              return JPEG_SCAN_ERR_DATA;
+            if (want) fn(ctx, bx, by, zz);
+          }
+        }
+      }
+      if (br.overrun) return JPEG_SCAN_ERR_DATA;
+    }
+  }
+  return JPEG_SCAN_OK;
+}
+
+int jpegDecoderIntervals(const jpeg_decoder_t* d, jpeg_interval_t* iv, int n) {
+  const jpeg_info_t& info = d->info;
+  const int total = info.mcus_x * info.mcus_y;
+  const int ri = info.restart_interval ? info.restart_interval : total;
+  if (n != (total + ri - 1) / ri) return JPEG_SCAN_ERR_FORMAT;
+  BitReader br = { d->jpg + info.scan_offset, d->jpg + d->len, 0, 0, false, false, 0 };
+
+  for (int i = 0, m = 0; i < n; i++) {
+    if (i && !restart(&br)) return JPEG_SCAN_ERR_DATA;
+    br.fed = 0;
+    iv[i].start = (uint32_t)(br.p - d->jpg);
+    int pred[3] = { 0, 0, 0 };
+    for (int k = 0; k < ri && m < total; k++, m++) {
+      for (int c = 0; c < info.ncomp; c++)
+        for (int b = 0; b < info.h[c] * info.v[c]; b++) {
+          if (!decodeBlock(&br, d->dct[c], d->act[c], &pred[c], NULL, NULL)) return JPEG_SCAN_ERR_DATA;
+          if (!k && !c && !b) iv[i].dc = (int16_t)pred[0];    // predictor was 0
+        }
+      if (br.overrun) return JPEG_SCAN_ERR_DATA;
+    }
+    iv[i].bits = br.fed * 8 - br.bits;
+    int mag = iv[i].dc < 0 ? -iv[i].dc : iv[i].dc, s = 0;
+    while (mag >> s) s++;
+    uint16_t code;
+    iv[i].dc_bits = (uint8_t)(jpegDecoderDcCode(d, 0, s, &code) + s);
+  }
+  return JPEG_SCAN_OK;
+}
+
+int jpegDecoderDcCode(const jpeg_decoder_t* d, int comp, int s, uint16_t* code) {
+  const HuffTable* t = d->dct[comp];
+  for (int len = 1; len <= 16; len++) {
+    if (t->maxcode[len] < 0) continue;
+    int count = t->maxcode[len] - t->mincode[len] + 1;
+    for (int k = 0; k < count; k++) {
+      if (t->vals[t->valptr[len] + k] != s) continue;
+      *code = (uint16_t)(t->mincode[len] + k);
+      return len;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * LZ4 block codec (see lz4block.h).
+ *
+ * Greedy single-probe matcher: one hash table slot per 4-byte prefix and an
+ * accelerating skip over incompressible runs, which is what keeps it fast on
+ * sensor noise. Loads go through memcpy because Xtensa traps on unaligned
+ * 32-bit reads.
+ */
+#include "lz4block.h"
+
+#include <string.h>
+
+#define MIN_MATCH      4
+#define LAST_LITERALS  5     // block must end with at least this many literals
+#define MF_LIMIT       12    // no match may start closer than this to the end
+#define MAX_DISTANCE   65535
+#define SKIP_TRIGGER   6
+
+static inline uint32_t read32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+  return (v * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline uint8_t* writeLength(uint8_t* op, size_t len) {
+  while (len >= 255) { *op++ = 255; len -= 255; }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+size_t lz4Compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap, uint32_t* table) {
+  if (cap < lz4CompressBound(n)) return 0;
+
+  const uint8_t* ip = src;
+  const uint8_t* anchor = src;
+  const uint8_t* const iend = src + n;
+  const uint8_t* const mflimit = n > MF_LIMIT ? iend - MF_LIMIT : src;
+  const uint8_t* const matchlimit = n > LAST_LITERALS ? iend - LAST_LITERALS : src;
+  uint8_t* op = dst;
+
+  if (n > MF_LIMIT) {
+    for (uint32_t i = 0; i < LZ4_HASH_ENTRIES; i++) table[i] = 0;
+    ip++;
+
+    while (ip < mflimit) {
+      // find a match, skipping faster the longer we miss
+      const uint8_t* ref;
+      uint32_t attempts = 1u << SKIP_TRIGGER;
+      for (;;) {
+        uint32_t h = hash4(read32(ip));
+        ref = src + table[h];
+        table[h] = (uint32_t)(ip - src);
+        if (ref < ip && ip - ref <= MAX_DISTANCE && read32(ref) == read32(ip)) break;
+        ip += attempts++ >> SKIP_TRIGGER;
+        if (ip >= mflimit) goto last_literals;
+      }
+
+      // extend backwards over pending literals
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) { ip--; ref--; }
+
+      // extend forwards
+      const uint8_t* mp = ip + MIN_MATCH;
+      const uint8_t* rp = ref + MIN_MATCH;
+      while (mp < matchlimit && *mp == *rp) { mp++; rp++; }
+
+      size_t lit = (size_t)(ip - anchor);
+      size_t mlen = (size_t)(mp - ip) - MIN_MATCH;
+      uint8_t* token = op++;
+      *token = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+      if (lit >= 15) op = writeLength(op, lit - 15);
+      memcpy(op, anchor, lit);
+      op += lit;
+
+      uint16_t off = (uint16_t)(ip - ref);
+      *op++ = (uint8_t)off;
+      *op++ = (uint8_t)(off >> 8);
+
+      *token |= (uint8_t)(mlen >= 15 ? 15 : mlen);
+      if (mlen >= 15) op = writeLength(op, mlen - 15);
+
+      ip = mp;
+      anchor = ip;
+      if (ip < mflimit) table[hash4(read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+    }
+  }
+
+last_literals:
+  size_t lit = (size_t)(iend - anchor);
+  *op++ = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+  if (lit >= 15) op = writeLength(op, lit - 15);
+  memcpy(op, anchor, lit);
+  op += lit;
+  return (size_t)(op - dst);
+}
+
+long lz4Decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+  const uint8_t* ip = src;
+  const uint8_t* const iend = src + n;
+  uint8_t* op = dst;
+  uint8_t* const oend = dst + cap;
+
+  while (ip < iend) {
+    uint8_t token = *ip++;
+
+    size_t lit = token >> 4;
+    if (lit == 15) {
+      uint8_t b;
+      do { if (ip >= iend) return -1; b = *ip++; lit += b; } while (b == 255);
+    }
+    if ((size_t)(iend - ip) < lit || (size_t)(oend - op) < lit) return -1;
+    memcpy(op, ip, lit);
+    ip += lit; op += lit;
+    if (ip == iend) break;                  // last sequence has no match
+
+    if (iend - ip < 2) return -1;
+    size_t off = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (off == 0 || off > (size_t)(op - dst)) return -1;
+
+    size_t mlen = token & 15;
+    if (mlen == 15) {
+      uint8_t b;
+      do { if (ip >= iend) return -1; b = *ip++; mlen += b; } while (b == 255);
+    }
+    mlen += MIN_MATCH;
+    if ((size_t)(oend - op) < mlen) return -1;
+
+    const uint8_t* ref = op - off;
+    while (mlen--) *op++ = *ref++;          // byte copy: matches may overlap
+  }
+  return (long)(op - dst);
+}
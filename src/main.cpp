@@ -2,30 +2,72 @@
  * TTGO T-Journal (ESP32 + OV2640 + OLED 0.91" SSD1306 128x32)
  * Prooven version
  * - Wi-Fi Access Point with browser UI at http://192.168.4.1
- * - Live MJPEG stream at  /stream   (same server/port)
+ * - Live MJPEG stream at  /stream   (same server/port); ?fps=&scale=8 for thumbnails,
+ *   ?rotate=90|180|270 for lossless rotation (tube-mounted cameras),
+ *   ?brightness=&contrast= adjusted in the compressed domain (also on /capture)
+ * - Multi-camera dashboard at /?action=dashboard (units from mDNS /peers or ?units=)
+ * - Block-delta stream at /delta (?key=<s>&thr=<levels>; keyframes + changed MCUs only),
+ *   viewer at /?action=delta
  * - OLED shows SSID / IP / status
- * - DNS wildcard -> http://nozzlecam/
+ * - DNS for our names -> http://nozzlecam/ (other names NXDOMAIN, counters at /dns)
  * - mDNS responder -> http://nozzcam.local/
+ * - Analytics QoS status at /qos  (?target=<fps> sets the stream fps target)
+ * - Motion heatmap at /heatmap (JPEG; activity from JPEG AC energy, decays over hours)
+ * - Scrub-preview sprite sheet at /sprites.jpg (?last=<s>; DC-luma tiles every few seconds)
+ * - Activity-driven capture rate at /power (?mode=auto idles the sensor at 1 fps until motion)
+ * - Capture timing at /timing (sensor VSYNC vs. DMA vs. delivered fps, overruns)
+ * - Per-viewer TCP stats at /tcp (cwnd, windows, send queue, RTT, retransmits, lwIP memory)
+ * - LZ4-compressed raw grayscale/YUV422 stream at /raw  (?fmt=gray|yuv&size=qvga)
+ * - Nozzle tip coordinates at /tip (JSON) and /tip/events (SSE)
+ * - Software auto-exposure assist at /ae (?on=1&target=&speed=)
+ * - Low-noise stacked stills at /capture?stack=N (RGB565 burst averaged into one JPEG)
+ * - Serial console (115200 baud): `help`, `status`, `bench <fb|jpeg|psram|wifi|oled>`
+ * - Snapshots at /?action=snapshot (mjpg-streamer style), long-poll at /next?after=seq
+ * - Telemetry history at /history?from=&to=&step= (seconds since boot, JSON)
+ * - Link probe at /probe?kb=N, PHY mode calibration at /calibrate (/phy = JSON)
+ * - Builds on the Arduino core or plain ESP-IDF (runtime.h); a BOOT line reports boot time and heap
+ * - Long-lived responses run on their own tasks (http_stream), so the UI
+ *   stays responsive while streams are open
  */
 
-#include <Arduino.h>
-#include <WiFi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_camera.h"
 #include "esp_timer.h"
-#include "img_converters.h"
-#include "fb_gfx.h"
 #include "esp_http_server.h"
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
 
-// DNS & mDNS
-#include <DNSServer.h>
-#include <ESPmDNS.h>
-
-// OLED
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
+#include "ae_assist.h"
+#include "bench.h"
+#include "camera.h"
+#include "cap_timing.h"
+#include "captive_dns.h"
+#include "console.h"
+#include "encoder.h"
+#include "frame_cache.h"
+#include "heatmap.h"
+#include "history.h"
+#include "http_stream.h"
+#include "jpeg_adjust.h"
+#include "jpeg_delta.h"
+#include "jpeg_rot.h"
+#include "jpeg_scan.h"
+#include "lz4block.h"
+#include "oled.h"
+#include "phy_tune.h"
+#include "psram.h"
+#include "qos.h"
+#include "rate_gov.h"
+#include "runtime.h"
+#include "sprites.h"
+#include "stack.h"
+#include "tcp_stats.h"
+#include "thumb.h"
+#include "tip.h"
 
 // ======= AP CONFIG =======
 static const char* AP_SSID     = "NozzleCAM";
@@ -40,121 +82,1205 @@ static const bool  AP_HIDDEN   = false;
 #ifndef I2C_SCL
 #define I2C_SCL 13
 #endif
-#define OLED_WIDTH   128
-#define OLED_HEIGHT   32
-#define OLED_ADDR   0x3C
-
-// ======= STREAM DEFAULTS (max-ish quality) =======
-framesize_t STREAM_SIZE = FRAMESIZE_UXGA; // 1600x1200 (needs PSRAM)
-int JPEG_QUALITY = 10;                    // lower = better image, bigger size
-int FB_COUNT     = 2;                     // 2 with PSRAM, else 1
-
-// ======= CAMERA PINS: TTGO T-JOURNAL =======
-#define PWDN_GPIO_NUM  32
-#define RESET_GPIO_NUM 15
-#define XCLK_GPIO_NUM  27
-#define SIOD_GPIO_NUM  25
-#define SIOC_GPIO_NUM  23
-#define Y9_GPIO_NUM    19
-#define Y8_GPIO_NUM    36
-#define Y7_GPIO_NUM    18
-#define Y6_GPIO_NUM    39
-#define Y5_GPIO_NUM     5
-#define Y4_GPIO_NUM    34
-#define Y3_GPIO_NUM    35
-#define Y2_GPIO_NUM    17
-#define VSYNC_GPIO_NUM 22
-#define HREF_GPIO_NUM  26
-#define PCLK_GPIO_NUM  21
 
 // ======= GLOBALS =======
 httpd_handle_t httpd_ctrl = NULL; // single server on port 80
-Adafruit_SSD1306 display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1);
-DNSServer dnsServer;
-const byte DNS_PORT = 53;
-
-// ---------- OLED helpers ----------
-static void oledPrintCentered(const String& line1, const String& line2 = "") {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-
-  int16_t x1, y1; uint16_t w, h;
-  display.getTextBounds(line1, 0, 0, &x1, &y1, &w, &h);
-  int16_t x = (OLED_WIDTH - w) / 2;
-  int16_t y = 2;
-  display.setCursor(x, y);
-  display.print(line1);
-
-  if (line2.length()) {
-    display.getTextBounds(line2, 0, 0, &x1, &y1, &w, &h);
-    x = (OLED_WIDTH - w) / 2;
-    y = 18;
-    display.setCursor(x, y);
-    display.print(line2);
-  }
-  display.display();
-}
-
-static void oledBoot() {
-  Wire.begin(I2C_SDA, I2C_SCL);
-  if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR)) return;
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 0);
-  display.println(F("TTGO T-Journal"));
-  display.println(F("AP Camera Stream"));
-  display.display();
-}
 
 // ---------- HTTP: stream handler ----------
-static esp_err_t stream_handler(httpd_req_t *req) {
+// Runs on its own task (http_stream) so the server stays free for other requests.
+// /stream?fps=2 decimates (dashboard tiles), &scale=8|16|32|64 sends DC thumbnails,
+// &rotate=90|180|270 turns frames losslessly in the DCT domain (jpeg_rot),
+// &brightness=-127..127&contrast=0.25..4 rewrite tables and DC (jpeg_adjust).
+#define THUMB_QUALITY   70
+#define STALE_FRAME_US  150000      // decimated streams skip frames that waited in the driver
+
+struct StreamOpts {
+  float fps;                        // 0 = every frame
+  int   thumb_shift;                // -1 = full size, else 1/(8 << shift)
+  int   rotate;                     // 0, 90, 180, 270 (clockwise)
+  int   brightness;                 // levels added to Y
+  float contrast;                   // 1 = unchanged
+};
+
+// ?brightness=&contrast= for /stream and /capture.
+static void adjustParams(const char* query, int* brightness, float* contrast) {
+  char val[12];
+  if (httpd_query_key_value(query, "brightness", val, sizeof(val)) == ESP_OK) *brightness = atoi(val);
+  if (httpd_query_key_value(query, "contrast", val, sizeof(val)) == ESP_OK) *contrast = atof(val);
+}
+
+static inline bool adjustWanted(int brightness, float contrast) {
+  return brightness || contrast != 1.0f;
+}
+
+// Per-stream output buffers are kept across frames and only grow.
+static bool reserve(uint8_t** buf, size_t* cap, size_t need) {
+  if (*cap >= need) return true;
+  free(*buf);
+  *buf = (uint8_t*)psAlloc(need);
+  *cap = *buf ? need : 0;
+  return *buf != NULL;
+}
+
+// Sleep until `due` in short steps so a closed peer is noticed.
+static bool waitUntil(int fd, int64_t due) {
+  for (;;) {
+    if (httpStreamPeerClosed(fd)) return false;
+    int64_t left = due - esp_timer_get_time();
+    if (left <= 0) return true;
+    vTaskDelay(pdMS_TO_TICKS(left > 100000 ? 100 : left / 1000 + 1));
+  }
+}
+
+static void streamBody(int fd, void* arg) {
+  StreamOpts opt = { 0, -1, 0, 0, 1.0f };
+  if (arg) { opt = *(StreamOpts*)arg; delete (StreamOpts*)arg; }
+  const int64_t interval_us = opt.fps > 0 ? (int64_t)(1e6f / opt.fps) : 0;
+  int64_t due = esp_timer_get_time();
+
   camera_fb_t * fb = NULL;
-  esp_err_t res = ESP_OK;
   size_t _jpg_buf_len = 0;
   uint8_t * _jpg_buf = NULL;
+  uint8_t * adj_buf = NULL;         // reused across frames, grow on demand
+  size_t adj_cap = 0;
+  uint8_t * rot_buf = NULL;
+  size_t rot_cap = 0;
   char part_buf[64];
 
-  res = httpd_resp_set_type(req, "multipart/x-mixed-replace;boundary=frame");
-  if(res != ESP_OK) return res;
+  while (!httpStreamPeerClosed(fd)) {
+    if (interval_us) {
+      if (!waitUntil(fd, due)) break;
+      due += interval_us;
+      if (due < esp_timer_get_time()) due = esp_timer_get_time() + interval_us;
+    }
+    fb = camFbGet();
+    if (!fb) break;
+    for (int i = 0; interval_us && i < FB_COUNT; i++) {      // want a fresh frame, not a queued one
+      int64_t ts = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+      if (esp_timer_get_time() - ts < STALE_FRAME_US) break;
+      camFbReturn(fb);
+      if (!(fb = camFbGet())) break;
+    }
+    if (!fb) break;
+
+    // keep fb until the frame is out: analytics stages run on it afterwards
+    bool thumb = false;
+    if (opt.thumb_shift >= 0 && fb->format == PIXFORMAT_JPEG) {
+      uint8_t* rgb;
+      int w, h;
+      thumb = thumbFromJpeg(fb->buf, fb->len, opt.thumb_shift, &rgb, &w, &h);
+      if (thumb) {
+        thumb = encodeJpeg(rgb, (size_t)w * h * 3, w, h, PIXFORMAT_RGB888, THUMB_QUALITY,
+                           &_jpg_buf, &_jpg_buf_len);
+        free(rgb);
+      }
+      if (!thumb) { camFbReturn(fb); break; }
+    } else if (fb->format != PIXFORMAT_JPEG) {
+      bool ok = encodeFrame(fb, JPEG_QUALITY, &_jpg_buf, &_jpg_buf_len);
+      if (!ok) { camFbReturn(fb); break; }
+    } else {
+      _jpg_buf = fb->buf;
+      _jpg_buf_len = fb->len;
+    }
 
-  while (true) {
-    fb = esp_camera_fb_get();
-    if (!fb) { httpd_resp_send_500(req); break; }
+    // adjust first so rotation transposes the already scaled tables; a step
+    // that fails passes its input on rather than drop the frame
+    const uint8_t* out = _jpg_buf;
+    size_t out_len = _jpg_buf_len;
+    if (adjustWanted(opt.brightness, opt.contrast)) {
+      long n = JPEG_ADJUST_ERR_SPACE;
+      for (int tries = 0; n == JPEG_ADJUST_ERR_SPACE && tries < 2; tries++) {
+        if (!reserve(&adj_buf, &adj_cap, jpegAdjustBound(out_len) << tries)) break;
+        n = jpegAdjust(out, out_len, opt.brightness, opt.contrast, adj_buf, adj_cap);
+      }
+      if (n > 0) {
+        out = adj_buf;
+        out_len = (size_t)n;
+      }
+    }
+    if (opt.rotate) {
+      long n = JPEG_ROT_ERR_SPACE;
+      for (int tries = 0; n == JPEG_ROT_ERR_SPACE && tries < 2; tries++) {
+        if (!reserve(&rot_buf, &rot_cap, jpegRotateBound(out_len) << tries)) break;
+        n = jpegRotate(out, out_len, opt.rotate, rot_buf, rot_cap);
+      }
+      if (n > 0) {
+        out = rot_buf;
+        out_len = (size_t)n;
+      }
+    }
+
+    size_t hlen = (size_t)snprintf(part_buf, sizeof(part_buf),
+      "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+      (unsigned)out_len);
+
+    bool sent =
+        httpStreamSend(fd, part_buf, hlen) == ESP_OK &&
+        httpStreamSend(fd, out, out_len) == ESP_OK &&
+        httpStreamSend(fd, "\r\n", 2) == ESP_OK;
+
+    if (sent) {
+      qosFrameSent(fb, hlen + out_len + 2);
+      if (!thumb)                        // snapshot pollers read this copy, not the sensor (as shot)
+        frameCacheOffer(_jpg_buf, _jpg_buf_len,
+                        (uint64_t)fb->timestamp.tv_sec * 1000000ULL + fb->timestamp.tv_usec);
+      qosRunStages(fb);   // after the send: the stream wins
+    }
+
+    if (_jpg_buf != fb->buf) free(_jpg_buf);
+    camFbReturn(fb);
+    fb = NULL; _jpg_buf = NULL;
+    if (!sent) break;
+
+    vTaskDelay(1);
+  }
+  free(adj_buf);
+  free(rot_buf);
+}
+
+static esp_err_t stream_handler(httpd_req_t *req) {
+  char query[112], val[12];
+  StreamOpts* opt = NULL;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    StreamOpts o = { 0, -1, 0, 0, 1.0f };
+    if (httpd_query_key_value(query, "fps", val, sizeof(val)) == ESP_OK) {
+      o.fps = atof(val);
+      if (o.fps < 0.02f) o.fps = 0.02f;   // dashboard budget holds up to 200 tiles
+    }
+    if (httpd_query_key_value(query, "scale", val, sizeof(val)) == ESP_OK) {
+      int sc = atoi(val);
+      o.thumb_shift = sc >= 64 ? 3 : sc >= 32 ? 2 : sc >= 16 ? 1 : sc >= 8 ? 0 : -1;
+    }
+    if (httpd_query_key_value(query, "rotate", val, sizeof(val)) == ESP_OK) {
+      int r = atoi(val);
+      o.rotate = r == 90 || r == 180 || r == 270 ? r : 0;
+    }
+    adjustParams(query, &o.brightness, &o.contrast);
+    if (o.fps > 0 || o.thumb_shift >= 0 || o.rotate || adjustWanted(o.brightness, o.contrast))
+      opt = new StreamOpts(o);
+  }
+  if (httpStreamDetach(req, "multipart/x-mixed-replace;boundary=frame", "stream",
+                       streamBody, opt) != ESP_OK) {
+    delete opt;
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: raw LZ4 stream ----------
+// Machine-vision clients get uncompressed pixels, LZ4-packed per frame.
+// Each frame is a 28-byte little-endian header followed by one LZ4 block:
+//   "NZR1" | u16 width | u16 height | u8 pixformat | u8 bytes/px | u16 0 |
+//   u32 seq | u32 raw_len | u32 lz4_len | u32 lz4_us (device compress time)
+// tools/raw_decoder decodes this on the host.
+#define RAW_HDR_LEN 28
+
+struct RawCtx {
+  framesize_t size;
+  int         bpp;
+  size_t      raw_cap;
+  uint8_t*    out;
+  uint32_t*   table;
+};
+
+// Raw capture is limited to VGA and below.
+static framesize_t rawFramesize(const char* name) {
+  framesize_t size = cameraFramesize(name);
+  return size <= FRAMESIZE_VGA ? size : FRAMESIZE_INVALID;
+}
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+static void rawBody(int fd, void* arg) {
+  RawCtx* ctx = (RawCtx*)arg;
+  const framesize_t size = ctx->size;
+  const int bpp = ctx->bpp;
+  uint8_t* out = ctx->out;
+
+  uint32_t seq = 0, win_frames = 0;
+  uint64_t win_raw = 0, win_lz4 = 0, win_us = 0;
+  int64_t  win_start = esp_timer_get_time();
+
+  while (!httpStreamPeerClosed(fd)) {
+    camera_fb_t* fb = camFbGet();
+    if (!fb) break;
+    if (fb->format == PIXFORMAT_JPEG || fb->len > ctx->raw_cap) { camFbReturn(fb); break; }
+
+    int64_t t0 = esp_timer_get_time();
+    size_t clen = lz4Compress(fb->buf, fb->len, out + RAW_HDR_LEN,
+                              lz4CompressBound(ctx->raw_cap), ctx->table);
+    uint32_t cus = (uint32_t)(esp_timer_get_time() - t0);
+
+    memcpy(out, "NZR1", 4);
+    put16(out + 4, fb->width);
+    put16(out + 6, fb->height);
+    out[8] = (uint8_t)fb->format;
+    out[9] = (uint8_t)bpp;
+    put16(out + 10, 0);
+    put32(out + 12, seq++);
+    put32(out + 16, fb->len);
+    put32(out + 20, clen);
+    put32(out + 24, cus);
+
+    bool sent = httpStreamSend(fd, out, RAW_HDR_LEN + clen) == ESP_OK;
+    if (sent) {
+      qosFrameSent(fb, RAW_HDR_LEN + clen);
+      qosRunStages(fb);
+    }
+    win_frames++; win_raw += fb->len; win_lz4 += clen; win_us += cus;
+    camFbReturn(fb);
+    if (!sent) break;
+
+    int64_t now = esp_timer_get_time();
+    if (now - win_start >= 5000000) {
+      printf("raw: %ux%u fps=%.1f lz4=%.1f MB/s ratio=%.2f\n",
+        resolution[size].width, resolution[size].height,
+        win_frames * 1e6f / (now - win_start),
+        win_us ? (float)win_raw / win_us : 0.0f,
+        win_lz4 ? (float)win_raw / win_lz4 : 0.0f);
+      win_frames = 0; win_raw = win_lz4 = win_us = 0;
+      win_start = now;
+    }
+    vTaskDelay(1);
+  }
+
+  free(out);
+  free(ctx->table);
+  delete ctx;
+  cameraRestoreStreamProfile();
+  cameraRelease();
+  printf("raw: stopped\n");
+}
+
+static esp_err_t raw_handler(httpd_req_t *req) {
+  char query[64], val[12];
+  pixformat_t fmt = PIXFORMAT_GRAYSCALE;
+  framesize_t size = FRAMESIZE_QVGA;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "fmt", val, sizeof(val)) == ESP_OK && !strcmp(val, "yuv"))
+      fmt = PIXFORMAT_YUV422;
+    if (httpd_query_key_value(query, "size", val, sizeof(val)) == ESP_OK)
+      size = rawFramesize(val);
+  }
+  if (size == FRAMESIZE_INVALID) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "size: 96x96|qqvga|qcif|hqvga|240x240|qvga|cif|hvga|vga");
+    return ESP_OK;
+  }
+  const char* holder;
+  if (!cameraClaim("raw", &holder)) {
+    char msg[32];
+    snprintf(msg, sizeof(msg), "camera busy (%s)", holder);
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, msg, HTTPD_RESP_USE_STRLEN);
+  }
+
+  const int bpp = fmt == PIXFORMAT_YUV422 ? 2 : 1;
+  const size_t raw_cap = (size_t)resolution[size].width * resolution[size].height * bpp;
+  uint8_t*  out   = (uint8_t*)psAlloc(RAW_HDR_LEN + lz4CompressBound(raw_cap));
+  uint32_t* table = (uint32_t*)malloc(LZ4_HASH_ENTRIES * sizeof(uint32_t));  // internal RAM: hot
+  cam_profile_t prof = { fmt, size, JPEG_QUALITY, 2 };
+  RawCtx* ctx = new RawCtx{ size, bpp, raw_cap, out, table };
+  if (!out || !table || cameraSetProfile(prof) != ESP_OK ||
+      httpStreamDetach(req, "application/octet-stream", "raw", rawBody, ctx) != ESP_OK) {
+    free(out); free(table); delete ctx;
+    cameraRestoreStreamProfile();
+    cameraRelease();
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  printf("raw: %ux%u %s started\n", resolution[size].width, resolution[size].height,
+                bpp == 2 ? "yuv422" : "gray");
+  return ESP_OK;
+}
+
+// ---------- HTTP: block-delta stream ----------
+// /delta: a full JPEG keyframe every ?key= seconds and, in between, only the
+// MCUs that changed by more than ?thr= levels, as compressed-domain patches
+// (jpeg_delta.h) in application/x-nozzle-delta parts; X-Source-Length gives
+// the frame a patch stands for. /?action=delta is a viewer that reassembles
+// it; tools/delta_replay measures it on recorded sessions.
+#define DELTA_KEY_S  10
+#define DELTA_THR    6
+
+struct DeltaOpts {
+  int key_s;
+  int thr;
+};
+
+// (Re)size the delta state for jpg's MCU grid; false if it can't be had.
+static bool deltaReserve(jpeg_delta_t* d, void** mem, const uint8_t* jpg, size_t len, int thr) {
+  jpeg_info_t info;
+  if (jpegScanHeaders(jpg, len, &info) != JPEG_SCAN_OK) return false;
+  const int mcus = info.mcus_x * info.mcus_y, blocks = info.h[0] * info.v[0] + info.ncomp - 1;
+  if (*mem && mcus <= d->mcus_cap && blocks <= d->blocks_cap) return true;
+  free(*mem);
+  *mem = psAlloc(jpegDeltaBytes(mcus, blocks));
+  if (*mem) jpegDeltaInit(d, mcus, blocks, thr, *mem);
+  return *mem != NULL;
+}
+
+static void deltaBody(int fd, void* arg) {
+  DeltaOpts opt = *(DeltaOpts*)arg;
+  delete (DeltaOpts*)arg;
+  jpeg_delta_t delta = {};
+  void* delta_mem = NULL;
+  bool keyed = false;
+  int64_t key_due = 0;
+  camera_fb_t * fb = NULL;
+  size_t _jpg_buf_len = 0;
+  uint8_t * _jpg_buf = NULL;
+  uint8_t * patch_buf = NULL;       // reused across frames, grow on demand
+  size_t patch_cap = 0;
+  char part_buf[128];
 
+  while (!httpStreamPeerClosed(fd)) {
+    fb = camFbGet();
+    if (!fb) break;
     if (fb->format != PIXFORMAT_JPEG) {
-      bool ok = frame2jpg(fb, JPEG_QUALITY, &_jpg_buf, &_jpg_buf_len);
-      esp_camera_fb_return(fb); fb = NULL;
-      if (!ok) { httpd_resp_send_500(req); break; }
+      bool ok = encodeFrame(fb, JPEG_QUALITY, &_jpg_buf, &_jpg_buf_len);
+      if (!ok) { camFbReturn(fb); break; }
     } else {
       _jpg_buf = fb->buf;
       _jpg_buf_len = fb->len;
     }
 
-    size_t hlen = (size_t)snprintf(part_buf, sizeof(part_buf),
-      "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
-      (unsigned)_jpg_buf_len);
-
-    if (httpd_resp_send_chunk(req, part_buf, hlen) != ESP_OK ||
-        httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len) != ESP_OK ||
-        httpd_resp_send_chunk(req, "\r\n", 2) != ESP_OK) {
-      if (fb) esp_camera_fb_return(fb);
-      else if (_jpg_buf) free(_jpg_buf);
-      break;
+    long n = JPEG_DELTA_ERR_KEY;
+    if (keyed && esp_timer_get_time() < key_due &&
+        reserve(&patch_buf, &patch_cap, jpegDeltaBound(_jpg_buf_len, delta.mcus_cap)))
+      n = jpegDeltaPatch(&delta, _jpg_buf, _jpg_buf_len, patch_buf, patch_cap, NULL);
+    if (n < 0) {                    // keyframe; a frame the state can't take goes out whole all the same
+      keyed = deltaReserve(&delta, &delta_mem, _jpg_buf, _jpg_buf_len, opt.thr) &&
+              jpegDeltaKey(&delta, _jpg_buf, _jpg_buf_len) == JPEG_SCAN_OK;
+      key_due = esp_timer_get_time() + (int64_t)opt.key_s * 1000000LL;
     }
 
-    if (fb) { esp_camera_fb_return(fb); fb = NULL; _jpg_buf = NULL; }
-    else if (_jpg_buf) { free(_jpg_buf); _jpg_buf = NULL; }
+    const uint8_t* out = n < 0 ? _jpg_buf : patch_buf;
+    size_t out_len = n < 0 ? _jpg_buf_len : (size_t)n;
+    size_t hlen = n < 0
+      ? (size_t)snprintf(part_buf, sizeof(part_buf),
+          "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", (unsigned)out_len)
+      : (size_t)snprintf(part_buf, sizeof(part_buf),
+          "--frame\r\nContent-Type: application/x-nozzle-delta\r\nContent-Length: %u\r\n"
+          "X-Source-Length: %u\r\n\r\n", (unsigned)out_len, (unsigned)_jpg_buf_len);
+
+    bool sent =
+        httpStreamSend(fd, part_buf, hlen) == ESP_OK &&
+        httpStreamSend(fd, out, out_len) == ESP_OK &&
+        httpStreamSend(fd, "\r\n", 2) == ESP_OK;
+
+    if (sent) {
+      qosFrameSent(fb, hlen + out_len + 2);
+      frameCacheOffer(_jpg_buf, _jpg_buf_len,
+                      (uint64_t)fb->timestamp.tv_sec * 1000000ULL + fb->timestamp.tv_usec);
+      qosRunStages(fb);
+    }
+
+    if (_jpg_buf != fb->buf) free(_jpg_buf);
+    camFbReturn(fb);
+    fb = NULL; _jpg_buf = NULL;
+    if (!sent) break;
 
     vTaskDelay(1);
   }
-  return res;
+  free(patch_buf);
+  free(delta_mem);
+}
+
+static esp_err_t delta_handler(httpd_req_t *req) {
+  char query[48], val[12];
+  DeltaOpts* opt = new DeltaOpts{ DELTA_KEY_S, DELTA_THR };
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "key", val, sizeof(val)) == ESP_OK) {
+      opt->key_s = atoi(val);
+      if (opt->key_s < 1) opt->key_s = 1;
+    }
+    if (httpd_query_key_value(query, "thr", val, sizeof(val)) == ESP_OK) {
+      opt->thr = atoi(val);
+      if (opt->thr < 0) opt->thr = 0;
+    }
+  }
+  if (httpStreamDetach(req, "multipart/x-mixed-replace;boundary=frame", "delta",
+                       deltaBody, opt) != ESP_OK) {
+    delete opt;
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+// /?action=delta: reads /delta with fetch(), draws keyframes and blits the
+// MCUs of each patch strip (decoded by the browser) into place on a canvas.
+// Browsers smooth chroma across MCU edges, so patch edges can show faint
+// seams until the next keyframe.
+static esp_err_t delta_view_handler(httpd_req_t *req) {
+  static const char DELTA_HTML[] = R"HTML(
+<!doctype html><html><head>
+<meta charset="utf-8"><meta name="viewport" content="width=device-width, initial-scale=1">
+<title>NozzleCAM - Delta stream</title>
+<style>
+  body{background:#000;color:#fff;font-family:system-ui,Arial,sans-serif;margin:0;padding:.5rem}
+  .bar{display:flex;gap:.5rem;align-items:center;margin-bottom:.5rem;flex-wrap:wrap}
+  canvas{display:block;max-width:100%;background:#111;border-radius:.5rem}
+  #info{font-size:.85rem;opacity:.8}
+</style>
+</head><body>
+<div class="bar"><strong>NozzleCAM</strong><span>delta stream</span><span id="info">connecting…</span></div>
+<canvas id="view" width="640" height="480"></canvas>
+<script>
+const cv = document.getElementById('view'), ctx = cv.getContext('2d');
+const info = document.getElementById('info');
+const q = new URLSearchParams(location.search);
+const url = '/delta?key=' + (q.get('key') || 10) + '&thr=' + (q.get('thr') || 6);
+let keys = 0, patches = 0, sent = 0, full = 0, frames = 0, t0 = performance.now();
+
+function find(buf, len, pat) {                 // first offset of pat in buf[0, len)
+  outer: for (let i = 0; i + pat.length <= len; i++) {
+    for (let j = 0; j < pat.length; j++) if (buf[i + j] !== pat[j]) continue outer;
+    return i;
+  }
+  return -1;
+}
+const EOH = [13, 10, 13, 10];
+
+async function key(body) {
+  const bmp = await createImageBitmap(new Blob([body], {type: 'image/jpeg'}));
+  if (cv.width !== bmp.width || cv.height !== bmp.height) { cv.width = bmp.width; cv.height = bmp.height; }
+  ctx.drawImage(bmp, 0, 0);
+  bmp.close();
+  keys++;
+}
+
+async function patch(body) {
+  const dv = new DataView(body.buffer, body.byteOffset, body.byteLength);
+  const mx = dv.getUint16(4, true), mw = body[8], mh = body[9];
+  const count = dv.getUint16(10, true), cols = dv.getUint16(12, true);
+  patches++;
+  if (!count || !keys) return;
+  const strip = body.subarray(16 + 2 * count);
+  const bmp = await createImageBitmap(new Blob([strip], {type: 'image/jpeg'}));
+  for (let k = 0; k < count; k++) {
+    const m = dv.getUint16(16 + 2 * k, true);
+    ctx.drawImage(bmp, (k % cols) * mw, Math.floor(k / cols) * mh, mw, mh,
+                  (m % mx) * mw, Math.floor(m / mx) * mh, mw, mh);
+  }
+  bmp.close();
+}
+
+function stats() {
+  const s = (performance.now() - t0) / 1000;
+  info.textContent = (frames / s).toFixed(1) + ' fps, ' + (sent / 1024 / s).toFixed(1) + ' kB/s (' +
+    (full ? (100 * sent / full).toFixed(0) : 0) + '% of MJPEG), ' + keys + ' keyframes, ' + patches + ' patches';
+  frames = sent = full = 0;
+  t0 = performance.now();
+}
+
+async function run() {
+  const r = await fetch(url, {cache: 'no-store'});
+  const rd = r.body.getReader();
+  let buf = new Uint8Array(1 << 16), len = 0;
+  for (;;) {
+    const {value, done} = await rd.read();
+    if (done) break;
+    if (len + value.length > buf.length) {
+      const nb = new Uint8Array(Math.max(buf.length * 2, len + value.length));
+      nb.set(buf.subarray(0, len));
+      buf = nb;
+    }
+    buf.set(value, len);
+    len += value.length;
+    for (;;) {
+      const eoh = find(buf, len, EOH);
+      if (eoh < 0) break;
+      const head = new TextDecoder().decode(buf.subarray(0, eoh));
+      const cl = /Content-Length:\s*(\d+)/i.exec(head);
+      if (!cl) { buf.copyWithin(0, eoh + 4, len); len -= eoh + 4; continue; }
+      const n = +cl[1], start = eoh + 4;
+      if (len < start + n) break;
+      const body = buf.slice(start, start + n);
+      const src = /X-Source-Length:\s*(\d+)/i.exec(head);
+      buf.copyWithin(0, start + n, len);
+      len -= start + n;
+      frames++;
+      sent += n;
+      full += src ? +src[1] : n;
+      if (src) await patch(body); else await key(body);
+    }
+  }
+}
+
+setInterval(stats, 2000);
+(async () => {
+  for (;;) {
+    try { await run(); } catch (e) {}
+    info.textContent = 'reconnecting…';
+    keys = 0;
+    await new Promise(r => setTimeout(r, 1000));
+  }
+})();
+</script>
+</body></html>
+)HTML";
+  httpd_resp_set_type(req, "text/html; charset=utf-8");
+  return httpd_resp_send(req, DELTA_HTML, HTTPD_RESP_USE_STRLEN);
+}
+
+// ---------- HTTP: nozzle tip ----------
+// GET /tip            -> latest result + config (JSON)
+//     ?roi=x0,y0,x1,y1 (permille) &scale=1|2|4|8 &min=<edge floor> reconfigures
+static esp_err_t tip_handler(httpd_req_t *req) {
+  char query[96], val[32];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    tip_config_t c = tipConfig();
+    if (httpd_query_key_value(query, "roi", val, sizeof(val)) == ESP_OK) {
+      unsigned x0, y0, x1, y1;
+      if (sscanf(val, "%u,%u,%u,%u", &x0, &y0, &x1, &y1) == 4) {
+        c.x0 = x0; c.y0 = y0; c.x1 = x1; c.y1 = y1;
+      }
+    }
+    if (httpd_query_key_value(query, "scale", val, sizeof(val)) == ESP_OK) c.scale = atoi(val);
+    if (httpd_query_key_value(query, "min", val, sizeof(val)) == ESP_OK)   c.min_strength = atoi(val);
+    tipSetConfig(c);
+  }
+
+  tip_config_t c = tipConfig();
+  char res[160], json[320];
+  tipResultJson(tipLatest(), res, sizeof(res));
+  int n = snprintf(json, sizeof(json),
+    "{\"roi\":[%u,%u,%u,%u],\"scale\":%u,\"min\":%u,\"latest\":%s}",
+    c.x0, c.y0, c.x1, c.y1, c.scale, c.min_strength, res);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// GET /tip/events -> Server-Sent Events, one "data:" line per analysed frame.
+// Without a video viewer the worker pulls frames itself so results keep coming.
+static void tipEventsBody(int fd, void* arg) {
+  (void)arg;
+  uint32_t seen = tipLatest().seq;
+  int64_t last_tx = esp_timer_get_time();
+  char json[160], line[192];
+
+  while (!httpStreamPeerClosed(fd)) {
+    if (qosStreamFps() == 0) {
+      camera_fb_t* fb = camFbGet();
+      if (fb) { qosRunStages(fb); camFbReturn(fb); }
+    }
+
+    tip_result_t r = tipLatest();
+    int64_t now = esp_timer_get_time();
+    if (r.seq != seen) {
+      seen = r.seq;
+      tipResultJson(r, json, sizeof(json));
+      int n = snprintf(line, sizeof(line), "data: %s\n\n", json);
+      if (httpStreamSend(fd, line, n) != ESP_OK) break;
+      last_tx = now;
+    } else if (now - last_tx > 15000000) {
+      if (httpStreamSend(fd, ": keepalive\n\n", 13) != ESP_OK) break;
+      last_tx = now;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+}
+
+static esp_err_t tip_events_handler(httpd_req_t *req) {
+  if (httpStreamDetach(req, "text/event-stream", "tip_sse", tipEventsBody, NULL) != ESP_OK) {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: software auto-exposure assist ----------
+// /ae -> status (JSON); /ae?on=1&target=110&speed=60&settle=2&clip=3&gain_max=15
+static esp_err_t ae_handler(httpd_req_t *req) {
+  char query[128], val[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    ae_config_t c = aeAssistConfig();
+    if (httpd_query_key_value(query, "target",   val, sizeof(val)) == ESP_OK) c.target = atoi(val);
+    if (httpd_query_key_value(query, "speed",    val, sizeof(val)) == ESP_OK) c.speed_pct = atoi(val);
+    if (httpd_query_key_value(query, "settle",   val, sizeof(val)) == ESP_OK) c.settle_frames = atoi(val);
+    if (httpd_query_key_value(query, "clip",     val, sizeof(val)) == ESP_OK) c.clip_pct = atoi(val);
+    if (httpd_query_key_value(query, "gain_max", val, sizeof(val)) == ESP_OK) c.gain_max = atoi(val);
+    aeAssistSetConfig(c);
+    if (httpd_query_key_value(query, "on", val, sizeof(val)) == ESP_OK) aeAssistEnable(val[0] == '1');
+  }
+  char json[384];
+  size_t n = aeAssistStatusJson(json, sizeof(json));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// ---------- HTTP: telemetry history ----------
+static bool historyChunk(const char* buf, size_t len, void* ctx) {
+  return httpd_resp_send_chunk((httpd_req_t*)ctx, buf, len) == ESP_OK;
+}
+
+// /history?from=&to=&step=  (seconds since boot; negative = relative to now)
+// Defaults: the last hour, step chosen for about 600 rows.
+static esp_err_t history_handler(httpd_req_t *req) {
+  int32_t now = (int32_t)historyNow();
+  int32_t from = now - 3600, to = now, step = 0;
+  char query[64], val[12];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "from", val, sizeof(val)) == ESP_OK) from = atoi(val);
+    if (httpd_query_key_value(query, "to",   val, sizeof(val)) == ESP_OK) to   = atoi(val);
+    if (httpd_query_key_value(query, "step", val, sizeof(val)) == ESP_OK) step = atoi(val);
+  }
+  if (from < 0) from += now;
+  if (to < 0)   to += now;
+  if (from < 0) from = 0;
+  if (to > now) to = now;
+  if (to < from) to = from;
+  int32_t min_step = (to - from) / 5000 + 1;        // cap the response at ~5000 rows
+  if (step <= 0) step = (to - from) / 600 + 1;
+  if (step < min_step) step = min_step;
+
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  if (!historyQueryJson(from, to, step, historyChunk, req)) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// ---------- HTTP: link probe + PHY calibration ----------
+// /probe?kb=N sends N KB of filler; goodput is measured on the device side
+// (first send -> last send returned) and fed to the PHY calibration.
+#define PROBE_CHUNK 4096
+
+static void probeBody(int fd, void* arg) {
+  size_t total = (size_t)(uintptr_t)arg * 1024;
+  uint8_t* chunk = (uint8_t*)malloc(PROBE_CHUNK);
+  if (!chunk) return;
+  for (int i = 0; i < PROBE_CHUNK; i++) chunk[i] = (uint8_t)(i * 31 + 7);
+
+  size_t sent = 0;
+  int64_t t0 = esp_timer_get_time();
+  while (sent < total) {
+    size_t n = total - sent < PROBE_CHUNK ? total - sent : PROBE_CHUNK;
+    if (httpStreamSend(fd, chunk, n) != ESP_OK) break;
+    sent += n;
+  }
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  free(chunk);
+  if (sent == total) phyRecordProbe(sent, us);
+}
+
+static esp_err_t probe_handler(httpd_req_t *req) {
+  char query[32], val[12];
+  uintptr_t kb = 1024;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "kb", val, sizeof(val)) == ESP_OK) {
+    kb = strtoul(val, NULL, 10);
+  }
+  if (kb < 16) kb = 16;
+  if (kb > 8192) kb = 8192;
+  if (httpStreamDetach(req, "application/octet-stream", "probe", probeBody, (void*)kb) != ESP_OK) {
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+// /phy -> calibration state (JSON); /phy?calibrate=1 starts a run
+static esp_err_t phy_handler(httpd_req_t *req) {
+  char query[32], val[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "calibrate", val, sizeof(val)) == ESP_OK && val[0] == '1') {
+    phyStartCalibration();
+  }
+  char json[256];
+  size_t n = phyStatusJson(json, sizeof(json));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// /calibrate -> page that drives the probes while the device switches PHY modes
+static esp_err_t calibrate_handler(httpd_req_t *req) {
+  static const char CAL_HTML[] = R"HTML(
+<!doctype html><html><head>
+<meta charset="utf-8"><meta name="viewport" content="width=device-width, initial-scale=1">
+<title>NozzleCAM - Wi-Fi calibration</title>
+<style>body{background:#000;color:#fff;font-family:system-ui,Arial,sans-serif;padding:1rem}
+pre{background:#111;padding:.75rem;border-radius:.5rem;white-space:pre-wrap}</style>
+</head><body>
+<h3>Wi-Fi PHY calibration</h3>
+<p>Keep this page open. The link drops briefly while each mode is tried.</p>
+<pre id="log"></pre>
+<script>
+const log = t => document.getElementById('log').textContent += t + '\n';
+const sleep = ms => new Promise(r => setTimeout(r, ms));
+async function phy(q){ const r = await fetch('/phy' + (q||''), {cache:'no-store'}); return r.json(); }
+async function probe(){
+  const t0 = performance.now();
+  const r = await fetch('/probe?kb=1024', {cache:'no-store'});
+  const b = await r.arrayBuffer();
+  return Math.round(b.byteLength * 8 / (performance.now() - t0));   // kbit/s
+}
+(async () => {
+  let st = await phy('?calibrate=1');
+  log('started');
+  while (true) {
+    await sleep(2500);                      // mode switch + reassociation
+    try { log(st.current + ': ' + await probe() + ' kbit/s (client side)'); }
+    catch(e) { log('probe failed, retrying'); continue; }
+    try { st = await phy(); } catch(e) { continue; }
+    if (st.state === 'done' || st.state === 'aborted') break;
+  }
+  if (st.state === 'aborted') log('aborted: no probe reached the device, stored mode kept');
+  else log('winner: ' + st.winner + '  ' + JSON.stringify(st.kbps));
+})();
+</script></body></html>
+)HTML";
+  httpd_resp_set_type(req, "text/html");
+  return httpd_resp_send(req, CAL_HTML, strlen(CAL_HTML));
+}
+
+// ---------- HTTP: analytics QoS status ----------
+static esp_err_t qos_handler(httpd_req_t *req) {
+  char query[32], val[12];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "target", val, sizeof(val)) == ESP_OK) {
+    qosSetTargetFps(atof(val));
+  }
+
+  char json[1024];
+  size_t n = qosStatusJson(json, sizeof(json));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// ---------- HTTP: adaptive capture rate ----------
+// /power -> governor state, duty cycle, energy estimate, event latency (JSON)
+//   ?mode=auto|max &idle_fps=1 &quiet=<s> &delta=<levels> &blocks=<n>
+static esp_err_t power_handler(httpd_req_t *req) {
+  char query[96], val[12];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    rate_config_t c = rateGovConfig();
+    if (httpd_query_key_value(query, "idle_fps", val, sizeof(val)) == ESP_OK) c.idle_fps = atof(val);
+    if (httpd_query_key_value(query, "quiet", val, sizeof(val)) == ESP_OK)    c.quiet_ms = atoi(val) * 1000;
+    if (httpd_query_key_value(query, "delta", val, sizeof(val)) == ESP_OK)    c.delta = atoi(val);
+    if (httpd_query_key_value(query, "blocks", val, sizeof(val)) == ESP_OK)   c.min_blocks = atoi(val);
+    rateGovSetConfig(c);
+    if (httpd_query_key_value(query, "mode", val, sizeof(val)) == ESP_OK) {
+      if (!strcmp(val, "auto")) rateGovEnable(true);
+      else if (!strcmp(val, "max")) rateGovEnable(false);
+    }
+  }
+  char json[640];
+  size_t n = rateGovStatusJson(json, sizeof(json));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// ---------- HTTP: DNS ----------
+// /dns -> what the DNS responder answered and turned away (JSON)
+static esp_err_t dns_handler(httpd_req_t *req) {
+  char json[768];
+  size_t n = captiveDnsJson(json, sizeof(json));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json, n);
+}
+
+// ---------- HTTP: TCP transport stats ----------
+// /tcp -> per-connection lwIP PCB samples for every detached response, plus
+// lwIP's TCP queues and heap (JSON). The caller's own connections say "you".
+static esp_err_t tcp_handler(httpd_req_t *req) {
+  const size_t cap = 4096;
+  char* json = (char*)malloc(cap);
+  if (!json) return httpd_resp_send_500(req);
+  size_t n = tcpStatsJson(json, cap, httpd_req_to_sockfd(req));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t err = httpd_resp_send(req, json, n);
+  free(json);
+  return err;
+}
+
+// ---------- HTTP: capture timing ----------
+// /timing -> sensor (VSYNC), capture (DMA) and delivered (network) rates side by side
+//   ?frames=N (<= 32) adds the last N per-frame records
+static esp_err_t timing_handler(httpd_req_t *req) {
+  char query[32], val[8];
+  int frames = 0;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "frames", val, sizeof(val)) == ESP_OK) {
+    frames = atoi(val);
+  }
+
+  const size_t cap = 4096;
+  char* json = (char*)malloc(cap);
+  if (!json) return httpd_resp_send_500(req);
+  int n = snprintf(json, cap, "{\"delivered_fps\":%.2f,\"delivered_kbps\":%u,\"capture\":",
+                   qosStreamFps(), (unsigned)(qosStreamBytesPerSec() / 1024));
+  n += capTimingJson(json + n, cap - n - 1, frames);
+  json[n++] = '}';
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t err = httpd_resp_send(req, json, n);
+  free(json);
+  return err;
+}
+
+// ---------- HTTP: snapshot + long-poll (mjpg-streamer / OctoPrint style) ----------
+// All pollers share the frame cache: one capture (or the running stream)
+// serves every concurrent request.
+#define SNAPSHOT_MAX_AGE_MS  500
+#define SNAPSHOT_TIMEOUT_MS  3000
+#define NEXT_TIMEOUT_MS      10000
+
+static void sendCachedFrame(int fd, const frame_ref_t* f, const char* fail_status) {
+  char extra[96];
+  if (!f) {
+    snprintf(extra, sizeof(extra), "X-Frame-Seq: %u\r\n", (unsigned)frameCacheSeq());
+    httpStreamSendHead(fd, fail_status, "text/plain", 0, extra);
+    return;
+  }
+  snprintf(extra, sizeof(extra), "X-Frame-Seq: %u\r\nX-Timestamp: %llu.%06u\r\n",
+           (unsigned)f->seq, (unsigned long long)(f->ts_us / 1000000), (unsigned)(f->ts_us % 1000000));
+  if (httpStreamSendHead(fd, "200 OK", "image/jpeg", (long)f->len, extra) == ESP_OK)
+    httpStreamSend(fd, f->buf, f->len);
+  frameCacheRelease(*f);
+}
+
+static void snapshotBody(int fd, void* arg) {
+  (void)arg;
+  frame_ref_t f;
+  bool ok = frameCacheAcquire(0, SNAPSHOT_MAX_AGE_MS, SNAPSHOT_TIMEOUT_MS, &f);
+  sendCachedFrame(fd, ok ? &f : NULL, "503 Service Unavailable");
+}
+
+static esp_err_t snapshot_handler(httpd_req_t *req) {
+  if (httpStreamDetach(req, NULL, "snapshot", snapshotBody, NULL, 4096) != ESP_OK) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
+}
+
+// /next?after=seq -> first frame with a higher seq (204 after 10 s without one).
+// Without `after` it waits for the frame after the current one.
+static void nextBody(int fd, void* arg) {
+  frame_ref_t f;
+  bool ok = frameCacheAcquire((uint32_t)(uintptr_t)arg, UINT32_MAX, NEXT_TIMEOUT_MS, &f);
+  sendCachedFrame(fd, ok ? &f : NULL, "204 No Content");
+}
+
+static esp_err_t next_handler(httpd_req_t *req) {
+  char query[32], val[12];
+  uint32_t after = frameCacheSeq();
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "after", val, sizeof(val)) == ESP_OK) {
+    after = strtoul(val, NULL, 10);
+  }
+  if (httpStreamDetach(req, NULL, "next", nextBody, (void*)(uintptr_t)after, 4096) != ESP_OK) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: stacked stills ----------
+// /capture?stack=N&size=qvga|hvga|vga&q=90 -> one JPEG averaged from an RGB565
+// burst of N (1..16) frames. The stream pauses for the burst only.
+// &brightness=&contrast= as on /stream.
+struct CaptureReq { int frames; framesize_t size; int quality; int brightness; float contrast; };
+
+static void captureBody(int fd, void* arg) {
+  CaptureReq* c = (CaptureReq*)arg;
+  stack_result_t r;
+  esp_err_t err = stackCapture(c->frames, c->size, c->quality, &r);
+  if (err == ESP_OK && adjustWanted(c->brightness, c->contrast)) {
+    size_t cap = jpegAdjustBound(r.len);
+    uint8_t* adj = (uint8_t*)psAlloc(cap);
+    long n = adj ? jpegAdjust(r.jpg, r.len, c->brightness, c->contrast, adj, cap) : JPEG_ADJUST_ERR_SPACE;
+    if (n > 0) {
+      free(r.jpg);
+      r.jpg = adj;
+      r.len = (size_t)n;
+    } else {
+      free(adj);                    // keep the unadjusted still
+    }
+  }
+  delete c;
+  if (err != ESP_OK) {
+    const char* status = err == ESP_ERR_INVALID_STATE || err == ESP_ERR_NOT_SUPPORTED
+                         ? "503 Service Unavailable" : "500 Internal Server Error";
+    const char* msg = err == ESP_ERR_NOT_SUPPORTED ? "needs PSRAM" : esp_err_to_name(err);
+    if (httpStreamSendHead(fd, status, "text/plain", strlen(msg), NULL) == ESP_OK)
+      httpStreamSend(fd, msg, strlen(msg));
+    return;
+  }
+  char extra[128];
+  snprintf(extra, sizeof(extra), "X-Stack-Frames: %d\r\nX-Stack-Accum-Us: %u\r\nX-Encode-Ms: %u\r\n",
+           r.frames, (unsigned)r.accum_us, (unsigned)r.encode_ms);
+  if (httpStreamSendHead(fd, "200 OK", "image/jpeg", (long)r.len, extra) == ESP_OK)
+    httpStreamSend(fd, r.jpg, r.len);
+  free(r.jpg);
+}
+
+static esp_err_t capture_handler(httpd_req_t *req) {
+  char query[112], val[12];
+  CaptureReq c = { 8, FRAMESIZE_VGA, 90, 0, 1.0f };
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "stack", val, sizeof(val)) == ESP_OK)
+      c.frames = atoi(val);                           // clamped to 1..16 by stackCapture
+    if (httpd_query_key_value(query, "size", val, sizeof(val)) == ESP_OK)
+      c.size = rawFramesize(val);                     // RGB565 VGA is already 600 KB per fb
+    if (httpd_query_key_value(query, "q", val, sizeof(val)) == ESP_OK)
+      c.quality = atoi(val);
+    adjustParams(query, &c.brightness, &c.contrast);
+  }
+  if (c.size == FRAMESIZE_INVALID) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "size: 96x96|qqvga|qcif|hqvga|240x240|qvga|cif|hvga|vga");
+    return ESP_OK;
+  }
+  CaptureReq* ctx = new CaptureReq(c);
+  if (httpStreamDetach(req, NULL, "capture", captureBody, ctx, 8192) != ESP_OK) {
+    delete ctx;
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: motion heatmap ----------
+// /heatmap            -> JPEG of the activity map over the latest frame
+//   ?zoom=1..8 (default 4, 16 px cells -> 1/4 of the frame size) &overlay=0
+//   ?half_life=<s> &floor=<n> reconfigure, ?reset=1 clears, ?info=1 -> JSON
+struct HeatmapReq { int zoom; bool overlay; };
+
+static void heatmapBody(int fd, void* arg) {
+  HeatmapReq r = *(HeatmapReq*)arg;
+  delete (HeatmapReq*)arg;
+  frame_ref_t f;
+  bool have_bg = r.overlay && frameCacheAcquire(0, 2000, SNAPSHOT_TIMEOUT_MS, &f);
+  uint8_t* jpg = NULL;
+  size_t len = 0;
+  esp_err_t err = heatmapRenderJpeg(have_bg ? f.buf : NULL, have_bg ? f.len : 0, r.zoom, &jpg, &len);
+  if (have_bg) frameCacheRelease(f);
+  if (err != ESP_OK) {
+    const char* msg = err == ESP_ERR_INVALID_STATE ? "no frames analysed yet" : esp_err_to_name(err);
+    if (httpStreamSendHead(fd, "503 Service Unavailable", "text/plain", strlen(msg), NULL) == ESP_OK)
+      httpStreamSend(fd, msg, strlen(msg));
+    return;
+  }
+  if (httpStreamSendHead(fd, "200 OK", "image/jpeg", (long)len, "Cache-Control: no-store\r\n") == ESP_OK)
+    httpStreamSend(fd, jpg, len);
+  free(jpg);
+}
+
+static esp_err_t heatmap_handler(httpd_req_t *req) {
+  char query[96], val[12];
+  HeatmapReq r = { 4, true };
+  bool info = false;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    heatmap_config_t c = heatmapConfig();
+    if (httpd_query_key_value(query, "half_life", val, sizeof(val)) == ESP_OK) c.half_life_s = atoi(val);
+    if (httpd_query_key_value(query, "floor", val, sizeof(val)) == ESP_OK)     c.floor = atoi(val);
+    heatmapSetConfig(c);
+    if (httpd_query_key_value(query, "reset", val, sizeof(val)) == ESP_OK && atoi(val)) heatmapReset();
+    if (httpd_query_key_value(query, "zoom", val, sizeof(val)) == ESP_OK)    r.zoom = atoi(val);
+    if (httpd_query_key_value(query, "overlay", val, sizeof(val)) == ESP_OK) r.overlay = atoi(val) != 0;
+    info = httpd_query_key_value(query, "info", val, sizeof(val)) == ESP_OK && atoi(val);
+  }
+  if (info) {
+    char json[256];
+    size_t n = heatmapStatusJson(json, sizeof(json));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, json, n);
+  }
+  HeatmapReq* ctx = new HeatmapReq(r);
+  if (httpStreamDetach(req, NULL, "heatmap", heatmapBody, ctx, 8192) != ESP_OK) {
+    delete ctx;
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: scrub-preview sprites ----------
+// /sprites.jpg -> grayscale sheet of DC-luma tiles with its index in a COM segment
+//   ?last=<s> (default all held) &cols=10 &rotate=90|180|270, ?info=1 -> JSON
+struct SpritesReq { uint32_t last_s; int cols; int rotate; };
+
+static void spritesBody(int fd, void* arg) {
+  SpritesReq r = *(SpritesReq*)arg;
+  delete (SpritesReq*)arg;
+  uint8_t* jpg = NULL;
+  size_t len = 0;
+  esp_err_t err = spritesRenderJpeg(r.last_s, r.cols, r.rotate, &jpg, &len);
+  if (err != ESP_OK) {
+    const char* msg = err == ESP_ERR_NOT_FOUND ? "no tiles in range" : esp_err_to_name(err);
+    if (httpStreamSendHead(fd, "503 Service Unavailable", "text/plain", strlen(msg), NULL) == ESP_OK)
+      httpStreamSend(fd, msg, strlen(msg));
+    return;
+  }
+  if (httpStreamSendHead(fd, "200 OK", "image/jpeg", (long)len, "Cache-Control: no-store\r\n") == ESP_OK)
+    httpStreamSend(fd, jpg, len);
+  free(jpg);
+}
+
+static esp_err_t sprites_handler(httpd_req_t *req) {
+  char query[64], val[12];
+  SpritesReq r = { 0, 10, 0 };
+  bool info = false;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "last", val, sizeof(val)) == ESP_OK)   r.last_s = atoi(val);
+    if (httpd_query_key_value(query, "cols", val, sizeof(val)) == ESP_OK)   r.cols = atoi(val);
+    if (httpd_query_key_value(query, "rotate", val, sizeof(val)) == ESP_OK) r.rotate = atoi(val);
+    info = httpd_query_key_value(query, "info", val, sizeof(val)) == ESP_OK && atoi(val);
+  }
+  if (info) {
+    char json[256];
+    size_t n = spritesStatusJson(json, sizeof(json));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, json, n);
+  }
+  SpritesReq* ctx = new SpritesReq(r);
+  if (httpStreamDetach(req, NULL, "sprites", spritesBody, ctx, 6144) != ESP_OK) {
+    delete ctx;
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
+}
+
+// ---------- HTTP: multi-camera dashboard ----------
+// /?action=dashboard: a grid of units. Tiles pull /stream?fps=&scale=8 thumbnails
+// sharing a fixed fps budget, so airtime stays bounded however many units are
+// shown; the focused tile alone switches to the full-rate stream.
+static esp_err_t dashboard_handler(httpd_req_t *req) {
+  static const char DASH_HTML[] = R"HTML(
+<!doctype html><html><head>
+<meta charset="utf-8"><meta name="viewport" content="width=device-width, initial-scale=1">
+<title>NozzleCAM - Dashboard</title>
+<style>
+  body{background:#000;color:#fff;font-family:system-ui,Arial,sans-serif;margin:0;padding:.5rem}
+  .bar{display:flex;gap:.5rem;align-items:center;margin-bottom:.5rem}
+  input,button{background:#111;color:#fff;border:1px solid #333;border-radius:.4rem;padding:.35rem .5rem}
+  #grid{display:grid;gap:.5rem;grid-template-columns:repeat(auto-fill,minmax(220px,1fr))}
+  .tile{position:relative;background:#111;border-radius:.5rem;overflow:hidden;cursor:pointer}
+  .tile img{display:block;width:100%;aspect-ratio:4/3;object-fit:contain;background:#000}
+  .tile.focus{grid-column:1/-1}
+  .tile span{position:absolute;left:.4rem;top:.3rem;font-size:.8rem;text-shadow:0 0 3px #000}
+  .tile button{position:absolute;right:.3rem;top:.3rem;padding:0 .4rem}
+</style>
+</head><body>
+<div class="bar"><strong>NozzleCAM</strong>
+  <input id="add" placeholder="add unit (host or IP)">
+  <span id="info"></span></div>
+<div id="grid"></div>
+<script>
+const THUMB_BUDGET_FPS = 4;     // all thumbnails together
+const THUMB_MAX_FPS = 2;        // per tile; no floor, or many tiles would outgrow the budget
+const BLANK = 'data:image/gif;base64,R0lGODlhAQABAAAAACw=';
+const self = location.host;
+const q = new URLSearchParams(location.search).get('units');
+let units = JSON.parse(localStorage.getItem('units') || '[]');
+if (q) units = q.split(',').map(s => s.trim()).filter(Boolean);
+let focus = null;
+const grid = document.getElementById('grid');
+
+function save(){ localStorage.setItem('units', JSON.stringify(units)); }
+function all(){ return [self, ...units.filter(u => u !== self)]; }
+
+function render(){
+  const list = all();
+  const thumbs = list.filter(u => u !== focus).length;
+  const fps = Math.min(THUMB_MAX_FPS, THUMB_BUDGET_FPS / Math.max(1, thumbs));
+  document.getElementById('info').textContent =
+    list.length + ' unit(s), thumbnails at ' + fps.toFixed(3) + ' fps';
+  for (const t of [...grid.children]) if (!list.includes(t.dataset.host)) { t.querySelector('img').src = BLANK; t.remove(); }
+  for (const host of list) {
+    let t = grid.querySelector('[data-host="' + host + '"]');
+    if (!t) {
+      t = document.createElement('div');
+      t.className = 'tile'; t.dataset.host = host;
+      t.innerHTML = '<img alt=""><span></span>' + (host === self ? '' : '<button title="remove">×</button>');
+      t.querySelector('span').textContent = host;
+      t.onclick = () => { focus = focus === host ? null : host; render(); };
+      const rm = t.querySelector('button');
+      if (rm) rm.onclick = e => { e.stopPropagation(); units = units.filter(u => u !== host); if (focus === host) focus = null; save(); render(); };
+      grid.appendChild(t);
+    }
+    t.classList.toggle('focus', host === focus);
+    const src = document.hidden ? BLANK
+              : 'http://' + host + (host === focus ? '/stream' : '/stream?fps=' + fps.toFixed(3) + '&scale=8');
+    const img = t.querySelector('img');
+    if (img.dataset.src !== src) { img.dataset.src = src; img.src = src; }
+  }
+}
+
+document.getElementById('add').onchange = e => {
+  const h = e.target.value.trim();
+  if (h && !units.includes(h)) { units.push(h); save(); render(); }
+  e.target.value = '';
+};
+document.addEventListener('visibilitychange', render);
+fetch('/peers', {cache:'no-store'}).then(r => r.json()).then(peers => {
+  let added = false;
+  for (const p of peers) if (p.ip && !units.includes(p.ip) && p.ip !== location.hostname) { units.push(p.ip); added = true; }
+  if (added) { save(); render(); }
+}).catch(() => {});
+render();
+</script>
+</body></html>
+)HTML";
+  httpd_resp_set_type(req, "text/html; charset=utf-8");
+  return httpd_resp_send(req, DASH_HTML, HTTPD_RESP_USE_STRLEN);
+}
+
+// /peers -> other NozzleCAMs answering mDNS _nozzlecam._tcp (JSON). The query
+// takes a few seconds, so it runs on its own task.
+static void peersBody(int fd, void* arg) {
+  (void)arg;
+  runtime_peer_t peer[8];
+  int found = runtimeMdnsQuery("nozzlecam", "tcp", 3000, peer, 8);
+  char json[1024];
+  int n = snprintf(json, sizeof(json), "[");
+  for (int i = 0; i < found && n < (int)sizeof(json) - 160; i++) {
+    const uint8_t* a = peer[i].ip;
+    n += snprintf(json + n, sizeof(json) - n, "%s{\"host\":\"%s.local\",\"ip\":\"%u.%u.%u.%u\",\"port\":%u}",
+                  i ? "," : "", peer[i].host, a[0], a[1], a[2], a[3], peer[i].port);
+  }
+  n += snprintf(json + n, sizeof(json) - n, "]");
+  if (httpStreamSendHead(fd, "200 OK", "application/json", n, "Cache-Control: no-store\r\n") == ESP_OK)
+    httpStreamSend(fd, json, n);
+}
+
+static esp_err_t peers_handler(httpd_req_t *req) {
+  if (httpStreamDetach(req, NULL, "peers", peersBody, NULL, 4096) != ESP_OK) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+  }
+  return ESP_OK;
 }
 
 // ---------- HTTP: index page ----------
 static esp_err_t index_handler(httpd_req_t *req) {
-  static const char PROGMEM INDEX_HTML[] = R"HTML(
+  // mjpg-streamer compatible: /?action=snapshot, /?action=stream. The
+  // handlers below read the full query themselves; a query longer than this
+  // still yields its (leading) action.
+  char query[112], action[12];
+  esp_err_t qerr = httpd_req_get_url_query_str(req, query, sizeof(query));
+  if ((qerr == ESP_OK || qerr == ESP_ERR_HTTPD_RESULT_TRUNC) &&
+      httpd_query_key_value(query, "action", action, sizeof(action)) == ESP_OK) {
+    if (!strcmp(action, "snapshot")) return snapshot_handler(req);
+    if (!strcmp(action, "stream")) return stream_handler(req);
+    if (!strcmp(action, "dashboard")) return dashboard_handler(req);
+    if (!strcmp(action, "delta")) return delta_view_handler(req);
+  }
+
+  static const char INDEX_HTML[] = R"HTML(
 <!doctype html><html><head>
 <meta charset="utf-8">
 <meta name="viewport" content="width=device-width, initial-scale=1, viewport-fit=cover">
@@ -179,6 +1305,7 @@ static esp_err_t index_handler(httpd_req_t *req) {
   button.icon:hover{background-color:#141414}
   button.icon:active{transform:translateY(1px)}
   button.icon.toggle.on{box-shadow:inset 0 0 0 2px #0af}
+  button.icon[hidden]{display:none}
   /* Assign icon images via CSS vars (self-contained SVG data URIs) */
   button.icon{background-image:var(--img)}
   /* Camera (Snapshot) */
@@ -186,6 +1313,14 @@ static esp_err_t index_handler(httpd_req_t *req) {
   /* Record (red circle) / Stop (red square) */
   #rec{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><circle cx='12' cy='12' r='6' fill='%23e53935'/></svg>")}
   #rec.on{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><rect x='7' y='7' width='10' height='10' rx='2' fill='%23e53935'/></svg>")}
+  /* Rotate (quarter-turn arrow) */
+  #rot{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><path fill='%23fff' d='M12 4V1l4 4-4 4V6a6 6 0 106 6h2a8 8 0 11-8-8z'/></svg>")}
+  /* Brightness / contrast (half-filled circle) */
+  #adj{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><circle cx='12' cy='12' r='8' fill='none' stroke='%23fff' stroke-width='2'/><path fill='%23fff' d='M12 4a8 8 0 010 16z'/></svg>")}
+  /* Network overlay (signal bars) */
+  #net{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><path fill='%23fff' d='M4 16h3v4H4zm5-4h3v8H9zm5-4h3v12h-3zm5-4h3v16h-3z'/></svg>")}
+  /* Review (play triangle) */
+  #rev{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><path fill='%23fff' d='M8 5v14l11-7z'/></svg>")}
   /* Fullscreen enter / exit */
   #fs{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><path fill='%23fff' d='M4 9V4h5v2H6v3H4zm10-5h5v5h-2V6h-3V4zM4 15h2v3h3v2H4v-5zm13 3v-3h2v5h-5v-2h3z'/></svg>")}
   #fs.on{--img:url("data:image/svg+xml;utf8,<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 24 24'><path fill='%23fff' d='M9 7V4H4v5h2V7h3zm9 2h2V4h-5v3h3v2zM7 15H4v5h5v-2H7v-3zm10 3h-3v2h5v-5h-2v3z'/></svg>")}
@@ -198,6 +1333,22 @@ static esp_err_t index_handler(httpd_req_t *req) {
     display:block;width:100vw;height:100vh;object-fit:contain;background:#000;touch-action:none;
   }
   canvas{display:none}
+  #adjust{position:fixed;top:3.75rem;right:.75rem;z-index:11;padding:.5rem .75rem;border-radius:.6rem;
+    background:rgba(0,0,0,.6);display:grid;grid-template-columns:auto 9rem 2.5rem;gap:.25rem .5rem;align-items:center;font-size:.85rem}
+  #adjust[hidden]{display:none}
+  #netinfo{position:fixed;left:.75rem;bottom:.75rem;z-index:11;padding:.4rem .6rem;border-radius:.5rem;
+    background:rgba(0,0,0,.6);font:12px/1.4 ui-monospace,Menlo,Consolas,monospace;white-space:pre;pointer-events:none}
+  #netinfo[hidden]{display:none}
+  /* Review of the last recording with sprite-sheet scrub previews */
+  #review{position:fixed;inset:0;z-index:20;background:rgba(0,0,0,.92);
+    display:flex;flex-direction:column;align-items:center;justify-content:center;gap:.75rem}
+  #review[hidden]{display:none}
+  #play{max-width:96vw;max-height:70vh;background:#000}
+  #scrubwrap{position:relative;width:90vw}
+  #scrub{width:100%}
+  #pv{position:absolute;bottom:2rem;display:none;border:1px solid #fff;background-repeat:no-repeat;
+    transform:translateX(-50%);pointer-events:none}
+  #revclose{position:absolute;top:.75rem;right:.75rem;font-size:1.5rem;background:none;border:0;color:#fff;cursor:pointer}
 </style>
 </head><body>
   <div class="bar">
@@ -206,6 +1357,10 @@ static esp_err_t index_handler(httpd_req_t *req) {
       <a id="dl" class="btn" download>Save file…</a>
       <button id="shot" class="icon" aria-label="Snapshot" title="Snapshot"></button>
       <button id="rec" class="icon toggle" aria-label="Record" title="Record" aria-pressed="false"></button>
+      <button id="rev" class="icon" aria-label="Review recording" title="Review recording" hidden></button>
+      <button id="rot" class="icon" aria-label="Rotate" title="Rotate"></button>
+      <button id="adj" class="icon toggle" aria-label="Brightness and contrast" title="Brightness / contrast" aria-pressed="false"></button>
+      <button id="net" class="icon toggle" aria-label="Connection stats" title="Connection stats" aria-pressed="false"></button>
       <button id="fs"  class="icon toggle" aria-label="Fullscreen" title="Fullscreen" aria-pressed="false"></button>
     </div>
   </div>
@@ -215,6 +1370,22 @@ static esp_err_t index_handler(httpd_req_t *req) {
     <canvas id="cvs"></canvas>
   </div>
 
+  <div id="adjust" hidden>
+    <label for="bri">Brightness</label><input id="bri" type="range" min="-100" max="100" step="5"><span id="briv"></span>
+    <label for="con">Contrast</label><input id="con" type="range" min="50" max="200" step="5"><span id="conv"></span>
+  </div>
+
+  <div id="netinfo" hidden></div>
+
+  <div id="review" hidden>
+    <button id="revclose" aria-label="Close">×</button>
+    <video id="play" playsinline></video>
+    <div id="scrubwrap">
+      <div id="pv"></div>
+      <input id="scrub" type="range" min="0" max="1" step="0.1" value="0">
+    </div>
+  </div>
+
 <script>
   const img  = document.getElementById('stream');
   const cvs  = document.getElementById('cvs');
@@ -223,10 +1394,84 @@ static esp_err_t index_handler(httpd_req_t *req) {
   const btnShot = document.getElementById('shot');
   const btnRec  = document.getElementById('rec');
   const btnFS   = document.getElementById('fs');
+  const btnRot  = document.getElementById('rot');
+
+  // Always start the MJPEG stream immediately. Rotation, brightness and
+  // contrast happen on the camera without decoding, so snapshots and
+  // recordings (drawn from this stream) come out the same way.
+  let rot = parseInt(localStorage.getItem('rotate') || '0', 10) || 0;
+  const bri = document.getElementById('bri');
+  const con = document.getElementById('con');
+  bri.value = localStorage.getItem('brightness') || '0';
+  con.value = localStorage.getItem('contrast') || '100';
+  function adjustQuery(){
+    const q = [];
+    if (+bri.value) q.push('brightness=' + bri.value);
+    if (+con.value !== 100) q.push('contrast=' + (con.value / 100).toFixed(2));
+    return q;
+  }
+  function startStream(){
+    const q = adjustQuery();
+    if (rot) q.unshift('rotate=' + rot);
+    img.src = '/stream' + (q.length ? '?' + q.join('&') : '');
+    btnRot.title = 'Rotate (' + rot + '°)';
+    document.getElementById('briv').textContent = bri.value;
+    document.getElementById('conv').textContent = con.value + '%';
+  }
+  startStream();
+  btnRot.onclick = () => {
+    rot = (rot + 90) % 360;
+    localStorage.setItem('rotate', String(rot));
+    startStream();
+  };
+  const btnAdj = document.getElementById('adj');
+  const adjust = document.getElementById('adjust');
+  btnAdj.onclick = () => {
+    adjust.hidden = !adjust.hidden;
+    btnAdj.classList.toggle('on', !adjust.hidden);
+    btnAdj.setAttribute('aria-pressed', adjust.hidden ? 'false' : 'true');
+  };
+  for (const el of [bri, con]) {
+    el.oninput = () => {                  // labels follow the thumb, the stream restarts on release
+      document.getElementById('briv').textContent = bri.value;
+      document.getElementById('conv').textContent = con.value + '%';
+    };
+    el.onchange = () => {
+      localStorage.setItem('brightness', bri.value);
+      localStorage.setItem('contrast', con.value);
+      startStream();
+    };
+  }
 
-  // Always start the MJPEG stream immediately
-  const streamURL = '/stream';
-  img.src = streamURL;
+  // Connection overlay: this viewer's TCP state from /tcp (lwIP PCB samples),
+  // to tell retransmissions, a small receive window and a full send queue apart.
+  const btnNet = document.getElementById('net');
+  const netinfo = document.getElementById('netinfo');
+  let netTimer = null;
+  const kb = b => (b / 1024).toFixed(1) + 'k';
+  async function pollNet(){
+    try{
+      const j = await (await fetch('/tcp', {cache:'no-store'})).json();
+      const mine = j.conns.filter(c => c.you);
+      const lines = (mine.length ? mine : j.conns).map(c =>
+        `${c.name} :${c.port}  rtt ${c.srtt_ms}±${c.rttvar_ms} ms  rto ${c.rto_ms} ms  retx ${c.retx}${c.recovery ? ' (recovering)' : ''}\n` +
+        `  cwnd ${kb(c.cwnd)}  peer wnd ${kb(c.peer_wnd)} (small ${c.small_wnd_pct}%)  rcv wnd ${kb(c.rcv_wnd)}\n` +
+        `  queued ${kb(c.queued)} / ${c.snd_queuelen} pbufs  in flight ${kb(c.in_flight)}  full ${c.full_queue_pct}%`);
+      const l = j.lwip;
+      lines.push(`lwIP ${l.active_pcbs} pcbs (+${l.time_wait_pcbs} time-wait)  queued ${kb(l.queued_bytes)} / ${l.queued_pbufs} pbufs  ` +
+                 `heap ${kb(l.heap_free)} (largest ${kb(l.heap_largest)})`);
+      netinfo.textContent = lines.join('\n');
+    }catch(e){ netinfo.textContent = 'no stats'; }
+  }
+  btnNet.onclick = () => {
+    const on = netinfo.hidden;
+    netinfo.hidden = !on;
+    btnNet.classList.toggle('on', on);
+    btnNet.setAttribute('aria-pressed', on ? 'true' : 'false');
+    clearInterval(netTimer);
+    netTimer = on ? setInterval(pollNet, 1000) : null;
+    if (on) pollNet();
+  };
 
   // --- Fullscreen ---
   function syncFSButton(){
@@ -305,8 +1550,70 @@ static esp_err_t index_handler(httpd_req_t *req) {
     }catch(e){ showMsg('Snapshot failed'); console.error(e); }
   };
 
+  // Review: the last recording plus its sprite sheet (/sprites.jpg, fetched
+  // once when recording stops). Tiles carry device times in the sheet's COM
+  // index; the recording ended at now_ms, so tile t sits at t - start.
+  const btnRev = document.getElementById('rev');
+  const review = document.getElementById('review');
+  const play = document.getElementById('play');
+  const scrub = document.getElementById('scrub');
+  const pv = document.getElementById('pv');
+  let last = null;   // {url, dur, sheet:{url, w, h, idx}}
+
+  function jpegComment(buf){
+    const b = new Uint8Array(buf);
+    for (let i = 2; i + 4 <= b.length && b[i] === 0xFF; ) {
+      const m = b[i + 1], len = b[i + 2] << 8 | b[i + 3];
+      if (m === 0xFE) return new TextDecoder().decode(b.subarray(i + 4, i + 2 + len));
+      if (m === 0xDA) break;
+      i += 2 + len;
+    }
+    return null;
+  }
+
+  async function fetchSprites(dur){
+    try {
+      const r = await fetch('/sprites.jpg?cols=10&last=' + Math.ceil(dur + 1) + (rot ? '&rotate=' + rot : ''));
+      if (!r.ok) return null;
+      const buf = await r.arrayBuffer();
+      const idx = JSON.parse(jpegComment(buf));
+      const url = URL.createObjectURL(new Blob([buf], {type: 'image/jpeg'}));
+      const im = new Image();
+      await new Promise((ok, bad) => { im.onload = ok; im.onerror = bad; im.src = url; });
+      return {url, w: im.naturalWidth, h: im.naturalHeight, idx};
+    } catch(e) { return null; }
+  }
+
+  function showPreview(){
+    const sh = last && last.sheet;
+    if (!sh || !sh.idx.t.length) return;
+    const t = sh.idx.now_ms - (last.dur - scrub.value) * 1000;
+    let k = 0;
+    while (k + 1 < sh.idx.t.length && sh.idx.t[k + 1] <= t) k++;
+    const [tw, th] = sh.idx.tile, z = 2, cols = sh.idx.cols;
+    pv.style.width = tw * z + 'px';
+    pv.style.height = th * z + 'px';
+    pv.style.backgroundImage = 'url(' + sh.url + ')';
+    pv.style.backgroundSize = sh.w * z + 'px ' + sh.h * z + 'px';
+    pv.style.backgroundPosition = -(k % cols) * tw * z + 'px ' + -Math.floor(k / cols) * th * z + 'px';
+    pv.style.left = (scrub.value / last.dur * 100) + '%';
+    pv.style.display = 'block';
+  }
+  scrub.oninput = showPreview;
+  scrub.onchange = () => { pv.style.display = 'none'; play.currentTime = +scrub.value; };
+  play.ontimeupdate = () => { if (pv.style.display !== 'block') scrub.value = play.currentTime; };
+  btnRev.onclick = () => {
+    if (!last) return;
+    play.src = last.url;
+    scrub.max = last.dur;
+    scrub.value = 0;
+    review.hidden = false;
+    play.play().catch(()=>{});
+  };
+  document.getElementById('revclose').onclick = () => { play.pause(); review.hidden = true; };
+
   // Recording (client-side): draw frames to canvas at ~20 fps, record canvas stream
-  let rec = null, chunks = [], drawTimer = null;
+  let rec = null, chunks = [], drawTimer = null, recStart = 0;
   function setRecUI(on){
     btnRec.classList.toggle('on', on);
     btnRec.setAttribute('aria-pressed', on ? 'true' : 'false');
@@ -349,12 +1656,17 @@ static esp_err_t index_handler(httpd_req_t *req) {
     rec.onstop = async ()=>{
       const type = chunks[0]?.type || 'video/webm';
       const blob = new Blob(chunks, { type });
+      const dur = (performance.now() - recStart) / 1000;
+      if (last) { URL.revokeObjectURL(last.url); if (last.sheet) URL.revokeObjectURL(last.sheet.url); }
+      last = {url: URL.createObjectURL(blob), dur, sheet: await fetchSprites(dur)};
+      btnRev.hidden = false;
       const ts = new Date().toISOString().replace(/[:.]/g,'-');
       await saveBlobSmart(blob, `NozzleCAM_${ts}.webm`, type);
       setRecUI(false);
     };
 
     rec.start(1000);
+    recStart = performance.now();
     setRecUI(true);
   };
 
@@ -403,13 +1715,56 @@ static void startCameraServer(){
   httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
   cfg.server_port = 80;
   cfg.uri_match_fn = httpd_uri_match_wildcard;
+  cfg.max_uri_handlers = 24;
+  cfg.max_open_sockets = 7;
+  httpStreamInstall(cfg);
 
   httpd_uri_t index_uri  = { .uri="/",        .method=HTTP_GET, .handler=index_handler, .user_ctx=NULL };
   httpd_uri_t stream_uri = { .uri="/stream",  .method=HTTP_GET, .handler=stream_handler,.user_ctx=NULL };
+  httpd_uri_t qos_uri    = { .uri="/qos",     .method=HTTP_GET, .handler=qos_handler,   .user_ctx=NULL };
+  httpd_uri_t raw_uri    = { .uri="/raw",     .method=HTTP_GET, .handler=raw_handler,   .user_ctx=NULL };
+  httpd_uri_t tip_uri    = { .uri="/tip",     .method=HTTP_GET, .handler=tip_handler,   .user_ctx=NULL };
+  httpd_uri_t tip_ev_uri = { .uri="/tip/events", .method=HTTP_GET, .handler=tip_events_handler, .user_ctx=NULL };
+  httpd_uri_t ae_uri     = { .uri="/ae",      .method=HTTP_GET, .handler=ae_handler,    .user_ctx=NULL };
+  httpd_uri_t next_uri   = { .uri="/next",    .method=HTTP_GET, .handler=next_handler,  .user_ctx=NULL };
+  httpd_uri_t hist_uri   = { .uri="/history", .method=HTTP_GET, .handler=history_handler, .user_ctx=NULL };
+  httpd_uri_t probe_uri  = { .uri="/probe",   .method=HTTP_GET, .handler=probe_handler, .user_ctx=NULL };
+  httpd_uri_t phy_uri    = { .uri="/phy",     .method=HTTP_GET, .handler=phy_handler,   .user_ctx=NULL };
+  httpd_uri_t cal_uri    = { .uri="/calibrate", .method=HTTP_GET, .handler=calibrate_handler, .user_ctx=NULL };
+  httpd_uri_t cap_uri    = { .uri="/capture", .method=HTTP_GET, .handler=capture_handler, .user_ctx=NULL };
+  httpd_uri_t timing_uri = { .uri="/timing",  .method=HTTP_GET, .handler=timing_handler, .user_ctx=NULL };
+  httpd_uri_t peers_uri  = { .uri="/peers",   .method=HTTP_GET, .handler=peers_handler, .user_ctx=NULL };
+  httpd_uri_t heat_uri   = { .uri="/heatmap", .method=HTTP_GET, .handler=heatmap_handler, .user_ctx=NULL };
+  httpd_uri_t power_uri  = { .uri="/power",   .method=HTTP_GET, .handler=power_handler, .user_ctx=NULL };
+  httpd_uri_t dns_uri    = { .uri="/dns",     .method=HTTP_GET, .handler=dns_handler,   .user_ctx=NULL };
+  httpd_uri_t sprite_uri = { .uri="/sprites.jpg", .method=HTTP_GET, .handler=sprites_handler, .user_ctx=NULL };
+  httpd_uri_t tcp_uri    = { .uri="/tcp",     .method=HTTP_GET, .handler=tcp_handler,   .user_ctx=NULL };
+  httpd_uri_t delta_uri  = { .uri="/delta",   .method=HTTP_GET, .handler=delta_handler, .user_ctx=NULL };
 
   if (httpd_start(&httpd_ctrl, &cfg) == ESP_OK) {
     httpd_register_uri_handler(httpd_ctrl, &index_uri);
     httpd_register_uri_handler(httpd_ctrl, &stream_uri);
+    httpd_register_uri_handler(httpd_ctrl, &qos_uri);
+    httpd_register_uri_handler(httpd_ctrl, &raw_uri);
+    httpd_register_uri_handler(httpd_ctrl, &tip_uri);
+    httpd_register_uri_handler(httpd_ctrl, &tip_ev_uri);
+    httpd_register_uri_handler(httpd_ctrl, &ae_uri);
+    httpd_register_uri_handler(httpd_ctrl, &next_uri);
+    httpd_register_uri_handler(httpd_ctrl, &hist_uri);
+    httpd_register_uri_handler(httpd_ctrl, &probe_uri);
+    httpd_register_uri_handler(httpd_ctrl, &phy_uri);
+    httpd_register_uri_handler(httpd_ctrl, &cal_uri);
+    httpd_register_uri_handler(httpd_ctrl, &cap_uri);
+    httpd_register_uri_handler(httpd_ctrl, &timing_uri);
+    httpd_register_uri_handler(httpd_ctrl, &peers_uri);
+    httpd_register_uri_handler(httpd_ctrl, &heat_uri);
+    httpd_register_uri_handler(httpd_ctrl, &power_uri);
+    httpd_register_uri_handler(httpd_ctrl, &dns_uri);
+    httpd_register_uri_handler(httpd_ctrl, &sprite_uri);
+    httpd_register_uri_handler(httpd_ctrl, &tcp_uri);
+    httpd_register_uri_handler(httpd_ctrl, &delta_uri);
+    captiveHttpInstall(httpd_ctrl);
+    httpStreamSetServer(httpd_ctrl);
   }
 }
 
@@ -417,101 +1772,93 @@ static void startCameraServer(){
 void setup() {
   WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0);
 
-  Serial.begin(115200);
-  delay(100);
-
-  oledBoot();
-  oledPrintCentered("Booting...", "");
-
-  // Ensure sensor is powered up (PWDN LOW)
-  pinMode(PWDN_GPIO_NUM, OUTPUT);
-  digitalWrite(PWDN_GPIO_NUM, LOW);
-
-  // Camera config
-  camera_config_t config;
-  config.ledc_channel = LEDC_CHANNEL_0;
-  config.ledc_timer   = LEDC_TIMER_0;
-  config.pin_d0       = Y2_GPIO_NUM;
-  config.pin_d1       = Y3_GPIO_NUM;
-  config.pin_d2       = Y4_GPIO_NUM;
-  config.pin_d3       = Y5_GPIO_NUM;
-  config.pin_d4       = Y6_GPIO_NUM;
-  config.pin_d5       = Y7_GPIO_NUM;
-  config.pin_d6       = Y8_GPIO_NUM;
-  config.pin_d7       = Y9_GPIO_NUM;
-  config.pin_xclk     = XCLK_GPIO_NUM;
-  config.pin_pclk     = PCLK_GPIO_NUM;
-  config.pin_vsync    = VSYNC_GPIO_NUM;
-  config.pin_href     = HREF_GPIO_NUM;
-  config.pin_sccb_sda = SIOD_GPIO_NUM;
-  config.pin_sccb_scl = SIOC_GPIO_NUM;
-  config.pin_pwdn     = PWDN_GPIO_NUM;
-  config.pin_reset    = RESET_GPIO_NUM;
-  config.xclk_freq_hz = 16500000;
-  config.pixel_format = PIXFORMAT_JPEG;
-
-  if (psramFound()) {
-    config.frame_size   = STREAM_SIZE;     // UXGA
-    config.jpeg_quality = JPEG_QUALITY;    // 10
-    config.fb_count     = 2;
-    config.fb_location  = CAMERA_FB_IN_PSRAM;
-  } else {
-    config.frame_size   = FRAMESIZE_SVGA;  // safer without PSRAM
-    config.jpeg_quality = 12;
-    config.fb_count     = 1;
-    config.fb_location  = CAMERA_FB_IN_DRAM;
-  }
+  runtimeConsoleBegin();
+  runtimeDelayMs(100);
 
-  esp_err_t err = esp_camera_init(&config);
+  oledInit(I2C_SDA, I2C_SCL);
+  oledShow("Booting...");
+
+  esp_err_t err = cameraInit();
   if (err != ESP_OK) {
-    Serial.printf("Camera init failed: 0x%x\n", err);
-    oledPrintCentered("Camera init", "FAILED");
-    delay(2000);
+    printf("Camera init failed: 0x%x\n", err);
+    oledShow("Camera init", "FAILED");
+    runtimeDelayMs(2000);
   } else {
     sensor_t* s = esp_camera_sensor_get();
-    Serial.printf("Sensor PID=0x%02X, VER=0x%02X, MIDL=0x%02X, MIDH=0x%02X\n",
+    printf("Sensor PID=0x%02X, VER=0x%02X, MIDL=0x%02X, MIDH=0x%02X\n",
       s->id.PID, s->id.VER, s->id.MIDL, s->id.MIDH);
 
-    s->set_framesize(s, psramFound() ? STREAM_SIZE : FRAMESIZE_SVGA);
-    s->set_quality(s, JPEG_QUALITY);
-    if (s->set_colorbar) s->set_colorbar(s, 0);
-    if (s->set_gain_ctrl)     s->set_gain_ctrl(s, 1);
-    if (s->set_exposure_ctrl) s->set_exposure_ctrl(s, 1);
-    if (s->set_whitebal)      s->set_whitebal(s, 1);
-    if (s->set_awb_gain)      s->set_awb_gain(s, 1);
-
-    oledPrintCentered("Camera", "OK");
-    delay(400);
+    encoderInit();
+    tipInit();
+    aeAssistInit();
+    heatmapModuleInit();
+    spritesInit();
+    rateGovInit();
+    oledShow("Camera", "OK");
+    runtimeDelayMs(400);
   }
 
   // Wi-Fi AP
-  WiFi.mode(WIFI_AP);
-  bool ap_ok = WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, AP_HIDDEN, 4);
-  IPAddress ip = WiFi.softAPIP();
-
-  Serial.println(ap_ok ? "AP started." : "AP start failed!");
-  Serial.print("SSID: "); Serial.println(AP_SSID);
-  Serial.print("IP:   "); Serial.println(ip);
-
-  // DNS wildcard -> http://nozzlecam/
-  dnsServer.start(DNS_PORT, "*", ip);
-  Serial.println("DNS server started (wildcard): http://nozzlecam/");
+  const runtime_ap_t ap = { AP_SSID, AP_PASSWORD, AP_CHANNEL, AP_HIDDEN, 4 };
+  uint8_t ip[4] = { 0, 0, 0, 0 };
+  bool ap_ok = runtimeApStart(ap, ip);
+  char ip_str[16];
+  snprintf(ip_str, sizeof(ip_str), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+
+  printf("%s\n", ap_ok ? "AP started." : "AP start failed!");
+  printf("SSID: %s\n", AP_SSID);
+  printf("IP:   %s\n", ip_str);
+  phyInit();   // last calibrated PHY mode, if any
+  historyInit();
+
+  // DNS: our names + captive checks -> http://nozzlecam/, NXDOMAIN for the rest
+  printf("%s\n", captiveDnsStart(ip) ? "DNS server started: http://nozzlecam/"
+                                      : "DNS server failed");
 
   // mDNS -> http://nozzcam.local/
-  if (MDNS.begin("nozzcam")) {
-    Serial.println("mDNS: http://nozzcam.local");
+  if (runtimeMdnsStart("nozzcam")) {
+    runtimeMdnsService("http", "tcp", 80);
+    runtimeMdnsService("nozzlecam", "tcp", 80);   // dashboard discovery (/peers)
+    printf("mDNS: http://nozzcam.local\n");
   } else {
-    Serial.println("mDNS setup failed");
+    printf("mDNS setup failed\n");
   }
 
-  oledPrintCentered(AP_SSID, ip.toString());
+  oledShow(AP_SSID, ip_str);
+
+  consoleInit();
+  benchInit();
+  benchRegister("oled", "n=20", oledBench);
+  tcpStatsInit();
 
   startCameraServer();
-  Serial.println("UI:     http://192.168.4.1");
-  Serial.println("Stream: http://192.168.4.1/stream");
-  Serial.println("Also try: http://nozzlecam/  or  http://nozzcam.local/");
+  printf("UI:     http://192.168.4.1\n");
+  printf("Stream: http://192.168.4.1/stream\n");
+  printf("Also try: http://nozzlecam/  or  http://nozzcam.local/\n");
+  printf("Console: type 'help'\n");
+
+  // one line to compare builds (tools/runtime_bench reads it from the serial log)
+  printf("BOOT runtime=%s boot_ms=%u heap_free=%u heap_min=%u psram_free=%u\n", runtimeName(),
+         (unsigned)(esp_timer_get_time() / 1000),
+         (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+         (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+         (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 }
 
 void loop() {
-  dnsServer.processNextRequest(); // keep DNS responsive
+  captiveDnsLoop();               // keep DNS responsive
+  phyLoop();                      // deferred PHY switches during calibration
+  int c;
+  while ((c = runtimeConsoleRead()) >= 0) consoleFeed((char)c);   // console runs on its own task
+}
+
+#ifndef ARDUINO
+// Plain ESP-IDF: no Arduino loop task, so app_main (the main task) runs it.
+extern "C" void app_main() {
+  setup();
+  for (;;) {
+    loop();
+    vTaskDelay(1);
+  }
 }
+#endif
@@ -0,0 +1,189 @@
+/**
+ * Status display (see oled.h).
+ */
+#include "oled.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+
+#include "console.h"
+
+static bool oled_ok = false;
+static char shown[2][24];                    // last oledShow() lines
+
+// ---------- drawing backend ----------
+#ifdef ARDUINO
+
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+static Adafruit_SSD1306 display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1);
+
+static bool panelBegin(int sda, int scl) {
+  Wire.begin(sda, scl);
+  if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR)) return false;
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  return true;
+}
+
+static void clear() { display.clearDisplay(); }
+static void text(int x, int y, const char* s) { display.setCursor(x, y); display.print(s); }
+static void fillRect(int x, int y, int w, int h) { display.fillRect(x, y, w, h, SSD1306_WHITE); }
+static void flush() { display.display(); }
+
+static int textWidth(const char* s) {
+  int16_t x1, y1;
+  uint16_t w, h;
+  display.getTextBounds(s, 0, 0, &x1, &y1, &w, &h);
+  return w;
+}
+
+#else  // plain ESP-IDF: own SSD1306 driver
+
+#include "driver/i2c.h"
+
+#define OLED_I2C_PORT  I2C_NUM_0
+#define OLED_I2C_HZ    400000
+#define I2C_TIMEOUT    pdMS_TO_TICKS(50)
+
+// Classic 5x7 glyphs, ASCII 32..126, one byte per column, LSB at the top.
+static const uint8_t FONT5X7[95][5] = {
+  {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+  {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+  {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+  {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+  {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+  {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+  {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+  {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+  {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+  {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+  {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+  {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+  {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+  {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+  {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+  {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+  {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
+  {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+  {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+  {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+  {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+  {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+  {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08},
+};
+
+static uint8_t fb[1 + OLED_WIDTH * OLED_HEIGHT / 8];   // leading 0x40: data control byte
+static uint8_t* const px = fb + 1;
+
+static bool command(const uint8_t* c, size_t n) {
+  uint8_t buf[32];
+  buf[0] = 0x00;                                         // command stream
+  memcpy(buf + 1, c, n);
+  return i2c_master_write_to_device(OLED_I2C_PORT, OLED_ADDR, buf, n + 1, I2C_TIMEOUT) == ESP_OK;
+}
+
+static bool panelBegin(int sda, int scl) {
+  i2c_config_t conf = {};
+  conf.mode = I2C_MODE_MASTER;
+  conf.sda_io_num = sda;
+  conf.scl_io_num = scl;
+  conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
+  conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
+  conf.master.clk_speed = OLED_I2C_HZ;
+  if (i2c_param_config(OLED_I2C_PORT, &conf) != ESP_OK ||
+      i2c_driver_install(OLED_I2C_PORT, I2C_MODE_MASTER, 0, 0, 0) != ESP_OK) return false;
+  // the Adafruit library's 128x32 sequence: internal charge pump, horizontal addressing
+  static const uint8_t init[] = {
+    0xAE, 0xD5, 0x80, 0xA8, OLED_HEIGHT - 1, 0xD3, 0x00, 0x40, 0x8D, 0x14, 0x20, 0x00,
+    0xA1, 0xC8, 0xDA, 0x02, 0x81, 0x8F, 0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6, 0x2E, 0xAF,
+  };
+  fb[0] = 0x40;
+  return command(init, sizeof(init));
+}
+
+static void clear() { memset(px, 0, sizeof(fb) - 1); }
+
+static inline void setPixel(int x, int y) {
+  if (x >= 0 && x < OLED_WIDTH && y >= 0 && y < OLED_HEIGHT) px[x + (y >> 3) * OLED_WIDTH] |= 1 << (y & 7);
+}
+
+static void text(int x, int y, const char* s) {
+  for (; *s; s++, x += 6) {
+    char c = *s >= 32 && *s <= 126 ? *s : '?';
+    const uint8_t* g = FONT5X7[c - 32];
+    for (int col = 0; col < 5; col++)
+      for (int row = 0; row < 8; row++)
+        if (g[col] >> row & 1) setPixel(x + col, y + row);
+  }
+}
+
+static void fillRect(int x, int y, int w, int h) {
+  for (int j = y; j < y + h; j++)
+    for (int i = x; i < x + w; i++) setPixel(i, j);
+}
+
+static void flush() {
+  static const uint8_t window[] = { 0x22, 0x00, OLED_HEIGHT / 8 - 1, 0x21, 0x00, OLED_WIDTH - 1 };
+  if (command(window, sizeof(window)))
+    i2c_master_write_to_device(OLED_I2C_PORT, OLED_ADDR, fb, sizeof(fb), I2C_TIMEOUT);
+}
+
+static int textWidth(const char* s) { return 6 * (int)strlen(s); }
+
+#endif
+
+// ---------- screens ----------
+
+bool oledInit(int sda, int scl) {
+  oled_ok = panelBegin(sda, scl);
+  if (!oled_ok) return false;
+  clear();
+  text(0, 0, "TTGO T-Journal");
+  text(0, 8, "AP Camera Stream");
+  flush();
+  return true;
+}
+
+void oledShow(const char* line1, const char* line2) {
+  snprintf(shown[0], sizeof(shown[0]), "%s", line1 ? line1 : "");
+  snprintf(shown[1], sizeof(shown[1]), "%s", line2 ? line2 : "");
+  if (!oled_ok) return;
+  clear();
+  text((OLED_WIDTH - textWidth(shown[0])) / 2, 2, shown[0]);
+  if (shown[1][0]) text((OLED_WIDTH - textWidth(shown[1])) / 2, 18, shown[1]);
+  flush();
+}
+
+const char* oledBench(int argc, char** argv) {
+  if (!oled_ok) return "no_oled";
+  int n = consoleArgInt(argc, argv, "n", 20);
+  if (n < 1) n = 1;
+  uint32_t render_us = 0, flush_us = 0, flush_max = 0;
+  for (int i = 0; i < n; i++) {
+    char line[24];
+    int64_t t0 = esp_timer_get_time();
+    clear();
+    snprintf(line, sizeof(line), "bench %d/%d", i + 1, n);
+    text(0, 0, line);
+    fillRect(0, 16, (OLED_WIDTH * (i + 1)) / n, 8);
+    int64_t t1 = esp_timer_get_time();
+    flush();
+    uint32_t f = (uint32_t)(esp_timer_get_time() - t1);
+    render_us += (uint32_t)(t1 - t0);
+    flush_us += f;
+    if (f > flush_max) flush_max = f;
+  }
+  char l1[24], l2[24];
+  memcpy(l1, shown[0], sizeof(l1));
+  memcpy(l2, shown[1], sizeof(l2));
+  oledShow(l1, l2);
+  printf("BENCH oled n=%d render_avg_us=%u flush_avg_us=%u flush_max_us=%u fps_max=%.1f\n",
+         n, (unsigned)(render_us / n), (unsigned)(flush_us / n), (unsigned)flush_max,
+         1e6f * n / (render_us + flush_us));
+  return NULL;
+}
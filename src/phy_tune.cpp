@@ -0,0 +1,190 @@
+/**
+ * Wi-Fi PHY calibration (see phy_tune.h).
+ *
+ * A run walks the candidate list (stored winner first). For each candidate:
+ * switch PHY, wait for the client to come back and pull PROBES_PER_CAND
+ * probes, keep the best goodput. A candidate that gets no probe within
+ * PROBE_TIMEOUT_MS (client could not reconnect) scores zero. A run where
+ * every candidate scored zero measured nothing: it is aborted, the mode in
+ * effect before it comes back and the stored winner is left alone.
+ */
+#include "phy_tune.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+
+#define PROBES_PER_CAND   2
+#define SWITCH_DELAY_MS   500       // let the HTTP response leave before switching
+#define PROBE_TIMEOUT_MS  20000
+
+struct PhyCandidate {
+  const char*      name;
+  uint8_t          protocol;
+  wifi_bandwidth_t bw;
+};
+
+static const PhyCandidate CANDIDATES[] = {
+  { "bgn-ht40", WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N, WIFI_BW_HT40 },
+  { "bgn-ht20", WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N, WIFI_BW_HT20 },
+  { "bg-ht20",  WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G,                     WIFI_BW_HT20 },
+};
+#define NUM_CANDIDATES (int)(sizeof(CANDIDATES) / sizeof(CANDIDATES[0]))
+
+enum PhyState { PHY_IDLE, PHY_RUNNING, PHY_DONE, PHY_ABORTED };
+
+static portMUX_TYPE phy_mux = portMUX_INITIALIZER_UNLOCKED;
+static PhyState state = PHY_IDLE;
+static int      current = -1;                 // candidate in effect
+static int      winner = -1;                  // stored / last calibrated winner
+static int      before = -1;                  // candidate in effect when the run started
+static int      order[NUM_CANDIDATES];        // calibration order
+static int      step = 0;                     // index into order[]
+static int      probes = 0;                   // probes done for order[step]
+static uint32_t kbps[NUM_CANDIDATES];         // best goodput per candidate
+static int64_t  apply_at = 0;                 // pending switch (us), 0 = none
+static int64_t  deadline = 0;                 // probe timeout for the current step
+
+static void applyCandidate(int i) {
+  const PhyCandidate& c = CANDIDATES[i];
+  esp_err_t e1 = esp_wifi_set_protocol(WIFI_IF_AP, c.protocol);
+  esp_err_t e2 = esp_wifi_set_bandwidth(WIFI_IF_AP, c.bw);
+  current = i;
+  printf("phy: %s (protocol=0x%x bw=%s)%s\n", c.name, c.protocol,
+         c.bw == WIFI_BW_HT40 ? "HT40" : "HT20",
+         (e1 == ESP_OK && e2 == ESP_OK) ? "" : " - driver rejected");
+}
+
+static int loadWinner() {
+  nvs_handle_t h;
+  uint8_t v = 0xFF;
+  if (nvs_open("phy", NVS_READONLY, &h) == ESP_OK) {
+    nvs_get_u8(h, "winner", &v);
+    nvs_close(h);
+  }
+  return v < NUM_CANDIDATES ? v : -1;
+}
+
+static void saveWinner(int i) {
+  nvs_handle_t h;
+  if (nvs_open("phy", NVS_READWRITE, &h) != ESP_OK) return;
+  nvs_set_u8(h, "winner", (uint8_t)i);
+  nvs_commit(h);
+  nvs_close(h);
+}
+
+void phyInit() {
+  winner = loadWinner();
+  if (winner >= 0) {
+    printf("phy: stored winner %s\n", CANDIDATES[winner].name);
+    applyCandidate(winner);
+  }
+}
+
+bool phyStartCalibration() {
+  portENTER_CRITICAL(&phy_mux);
+  if (state == PHY_RUNNING) {
+    portEXIT_CRITICAL(&phy_mux);
+    return false;
+  }
+  int n = 0;
+  if (winner >= 0) order[n++] = winner;           // retry the winner first
+  for (int i = 0; i < NUM_CANDIDATES; i++)
+    if (i != winner) order[n++] = i;
+  memset(kbps, 0, sizeof(kbps));
+  before = current;
+  step = 0;
+  probes = 0;
+  state = PHY_RUNNING;
+  apply_at = esp_timer_get_time() + SWITCH_DELAY_MS * 1000LL;
+  deadline = apply_at + PROBE_TIMEOUT_MS * 1000LL;
+  portEXIT_CRITICAL(&phy_mux);
+  printf("phy: calibration started\n");
+  return true;
+}
+
+// Under phy_mux: move to the next candidate or finish.
+static void advance(int64_t now) {
+  probes = 0;
+  if (++step < NUM_CANDIDATES) {
+    apply_at = now + SWITCH_DELAY_MS * 1000LL;
+    deadline = apply_at + PROBE_TIMEOUT_MS * 1000LL;
+    return;
+  }
+  int best = 0;
+  for (int i = 1; i < NUM_CANDIDATES; i++) if (kbps[i] > kbps[best]) best = i;
+  if (kbps[best] == 0) {
+    state = PHY_ABORTED;                          // nothing measured: no winner
+  } else {
+    winner = best;
+    state = PHY_DONE;
+  }
+  apply_at = now + SWITCH_DELAY_MS * 1000LL;
+}
+
+void phyRecordProbe(size_t bytes, uint32_t elapsed_us) {
+  if (!elapsed_us) return;
+  uint32_t k = (uint32_t)((uint64_t)bytes * 8000ULL / elapsed_us);   // kbit/s
+  portENTER_CRITICAL(&phy_mux);
+  bool counted = state == PHY_RUNNING && !apply_at && current == order[step];
+  if (counted) {
+    if (k > kbps[current]) kbps[current] = k;
+    if (++probes >= PROBES_PER_CAND) advance(esp_timer_get_time());
+  }
+  portEXIT_CRITICAL(&phy_mux);
+  printf("phy: probe %u KB in %u ms = %u kbit/s%s\n", (unsigned)(bytes / 1024),
+         (unsigned)(elapsed_us / 1000), (unsigned)k, counted ? "" : " (not calibrating)");
+}
+
+void phyLoop() {
+  int64_t now = esp_timer_get_time();
+  int apply = -1;
+  PhyState st = PHY_IDLE;
+
+  portENTER_CRITICAL(&phy_mux);
+  if (state == PHY_RUNNING && !apply_at && now > deadline) {
+    advance(now);                                  // client never came back
+  }
+  if (apply_at && now >= apply_at) {
+    apply_at = 0;
+    st = state;
+    // aborted: back to what was in effect (safe default if that was the driver's own)
+    apply = st == PHY_RUNNING ? order[step] : st == PHY_DONE ? winner : before >= 0 ? before : 1;
+  }
+  portEXIT_CRITICAL(&phy_mux);
+
+  if (apply < 0) return;
+  applyCandidate(apply);
+  if (st == PHY_DONE) {
+    saveWinner(apply);
+    printf("phy: calibration done, winner %s", CANDIDATES[apply].name);
+    for (int i = 0; i < NUM_CANDIDATES; i++)
+      printf(" %s=%u", CANDIDATES[i].name, (unsigned)kbps[i]);
+    printf(" kbit/s\n");
+  } else if (st == PHY_ABORTED) {
+    printf("phy: calibration aborted, no probe on any candidate; back to %s, stored winner kept\n",
+           CANDIDATES[apply].name);
+  }
+}
+
+size_t phyStatusJson(char* buf, size_t len) {
+  static const char* STATES[] = { "idle", "running", "done", "aborted" };
+  portENTER_CRITICAL(&phy_mux);
+  PhyState st = state;
+  int cur = current, win = winner, s = step;
+  uint32_t k[NUM_CANDIDATES];
+  memcpy(k, kbps, sizeof(k));
+  portEXIT_CRITICAL(&phy_mux);
+
+  int n = snprintf(buf, len, "{\"state\":\"%s\",\"current\":\"%s\",\"winner\":\"%s\",\"step\":%d,\"kbps\":{",
+                   STATES[st], cur >= 0 ? CANDIDATES[cur].name : "default",
+                   win >= 0 ? CANDIDATES[win].name : "none", s);
+  for (int i = 0; i < NUM_CANDIDATES && n < (int)len; i++)
+    n += snprintf(buf + n, len - n, "%s\"%s\":%u", i ? "," : "", CANDIDATES[i].name, (unsigned)k[i]);
+  if (n < (int)len) n += snprintf(buf + n, len - n, "}}");
+  return n < (int)len ? n : len - 1;
+}
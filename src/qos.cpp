@@ -0,0 +1,268 @@
+/**
+ * Compute-budget QoS scheduler (see qos.h).
+ *
+ * Every stage gets a divisor every_n = max(budget_n, backoff):
+ *   budget_n = ceil(measured cost / per-frame budget)  -> amortized cost fits the budget
+ *   backoff  = power of two raised by the once-a-second fps controller
+ * When the delivered stream fps falls below target because of the stages
+ * (the stream would make it without their time) the lowest-priority stage
+ * doubles its backoff; after a few good seconds the highest-priority
+ * backed-off stage halves it again. A stream that is slow on purpose
+ * (?fps=, thumbnails, a sensor idling at a low rate) spends its frame period
+ * waiting, not in stages, and leaves the stages alone. Stages registered
+ * without a budget pace themselves and are never backed off.
+ */
+#include "qos.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+struct QosStage {
+  const char*  name;
+  uint8_t      priority;
+  uint32_t     budget_us;
+  qos_stage_fn fn;
+  void*        ctx;
+
+  uint32_t cost_us;       // EWMA of measured cost per run
+  uint32_t max_us;        // worst run seen in the current window
+  uint32_t peak_us;       // worst run seen in the last window
+  uint16_t backoff;       // fps-pressure divisor (power of two)
+  uint16_t every_n;       // effective divisor
+  uint32_t runs;          // runs in the current window
+  float    rate;          // runs per second, last window
+};
+
+// Kept sorted by descending priority.
+static QosStage     stages[QOS_MAX_STAGES];
+static int          stage_count = 0;
+static portMUX_TYPE qos_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static float    target_fps = 10.0f;
+static bool     running = false;       // one stage pass at a time
+static uint64_t last_run_ts = 0;       // frame timestamp of the last pass
+static uint32_t frame_no = 0;          // frames offered to stages
+
+// Stream accounting (1 s windows)
+static uint64_t last_sent_ts = 0;
+static uint32_t win_frames = 0, win_bytes = 0;
+static uint64_t win_stage_us = 0;      // time spent in stage passes
+static int64_t  win_start_us = 0;
+static float    stream_fps = 0.0f;
+static uint32_t stream_bps = 0;
+static uint8_t  good_secs = 0;
+
+static inline uint64_t frameTs(const camera_fb_t* fb) {
+  return (uint64_t)fb->timestamp.tv_sec * 1000000ULL + (uint64_t)fb->timestamp.tv_usec;
+}
+
+static uint16_t clampN(uint32_t n) {
+  if (n < 1) return 1;
+  if (n > QOS_MAX_EVERY_N) return QOS_MAX_EVERY_N;
+  return (uint16_t)n;
+}
+
+static void updateEveryN(QosStage& s) {
+  uint32_t budget_n = s.budget_us ? (s.cost_us + s.budget_us - 1) / s.budget_us : 1;
+  s.every_n = clampN(budget_n > s.backoff ? budget_n : s.backoff);
+}
+
+// Enter qos_mux with no stage pass in flight: a pass walks the table
+// without the lock, so entries may only move between passes.
+static void lockBetweenPasses() {
+  for (;;) {
+    portENTER_CRITICAL(&qos_mux);
+    if (!running) return;
+    portEXIT_CRITICAL(&qos_mux);
+    vTaskDelay(1);
+  }
+}
+
+bool qosRegisterStage(const char* name, uint8_t priority, uint32_t budget_us,
+                      qos_stage_fn fn, void* ctx) {
+  if (!fn) return false;
+  bool ok = false;
+  lockBetweenPasses();
+  if (stage_count < QOS_MAX_STAGES) {
+    int pos = stage_count;
+    while (pos > 0 && stages[pos - 1].priority < priority) {
+      stages[pos] = stages[pos - 1];
+      pos--;
+    }
+    QosStage& s = stages[pos];
+    memset(&s, 0, sizeof(s));
+    s.name = name; s.priority = priority; s.budget_us = budget_us;
+    s.fn = fn; s.ctx = ctx;
+    s.backoff = 1; s.every_n = 1;
+    stage_count++;
+    ok = true;
+  }
+  portEXIT_CRITICAL(&qos_mux);
+  return ok;
+}
+
+bool qosUnregisterStage(qos_stage_fn fn) {
+  bool found = false;
+  lockBetweenPasses();
+  for (int i = 0; i < stage_count; i++) {
+    if (stages[i].fn != fn) continue;
+    for (int j = i + 1; j < stage_count; j++) stages[j - 1] = stages[j];
+    stage_count--;
+    found = true;
+    break;
+  }
+  portEXIT_CRITICAL(&qos_mux);
+  return found;
+}
+
+void qosSetTargetFps(float fps) {
+  portENTER_CRITICAL(&qos_mux);
+  target_fps = fps < 0 ? 0 : fps;
+  good_secs = 0;
+  portEXIT_CRITICAL(&qos_mux);
+}
+
+float qosTargetFps() { return target_fps; }
+
+// Called once per second under qos_mux.
+static void rollWindow(int64_t now) {
+  float secs = (now - win_start_us) / 1e6f;
+  stream_fps = win_frames / secs;
+  stream_bps = (uint32_t)(win_bytes / secs);
+
+  for (int i = 0; i < stage_count; i++) {
+    stages[i].rate = stages[i].runs / secs;
+    stages[i].runs = 0;
+    stages[i].peak_us = stages[i].max_us;
+    stages[i].max_us = 0;
+  }
+
+  // fps controller: only meaningful while someone is actually streaming.
+  // Stages run on the stream task after the send, so their time adds to the
+  // frame period; they are to blame when taking it out would reach 90%.
+  if (target_fps > 0 && win_frames > 0 && stage_count > 0) {
+    float period_us = (now - win_start_us) / (float)win_frames;
+    float own_us = period_us - (float)win_stage_us / win_frames;
+    bool stage_bound = own_us < 1e6f / (target_fps * 0.9f);
+    if (stream_fps < target_fps * 0.9f && stage_bound) {
+      good_secs = 0;
+      for (int i = stage_count - 1; i >= 0; i--) {       // lowest priority first
+        if (!stages[i].budget_us) continue;
+        if (stages[i].backoff < QOS_MAX_EVERY_N) { stages[i].backoff *= 2; break; }
+      }
+    } else if ((stream_fps >= target_fps * 0.98f || !stage_bound) && ++good_secs >= 3) {
+      good_secs = 0;
+      for (int i = 0; i < stage_count; i++) {            // highest priority first
+        if (stages[i].backoff > 1) { stages[i].backoff /= 2; break; }
+      }
+    }
+  }
+  for (int i = 0; i < stage_count; i++) updateEveryN(stages[i]);
+
+  win_frames = 0;
+  win_bytes = 0;
+  win_stage_us = 0;
+  win_start_us = now;
+}
+
+void qosFrameSent(const camera_fb_t* fb, size_t bytes) {
+  int64_t now = esp_timer_get_time();
+  uint64_t ts = frameTs(fb);
+  portENTER_CRITICAL(&qos_mux);
+  if (!win_start_us) win_start_us = now;
+  if (ts != last_sent_ts) { last_sent_ts = ts; win_frames++; }  // count unique frames
+  win_bytes += bytes;
+  if (now - win_start_us >= 1000000) rollWindow(now);
+  portEXIT_CRITICAL(&qos_mux);
+}
+
+void qosRunStages(const camera_fb_t* fb) {
+  uint64_t ts = frameTs(fb);
+  uint32_t n;
+  portENTER_CRITICAL(&qos_mux);
+  if (running || ts == last_run_ts || stage_count == 0) {
+    portEXIT_CRITICAL(&qos_mux);
+    return;
+  }
+  running = true;
+  last_run_ts = ts;
+  n = ++frame_no;
+  portEXIT_CRITICAL(&qos_mux);
+
+  for (int i = 0; i < stage_count; i++) {
+    QosStage& s = stages[i];
+    if ((n + i) % s.every_n) continue;       // stagger stages with equal divisors
+
+    int64_t t0 = esp_timer_get_time();
+    s.fn(fb, s.ctx);
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+    portENTER_CRITICAL(&qos_mux);
+    s.cost_us = s.cost_us ? (s.cost_us * 7 + dt) / 8 : dt;
+    if (dt > s.max_us) s.max_us = dt;
+    s.runs++;
+    win_stage_us += dt;
+    updateEveryN(s);
+    portEXIT_CRITICAL(&qos_mux);
+  }
+
+  portENTER_CRITICAL(&qos_mux);
+  running = false;
+  portEXIT_CRITICAL(&qos_mux);
+}
+
+// A window that never closed means no frames went out: the stream is idle.
+static void expireIdle() {
+  if (win_start_us && esp_timer_get_time() - win_start_us > 2000000) {
+    stream_fps = 0;
+    stream_bps = 0;
+    for (int i = 0; i < stage_count; i++) stages[i].rate = 0;
+  }
+}
+
+float qosStreamFps() {
+  portENTER_CRITICAL(&qos_mux);
+  expireIdle();
+  float fps = stream_fps;
+  portEXIT_CRITICAL(&qos_mux);
+  return fps;
+}
+
+uint32_t qosStreamBytesPerSec() {
+  portENTER_CRITICAL(&qos_mux);
+  expireIdle();
+  uint32_t bps = stream_bps;
+  portEXIT_CRITICAL(&qos_mux);
+  return bps;
+}
+
+size_t qosStatusJson(char* buf, size_t len) {
+  QosStage snap[QOS_MAX_STAGES];
+  int count;
+  float fps, target;
+  uint32_t bps;
+
+  portENTER_CRITICAL(&qos_mux);
+  expireIdle();
+  count = stage_count;
+  memcpy(snap, stages, sizeof(QosStage) * count);
+  fps = stream_fps; bps = stream_bps; target = target_fps;
+  portEXIT_CRITICAL(&qos_mux);
+
+  size_t n = snprintf(buf, len,
+    "{\"stream\":{\"fps\":%.1f,\"bytes_per_s\":%u,\"target_fps\":%.1f},\"stages\":[",
+    fps, (unsigned)bps, target);
+  for (int i = 0; i < count && n < len; i++) {
+    const QosStage& s = snap[i];
+    n += snprintf(buf + n, len - n,
+      "%s{\"name\":\"%s\",\"priority\":%u,\"budget_us\":%u,\"cost_us\":%u,"
+      "\"peak_us\":%u,\"every_n\":%u,\"backoff\":%u,\"rate\":%.2f}",
+      i ? "," : "", s.name, s.priority, (unsigned)s.budget_us, (unsigned)s.cost_us,
+      (unsigned)s.peak_us, s.every_n, s.backoff, s.rate);
+  }
+  if (n < len) n += snprintf(buf + n, len - n, "]}");
+  return n < len ? n : len - 1;
+}
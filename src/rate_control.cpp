@@ -0,0 +1,80 @@
+/**
+ * Motion gate and idle/active policy (see rate_control.h).
+ */
+#include "rate_control.h"
+
+#include <string.h>
+
+rate_config_t rateDefaultConfig() {
+  rate_config_t c;
+  c.idle_fps = 1.0f;
+  c.quiet_ms = 10000;
+  c.delta = 12;
+  c.min_blocks = 6;
+  return c;
+}
+
+size_t motionGridBytes(int bw, int bh) {
+  return (size_t)bw * bh * 2;
+}
+
+void motionGridInit(motion_grid_t* g, int bw, int bh, void* mem) {
+  g->bw = bw;
+  g->bh = bh;
+  g->prev = (uint8_t*)mem;
+  g->cur = g->prev + (size_t)bw * bh;
+  g->primed = false;
+}
+
+int motionCompare(motion_grid_t* g, uint8_t delta) {
+  const size_t n = (size_t)g->bw * g->bh;
+  int changed = 0;
+  if (g->primed) {
+    int32_t shift = 0;
+    for (size_t i = 0; i < n; i++) shift += (int)g->cur[i] - (int)g->prev[i];
+    shift /= (int32_t)n;                       // global brightness change
+    for (size_t i = 0; i < n; i++) {
+      int d = (int)g->cur[i] - (int)g->prev[i] - shift;
+      if (d > delta || d < -delta) changed++;
+    }
+  }
+  uint8_t* t = g->prev;
+  g->prev = g->cur;
+  g->cur = t;
+  g->primed = true;
+  return changed;
+}
+
+void rateInit(rate_state_t* s, int64_t now_us) {
+  memset(s, 0, sizeof(*s));
+  s->mode = RATE_ACTIVE;                     // start fast, settle into idle
+  s->mode_since_us = now_us;
+  s->last_motion_us = now_us;
+}
+
+static void enter(rate_state_t* s, rate_mode_t m, int64_t now_us) {
+  uint64_t dt = now_us > s->mode_since_us ? (uint64_t)(now_us - s->mode_since_us) : 0;
+  if (s->mode == RATE_ACTIVE) s->active_us += dt; else s->idle_us += dt;
+  s->mode = m;
+  s->mode_since_us = now_us;
+}
+
+bool rateStep(const rate_config_t& c, rate_state_t* s, bool motion, int64_t now_us) {
+  if (motion) s->last_motion_us = now_us;
+  if (s->mode == RATE_IDLE && motion) {
+    enter(s, RATE_ACTIVE, now_us);
+    s->events++;
+    return true;
+  }
+  if (s->mode == RATE_ACTIVE && now_us - s->last_motion_us > (int64_t)c.quiet_ms * 1000) {
+    enter(s, RATE_IDLE, now_us);
+    return true;
+  }
+  return false;
+}
+
+void rateDuty(const rate_state_t& s, int64_t now_us, uint64_t* active_us, uint64_t* idle_us) {
+  uint64_t open = now_us > s.mode_since_us ? (uint64_t)(now_us - s.mode_since_us) : 0;
+  *active_us = s.active_us + (s.mode == RATE_ACTIVE ? open : 0);
+  *idle_us = s.idle_us + (s.mode == RATE_IDLE ? open : 0);
+}
@@ -0,0 +1,254 @@
+/**
+ * Capture rate governor (see rate_gov.h).
+ *
+ * CLKRC (sensor bank 0x11) is written by the driver on every framesize
+ * change, so the full-rate value is read back after each profile switch
+ * rather than assumed. The idle divider is derived from the full-rate
+ * sensor fps measured by cap_timing, sampled only while active and only
+ * from a window of VSYNC edges that all came after the last switch (the
+ * window is 120 edges, many seconds of idle frames).
+ */
+#include "rate_gov.h"
+
+#include <stdio.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "camera.h"
+#include "cap_timing.h"
+#include "http_stream.h"
+#include "jpeg_scan.h"
+#include "psram.h"
+#include "qos.h"
+
+#define REG_CLKRC          0x111     // sensor bank: [7] doubler, [5:0] divider - 1
+#define ACTIVE_CHECK_MS    200       // check period at full rate (quiet detection only)
+#define FAST_FPS_EVERY_US  1000000LL // fast_fps refresh while active
+#define FAST_FPS_MIN_EDGES 8
+
+// Nominal draw for the energy estimate (T-Journal at the battery, soft AP up,
+// one client). Calibrate with a USB power meter for absolute numbers.
+#define POWER_BASE_MW         520
+#define POWER_SENSOR_FAST_MW  130
+#define POWER_SENSOR_IDLE_MW  45
+
+static SemaphoreHandle_t gov_lock = NULL;
+static bool          enabled = false;
+static rate_config_t config;
+static rate_state_t  state;
+static motion_grid_t grid;
+static void*         grid_mem = NULL;
+static framesize_t   grid_size = FRAMESIZE_INVALID;
+static int           fast_clkrc = -1;        // read back after each profile switch
+static int           idle_clkrc = -1;
+static float         fast_fps = 0;           // sensor fps at full rate (cap_timing)
+static int64_t       switched_us = 0;        // last CLKRC change (mode or profile switch)
+static int64_t       fast_sampled_us = 0;
+static int64_t       checked_ts = 0;         // frame timestamp of the last stage check
+static uint32_t      last_changed = 0, cost_us = 0;
+// event latency: motion frame -> first full-rate frame
+static int64_t       detect_ts = 0, prev_ts = 0;
+static uint32_t      lat_last_ms = 0, lat_max_ms = 0, lat_n = 0;
+static uint64_t      lat_sum_ms = 0;
+
+static void blockDc(void* ctx, int comp, int bx, int by, int dc, int ac) {
+  (void)comp; (void)ac;
+  motionAddBlock((motion_grid_t*)ctx, bx, by, dc);
+}
+
+static void writeClkrc(int v) {
+  sensor_t* s = esp_camera_sensor_get();
+  if (s && s->set_reg && v >= 0) s->set_reg(s, REG_CLKRC, 0xFF, v);
+}
+
+// While active: refresh fast_fps from a VSYNC window that starts after the
+// last switch. The last edge is at most one period old, so the first one
+// is no earlier than now - window - period.
+static void sampleFastFps(int64_t now) {
+  if (now - fast_sampled_us < FAST_FPS_EVERY_US) return;
+  fast_sampled_us = now;
+  cap_timing_stats_t st;
+  if (!capTimingStats(&st) || st.edges < FAST_FPS_MIN_EDGES || st.sensor_fps <= 0.5f) return;
+  if (now - (int64_t)st.window_ms * 1000 - st.period_us > switched_us) fast_fps = st.sensor_fps;
+}
+
+// Idle divider for config.idle_fps, from the full-rate fps sampled while active.
+static int idleClkrc() {
+  float ratio = fast_fps > 0 && config.idle_fps > 0 ? fast_fps / config.idle_fps : 8.0f;
+  int div = (int)(((fast_clkrc & 0x3F) + 1) * ratio + 0.5f) - 1;
+  if (div > 0x3F) div = 0x3F;
+  if (div < (fast_clkrc & 0x3F)) div = fast_clkrc & 0x3F;
+  return (fast_clkrc & 0x80) | div;
+}
+
+// Under gov_lock.
+static void processFrame(const camera_fb_t* fb) {
+  int64_t t0 = esp_timer_get_time();
+  int64_t ts = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+
+  cam_profile_t p = cameraProfile();
+  if (p.size != grid_size) {                 // profile switch: driver rewrote CLKRC
+    jpeg_info_t info;
+    if (jpegScanHeaders(fb->buf, fb->len, &info) != JPEG_SCAN_OK) return;
+    free(grid_mem);
+    int bw = (info.width + 7) / 8, bh = (info.height + 7) / 8;
+    grid_mem = psAlloc(motionGridBytes(bw, bh));
+    grid_size = FRAMESIZE_INVALID;
+    if (!grid_mem) return;
+    motionGridInit(&grid, bw, bh, grid_mem);
+    grid_size = p.size;
+    sensor_t* s = esp_camera_sensor_get();
+    fast_clkrc = s && s->get_reg ? s->get_reg(s, REG_CLKRC, 0xFF) : -1;
+    fast_fps = 0;
+    switched_us = t0;
+    rateInit(&state, t0);
+    detect_ts = 0;
+  }
+  if (fast_clkrc < 0) return;
+
+  if (jpegScan(fb->buf, fb->len, JPEG_SCAN_LUMA_ONLY, blockDc, &grid, NULL) != JPEG_SCAN_OK) return;
+  int changed = motionCompare(&grid, config.delta);
+  last_changed = changed;
+
+  // full rate reached after an event: frame period back near the fast one
+  if (detect_ts && ts > detect_ts && prev_ts && fast_fps > 0 &&
+      ts - prev_ts < (int64_t)(1.5e6f / fast_fps)) {
+    uint32_t ms = (uint32_t)((ts - detect_ts) / 1000);
+    lat_last_ms = ms;
+    if (ms > lat_max_ms) lat_max_ms = ms;
+    lat_sum_ms += ms;
+    lat_n++;
+    detect_ts = 0;
+  }
+  prev_ts = ts;
+
+  if (rateStep(config, &state, changed >= config.min_blocks, t0)) {
+    switched_us = t0;
+    if (state.mode == RATE_IDLE) {
+      idle_clkrc = idleClkrc();
+      writeClkrc(idle_clkrc);
+    } else {
+      writeClkrc(fast_clkrc);
+      detect_ts = ts;
+    }
+    printf("rate: %s (changed blocks %d)\n", state.mode == RATE_IDLE ? "idle" : "active", changed);
+  } else if (state.mode == RATE_ACTIVE) {
+    sampleFastFps(t0);
+  }
+  cost_us = (uint32_t)(esp_timer_get_time() - t0);
+}
+
+static void handleFrame(const camera_fb_t* fb) {
+  if (!enabled) return;
+  if (cameraClaimed()) {                     // the claimer re-inits the driver: resync after
+    grid_size = FRAMESIZE_INVALID;
+    return;
+  }
+  if (fb->format != PIXFORMAT_JPEG) return;
+  if (xSemaphoreTake(gov_lock, 0) != pdTRUE) return;    // stage and sampler never queue up
+  processFrame(fb);
+  xSemaphoreGive(gov_lock);
+}
+
+// Registered without a QoS budget so fps pressure never thins it out: at
+// idle the stream runs at the sensor's low rate and every frame is a motion
+// check, as in the sampler. At full rate it paces itself like the sampler,
+// except right after an event, when the latency needs consecutive frames.
+static void rateStage(const camera_fb_t* fb, void* ctx) {
+  (void)ctx;
+  int64_t ts = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+  if (state.mode == RATE_ACTIVE && !detect_ts && ts - checked_ts < ACTIVE_CHECK_MS * 1000LL) return;
+  checked_ts = ts;
+  handleFrame(fb);
+}
+
+// Without a stream nobody pulls frames: sample them here. At idle every
+// frame is checked (that is the point of the low rate); at full rate only
+// a few per second, to notice when things go quiet.
+static void samplerTask(void* arg) {
+  (void)arg;
+  for (;;) {
+    if (cameraClaimed()) grid_size = FRAMESIZE_INVALID;
+    if (!enabled || qosStreamFps() > 0 || httpStreamActive() || cameraClaimed()) {
+      vTaskDelay(pdMS_TO_TICKS(500));
+      continue;
+    }
+    camera_fb_t* fb = camFbGet();
+    if (fb) {
+      handleFrame(fb);
+      camFbReturn(fb);
+    }
+    if (state.mode == RATE_ACTIVE) vTaskDelay(pdMS_TO_TICKS(ACTIVE_CHECK_MS));
+  }
+}
+
+void rateGovInit() {
+  config = rateDefaultConfig();
+  rateInit(&state, esp_timer_get_time());
+  gov_lock = xSemaphoreCreateMutex();
+  // Above the AE assist: a missed motion frame costs an event, not just quality.
+  qosRegisterStage("rate", 230, 0, rateStage, NULL);
+  xTaskCreate(samplerTask, "rate", 4096, NULL, 2, NULL);
+}
+
+void rateGovEnable(bool on) {
+  xSemaphoreTake(gov_lock, portMAX_DELAY);
+  if (on && !enabled) {
+    grid_size = FRAMESIZE_INVALID;           // re-read CLKRC, start at full rate
+    enabled = true;
+  } else if (!on && enabled) {
+    enabled = false;
+    if (state.mode == RATE_IDLE && !cameraClaimed()) writeClkrc(fast_clkrc);
+    rateInit(&state, esp_timer_get_time());
+  }
+  xSemaphoreGive(gov_lock);
+  printf("rate: governor %s\n", on ? "auto" : "off (full rate)");
+}
+
+bool rateGovEnabled() {
+  return enabled;
+}
+
+void rateGovSetConfig(const rate_config_t& c) {
+  xSemaphoreTake(gov_lock, portMAX_DELAY);
+  config = c;
+  if (config.idle_fps < 0.1f) config.idle_fps = 0.1f;
+  if (enabled && state.mode == RATE_IDLE) {
+    idle_clkrc = idleClkrc();
+    writeClkrc(idle_clkrc);
+  }
+  xSemaphoreGive(gov_lock);
+}
+
+rate_config_t rateGovConfig() {
+  return config;
+}
+
+size_t rateGovStatusJson(char* buf, size_t len) {
+  xSemaphoreTake(gov_lock, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  uint64_t act_us, idle_us;
+  rateDuty(state, now, &act_us, &idle_us);
+  float duty = act_us + idle_us ? (float)act_us / (act_us + idle_us) : 1.0f;
+  float mw = POWER_BASE_MW + duty * POWER_SENSOR_FAST_MW + (1 - duty) * POWER_SENSOR_IDLE_MW;
+  float full_mw = POWER_BASE_MW + POWER_SENSOR_FAST_MW;
+  cap_timing_stats_t st;
+  bool have = capTimingStats(&st);
+  int n = snprintf(buf, len,
+    "{\"mode\":\"%s\",\"state\":\"%s\",\"sensor_fps\":%.2f,\"fast_fps\":%.2f,"
+    "\"clkrc_fast\":%d,\"clkrc_idle\":%d,\"changed_blocks\":%u,\"cost_us\":%u,"
+    "\"active_s\":%u,\"idle_s\":%u,\"duty_pct\":%.1f,\"est_mwh_per_h\":%.0f,\"saving_pct\":%.1f,"
+    "\"events\":%u,\"latency_ms\":{\"last\":%u,\"avg\":%u,\"max\":%u,\"n\":%u},"
+    "\"config\":{\"idle_fps\":%.2f,\"quiet_s\":%u,\"delta\":%u,\"blocks\":%u}}",
+    enabled ? "auto" : "max", state.mode == RATE_IDLE ? "idle" : "active",
+    have ? st.sensor_fps : 0.0f, fast_fps, fast_clkrc, idle_clkrc, (unsigned)last_changed,
+    (unsigned)cost_us, (unsigned)(act_us / 1000000), (unsigned)(idle_us / 1000000), duty * 100,
+    mw, 100 * (1 - mw / full_mw), (unsigned)state.events, (unsigned)lat_last_ms,
+    lat_n ? (unsigned)(lat_sum_ms / lat_n) : 0, (unsigned)lat_max_ms, (unsigned)lat_n,
+    config.idle_fps, (unsigned)(config.quiet_ms / 1000), config.delta, config.min_blocks);
+  xSemaphoreGive(gov_lock);
+  return n < (int)len ? n : len - 1;
+}
@@ -0,0 +1,132 @@
+/**
+ * Runtime glue for the Arduino core and plain ESP-IDF (see runtime.h).
+ */
+#include "runtime.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mdns.h"
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+const char* runtimeName() { return "arduino"; }
+
+void runtimeConsoleBegin() {
+  Serial.begin(115200);
+}
+
+int runtimeConsoleRead() {
+  return Serial.available() ? Serial.read() : -1;
+}
+
+bool runtimeApStart(const runtime_ap_t& ap, uint8_t ip[4]) {
+  WiFi.mode(WIFI_AP);
+  bool ok = WiFi.softAP(ap.ssid, ap.password, ap.channel, ap.hidden, ap.max_clients);
+  IPAddress a = WiFi.softAPIP();
+  for (int i = 0; i < 4; i++) ip[i] = a[i];
+  return ok;
+}
+
+#else  // plain ESP-IDF
+
+#include "driver/uart.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+
+#define CONSOLE_UART  UART_NUM_0
+
+const char* runtimeName() { return "esp-idf"; }
+
+void runtimeConsoleBegin() {
+  // the ROM / VFS console already runs UART0 at 115200 for printf(); the
+  // driver adds an RX buffer so lines typed during a long command survive
+  uart_driver_install(CONSOLE_UART, 256, 0, 0, NULL, 0);
+}
+
+int runtimeConsoleRead() {
+  uint8_t c;
+  return uart_read_bytes(CONSOLE_UART, &c, 1, 0) == 1 ? c : -1;
+}
+
+bool runtimeApStart(const runtime_ap_t& ap, uint8_t ip[4]) {
+  esp_err_t err = nvs_flash_init();                     // Wi-Fi calibration data, phy_tune
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    nvs_flash_erase();
+    err = nvs_flash_init();
+  }
+  if (err != ESP_OK) return false;
+  if (esp_netif_init() != ESP_OK) return false;
+  err = esp_event_loop_create_default();
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;
+  esp_netif_t* netif = esp_netif_create_default_wifi_ap();
+
+  wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+  if (esp_wifi_init(&init) != ESP_OK) return false;
+  esp_wifi_set_storage(WIFI_STORAGE_RAM);
+
+  wifi_config_t cfg = {};
+  strncpy((char*)cfg.ap.ssid, ap.ssid, sizeof(cfg.ap.ssid));
+  cfg.ap.ssid_len = strlen(ap.ssid);
+  strncpy((char*)cfg.ap.password, ap.password, sizeof(cfg.ap.password));
+  cfg.ap.channel = ap.channel;
+  cfg.ap.ssid_hidden = ap.hidden;
+  cfg.ap.max_connection = ap.max_clients;
+  cfg.ap.beacon_interval = 100;
+  cfg.ap.authmode = ap.password[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+  if (esp_wifi_set_mode(WIFI_MODE_AP) != ESP_OK ||
+      esp_wifi_set_config(WIFI_IF_AP, &cfg) != ESP_OK ||
+      esp_wifi_start() != ESP_OK) return false;
+
+  esp_netif_ip_info_t info;
+  if (esp_netif_get_ip_info(netif, &info) != ESP_OK) return false;
+  memcpy(ip, &info.ip.addr, 4);
+  return true;
+}
+
+#endif
+
+// ---------- mDNS (same IDF component in both builds) ----------
+
+bool runtimeMdnsStart(const char* host) {
+  return mdns_init() == ESP_OK && mdns_hostname_set(host) == ESP_OK &&
+         mdns_instance_name_set(host) == ESP_OK;
+}
+
+bool runtimeMdnsService(const char* type, const char* proto, uint16_t port) {
+  char t[32], p[8];
+  snprintf(t, sizeof(t), "_%s", type);
+  snprintf(p, sizeof(p), "_%s", proto);
+  return mdns_service_add(NULL, t, p, port, NULL, 0) == ESP_OK;
+}
+
+int runtimeMdnsQuery(const char* type, const char* proto, uint32_t timeout_ms,
+                     runtime_peer_t* out, int max) {
+  char t[32], p[8];
+  snprintf(t, sizeof(t), "_%s", type);
+  snprintf(p, sizeof(p), "_%s", proto);
+  mdns_result_t* results = NULL;
+  if (mdns_query_ptr(t, p, timeout_ms, max, &results) != ESP_OK) return 0;
+  int n = 0;
+  for (mdns_result_t* r = results; r && n < max; r = r->next) {
+    const mdns_ip_addr_t* a = r->addr;
+    while (a && a->addr.type != ESP_IPADDR_TYPE_V4) a = a->next;
+    if (!r->hostname || !a) continue;
+    snprintf(out[n].host, sizeof(out[n].host), "%s", r->hostname);
+    memcpy(out[n].ip, &a->addr.u_addr.ip4.addr, 4);
+    out[n].port = r->port;
+    n++;
+  }
+  mdns_query_results_free(results);
+  return n;
+}
+
+void runtimeDelayMs(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
@@ -0,0 +1,94 @@
+/**
+ * DC-luma sprite sheets (see sprite_sheet.h).
+ */
+#include "sprite_sheet.h"
+
+#include <string.h>
+
+size_t spriteSheetBytes(int cap, int tile_w, int tile_h) {
+  size_t px = (size_t)tile_w * tile_h;
+  return (size_t)cap * px + (size_t)cap * sizeof(uint32_t) + px * (sizeof(uint32_t) + sizeof(uint16_t));
+}
+
+void spriteSheetInit(sprite_sheet_t* s, int cap, int tile_w, int tile_h, void* mem) {
+  size_t px = (size_t)tile_w * tile_h;
+  s->tile_w = tile_w;
+  s->tile_h = tile_h;
+  s->cap = cap;
+  s->t_ms = (uint32_t*)mem;                   // 32-bit members first: mem is aligned
+  s->acc = s->t_ms + cap;
+  s->hits = (uint16_t*)(s->acc + px);
+  s->tiles = (uint8_t*)(s->hits + px);
+  s->bw = s->bh = 0;
+  spriteSheetClear(s);
+}
+
+void spriteSheetClear(sprite_sheet_t* s) {
+  s->count = 0;
+  s->head = 0;
+}
+
+void spriteBegin(sprite_sheet_t* s, int bw, int bh) {
+  size_t px = (size_t)s->tile_w * s->tile_h;
+  memset(s->acc, 0, px * sizeof(uint32_t));
+  memset(s->hits, 0, px * sizeof(uint16_t));
+  s->bw = bw;
+  s->bh = bh;
+}
+
+void spriteCommit(sprite_sheet_t* s, uint32_t t_ms) {
+  size_t px = (size_t)s->tile_w * s->tile_h;
+  uint8_t* t = s->tiles + (size_t)s->head * px;
+  for (size_t i = 0; i < px; i++)
+    t[i] = s->hits[i] ? (uint8_t)((s->acc[i] + s->hits[i] / 2) / s->hits[i]) : 0;
+  s->t_ms[s->head] = t_ms;
+  s->head = (uint16_t)((s->head + 1) % s->cap);
+  if (s->count < s->cap) s->count++;
+}
+
+static inline int slotOf(const sprite_sheet_t* s, int i) {
+  return (s->head + s->cap - s->count + i) % s->cap;
+}
+
+uint32_t spriteTime(const sprite_sheet_t* s, int i) {
+  return s->t_ms[slotOf(s, i)];
+}
+
+int spriteFind(const sprite_sheet_t* s, uint32_t t_ms) {
+  int i = 0;
+  while (i < s->count && spriteTime(s, i) < t_ms) i++;
+  return i;
+}
+
+void spriteSheetSize(const sprite_sheet_t* s, int n, int cols, int rotate, int* w, int* h) {
+  bool swap = rotate == 90 || rotate == 270;
+  int tw = swap ? s->tile_h : s->tile_w, th = swap ? s->tile_w : s->tile_h;
+  if (cols < 1) cols = 1;
+  if (n < 1) n = 1;
+  int c = n < cols ? n : cols;
+  *w = c * tw;
+  *h = ((n + cols - 1) / cols) * th;
+}
+
+void spriteRender(const sprite_sheet_t* s, int first, int n, int cols, int rotate, uint8_t* out) {
+  int w, h;
+  spriteSheetSize(s, n, cols, rotate, &w, &h);
+  memset(out, 0, (size_t)w * h);
+  const int sw = s->tile_w, sh = s->tile_h;
+  const bool swap = rotate == 90 || rotate == 270;
+  const int tw = swap ? sh : sw, th = swap ? sw : sh;
+  if (cols < 1) cols = 1;
+
+  for (int k = 0; k < n && first + k < s->count; k++) {
+    const uint8_t* t = s->tiles + (size_t)slotOf(s, first + k) * sw * sh;
+    uint8_t* dst = out + (size_t)(k / cols) * th * w + (size_t)(k % cols) * tw;
+    for (int y = 0; y < th; y++) {
+      uint8_t* row = dst + (size_t)y * w;
+      for (int x = 0; x < tw; x++) {
+        int sx = rotate == 90 ? y : rotate == 270 ? sw - 1 - y : rotate == 180 ? sw - 1 - x : x;
+        int sy = rotate == 90 ? sh - 1 - x : rotate == 270 ? x : rotate == 180 ? sh - 1 - y : y;
+        row[x] = t[sy * sw + sx];
+      }
+    }
+  }
+}
@@ -0,0 +1,152 @@
+/**
+ * Scrub-preview sprite sheets (see sprites.h).
+ */
+#include "sprites.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "encoder.h"
+#include "jpeg_scan.h"
+#include "psram.h"
+#include "qos.h"
+#include "sprite_sheet.h"
+
+#define SHEET_QUALITY   75
+#define MAX_COLS        32
+#define INDEX_MAX       (16 * 1024)   // COM segment payload (< 64 KB)
+
+static SemaphoreHandle_t sp_lock = NULL;
+static sprite_sheet_t sheet;
+static bool     ready = false;
+static int64_t  next_us = 0;
+static uint32_t cost_us = 0, scan_errors = 0;
+
+static void lumaDc(void* ctx, int comp, int bx, int by, int dc, int ac) {
+  (void)comp; (void)ac;
+  spriteAddBlock((sprite_sheet_t*)ctx, bx, by, dc);
+}
+
+static void spriteStage(const camera_fb_t* fb, void* ctx) {
+  (void)ctx;
+  int64_t now = esp_timer_get_time();
+  if (!ready || fb->format != PIXFORMAT_JPEG || now < next_us) return;
+  next_us = now + SPRITE_INTERVAL_S * 1000000LL;
+
+  jpeg_info_t info;
+  if (jpegScanHeaders(fb->buf, fb->len, &info) != JPEG_SCAN_OK) { scan_errors++; return; }
+  xSemaphoreTake(sp_lock, portMAX_DELAY);
+  spriteBegin(&sheet, info.blocks_x[0], info.blocks_y[0]);
+  if (jpegScan(fb->buf, fb->len, JPEG_SCAN_LUMA_ONLY, lumaDc, &sheet, NULL) == JPEG_SCAN_OK) {
+    spriteCommit(&sheet, (uint32_t)(now / 1000));     // same clock as now_ms in the index
+  } else {
+    scan_errors++;
+  }
+  xSemaphoreGive(sp_lock);
+  cost_us = (uint32_t)(esp_timer_get_time() - now);
+}
+
+void spritesInit() {
+  sp_lock = xSemaphoreCreateMutex();
+  int cap = SPRITE_CAP;
+  size_t bytes = spriteSheetBytes(cap, SPRITE_TILE_W, SPRITE_TILE_H);
+  void* mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  if (!mem) {
+    cap = SPRITE_CAP_FALLBACK;
+    bytes = spriteSheetBytes(cap, SPRITE_TILE_W, SPRITE_TILE_H);
+    mem = psAlloc(bytes);
+  }
+  if (!mem) {
+    printf("sprites: no memory\n");
+    return;
+  }
+  spriteSheetInit(&sheet, cap, SPRITE_TILE_W, SPRITE_TILE_H, mem);
+  ready = true;
+  printf("sprites: %d tiles, %u KB\n", cap, (unsigned)(bytes / 1024));
+  // Below the heatmap: a missed sample only shifts one preview by a frame.
+  qosRegisterStage("sprites", 30, 1000, spriteStage, NULL);
+}
+
+esp_err_t spritesRenderJpeg(uint32_t last_s, int cols, int rotate, uint8_t** jpg, size_t* len) {
+  if (!ready) return ESP_ERR_INVALID_STATE;
+  if (cols < 1) cols = 10;
+  if (cols > MAX_COLS) cols = MAX_COLS;
+  if (rotate != 90 && rotate != 180 && rotate != 270) rotate = 0;
+
+  uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+  char* index = (char*)malloc(INDEX_MAX);
+  if (!index) return ESP_ERR_NO_MEM;
+
+  xSemaphoreTake(sp_lock, portMAX_DELAY);
+  int first = last_s && last_s * 1000ULL < now_ms ? spriteFind(&sheet, now_ms - last_s * 1000) : 0;
+  int n = sheet.count - first;
+  if (n <= 0) {
+    xSemaphoreGive(sp_lock);
+    free(index);
+    return ESP_ERR_NOT_FOUND;
+  }
+  int w, h;
+  spriteSheetSize(&sheet, n, cols, rotate, &w, &h);
+  uint8_t* gray = (uint8_t*)psAlloc((size_t)w * h);
+  if (gray) spriteRender(&sheet, first, n, cols, rotate, gray);
+  bool swap = rotate == 90 || rotate == 270;
+  int k = snprintf(index, INDEX_MAX, "{\"tile\":[%d,%d],\"cols\":%d,\"interval_ms\":%d,\"now_ms\":%u,\"t\":[",
+                   swap ? SPRITE_TILE_H : SPRITE_TILE_W, swap ? SPRITE_TILE_W : SPRITE_TILE_H,
+                   n < cols ? n : cols, SPRITE_INTERVAL_S * 1000, (unsigned)now_ms);
+  for (int i = 0; i < n && k < INDEX_MAX; i++)
+    k += snprintf(index + k, INDEX_MAX - k, "%s%u", i ? "," : "", (unsigned)spriteTime(&sheet, first + i));
+  if (k < INDEX_MAX) k += snprintf(index + k, INDEX_MAX - k, "]}");
+  xSemaphoreGive(sp_lock);
+  if (!gray || k >= INDEX_MAX) {
+    free(gray);
+    free(index);
+    return ESP_ERR_NO_MEM;
+  }
+
+  uint8_t* enc = NULL;
+  size_t enc_len = 0;
+  bool ok = encodeJpeg(gray, (size_t)w * h, w, h, PIXFORMAT_GRAYSCALE, SHEET_QUALITY, &enc, &enc_len);
+  free(gray);
+  if (!ok || enc_len < 2) {
+    free(enc);
+    free(index);
+    return ESP_FAIL;
+  }
+
+  // SOI, COM with the index, then the rest of the encoded sheet
+  size_t out_len = enc_len + 4 + k;
+  uint8_t* out = (uint8_t*)psAlloc(out_len);
+  if (out) {
+    out[0] = 0xFF; out[1] = 0xD8;
+    out[2] = 0xFF; out[3] = 0xFE;
+    out[4] = (uint8_t)((k + 2) >> 8);
+    out[5] = (uint8_t)(k + 2);
+    memcpy(out + 6, index, k);
+    memcpy(out + 6 + k, enc + 2, enc_len - 2);
+  }
+  free(enc);
+  free(index);
+  if (!out) return ESP_ERR_NO_MEM;
+  *jpg = out;
+  *len = out_len;
+  return ESP_OK;
+}
+
+size_t spritesStatusJson(char* buf, size_t len) {
+  xSemaphoreTake(sp_lock, portMAX_DELAY);
+  int n = snprintf(buf, len,
+    "{\"tiles\":%u,\"cap\":%u,\"tile\":[%d,%d],\"interval_s\":%d,\"oldest_ms\":%u,\"newest_ms\":%u,"
+    "\"cost_us\":%u,\"scan_errors\":%u}",
+    ready ? sheet.count : 0, ready ? sheet.cap : 0, SPRITE_TILE_W, SPRITE_TILE_H, SPRITE_INTERVAL_S,
+    ready && sheet.count ? (unsigned)spriteTime(&sheet, 0) : 0,
+    ready && sheet.count ? (unsigned)spriteTime(&sheet, sheet.count - 1) : 0,
+    (unsigned)cost_us, (unsigned)scan_errors);
+  xSemaphoreGive(sp_lock);
+  return n < (int)len ? n : len - 1;
+}
@@ -0,0 +1,85 @@
+/**
+ * Stacked stills (see stack.h).
+ */
+#include "stack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#include "camera.h"
+#include "encoder.h"
+#include "stack_accum.h"
+
+#define SETTLE_FRAMES 3          // frames dropped after the format switch (AE/AWB)
+
+static esp_err_t burst(uint32_t* acc, size_t pixels, int frames, stack_result_t* out) {
+  for (int i = 0; i < SETTLE_FRAMES; i++) {
+    camera_fb_t* fb = camFbGet();
+    if (fb) camFbReturn(fb);
+  }
+  uint64_t accum_us = 0;
+  int64_t t0 = esp_timer_get_time();
+  int got = 0, misses = 0;
+  while (got < frames && misses < 3) {
+    camera_fb_t* fb = camFbGet();
+    if (!fb) { misses++; continue; }
+    if (fb->format != PIXFORMAT_RGB565 || fb->len < pixels * 2) {
+      camFbReturn(fb);
+      return ESP_FAIL;
+    }
+    int64_t a0 = esp_timer_get_time();
+    stackAccumulate(acc, fb->buf, pixels);
+    accum_us += esp_timer_get_time() - a0;
+    camFbReturn(fb);
+    got++;
+  }
+  out->frames = got;
+  out->grab_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+  out->accum_us = got ? (uint32_t)(accum_us / got) : 0;
+  return got ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t stackCapture(int frames, framesize_t size, int quality, stack_result_t* out) {
+  memset(out, 0, sizeof(*out));
+  if (frames < 1) frames = 1;
+  if (frames > STACK_MAX_FRAMES) frames = STACK_MAX_FRAMES;
+  if (quality < 10 || quality > 100) quality = 90;
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) return ESP_ERR_NOT_SUPPORTED;
+  if (!cameraClaim("capture")) return ESP_ERR_INVALID_STATE;
+
+  const size_t pixels = (size_t)resolution[size].width * resolution[size].height;
+  uint32_t* acc = (uint32_t*)heap_caps_calloc(pixels, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+  if (!acc) {
+    cameraRelease();
+    return ESP_ERR_NO_MEM;
+  }
+
+  cam_profile_t prof = { PIXFORMAT_RGB565, size, JPEG_QUALITY, 2 };
+  esp_err_t err = cameraSetProfile(prof);
+  if (err == ESP_OK) err = burst(acc, pixels, frames, out);
+  cameraRestoreStreamProfile();          // stream resumes while we encode
+  cameraRelease();
+
+  if (err == ESP_OK) {
+    int64_t t0 = esp_timer_get_time();
+    uint8_t* rgb = (uint8_t*)acc;
+    stackFinish(acc, pixels, out->frames, rgb);
+    if (encodeJpeg(rgb, pixels * 3, resolution[size].width, resolution[size].height,
+                   PIXFORMAT_RGB888, quality, &out->jpg, &out->len)) {
+      out->width = resolution[size].width;
+      out->height = resolution[size].height;
+      out->encode_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    } else {
+      err = ESP_FAIL;
+    }
+  }
+  heap_caps_free(acc);
+  printf("capture: %d/%d frames %ux%u accum %u us/frame grab %u ms encode %u ms %s\n",
+         out->frames, frames, resolution[size].width, resolution[size].height,
+         (unsigned)out->accum_us, (unsigned)out->grab_ms, (unsigned)out->encode_ms,
+         esp_err_to_name(err));
+  return err;
+}
@@ -0,0 +1,37 @@
+/**
+ * Fixed-point frame stacking for RGB565 bursts (see stack_accum.h).
+ */
+#include "stack_accum.h"
+
+void stackAccumulate(uint32_t* acc, const uint8_t* frame, size_t pixels) {
+  // Two pixels per 32-bit load: bytes hi0 lo0 hi1 lo1 (little-endian load).
+  const uint32_t* src = (const uint32_t*)frame;
+  size_t pairs = pixels / 2;
+  for (size_t i = 0; i < pairs; i++) {
+    uint32_t w = src[i];
+    uint32_t p0 = ((w & 0xFF) << 8) | ((w >> 8) & 0xFF);
+    uint32_t p1 = ((w >> 8) & 0xFF00) | (w >> 24);
+    acc[2 * i]     += ((p0 & 0xF800) << 8) | ((p0 & 0x07E0) << 4) | (p0 & 0x001F);
+    acc[2 * i + 1] += ((p1 & 0xF800) << 8) | ((p1 & 0x07E0) << 4) | (p1 & 0x001F);
+  }
+  if (pixels & 1) {
+    uint32_t p = (frame[2 * (pixels - 1)] << 8) | frame[2 * (pixels - 1) + 1];
+    acc[pixels - 1] += ((p & 0xF800) << 8) | ((p & 0x07E0) << 4) | (p & 0x001F);
+  }
+}
+
+void stackFinish(const uint32_t* acc, size_t pixels, int frames, uint8_t* out) {
+  if (frames < 1) frames = 1;
+  // sum * 255 / (max * frames) as a Q16 multiply
+  uint32_t k5 = (uint32_t)((255u << 16) / (31u * frames));
+  uint32_t k6 = (uint32_t)((255u << 16) / (63u * frames));
+  for (size_t i = 0; i < pixels; i++) {
+    uint32_t a = acc[i];                       // read before out[3i..] overwrites it
+    uint32_t r = (((a >> 19) & 0x1FF) * k5 + 0x8000) >> 16;
+    uint32_t g = (((a >> 9) & 0x3FF) * k6 + 0x8000) >> 16;
+    uint32_t b = ((a & 0x1FF) * k5 + 0x8000) >> 16;
+    out[3 * i]     = r > 255 ? 255 : r;
+    out[3 * i + 1] = g > 255 ? 255 : g;
+    out[3 * i + 2] = b > 255 ? 255 : b;
+  }
+}
@@ -0,0 +1,266 @@
+/**
+ * Per-viewer TCP statistics (see tcp_stats.h).
+ *
+ * PCBs belong to the tcpip thread, so every read goes through
+ * tcpip_api_call(); the socket's PCB is found with lwIP's own
+ * lwip_socket_dbg_get_socket(). A sample is matched to the previous one by
+ * fd and remote address, so a reused fd starts its counters over.
+ */
+#include "tcp_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/api.h"
+#include "lwip/priv/sockets_priv.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "lwip/sockets.h"
+#include "lwip/stats.h"
+#include "lwip/tcp.h"
+
+#include "console.h"
+#include "http_stream.h"
+
+struct Entry {
+  tcp_conn_stats_t s;
+  bool             live;
+};
+
+static Entry        entries[HTTP_STREAM_MAX];
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ---------- tcpip thread ----------
+
+struct PcbRead {
+  struct tcpip_api_call_data base;
+  int                n;
+  http_stream_info_t conn[HTTP_STREAM_MAX];
+  tcp_conn_stats_t   out[HTTP_STREAM_MAX];
+  bool               ok[HTTP_STREAM_MAX];
+};
+
+static void readPcb(const struct tcp_pcb* pcb, tcp_conn_stats_t* o) {
+  o->remote_ip    = ip4_addr_get_u32(ip_2_ip4(&pcb->remote_ip));
+  o->remote_port  = pcb->remote_port;
+  o->state        = (uint8_t)pcb->state;
+  o->mss          = pcb->mss;
+  o->cwnd         = pcb->cwnd;
+  o->ssthresh     = pcb->ssthresh;
+  o->peer_wnd     = pcb->snd_wnd;
+  o->rcv_wnd      = pcb->rcv_wnd;
+  o->queued       = pcb->snd_lbb - pcb->lastack;
+  o->in_flight    = pcb->snd_nxt - pcb->lastack;
+  o->snd_buf_free = pcb->snd_buf;
+  o->snd_queuelen = pcb->snd_queuelen;
+  // tcp_in.c keeps sa = 8 * srtt and sv = 4 * rttvar, in slow-timer ticks
+  o->srtt_ms      = pcb->sa > 0 ? (uint32_t)pcb->sa * TCP_SLOW_INTERVAL / 8 : 0;
+  o->rttvar_ms    = pcb->sv > 0 ? (uint32_t)pcb->sv * TCP_SLOW_INTERVAL / 4 : 0;
+  o->rto_ms       = pcb->rto > 0 ? (uint32_t)pcb->rto * TCP_SLOW_INTERVAL : 0;
+  o->nrtx         = pcb->nrtx;
+  o->recovery     = (pcb->flags & TF_INFR) != 0;
+}
+
+static err_t readPcbs(struct tcpip_api_call_data* call) {
+  PcbRead* r = (PcbRead*)call;
+  for (int i = 0; i < r->n; i++) {
+    struct lwip_sock* sock = lwip_socket_dbg_get_socket(r->conn[i].fd);
+    struct netconn* conn = sock ? sock->conn : NULL;
+    r->ok[i] = conn && NETCONNTYPE_GROUP(conn->type) == NETCONN_TCP && conn->pcb.tcp;
+    if (r->ok[i]) readPcb(conn->pcb.tcp, &r->out[i]);
+  }
+  return ERR_OK;
+}
+
+struct GlobalRead {
+  struct tcpip_api_call_data base;
+  tcp_global_stats_t*        o;
+};
+
+static err_t readGlobal(struct tcpip_api_call_data* call) {
+  tcp_global_stats_t* o = ((GlobalRead*)call)->o;
+  for (struct tcp_pcb* pcb = tcp_active_pcbs; pcb; pcb = pcb->next) {
+    o->active_pcbs++;
+    o->queued_bytes += pcb->snd_lbb - pcb->lastack;
+    o->queued_pbufs += pcb->snd_queuelen;
+#if TCP_QUEUE_OOSEQ
+    if (pcb->ooseq) o->ooseq_pcbs++;
+#endif
+  }
+  for (struct tcp_pcb* pcb = tcp_tw_pcbs; pcb; pcb = pcb->next) o->time_wait_pcbs++;
+  return ERR_OK;
+}
+
+// ---------- sampler ----------
+
+static void merge(const PcbRead& r) {
+  portENTER_CRITICAL(&stats_mux);
+  bool seen[HTTP_STREAM_MAX] = {};
+  for (int i = 0; i < r.n; i++) {
+    if (!r.ok[i]) continue;
+    const tcp_conn_stats_t& n = r.out[i];
+    Entry* e = NULL;
+    for (int k = 0; k < HTTP_STREAM_MAX && !e; k++)
+      if (entries[k].live && entries[k].s.fd == r.conn[i].fd && entries[k].s.remote_ip == n.remote_ip &&
+          entries[k].s.remote_port == n.remote_port) e = &entries[k];
+    for (int k = 0; k < HTTP_STREAM_MAX && !e; k++)
+      if (!entries[k].live && !seen[k]) {
+        e = &entries[k];
+        memset(e, 0, sizeof(*e));
+        e->live = true;
+      }
+    if (!e) continue;
+    seen[e - entries] = true;
+
+    uint8_t prev = e->s.nrtx;
+    uint32_t retx = e->s.retx, samples = e->s.samples, small = e->s.small_wnd, full = e->s.full_queue;
+    if (n.nrtx > prev) retx += n.nrtx - prev;
+    else if (n.nrtx && n.nrtx < prev) retx += n.nrtx;      // a new episode since the last sample
+    e->s = n;
+    e->s.fd = r.conn[i].fd;
+    e->s.name = r.conn[i].name;
+    e->s.retx = retx;
+    e->s.samples = samples + 1;
+    e->s.small_wnd = small + (n.peer_wnd < 2u * n.mss);
+    e->s.full_queue = full + (n.snd_buf_free < n.mss || n.snd_queuelen + 1 >= TCP_SND_QUEUELEN);
+  }
+  for (int k = 0; k < HTTP_STREAM_MAX; k++)
+    if (!seen[k]) entries[k].live = false;
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+static void samplerTask(void*) {
+  static PcbRead r;                    // only this task uses it; keeps the stack small
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(TCP_STATS_PERIOD_MS));
+    memset(&r, 0, sizeof(r));
+    r.n = httpStreamList(r.conn, HTTP_STREAM_MAX);
+    if (r.n && tcpip_api_call(readPcbs, &r.base) != ERR_OK) continue;
+    merge(r);
+  }
+}
+
+int tcpStatsConns(tcp_conn_stats_t* out, int max) {
+  int n = 0;
+  portENTER_CRITICAL(&stats_mux);
+  for (int k = 0; k < HTTP_STREAM_MAX && n < max; k++)
+    if (entries[k].live) out[n++] = entries[k].s;
+  portEXIT_CRITICAL(&stats_mux);
+  return n;
+}
+
+bool tcpStatsGlobal(tcp_global_stats_t* out) {
+  memset(out, 0, sizeof(*out));
+  GlobalRead g;
+  g.o = out;
+  bool ok = tcpip_api_call(readGlobal, &g.base) == ERR_OK;
+  out->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  out->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+  out->heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+  return ok;
+}
+
+// ---------- output ----------
+
+static const char* ipStr(uint32_t ip, char* buf, size_t len) {
+  const uint8_t* b = (const uint8_t*)&ip;
+  snprintf(buf, len, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+  return buf;
+}
+
+static unsigned pct(uint32_t part, uint32_t whole) {
+  return whole ? (unsigned)(100 * part / whole) : 0;
+}
+
+// IPv4 address of a socket's peer (network order), 0 if unknown. httpd
+// listens on IPv6, so viewers arrive as v4-mapped addresses.
+static uint32_t peerIp(int fd) {
+  struct sockaddr_in6 peer;
+  socklen_t plen = sizeof(peer);
+  uint32_t ip = 0;
+  if (fd < 0 || getpeername(fd, (struct sockaddr*)&peer, &plen) != 0) return 0;
+  if (peer.sin6_family == AF_INET) memcpy(&ip, &((struct sockaddr_in*)&peer)->sin_addr, 4);
+  else memcpy(&ip, &peer.sin6_addr.s6_addr[12], 4);
+  return ip;
+}
+
+size_t tcpStatsJson(char* buf, size_t len, int viewer_fd) {
+  const uint32_t viewer_ip = peerIp(viewer_fd);
+  tcp_conn_stats_t c[HTTP_STREAM_MAX];
+  int nc = tcpStatsConns(c, HTTP_STREAM_MAX);
+  tcp_global_stats_t g;
+  tcpStatsGlobal(&g);
+
+  int n = snprintf(buf, len, "{\"period_ms\":%d,\"conns\":[", TCP_STATS_PERIOD_MS);
+  for (int i = 0; i < nc && n < (int)len; i++) {
+    char ip[16];
+    n += snprintf(buf + n, len - n,
+      "%s{\"name\":\"%s\",\"fd\":%d,\"ip\":\"%s\",\"port\":%u,\"you\":%s,\"state\":%u,\"mss\":%u,"
+      "\"cwnd\":%u,\"ssthresh\":%u,\"peer_wnd\":%u,\"rcv_wnd\":%u,\"queued\":%u,\"in_flight\":%u,"
+      "\"snd_buf_free\":%u,\"snd_queuelen\":%u,\"srtt_ms\":%u,\"rttvar_ms\":%u,\"rto_ms\":%u,"
+      "\"nrtx\":%u,\"recovery\":%s,\"retx\":%u,\"samples\":%u,\"small_wnd_pct\":%u,\"full_queue_pct\":%u}",
+      i ? "," : "", c[i].name, c[i].fd, ipStr(c[i].remote_ip, ip, sizeof(ip)), c[i].remote_port,
+      viewer_ip && c[i].remote_ip == viewer_ip ? "true" : "false", c[i].state, c[i].mss,
+      (unsigned)c[i].cwnd, (unsigned)c[i].ssthresh, (unsigned)c[i].peer_wnd, (unsigned)c[i].rcv_wnd,
+      (unsigned)c[i].queued, (unsigned)c[i].in_flight, (unsigned)c[i].snd_buf_free, c[i].snd_queuelen,
+      (unsigned)c[i].srtt_ms, (unsigned)c[i].rttvar_ms, (unsigned)c[i].rto_ms, c[i].nrtx,
+      c[i].recovery ? "true" : "false", (unsigned)c[i].retx, (unsigned)c[i].samples,
+      pct(c[i].small_wnd, c[i].samples), pct(c[i].full_queue, c[i].samples));
+  }
+  if (n < (int)len)
+    n += snprintf(buf + n, len - n,
+      "],\"lwip\":{\"active_pcbs\":%u,\"time_wait_pcbs\":%u,\"queued_bytes\":%u,\"queued_pbufs\":%u,"
+      "\"ooseq_pcbs\":%u,\"snd_buf\":%u,\"snd_queuelen_max\":%u,\"wnd\":%u,"
+      "\"heap_free\":%u,\"heap_largest\":%u,\"heap_min\":%u",
+      g.active_pcbs, g.time_wait_pcbs, (unsigned)g.queued_bytes, (unsigned)g.queued_pbufs,
+      g.ooseq_pcbs, (unsigned)TCP_SND_BUF, (unsigned)TCP_SND_QUEUELEN, (unsigned)TCP_WND,
+      (unsigned)g.heap_free, (unsigned)g.heap_largest, (unsigned)g.heap_min);
+#if LWIP_STATS && MIB2_STATS
+  if (n < (int)len)
+    n += snprintf(buf + n, len - n, ",\"retrans_segs\":%u", (unsigned)lwip_stats.mib2.tcpretranssegs);
+#endif
+#if LWIP_STATS && MEMP_STATS
+  static const struct { const char* name; int id; } pools[] = {
+    { "tcp_pcb", MEMP_TCP_PCB }, { "tcp_seg", MEMP_TCP_SEG },
+    { "pbuf", MEMP_PBUF }, { "pbuf_pool", MEMP_PBUF_POOL },
+  };
+  for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]) && n < (int)len; i++) {
+    const struct stats_mem* m = lwip_stats.memp[pools[i].id];
+    n += snprintf(buf + n, len - n, "%s\"%s\":[%u,%u,%u]", i ? "," : ",\"memp\":{", pools[i].name,
+                  (unsigned)m->used, (unsigned)m->max, (unsigned)m->err);
+  }
+  if (n < (int)len) n += snprintf(buf + n, len - n, "}");
+#endif
+  if (n < (int)len) n += snprintf(buf + n, len - n, "}}");
+  return n < (int)len ? n : len - 1;
+}
+
+// ---------- console ----------
+
+static const char* tcpCmd(int, char**) {
+  tcp_conn_stats_t c[HTTP_STREAM_MAX];
+  int nc = tcpStatsConns(c, HTTP_STREAM_MAX);
+  for (int i = 0; i < nc; i++) {
+    char ip[16];
+    printf("TCP name=%s ip=%s port=%u cwnd=%u peer_wnd=%u queued=%u in_flight=%u pbufs=%u "
+           "srtt_ms=%u rto_ms=%u retx=%u small_wnd_pct=%u full_queue_pct=%u\n",
+           c[i].name, ipStr(c[i].remote_ip, ip, sizeof(ip)), c[i].remote_port, (unsigned)c[i].cwnd,
+           (unsigned)c[i].peer_wnd, (unsigned)c[i].queued, (unsigned)c[i].in_flight, c[i].snd_queuelen,
+           (unsigned)c[i].srtt_ms, (unsigned)c[i].rto_ms, (unsigned)c[i].retx,
+           pct(c[i].small_wnd, c[i].samples), pct(c[i].full_queue, c[i].samples));
+  }
+  tcp_global_stats_t g;
+  if (!tcpStatsGlobal(&g)) return "tcpip";
+  printf("TCP global active=%u time_wait=%u queued=%u pbufs=%u ooseq=%u heap=%u heap_largest=%u\n",
+         g.active_pcbs, g.time_wait_pcbs, (unsigned)g.queued_bytes, (unsigned)g.queued_pbufs,
+         g.ooseq_pcbs, (unsigned)g.heap_free, (unsigned)g.heap_largest);
+  return NULL;
+}
+
+void tcpStatsInit() {
+  consoleRegister("tcp", "per-viewer TCP and lwIP memory", tcpCmd);
+  xTaskCreate(samplerTask, "tcp_stats", 3072, NULL, 1, NULL);
+}
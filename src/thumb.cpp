@@ -0,0 +1,88 @@
+/**
+ * DC thumbnails (see thumb.h).
+ */
+#include "thumb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_scan.h"
+
+struct DcPlanes {
+  uint8_t* p[3];
+  int      stride[3];
+};
+
+static inline uint8_t clamp255(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+static void storeDc(void* ctx, int comp, int bx, int by, int dc, int ac_sum) {
+  (void)ac_sum;
+  DcPlanes* d = (DcPlanes*)ctx;
+  d->p[comp][by * d->stride[comp] + bx] = clamp255(128 + (dc >> 3));
+}
+
+bool thumbFromJpeg(const uint8_t* jpg, size_t len, int shift,
+                   uint8_t** rgb, int* width, int* height) {
+  jpeg_info_t info;
+  if (shift < 0) shift = 0;
+  if (shift > 3) shift = 3;
+  if (jpegScanHeaders(jpg, len, &info) != JPEG_SCAN_OK) return false;
+
+  DcPlanes d;
+  size_t total = 0;
+  for (int c = 0; c < info.ncomp; c++) total += (size_t)info.blocks_x[c] * info.blocks_y[c];
+  uint8_t* planes = (uint8_t*)malloc(total);
+  if (!planes) return false;
+  uint8_t* p = planes;
+  for (int c = 0; c < info.ncomp; c++) {
+    d.p[c] = p;
+    d.stride[c] = info.blocks_x[c];
+    p += (size_t)info.blocks_x[c] * info.blocks_y[c];
+  }
+  if (jpegScan(jpg, len, 0, storeDc, &d, NULL) != JPEG_SCAN_OK) {
+    free(planes);
+    return false;
+  }
+
+  // visible blocks only (the block grid is padded to whole MCUs)
+  const int bw = (info.width + 7) / 8, bh = (info.height + 7) / 8;
+  const int n = 1 << shift;
+  const int w = bw >> shift, h = bh >> shift;
+  if (w < 1 || h < 1) {
+    free(planes);
+    return false;
+  }
+  uint8_t* out = (uint8_t*)malloc((size_t)w * h * 3);
+  if (!out) {
+    free(planes);
+    return false;
+  }
+
+  const int hmax = info.h[0], vmax = info.v[0];
+  uint8_t* o = out;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int sy = 0;
+      for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++) sy += d.p[0][((y << shift) + j) * d.stride[0] + (x << shift) + i];
+      int Y = sy >> (2 * shift);
+      if (info.ncomp < 3) {
+        o[0] = o[1] = o[2] = (uint8_t)Y;
+      } else {
+        // centre block of the cell, mapped onto the chroma grid
+        int cx = ((x << shift) + n / 2), cy = ((y << shift) + n / 2);
+        int cb = d.p[1][(cy * info.v[1] / vmax) * d.stride[1] + cx * info.h[1] / hmax] - 128;
+        int cr = d.p[2][(cy * info.v[2] / vmax) * d.stride[2] + cx * info.h[2] / hmax] - 128;
+        o[0] = clamp255(Y + ((91881 * cr) >> 16));                  // JFIF YCbCr -> RGB
+        o[1] = clamp255(Y - ((22554 * cb + 46802 * cr) >> 16));
+        o[2] = clamp255(Y + ((116130 * cb) >> 16));
+      }
+      o += 3;
+    }
+  }
+  free(planes);
+  *rgb = out;
+  *width = w;
+  *height = h;
+  return true;
+}
@@ -0,0 +1,137 @@
+/**
+ * Sub-pixel nozzle tip localization (see tip.h).
+ */
+#include "tip.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "jpeg_roi.h"
+#include "jpeg_scan.h"
+#include "psram.h"
+#include "qos.h"
+#include "tip_locate.h"
+
+// ---------- frame adapter ----------
+
+static portMUX_TYPE  tip_mux = portMUX_INITIALIZER_UNLOCKED;
+static tip_config_t  config = { 250, 0, 750, 600, 4, 24 };
+static tip_result_t  latest;
+static uint8_t*      gray_buf = NULL;
+static uint8_t*      mag_buf = NULL;
+static size_t        buf_cap = 0;
+
+static bool ensureBuffers(size_t n) {
+  if (n <= buf_cap) return true;
+  free(gray_buf); free(mag_buf);
+  gray_buf = (uint8_t*)psAlloc(n);
+  mag_buf  = (uint8_t*)psAlloc(n);
+  buf_cap = gray_buf && mag_buf ? n : 0;
+  return buf_cap != 0;
+}
+
+static void tipStage(const camera_fb_t* fb, void* ctx) {
+  (void)ctx;
+  int64_t t0 = esp_timer_get_time();
+  tip_config_t cfg = tipConfig();
+
+  int scale = fb->format == PIXFORMAT_JPEG ? cfg.scale : 1;
+  int fw = (fb->width + scale - 1) / scale, fh = (fb->height + scale - 1) / scale;
+  int rx0 = fw * cfg.x0 / 1000, ry0 = fh * cfg.y0 / 1000;
+  int rw = fw * cfg.x1 / 1000 - rx0, rh = fh * cfg.y1 / 1000 - ry0;
+  if (rw > TIP_MAX_W) rw = TIP_MAX_W;
+
+  bool have = false;
+  const uint8_t* gray = NULL;
+  int stride = rw;
+  if (rw >= 5 && rh >= 5 && ensureBuffers((size_t)rw * rh)) {
+    if (fb->format == PIXFORMAT_JPEG) {
+      have = jpegDecodeGray(fb->buf, fb->len, scale, rx0, ry0, rw, rh, gray_buf) == JPEG_SCAN_OK;
+      gray = gray_buf;
+    } else if (fb->format == PIXFORMAT_GRAYSCALE) {
+      gray = fb->buf + ry0 * fb->width + rx0;
+      stride = fb->width;
+      have = true;
+    } else if (fb->format == PIXFORMAT_YUV422) {
+      for (int y = 0; y < rh; y++) {             // Y0 U Y1 V: luma on even bytes
+        const uint8_t* src = fb->buf + ((ry0 + y) * fb->width + rx0) * 2;
+        uint8_t* dst = gray_buf + y * rw;
+        for (int x = 0; x < rw; x++) dst[x] = src[x * 2];
+      }
+      gray = gray_buf;
+      have = true;
+    }
+  }
+
+  tip_result_t r;
+  memset(&r, 0, sizeof(r));
+  r.frame_us = (uint64_t)fb->timestamp.tv_sec * 1000000ULL + fb->timestamp.tv_usec;
+  int32_t xq, yq;
+  uint16_t strength;
+  if (have && tipLocate(gray, rw, rh, stride, cfg.min_strength, mag_buf, &xq, &yq, &strength)) {
+    // ROI-local decoded pixels -> full-frame pixel centres
+    r.found = true;
+    r.x_q8 = ((rx0 << 8) + xq) * scale + (scale - 1) * 128;
+    r.y_q8 = ((ry0 << 8) + yq) * scale + (scale - 1) * 128;
+    r.strength = strength;
+  }
+  r.cost_us = (uint32_t)(esp_timer_get_time() - t0);
+
+  portENTER_CRITICAL(&tip_mux);
+  r.seq = latest.seq + 1;
+  latest = r;
+  portEXIT_CRITICAL(&tip_mux);
+}
+
+void tipInit() {
+  // One UXGA frame costs 5.1-5.8 ms end to end on the host at the default
+  // 1/4 scale and ROI, SVGA 1.3-1.8 ms (tools/tip_bench, three runs), nearly
+  // all of it the entropy pass down to the ROI's last row. The budget is the
+  // UXGA figure: every frame at any framesize, unless the device's measured
+  // cost is higher, which it is.
+  qosRegisterStage("tip", 200, 6000, tipStage, NULL);
+}
+
+void tipSetConfig(const tip_config_t& cfg) {
+  tip_config_t c = cfg;
+  if (c.x1 > 1000) c.x1 = 1000;
+  if (c.y1 > 1000) c.y1 = 1000;
+  if (c.x0 >= c.x1 || c.y0 >= c.y1) return;
+  if (c.scale != 1 && c.scale != 2 && c.scale != 4 && c.scale != 8) c.scale = 4;
+  portENTER_CRITICAL(&tip_mux);
+  config = c;
+  portEXIT_CRITICAL(&tip_mux);
+}
+
+tip_config_t tipConfig() {
+  portENTER_CRITICAL(&tip_mux);
+  tip_config_t c = config;
+  portEXIT_CRITICAL(&tip_mux);
+  return c;
+}
+
+tip_result_t tipLatest() {
+  portENTER_CRITICAL(&tip_mux);
+  tip_result_t r = latest;
+  portEXIT_CRITICAL(&tip_mux);
+  return r;
+}
+
+size_t tipResultJson(const tip_result_t& r, char* buf, size_t len) {
+  int n;
+  if (r.found) {
+    n = snprintf(buf, len,
+      "{\"seq\":%u,\"t_us\":%llu,\"found\":true,\"x\":%.2f,\"y\":%.2f,"
+      "\"strength\":%u,\"cost_us\":%u}",
+      (unsigned)r.seq, (unsigned long long)r.frame_us, r.x_q8 / 256.0f, r.y_q8 / 256.0f,
+      r.strength, (unsigned)r.cost_us);
+  } else {
+    n = snprintf(buf, len, "{\"seq\":%u,\"t_us\":%llu,\"found\":false,\"cost_us\":%u}",
+      (unsigned)r.seq, (unsigned long long)r.frame_us, (unsigned)r.cost_us);
+  }
+  return n < (int)len ? n : len - 1;
+}
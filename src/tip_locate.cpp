@@ -0,0 +1,91 @@
+/**
+ * Sub-pixel tip locator (see tip_locate.h).
+ */
+#include "tip_locate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Vertex offset of a parabola through (-1,a) (0,b) (+1,c), Q8, clamped to ±0.5.
+static int32_t parabolaQ8(int32_t a, int32_t b, int32_t c) {
+  int32_t den = a - 2 * b + c;
+  if (den == 0) return 0;
+  int32_t d = ((a - c) * 128) / den;
+  if (d > 128) d = 128;
+  if (d < -128) d = -128;
+  return d;
+}
+
+// Sub-pixel row of the edge maximum near row r in column x, Q8.
+static int32_t refineRowQ8(const uint8_t* mag, int w, int h, int x, int r) {
+  int best = r;
+  for (int y = r - 1; y >= r - 2 && y >= 1; y--)
+    if (mag[y * w + x] > mag[best * w + x]) best = y;
+  if (best <= 1 || best >= h - 2) return best << 8;
+  return (best << 8) + parabolaQ8(mag[(best - 1) * w + x], mag[best * w + x],
+                                  mag[(best + 1) * w + x]);
+}
+
+bool tipLocate(const uint8_t* gray, int w, int h, int stride, uint8_t min_strength,
+               uint8_t* mag, int32_t* x_q8, int32_t* y_q8, uint16_t* strength) {
+  if (w < 5 || h < 5 || w > TIP_MAX_W) return false;
+
+  // Sobel |gx|+|gy|, scaled to 0..255
+  uint8_t peak = 0;
+  memset(mag, 0, (size_t)w * h);
+  for (int y = 1; y < h - 1; y++) {
+    const uint8_t* p0 = gray + (y - 1) * stride;
+    const uint8_t* p1 = p0 + stride;
+    const uint8_t* p2 = p1 + stride;
+    uint8_t* m = mag + y * w;
+    for (int x = 1; x < w - 1; x++) {
+      int gx = (p0[x + 1] + 2 * p1[x + 1] + p2[x + 1]) - (p0[x - 1] + 2 * p1[x - 1] + p2[x - 1]);
+      int gy = (p2[x - 1] + 2 * p2[x] + p2[x + 1]) - (p0[x - 1] + 2 * p0[x] + p0[x + 1]);
+      int v = (abs(gx) + abs(gy)) >> 3;
+      if (v > 255) v = 255;
+      m[x] = (uint8_t)v;
+      if (v > peak) peak = (uint8_t)v;
+    }
+  }
+  int thr = peak / 3;
+  if (thr < min_strength) thr = min_strength;
+  if (peak < thr || thr == 0) return false;
+
+  // lowest edge row per column, median-of-3 across columns against speckle
+  int16_t bottom[TIP_MAX_W];
+  for (int x = 0; x < w; x++) {
+    bottom[x] = -1;
+    if (x == 0 || x == w - 1) continue;
+    for (int y = h - 2; y >= 1; y--)
+      if (mag[y * w + x] >= thr) { bottom[x] = (int16_t)y; break; }
+  }
+  int best_x = -1, best_y = -1;
+  for (int x = 2; x < w - 2; x++) {
+    int a = bottom[x - 1], b = bottom[x], c = bottom[x + 1];
+    int med = a > b ? (b > c ? b : (a > c ? c : a)) : (a > c ? a : (b > c ? c : b));
+    if (med < 0 || bottom[x] != med) continue;
+    if (med > best_y) { best_y = med; best_x = x; }
+  }
+  if (best_x < 0) return false;
+
+  // flat tip: centre of the run of columns at the lowest row
+  int run_end = best_x;
+  while (run_end + 1 < w - 2 && bottom[run_end + 1] == best_y) run_end++;
+
+  int32_t yq = refineRowQ8(mag, w, h, best_x, best_y);
+  int32_t xq;
+  if (run_end > best_x) {
+    int cx = (best_x + run_end) / 2;
+    xq = (best_x + run_end) << 7;                 // (a+b)/2 in Q8
+    yq = refineRowQ8(mag, w, h, cx, best_y);
+  } else {
+    int32_t l = bottom[best_x - 1] >= 0 ? refineRowQ8(mag, w, h, best_x - 1, bottom[best_x - 1]) : 0;
+    int32_t r = bottom[best_x + 1] >= 0 ? refineRowQ8(mag, w, h, best_x + 1, bottom[best_x + 1]) : 0;
+    xq = (best_x << 8) + parabolaQ8(l >> 4, yq >> 4, r >> 4);   // Q4 keeps the product small
+  }
+
+  *x_q8 = xq;
+  *y_q8 = yq;
+  *strength = mag[best_y * w + best_x];
+  return true;
+}
@@ -0,0 +1,114 @@
+/**
+ * NozzleCAM compressed-domain brightness / contrast benchmark (host side).
+ *
+ * Encodes a synthetic frame with libjpeg the way the sensor does (4:2:2,
+ * standard Huffman tables), adjusts it with src/jpeg_adjust.cpp for a set of
+ * brightness / contrast pairs and checks each result: it must decode with
+ * libjpeg and match the decoded original mapped through
+ *
+ *   y' = 128 + g * (y - 128) + b
+ *
+ * where g and b are the gain and offset the quantizer steps actually allow
+ * (mean and max |diff| of Y; IDCT rounding and per-frequency rounding of the
+ * tables may differ). A case with restart markers and a grayscale one cover
+ * the other layouts. Time per frame is compared with the pixel way round:
+ * libjpeg decode + per-pixel map + encode.
+ *
+ * Build:  g++ -O2 -I../../include -I../common adjust_bench.cpp ../../src/jpeg_adjust.cpp ../../src/jpeg_scan.cpp ../../src/jpeg_enc.cpp -ljpeg -o adjust_bench
+ * Use:    ./adjust_bench [quality=80] [reps=10]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bench_fixture.h"
+#include "jpeg_adjust.h"
+#include "jpeg_scan.h"
+
+static inline int clamp255(double v) { return v < 0 ? 0 : v > 255 ? 255 : (int)lround(v); }
+
+// Squeeze the scene into 40..193, away from black and white, so the
+// reference map below doesn't have to model clipping of the original.
+static void squeeze(std::vector<uint8_t>& rgb) {
+  for (auto& v : rgb) v = (uint8_t)(40 + v * 0.6);
+}
+
+int main(int argc, char** argv) {
+  int quality = argc > 1 ? atoi(argv[1]) : 80;
+  int reps = argc > 2 ? atoi(argv[2]) : 10;
+  if (reps < 1) reps = 1;
+  struct { const char* name; int w, h, ncomp, restart_rows; } cases[] = {
+    { "qvga", 320, 240, 3, 0 }, { "vga", 640, 480, 3, 0 }, { "svga", 800, 600, 3, 0 },
+    { "xga", 1024, 768, 3, 0 }, { "uxga", 1600, 1200, 3, 0 },
+    { "vga-rst", 640, 480, 3, 1 }, { "vga-gray", 640, 480, 1, 0 },
+  };
+  struct { int b; float c; } adj[] = { { 0, 1.5f }, { 30, 1.0f }, { -40, 1.0f }, { 20, 0.7f }, { -15, 1.3f } };
+
+  printf("quality=%d reps=%d\n", quality, reps);
+  printf("%-8s %5s %5s %6s %6s %9s %9s %6s %6s %8s %9s\n", "case", "b", "c", "gain", "off",
+         "bytes_in", "bytes_out", "mean", "max", "ms", "pixel_ms");
+  bool all_ok = true;
+  for (auto& cs : cases) {
+    std::vector<uint8_t> rgb, src;
+    scene(cs.w, cs.h, rgb);
+    squeeze(rgb);
+    if (cs.ncomp == 1) {
+      src.resize((size_t)cs.w * cs.h);
+      for (size_t i = 0; i < src.size(); i++) src[i] = rgb[3 * i + 1];
+    } else {
+      src = rgb;
+    }
+    std::vector<uint8_t> jpg = libjpegEncode(src.data(), cs.w, cs.h, cs.ncomp, quality, cs.restart_rows);
+    jpeg_info_t info;
+    jpegScanHeaders(jpg.data(), jpg.size(), &info);
+
+    int w, h;
+    std::vector<uint8_t> y0;
+    libjpegDecode(jpg.data(), jpg.size(), JCS_GRAYSCALE, &w, &h, y0);
+
+    for (auto& a : adj) {
+      std::vector<uint8_t> out(jpegAdjustBound(jpg.size()));
+      long n = 0;
+      auto t0 = clk::now();
+      for (int r = 0; r < reps; r++) n = jpegAdjust(jpg.data(), jpg.size(), a.b, a.c, out.data(), out.size());
+      double ms = msSince(t0) / reps;
+
+      // pixel reference: decode, map every sample, encode again
+      t0 = clk::now();
+      for (int r = 0; r < reps; r++) {
+        std::vector<uint8_t> px;
+        int dw, dh;
+        libjpegDecode(jpg.data(), jpg.size(), cs.ncomp == 3 ? JCS_YCbCr : JCS_GRAYSCALE, &dw, &dh, px);
+        for (size_t i = 0; i < px.size(); i += cs.ncomp) px[i] = clamp255(128 + a.c * (px[i] - 128) + a.b);
+        libjpegEncode(px.data(), dw, dh, cs.ncomp, quality, 0);      // YCbCr passes through as "RGB" bytes: same cost
+      }
+      double pixel_ms = msSince(t0) / reps;
+
+      // what the tables allow: DC gain q0'/q0, offset in whole DC steps
+      jpeg_info_t ai;
+      double gain = 0, off = 0, mean = 0;
+      int maxd = -1, gw = 0, gh = 0;
+      std::vector<uint8_t> got;
+      bool ok = n > 0 && jpegScanHeaders(out.data(), n, &ai) == JPEG_SCAN_OK &&
+                libjpegDecode(out.data(), n, JCS_GRAYSCALE, &gw, &gh, got) && gw == w && gh == h;
+      if (ok) {
+        gain = (double)ai.qdc[0] / info.qdc[0];
+        off = lround(8.0 * a.b / ai.qdc[0]) * ai.qdc[0] / 8.0;
+        maxd = 0;
+        for (size_t i = 0; i < got.size(); i++) {
+          int dd = abs(clamp255(128 + gain * (y0[i] - 128) + off) - got[i]);
+          mean += dd;
+          if (dd > maxd) maxd = dd;
+        }
+        mean /= got.size();
+        ok = mean < 1.5;
+      }
+      all_ok &= ok;
+      printf("%-8s %5d %5.2f %6.3f %6.2f %9zu %9ld %6.2f %6d %8.2f %9.2f%s\n", cs.name, a.b, a.c, gain, off,
+             jpg.size(), n, mean, maxd, ms, pixel_ms, ok ? "" : "  FAIL");
+    }
+  }
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/**
+ * Shared fixture for the host JPEG benchmarks (jpeg_bench, rotate_bench,
+ * adjust_bench): the synthetic test scene and libjpeg encode / decode the
+ * way the sensor lays frames out (4:2:2, standard Huffman tables).
+ *
+ * Header only; a bench adds -I../common to its build line.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <jpeglib.h>
+
+using clk = std::chrono::steady_clock;
+
+static inline double msSince(clk::time_point t0) {
+  return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+// Scene in RGB: gradients, a bright bed line, fine texture and noise.
+// Deterministic (srand(7)), so runs compare.
+static void scene(int w, int h, std::vector<uint8_t>& rgb) {
+  rgb.resize((size_t)w * h * 3);
+  srand(7);
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      double fx = (double)x / w, fy = (double)y / h;
+      int r = (int)(60 + 120 * fx + 30 * sin(x * 0.05) + rand() % 12);
+      int g = (int)(50 + 140 * fy + 20 * cos(y * 0.07) + rand() % 12);
+      int b = (int)(90 + 60 * sin((x + y) * 0.01) + rand() % 12);
+      if (fabs(fy - 0.7) < 0.01) r = g = b = 240;
+      uint8_t* p = &rgb[((size_t)y * w + x) * 3];
+      p[0] = r < 0 ? 0 : r > 255 ? 255 : r;
+      p[1] = g < 0 ? 0 : g > 255 ? 255 : g;
+      p[2] = b < 0 ? 0 : b > 255 ? 255 : b;
+    }
+}
+
+// RGB (4:2:2) or gray JPEG with libjpeg; restart_rows > 0 adds DRI markers.
+static std::vector<uint8_t> libjpegEncode(const uint8_t* px, int w, int h, int ncomp, int quality,
+                                          int restart_rows) {
+  jpeg_compress_struct c;
+  jpeg_error_mgr err;
+  c.err = jpeg_std_error(&err);
+  jpeg_create_compress(&c);
+  unsigned char* out = NULL;
+  unsigned long len = 0;
+  jpeg_mem_dest(&c, &out, &len);
+  c.image_width = w;
+  c.image_height = h;
+  c.input_components = ncomp;
+  c.in_color_space = ncomp == 3 ? JCS_RGB : JCS_GRAYSCALE;
+  jpeg_set_defaults(&c);
+  jpeg_set_quality(&c, quality, TRUE);
+  if (ncomp == 3) {
+    c.comp_info[0].h_samp_factor = 2;
+    c.comp_info[0].v_samp_factor = 1;
+  }
+  c.restart_in_rows = restart_rows;
+  jpeg_start_compress(&c, TRUE);
+  while (c.next_scanline < (unsigned)h) {
+    JSAMPROW row = (JSAMPROW)&px[(size_t)c.next_scanline * w * ncomp];
+    jpeg_write_scanlines(&c, &row, 1);
+  }
+  jpeg_finish_compress(&c);
+  jpeg_destroy_compress(&c);
+  std::vector<uint8_t> v(out, out + len);
+  free(out);
+  return v;
+}
+
+// Decode to color space cs. False on a broken header or any libjpeg
+// warning (corrupt data, bad restart markers).
+static bool libjpegDecode(const uint8_t* jpg, size_t len, J_COLOR_SPACE cs, int* w, int* h,
+                          std::vector<uint8_t>& px) {
+  jpeg_decompress_struct d;
+  jpeg_error_mgr err;
+  d.err = jpeg_std_error(&err);
+  jpeg_create_decompress(&d);
+  jpeg_mem_src(&d, jpg, len);
+  bool ok = jpeg_read_header(&d, TRUE) == JPEG_HEADER_OK;
+  if (ok) {
+    d.out_color_space = cs;
+    jpeg_start_decompress(&d);
+    *w = d.output_width;
+    *h = d.output_height;
+    int n = d.output_components;
+    px.resize((size_t)*w * *h * n);
+    while (d.output_scanline < d.output_height) {
+      JSAMPROW row = &px[(size_t)d.output_scanline * *w * n];
+      jpeg_read_scanlines(&d, &row, 1);
+    }
+    ok = err.num_warnings == 0;
+    jpeg_finish_decompress(&d);
+  }
+  jpeg_destroy_decompress(&d);
+  return ok;
+}
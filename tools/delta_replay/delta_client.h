@@ -0,0 +1,104 @@
+/**
+ * NozzleCAM block-delta client (host side, header-only).
+ *
+ * Reassembles the /delta stream (src/jpeg_delta.h): a keyframe is a plain
+ * JPEG and replaces the picture; a patch carries the changed MCUs as one
+ * small JPEG strip, decoded with libjpeg and copied MCU by MCU to the grid
+ * positions in its index. The picture is RGB, 3 bytes per pixel.
+ *
+ * Fancy (smoothing) chroma upsampling reads across MCU edges, so a strip
+ * decodes slightly differently at the edges of each patch than the same
+ * MCUs inside the full frame. With fancy = false (box upsampling) every MCU
+ * decodes on its own and a patched picture is bit-exact with decoding the
+ * original frame the same way; browsers always smooth, which leaves faint
+ * seams until the next keyframe.
+ */
+#pragma once
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <jpeglib.h>
+
+class DeltaClient {
+public:
+  explicit DeltaClient(bool fancy = false) : fancy_(fancy) {
+    d_.err = jpeg_std_error(&err_.pub);
+    err_.pub.error_exit = [](j_common_ptr c) { longjmp(((Err*)c->err)->jb, 1); };
+    err_.pub.emit_message = [](j_common_ptr, int) {};
+    jpeg_create_decompress(&d_);
+  }
+  ~DeltaClient() { jpeg_destroy_decompress(&d_); }
+  DeltaClient(const DeltaClient&) = delete;
+  DeltaClient& operator=(const DeltaClient&) = delete;
+
+  // One multipart body: a JPEG (keyframe) or an NZD1 patch.
+  bool feed(const uint8_t* p, size_t len) {
+    if (len >= 4 && !memcmp(p, "NZD1", 4)) return patch(p, len);
+    return decode(p, len, &rgb_, &w_, &h_);
+  }
+
+  bool patch(const uint8_t* p, size_t len) {
+    if (len < 16 || memcmp(p, "NZD1", 4) || rgb_.empty()) return false;
+    int mx = get16(p + 4), my = get16(p + 6), mw = p[8], mh = p[9];
+    int count = get16(p + 10), cols = get16(p + 12);
+    if (mx * mw < w_ || my * mh < h_ || (size_t)16 + 2 * count > len) return false;
+    if (!count) return true;                                // heartbeat: nothing changed
+    const uint8_t* idx = p + 16;
+    int sw, sh;
+    if (!cols || !decode(idx + 2 * count, len - 16 - 2 * count, &strip_, &sw, &sh)) return false;
+    if (sw < cols * mw || sh < (count + cols - 1) / cols * mh) return false;
+    for (int k = 0; k < count; k++) {
+      int m = get16(idx + 2 * k);
+      if (m >= mx * my) return false;
+      int dx = m % mx * mw, dy = m / mx * mh, sx = k % cols * mw, sy = k / cols * mh;
+      int cw = dx + mw <= w_ ? mw : w_ - dx;                 // edge MCUs hang over the image
+      for (int y = 0; y < mh && dy + y < h_; y++)
+        memcpy(&rgb_[((size_t)(dy + y) * w_ + dx) * 3], &strip_[((size_t)(sy + y) * sw + sx) * 3], (size_t)cw * 3);
+    }
+    return true;
+  }
+
+  const std::vector<uint8_t>& rgb() const { return rgb_; }
+  int width() const { return w_; }
+  int height() const { return h_; }
+
+  // Any JPEG to RGB the way the client decodes (same upsampling).
+  bool decode(const uint8_t* jpg, size_t len, std::vector<uint8_t>* out, int* w, int* h) {
+    if (setjmp(err_.jb)) {
+      jpeg_abort_decompress(&d_);
+      return false;
+    }
+    jpeg_mem_src(&d_, jpg, len);
+    if (jpeg_read_header(&d_, TRUE) != JPEG_HEADER_OK) return false;
+    d_.out_color_space = JCS_RGB;
+    d_.do_fancy_upsampling = fancy_ ? TRUE : FALSE;
+    d_.dct_method = JDCT_ISLOW;
+    jpeg_start_decompress(&d_);
+    *w = d_.output_width;
+    *h = d_.output_height;
+    out->resize((size_t)*w * *h * 3);
+    while (d_.output_scanline < d_.output_height) {
+      JSAMPROW row = &(*out)[(size_t)d_.output_scanline * *w * 3];
+      jpeg_read_scanlines(&d_, &row, 1);
+    }
+    jpeg_finish_decompress(&d_);
+    return true;
+  }
+
+private:
+  struct Err {
+    jpeg_error_mgr pub;
+    jmp_buf        jb;
+  };
+
+  static int get16(const uint8_t* p) { return p[0] | p[1] << 8; }
+
+  bool                   fancy_;
+  jpeg_decompress_struct d_;
+  Err                    err_;
+  std::vector<uint8_t>   rgb_, strip_;
+  int                    w_ = 0, h_ = 0;
+};
@@ -0,0 +1,338 @@
+/**
+ * NozzleCAM block-delta stream replay (host side).
+ *
+ * Runs a recorded session through the /delta sender logic of the firmware
+ * (src/jpeg_delta.cpp, same keyframe rules) for a range of thresholds and
+ * reassembles every frame with delta_client.h. Per threshold: bytes sent vs.
+ * the plain MJPEG stream (multipart headers included on both sides),
+ * keyframes, share of MCUs sent, sender time per frame, and the picture
+ * quality the viewer ends up with: PSNR of the reassembled frame against
+ * the decoded original (mean and worst frame; "exact" when identical).
+ *
+ * A session is a multipart dump of /stream, concatenated JPEGs, or "synth":
+ * a static scene with sensor noise where a bright nozzle moves for a third
+ * of the time, encoded 4:2:2 with src/jpeg_enc.cpp.
+ *
+ * Live mode reads /delta from a unit and reports fps, bandwidth against the
+ * source frames (X-Source-Length) and reassembly errors.
+ *
+ * Build:  g++ -O2 -std=c++17 -I../../include delta_replay.cpp ../../src/jpeg_delta.cpp ../../src/jpeg_scan.cpp ../../src/jpeg_enc.cpp -ljpeg -o delta_replay
+ * Use:    curl -s --max-time 60 http://192.168.4.1/stream > session.mjpeg
+ *         ./delta_replay session.mjpeg [key seconds=10] [fps=20]
+ *         ./delta_replay synth [key seconds=10] [fps=20] [size=vga] [frames=300]
+ *         ./delta_replay live <host> [seconds=20] [key=10] [thr=6]
+ */
+#include <math.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "delta_client.h"
+#include "jpeg_delta.h"
+#include "jpeg_enc.h"
+#include "jpeg_scan.h"
+
+using clk = std::chrono::steady_clock;
+using Frame = std::vector<uint8_t>;
+
+#define PART_HEADER 64                // "--frame\r\nContent-Type: ...\r\nContent-Length: n\r\n\r\n" + CRLF
+
+static const int THRESHOLDS[] = { 0, 2, 4, 6, 8, 12 };
+
+// ---------- sessions ----------
+
+static bool readFile(const char* path, std::string* data) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data->append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// Bodies of a multipart dump, or SOI .. EOI runs of concatenated JPEGs.
+static std::vector<Frame> splitSession(const std::string& s) {
+  std::vector<Frame> frames;
+  if (s.find("Content-Length:") != std::string::npos) {
+    for (size_t p = 0;;) {
+      size_t cl = s.find("Content-Length:", p);
+      size_t eoh = cl == std::string::npos ? cl : s.find("\r\n\r\n", cl);
+      if (eoh == std::string::npos) break;
+      size_t len = strtoul(s.c_str() + cl + 15, NULL, 10);
+      if (eoh + 4 + len > s.size()) break;                   // cut off by the recording's end
+      frames.emplace_back(s.begin() + eoh + 4, s.begin() + eoh + 4 + len);
+      p = eoh + 4 + len;
+    }
+    return frames;
+  }
+  for (size_t p = 0;;) {
+    size_t soi = s.find("\xFF\xD8", p), eoi = soi == std::string::npos ? soi : s.find("\xFF\xD9", soi + 2);
+    if (eoi == std::string::npos) break;
+    frames.emplace_back(s.begin() + soi, s.begin() + eoi + 2);
+    p = eoi + 2;
+  }
+  return frames;
+}
+
+// Bed texture, a part edge and a nozzle that moves during the middle third
+// and rests otherwise; sensor noise on every pixel.
+static std::vector<Frame> synthSession(int w, int h, int count) {
+  jpeg_enc_t e;
+  jpegEncInit(&e, w, h, JPEG_ENC_YUV422, 80);
+  std::vector<uint8_t> src((size_t)w * h * 2), out((size_t)w * h * 2 + 4096);
+  std::vector<Frame> frames;
+  srand(5);
+  for (int f = 0; f < count; f++) {
+    double t = f < count / 3 ? 0 : f < 2 * count / 3 ? (double)(f - count / 3) / (count / 3) : 1;
+    double cx = w * (0.25 + 0.5 * t), cy = h * (0.45 + 0.1 * sin(t * 12));
+    for (int y = 0; y < h; y++)
+      for (int x = 0; x < w; x++) {
+        double d2 = ((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (w * w * 0.0015);
+        int v = (int)(60 + 30 * sin(x * 0.11) * cos(y * 0.07) + (y > h * 0.7 ? 50 : 0) +
+                      140 * exp(-d2) + rand() % 7 - 3);
+        uint8_t* p = &src[((size_t)y * w + x) * 2];
+        p[0] = v < 0 ? 0 : v > 255 ? 255 : v;
+        p[1] = (uint8_t)(x & 1 ? 120 + (y > h * 0.7 ? 12 : 0) : 134);
+      }
+    size_t n = jpegEncHeader(&e, out.data(), out.size());
+    long r = jpegEncRows(&e, src.data(), 0, e.mcus_y, out.data() + n, out.size() - n - 2);
+    if (r < 0) break;
+    n += r;
+    out[n++] = 0xFF;
+    out[n++] = 0xD9;
+    frames.emplace_back(out.begin(), out.begin() + n);
+  }
+  return frames;
+}
+
+// ---------- replay ----------
+
+struct Result {
+  uint64_t full = 0, sent = 0, keys = 0, patches = 0, mcus = 0, changed = 0;
+  double   ms = 0, psnr_sum = 0, psnr_min = 1e9;
+  int      exact = 0, bad = 0;
+};
+
+static double psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  if (a.size() != b.size() || a.empty()) return 0;
+  double se = 0;
+  for (size_t i = 0; i < a.size(); i++) se += (double)(a[i] - b[i]) * (a[i] - b[i]);
+  return se ? 10 * log10(255.0 * 255.0 * a.size() / se) : INFINITY;
+}
+
+// The firmware's deltaBody, minus the network.
+static Result replay(const std::vector<Frame>& frames, int threshold, int key_frames) {
+  Result r;
+  jpeg_info_t info;
+  if (jpegScanHeaders(frames[0].data(), frames[0].size(), &info) != JPEG_SCAN_OK) return r;
+  const int mcus = info.mcus_x * info.mcus_y, blocks = info.h[0] * info.v[0] + info.ncomp - 1;
+  std::vector<uint8_t> mem(jpegDeltaBytes(mcus, blocks)), out, orig;
+  jpeg_delta_t d;
+  jpegDeltaInit(&d, mcus, blocks, threshold, mem.data());
+  DeltaClient client;
+  bool keyed = false;
+  int since_key = 0;
+  for (const Frame& f : frames) {
+    auto t0 = clk::now();
+    long n = -1;
+    int changed = 0;
+    if (keyed && since_key < key_frames) {
+      out.resize(jpegDeltaBound(f.size(), mcus));
+      n = jpegDeltaPatch(&d, f.data(), f.size(), out.data(), out.size(), &changed);
+    }
+    if (n < 0) keyed = jpegDeltaKey(&d, f.data(), f.size()) == JPEG_SCAN_OK;
+    r.ms += std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+
+    const uint8_t* body = n < 0 ? f.data() : out.data();
+    size_t len = n < 0 ? f.size() : (size_t)n;
+    r.full += f.size() + PART_HEADER;
+    r.sent += len + PART_HEADER;
+    r.mcus += mcus;
+    if (n < 0) {
+      r.keys++;
+      r.changed += mcus;
+      since_key = 0;
+    } else {
+      r.patches++;
+      r.changed += changed;
+      since_key++;
+    }
+
+    int w, h;
+    if (!client.feed(body, len) || !client.decode(f.data(), f.size(), &orig, &w, &h)) {
+      r.bad++;
+      continue;
+    }
+    double p = psnr(client.rgb(), orig);
+    if (std::isinf(p)) {
+      r.exact++;
+      p = 99;
+    }
+    r.psnr_sum += p;
+    if (p < r.psnr_min) r.psnr_min = p;
+  }
+  return r;
+}
+
+static int replayMain(int argc, char** argv) {
+  double key_s = argc > 2 ? atof(argv[2]) : 10;
+  double fps = argc > 3 ? atof(argv[3]) : 20;
+  std::vector<Frame> frames;
+  if (!strcmp(argv[1], "synth")) {
+    struct { const char* name; int w, h; } sizes[] = {
+      { "qvga", 320, 240 }, { "vga", 640, 480 }, { "svga", 800, 600 }, { "uxga", 1600, 1200 },
+    };
+    int w = 640, h = 480;
+    for (auto& z : sizes)
+      if (argc > 4 && !strcmp(argv[4], z.name)) {
+        w = z.w;
+        h = z.h;
+      }
+    frames = synthSession(w, h, argc > 5 ? atoi(argv[5]) : 300);
+  } else {
+    std::string data;
+    if (!readFile(argv[1], &data)) {
+      perror(argv[1]);
+      return 1;
+    }
+    frames = splitSession(data);
+  }
+  jpeg_info_t info;
+  if (frames.empty() || jpegScanHeaders(frames[0].data(), frames[0].size(), &info) != JPEG_SCAN_OK) {
+    fprintf(stderr, "no frames in %s\n", argv[1]);
+    return 1;
+  }
+  int key_frames = (int)(key_s * fps + 0.5);
+  printf("session %s: %zu frames %dx%d (%d MCUs), keyframe every %d frames (%.0f s at %.0f fps)\n",
+         argv[1], frames.size(), info.width, info.height, info.mcus_x * info.mcus_y, key_frames, key_s, fps);
+  printf("%5s %10s %10s %7s %6s %8s %8s %9s %9s %6s %4s\n", "thr", "full_kB", "delta_kB", "ratio",
+         "keys", "mcus_%", "ms/frm", "psnr_avg", "psnr_min", "exact", "bad");
+  bool ok = true;
+  for (int t : THRESHOLDS) {
+    Result r = replay(frames, t, key_frames);
+    size_t good = frames.size() - r.bad;
+    printf("%5d %10.1f %10.1f %6.1f%% %6llu %8.1f %8.2f %9.1f %9.1f %6d %4d\n", t, r.full / 1024.0,
+           r.sent / 1024.0, 100.0 * r.sent / r.full, (unsigned long long)r.keys,
+           100.0 * r.changed / r.mcus, r.ms / frames.size(), good ? r.psnr_sum / good : 0,
+           good ? r.psnr_min : 0, r.exact, r.bad);
+    ok &= r.bad == 0;
+  }
+  printf("(psnr in dB against the decoded original, 99 = identical)\n");
+  if (!ok) printf("FAIL\n");
+  return ok ? 0 : 1;
+}
+
+// ---------- live ----------
+
+static int openStream(const char* host, const std::string& path) {
+  addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, "80", &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, 0);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return -1;
+  timeval tv = { 5, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\n\r\n";
+  if (send(fd, req.data(), req.size(), 0) != (ssize_t)req.size()) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static size_t headerValue(const std::string& h, const char* name) {
+  size_t p = h.find(name);
+  return p == std::string::npos ? 0 : strtoul(h.c_str() + p + strlen(name), NULL, 10);
+}
+
+static int liveMain(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s live <host> [seconds=20] [key=10] [thr=6]\n", argv[0]);
+    return 2;
+  }
+  const char* host = argv[2];
+  double secs = argc > 3 ? atof(argv[3]) : 20;
+  std::string path = std::string("/delta?key=") + (argc > 4 ? argv[4] : "10") + "&thr=" + (argc > 5 ? argv[5] : "6");
+  int fd = openStream(host, path);
+  if (fd < 0) {
+    fprintf(stderr, "can't connect to %s\n", host);
+    return 1;
+  }
+  printf("http://%s%s for %.0f s\n", host, path.c_str(), secs);
+  DeltaClient client(true);
+  std::string buf;
+  bool head = true;
+  char chunk[16384];
+  uint64_t keys = 0, patches = 0, bad = 0, sent = 0, full = 0, frames = 0;
+  auto t0 = clk::now(), win = t0;
+  uint64_t win_frames = 0, win_sent = 0, win_full = 0;
+  while (std::chrono::duration<double>(clk::now() - t0).count() < secs) {
+    ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+    if (r <= 0) break;
+    buf.append(chunk, r);
+    for (;;) {
+      size_t eoh = buf.find("\r\n\r\n");
+      if (eoh == std::string::npos) break;
+      std::string h = buf.substr(0, eoh);
+      size_t len = headerValue(h, "Content-Length:");
+      if (head || !len) {                                    // response header / stray blank lines
+        head = false;
+        buf.erase(0, eoh + 4);
+        continue;
+      }
+      if (buf.size() < eoh + 4 + len) break;
+      const uint8_t* body = (const uint8_t*)buf.data() + eoh + 4;
+      bool patch = len >= 4 && !memcmp(body, "NZD1", 4);
+      size_t src = patch ? headerValue(h, "X-Source-Length:") : len;
+      (patch ? patches : keys)++;
+      if (!client.feed(body, len)) bad++;
+      frames++;
+      sent += len + PART_HEADER;
+      full += src + PART_HEADER;
+      win_frames++;
+      win_sent += len + PART_HEADER;
+      win_full += src + PART_HEADER;
+      buf.erase(0, eoh + 4 + len);
+    }
+    double ws = std::chrono::duration<double>(clk::now() - win).count();
+    if (ws >= 5) {
+      printf("fps=%.1f delta=%.1f kB/s full=%.1f kB/s (%.0f%%) keys=%llu patches=%llu bad=%llu\n",
+             win_frames / ws, win_sent / 1024.0 / ws, win_full / 1024.0 / ws,
+             win_full ? 100.0 * win_sent / win_full : 0, (unsigned long long)keys,
+             (unsigned long long)patches, (unsigned long long)bad);
+      fflush(stdout);
+      win = clk::now();
+      win_frames = win_sent = win_full = 0;
+    }
+  }
+  close(fd);
+  double s = std::chrono::duration<double>(clk::now() - t0).count();
+  printf("%llu frames (%llu keys, %llu patches) in %.1f s: %.1f kB/s, %.0f%% of the full stream, %llu bad\n",
+         (unsigned long long)frames, (unsigned long long)keys, (unsigned long long)patches, s,
+         sent / 1024.0 / s, full ? 100.0 * sent / full : 0, (unsigned long long)bad);
+  return frames && !bad ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <session.mjpeg|frames.jpg|synth> [key seconds=10] [fps=20] [size] [frames]\n"
+                    "       %s live <host> [seconds=20] [key=10] [thr=6]\n", argv[0], argv[0]);
+    return 2;
+  }
+  if (!strcmp(argv[1], "live")) return liveMain(argc, argv);
+  return replayMain(argc, argv);
+}
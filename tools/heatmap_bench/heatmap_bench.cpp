@@ -0,0 +1,185 @@
+/**
+ * NozzleCAM motion heatmap benchmark (host side).
+ *
+ * Feeds synthetic per-block AC energies (textured background, sensor noise,
+ * a small "hornet" walking a fixed path) through src/heatmap_accum.cpp and
+ * reports the per-frame update cost (block adds + fold), the decay and the
+ * render, plus how much of the heat ended up on the path.
+ *
+ * Then the whole per-frame stage as heatmap.cpp runs it: the same kind of
+ * scene is encoded with src/jpeg_enc.cpp (4:2:2 like the sensor) at every
+ * stream framesize, and the entropy scan for luma AC energies
+ * (src/jpeg_scan.cpp) plus the update is timed on the encoded frames. The
+ * scan is nearly all of it; the QoS budget in heatmap.cpp is sized from
+ * these numbers.
+ *
+ * Build:  g++ -O2 -I../../include heatmap_bench.cpp ../../src/heatmap_accum.cpp ../../src/jpeg_scan.cpp ../../src/jpeg_enc.cpp -o heatmap_bench
+ * Use:    ./heatmap_bench [width=1600] [height=1200] [frames=3000] [quality=80]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "heatmap_accum.h"
+#include "jpeg_enc.h"
+#include "jpeg_scan.h"
+
+using clk = std::chrono::steady_clock;
+
+static void blockEnergy(void* ctx, int comp, int bx, int by, int dc, int ac) {
+  (void)comp; (void)dc;
+  heatmapAddBlock((heatmap_t*)ctx, bx, by, ac);
+}
+
+// YUV422 frame: textured bed with noise, a dark blob (the hornet) at (hx, hy).
+static void scene(int w, int h, int hx, int hy, std::mt19937& rng, std::vector<uint8_t>& yuv) {
+  yuv.resize((size_t)w * h * 2);
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      int v = 110 + (int)(40 * sinf(x * 0.07f) * cosf(y * 0.05f)) + (int)(rng() % 8) - 4;
+      if ((x - hx) * (x - hx) + (y - hy) * (y - hy) < (w / 40) * (w / 40)) v = 30 + rng() % 16;
+      uint8_t* p = &yuv[((size_t)y * w + x) * 2];
+      p[0] = (uint8_t)(x & 1 ? 130 + (rng() % 4) : 124 + (rng() % 4));   // U / V
+      p[1] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+  for (size_t i = 0; i + 3 < yuv.size(); i += 4) {   // Y0 U Y1 V order
+    uint8_t u = yuv[i], y0 = yuv[i + 1], v = yuv[i + 2], y1 = yuv[i + 3];
+    yuv[i] = y0; yuv[i + 1] = u; yuv[i + 2] = y1; yuv[i + 3] = v;
+  }
+}
+
+// Scan + update per encoded frame, as processFrame() does it.
+static void endToEnd(int quality) {
+  static const struct { const char* name; int w, h; } SIZES[] = {
+    { "qvga", 320, 240 }, { "vga", 640, 480 }, { "svga", 800, 600 }, { "xga", 1024, 768 },
+    { "hd", 1280, 720 }, { "sxga", 1280, 1024 }, { "uxga", 1600, 1200 },
+  };
+  printf("end to end (scan + update) on encoded frames, quality %d\n", quality);
+  std::mt19937 rng(2);
+  for (const auto& sz : SIZES) {
+    jpeg_enc_t e;
+    if (!jpegEncInit(&e, sz.w, sz.h, JPEG_ENC_YUV422, quality)) continue;
+    const int n = 8;
+    std::vector<std::vector<uint8_t>> jpgs(n);
+    std::vector<uint8_t> yuv;
+    size_t bytes = 0;
+    for (int f = 0; f < n; f++) {
+      scene(sz.w, sz.h, sz.w / 4 + f * sz.w / 16, sz.h / 2, rng, yuv);
+      std::vector<uint8_t>& j = jpgs[f];
+      j.resize((size_t)sz.w * sz.h * 2 + JPEG_ENC_HEADER_MAX);
+      size_t hl = jpegEncHeader(&e, j.data(), j.size());
+      long bl = jpegEncRows(&e, yuv.data(), 0, e.mcus_y, j.data() + hl, j.size() - hl - 2);
+      if (!hl || bl < 0) { j.clear(); continue; }
+      j.resize(hl + bl + 2);
+      j[hl + bl] = 0xFF;
+      j[hl + bl + 1] = 0xD9;
+      bytes += j.size();
+    }
+    jpeg_info_t info;
+    if (jpgs[0].empty() || jpegScanHeaders(jpgs[0].data(), jpgs[0].size(), &info) != JPEG_SCAN_OK) {
+      printf("  %-5s encode failed\n", sz.name);
+      continue;
+    }
+    int cols = heatmapCells((info.width + 7) / 8), rows = heatmapCells((info.height + 7) / 8);
+    std::vector<uint8_t> mem(heatmapBytes(cols, rows));
+    heatmap_t hm;
+    heatmapInit(&hm, cols, rows, mem.data());
+
+    int reps = 0, errors = 0;
+    double scan_us = 0, upd_us = 0;
+    while (scan_us + upd_us < 300000 || reps < 2 * n) {
+      const std::vector<uint8_t>& j = jpgs[reps++ % n];
+      auto t0 = clk::now();
+      if (jpegScanHeaders(j.data(), j.size(), &info) != JPEG_SCAN_OK ||
+          jpegScan(j.data(), j.size(), JPEG_SCAN_AC | JPEG_SCAN_LUMA_ONLY, blockEnergy, &hm, NULL) != JPEG_SCAN_OK)
+        errors++;
+      auto t1 = clk::now();
+      heatmapUpdate(&hm, 24);
+      scan_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+      upd_us += std::chrono::duration<double, std::micro>(clk::now() - t1).count();
+    }
+    printf("  %-5s %4dx%-4d %6.1f KB  scan %7.0f us + update %5.0f us = %7.0f us/frame%s\n",
+           sz.name, sz.w, sz.h, bytes / 1024.0 / n, scan_us / reps, upd_us / reps,
+           (scan_us + upd_us) / reps, errors ? "  SCAN ERRORS" : "");
+  }
+}
+
+int main(int argc, char** argv) {
+  int w = argc > 1 ? atoi(argv[1]) : 1600, h = argc > 2 ? atoi(argv[2]) : 1200;
+  int frames = argc > 3 ? atoi(argv[3]) : 3000;
+  int quality = argc > 4 ? atoi(argv[4]) : 80;
+  int bw = (w + 7) / 8, bh = (h + 7) / 8;
+  int cols = heatmapCells(bw), rows = heatmapCells(bh);
+
+  std::vector<uint8_t> mem(heatmapBytes(cols, rows));
+  heatmap_t hm;
+  heatmapInit(&hm, cols, rows, mem.data());
+
+  std::mt19937 rng(1);
+  std::vector<int> texture((size_t)bw * bh);
+  for (auto& t : texture) t = 20 + rng() % 200;          // static detail per block
+  std::normal_distribution<float> noise(0.0f, 4.0f);
+  std::vector<float> noise_tab(1 << 16);
+  for (auto& v : noise_tab) v = noise(rng);
+
+  // hornet: ~6x6 blocks, walks an ellipse through the entrance
+  std::vector<int> path_x(frames), path_y(frames);
+  for (int f = 0; f < frames; f++) {
+    path_x[f] = (int)(bw / 2 + bw / 3 * cosf(f * 0.02f));
+    path_y[f] = (int)(bh / 2 + bh / 4 * sinf(f * 0.02f));
+  }
+  auto onPath = [&](int bx, int by, int f) { return abs(bx - path_x[f]) < 3 && abs(by - path_y[f]) < 3; };
+
+  double add_us = 0, upd_us = 0, dec_us = 0;
+  uint32_t n_noise = 0;
+  for (int f = 0; f < frames; f++) {
+    auto t0 = clk::now();
+    for (int by = 0; by < bh; by++)
+      for (int bx = 0; bx < bw; bx++) {
+        int e = texture[(size_t)by * bw + bx] + (int)noise_tab[n_noise++ & 0xFFFF];
+        if (onPath(bx, by, f)) e += 300;
+        heatmapAddBlock(&hm, bx, by, e < 0 ? 0 : e);
+      }
+    auto t1 = clk::now();
+    heatmapUpdate(&hm, 24);
+    auto t2 = clk::now();
+    add_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+    upd_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+    if (f % 25 == 24) {                                 // once a second at 25 fps
+      auto d0 = clk::now();
+      heatmapDecay(&hm, heatmapDecayFactor(1000, 3600));
+      dec_us += std::chrono::duration<double, std::micro>(clk::now() - d0).count();
+    }
+  }
+
+  std::vector<uint8_t> rgb((size_t)cols * rows * 3 * 16);
+  auto r0 = clk::now();
+  heatmapRender(&hm, NULL, 4, rgb.data());
+  double render_us = std::chrono::duration<double, std::micro>(clk::now() - r0).count();
+
+  // share of the heat on cells the hornet ever visited
+  double on = 0, all = 0;
+  std::vector<bool> visited((size_t)cols * rows);
+  for (int f = 0; f < frames; f++)
+    for (int by = 0; by < bh; by++)
+      for (int bx = 0; bx < bw; bx++)
+        if (onPath(bx, by, f) && heatmapCells(bx) < cols && heatmapCells(by) < rows)
+          visited[(size_t)heatmapCells(by) * cols + heatmapCells(bx)] = true;
+  size_t nv = 0;
+  for (size_t i = 0; i < visited.size(); i++) {
+    all += hm.heat[i];
+    if (visited[i]) { on += hm.heat[i]; nv++; }
+  }
+
+  printf("%dx%d  %dx%d cells  %d frames\n", w, h, cols, rows, frames);
+  printf("per frame: block adds %.0f us + update %.0f us = %.0f us\n",
+         add_us / frames, upd_us / frames, (add_us + upd_us) / frames);
+  printf("decay %.0f us/s  render x4 %.0f us\n", dec_us / (frames / 25), render_us);
+  printf("heat on path: %.1f%% (path covers %.1f%% of cells)\n",
+         all ? 100 * on / all : 0, 100.0 * nv / visited.size());
+  endToEnd(quality);
+  return 0;
+}
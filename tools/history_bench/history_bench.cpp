@@ -0,0 +1,116 @@
+/**
+ * NozzleCAM telemetry history codec benchmark (host side).
+ *
+ * Encodes a synthetic day of 1 Hz samples (idle hours, streaming sessions
+ * with fps/throughput/RSSI jitter, slowly draining battery) into 1 KB blocks,
+ * verifies the round trip and prints storage and codec speed.
+ *
+ * Build:  g++ -O2 -I../../include history_bench.cpp ../../src/history_codec.cpp -o history_bench
+ * Use:    ./history_bench [seconds=86400] [block bytes=1024]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "history_codec.h"
+
+static uint32_t rng = 12345;
+static int rnd(int n) { rng = rng * 1103515245u + 12345u; return (int)((rng >> 16) % (uint32_t)n); }
+
+static std::vector<hist_sample_t> synthesize(uint32_t secs) {
+  std::vector<hist_sample_t> out(secs);
+  bool streaming = false;
+  uint32_t switch_at = 0;
+  int heap = 180, batt = 100, rssi = -55;
+  for (uint32_t t = 0; t < secs; t++) {
+    if (t >= switch_at) {                       // sessions of 5..60 min, gaps of 10..120 min
+      streaming = !streaming;
+      switch_at = t + (streaming ? 300 + rnd(3300) : 600 + rnd(6600));
+    }
+    hist_sample_t& s = out[t];
+    if (rnd(600) == 0) heap += rnd(9) - 4;
+    if (t % 900 == 0 && batt > 5) batt--;
+    if (streaming) {
+      rssi += rnd(3) - 1;
+      if (rssi < -80) rssi = -80;
+      if (rssi > -40) rssi = -40;
+      s.v[HIST_FPS_X10] = 98 + rnd(5);
+      s.v[HIST_KBPS]    = 190 + rnd(40);
+      s.v[HIST_CLIENTS] = 1;
+      s.v[HIST_RSSI]    = rssi;
+      s.v[HIST_HEAP_KB] = heap - 12;
+    } else {
+      s.v[HIST_FPS_X10] = 0;
+      s.v[HIST_KBPS]    = 0;
+      s.v[HIST_CLIENTS] = 0;
+      s.v[HIST_RSSI]    = 0;
+      s.v[HIST_HEAP_KB] = heap;
+    }
+    s.v[HIST_BATTERY] = batt;
+  }
+  return out;
+}
+
+struct Check {
+  const std::vector<hist_sample_t>* ref;
+  uint32_t next;
+  bool ok;
+};
+
+static void verify(uint32_t t, const hist_sample_t& s, void* ctx) {
+  Check* c = (Check*)ctx;
+  if (t != c->next || memcmp(&s, &(*c->ref)[t], sizeof(s)) != 0) c->ok = false;
+  c->next = t + 1;
+}
+
+static void sink(uint32_t t, const hist_sample_t& s, void* ctx) {
+  *(uint64_t*)ctx += t + s.v[HIST_KBPS];
+}
+
+int main(int argc, char** argv) {
+  uint32_t secs = argc > 1 ? (uint32_t)atoi(argv[1]) : 86400;
+  size_t block = argc > 2 ? (size_t)atoi(argv[2]) : 1024;
+  std::vector<hist_sample_t> samples = synthesize(secs);
+
+  using clk = std::chrono::steady_clock;
+  std::vector<std::vector<uint8_t>> blocks;
+  hist_encoder_t enc;
+  auto t0 = clk::now();
+  for (uint32_t t = 0; t < secs; t++) {
+    if (blocks.empty() || !histBlockAppend(&enc, t, samples[t])) {
+      blocks.emplace_back(block);
+      histBlockBegin(&enc, blocks.back().data(), block, t, samples[t]);
+    }
+  }
+  double enc_ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+
+  Check c = { &samples, 0, true };
+  for (auto& b : blocks)
+    if (histBlockDecode(b.data(), b.size(), verify, &c) < 0) c.ok = false;
+  if (!c.ok || c.next != secs) {
+    printf("round trip FAILED at t=%u\n", c.next);
+    return 1;
+  }
+
+  const int reps = 20;
+  uint64_t acc = 0;
+  t0 = clk::now();
+  for (int r = 0; r < reps; r++)
+    for (auto& b : blocks) histBlockDecode(b.data(), b.size(), sink, &acc);
+  double dec_ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count() / reps;
+
+  size_t payload = 0;
+  for (auto& b : blocks) payload += b[6] | (b[7] << 8);
+  size_t raw = (size_t)secs * sizeof(hist_sample_t);
+  printf("samples        %u (%.1f h)\n", secs, secs / 3600.0);
+  printf("blocks         %zu x %zu B = %zu KB (payload %zu KB, fill %.0f%%)\n", blocks.size(),
+         block, blocks.size() * block / 1024, payload / 1024, 100.0 * payload / (blocks.size() * block));
+  printf("bytes/sample   %.2f (raw struct %zu, ratio %.1fx)\n", (double)payload / secs,
+         sizeof(hist_sample_t), (double)raw / payload);
+  printf("encode         %.1f ns/sample\n", enc_ns / secs);
+  printf("decode         %.1f ns/sample (%.0f Msamples/s)  [%llu]\n", dec_ns / secs,
+         secs / dec_ns * 1000.0, (unsigned long long)(acc & 0xF));
+  return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * NozzleCAM strip JPEG encoder benchmark (host side).
+ *
+ * Encodes a synthetic frame in every source format the sensor can deliver
+ * with src/jpeg_enc.cpp, once as a single strip and once as two strips on
+ * two threads (the firmware's two-core split), and checks the results:
+ * both must be byte-identical, decode with libjpeg and match the source
+ * (PSNR of Y). libjpeg's own encoder (4:2:2, islow DCT) is timed as a
+ * reference for the single-core path.
+ *
+ * Build:  g++ -O2 -pthread -I../../include -I../common jpeg_bench.cpp ../../src/jpeg_enc.cpp -ljpeg -o jpeg_bench
+ * Use:    ./jpeg_bench [quality=80] [reps=5]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "bench_fixture.h"
+#include "jpeg_enc.h"
+
+static inline int lumaOf(int r, int g, int b) {
+  return (int)(0.299 * r + 0.587 * g + 0.114 * b + 0.5);
+}
+
+// Source buffer in the given format plus its reference luma.
+static void toFormat(const std::vector<uint8_t>& rgb, int w, int h, jpeg_enc_format_t fmt,
+                     std::vector<uint8_t>& src, std::vector<uint8_t>& luma) {
+  size_t n = (size_t)w * h;
+  src.assign(n * jpegEncBytesPerPixel(fmt), 0);
+  luma.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    int r = rgb[3 * i], g = rgb[3 * i + 1], b = rgb[3 * i + 2];
+    switch (fmt) {
+      case JPEG_ENC_GRAY:
+        src[i] = luma[i] = lumaOf(r, g, b);
+        break;
+      case JPEG_ENC_RGB888:
+        memcpy(&src[3 * i], &rgb[3 * i], 3);
+        luma[i] = lumaOf(r, g, b);
+        break;
+      case JPEG_ENC_RGB565: {
+        uint16_t p = (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+        src[2 * i] = p >> 8;
+        src[2 * i + 1] = p & 0xFF;
+        int r8 = (r >> 3) << 3 | r >> 5, g8 = (g >> 2) << 2 | g >> 6, b8 = (b >> 3) << 3 | b >> 5;
+        luma[i] = lumaOf(r8, g8, b8);
+        break;
+      }
+      case JPEG_ENC_YUV422: {
+        int y = lumaOf(r, g, b);
+        int c = (i & 1) ? (int)(128 + 0.5 * r - 0.4187 * g - 0.0813 * b)
+                        : (int)(128 - 0.1687 * r - 0.3313 * g + 0.5 * b);
+        src[2 * i] = luma[i] = y;
+        src[2 * i + 1] = c < 0 ? 0 : c > 255 ? 255 : c;
+        break;
+      }
+    }
+  }
+}
+
+// Header + strips + EOI, strips encoded concurrently.
+static std::vector<uint8_t> encode(const jpeg_enc_t& e, const uint8_t* src, int strips) {
+  static std::vector<std::vector<uint8_t>> part;         // kept across calls: not timed
+  part.resize(strips);
+  std::vector<long> len(strips);
+  std::vector<std::thread> th;
+  for (int s = 0; s < strips; s++) {
+    int r0 = e.mcus_y * s / strips, r1 = e.mcus_y * (s + 1) / strips;
+    size_t cap = (size_t)(r1 - r0) * 8 * e.width * 3 + 1024;
+    if (part[s].size() < cap) part[s].resize(cap);
+    auto job = [&, s, r0, r1] { len[s] = jpegEncRows(&e, src, r0, r1, part[s].data(), part[s].size()); };
+    if (s + 1 < strips) th.emplace_back(job); else job();
+  }
+  for (auto& t : th) t.join();
+
+  std::vector<uint8_t> out(JPEG_ENC_HEADER_MAX);
+  out.resize(jpegEncHeader(&e, out.data(), out.size()));
+  for (int s = 0; s < strips; s++) {
+    if (len[s] < 0) return {};
+    out.insert(out.end(), part[s].begin(), part[s].begin() + len[s]);
+  }
+  out.push_back(0xFF);
+  out.push_back(0xD9);
+  return out;
+}
+
+static double psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  double se = 0;
+  for (size_t i = 0; i < a.size(); i++) se += (double)(a[i] - b[i]) * (a[i] - b[i]);
+  double mse = se / a.size();
+  return mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : 99;
+}
+
+int main(int argc, char** argv) {
+  int quality = argc > 1 ? atoi(argv[1]) : 80;
+  int reps = argc > 2 ? atoi(argv[2]) : 5;
+  if (reps < 1) reps = 1;
+  struct { const char* name; int w, h; } sizes[] = {
+    { "qvga", 320, 240 }, { "vga", 640, 480 }, { "svga", 800, 600 },
+    { "xga", 1024, 768 }, { "uxga", 1600, 1200 }, { "odd", 333, 117 },
+  };
+  struct { const char* name; jpeg_enc_format_t fmt; } formats[] = {
+    { "gray", JPEG_ENC_GRAY }, { "yuv422", JPEG_ENC_YUV422 },
+    { "rgb565", JPEG_ENC_RGB565 }, { "rgb888", JPEG_ENC_RGB888 },
+  };
+
+  printf("quality=%d reps=%d host threads=%u (fps_2 needs 2+ to show a speedup)\n", quality, reps,
+         std::thread::hardware_concurrency());
+  printf("%-5s %-7s %9s %8s %7s %9s %9s %8s %s\n", "size", "format", "bytes", "psnr_y",
+         "ms_1", "fps_1", "fps_2", "speedup", "libjpeg_fps");
+  bool all_ok = true;
+  for (auto& sz : sizes) {
+    std::vector<uint8_t> rgb;
+    scene(sz.w, sz.h, rgb);
+    auto t0 = clk::now();
+    for (int r = 0; r < reps; r++) libjpegEncode(rgb.data(), sz.w, sz.h, 3, quality, 0);
+    double lib_ms = msSince(t0) / reps;
+
+    for (auto& f : formats) {
+      std::vector<uint8_t> src, luma;
+      toFormat(rgb, sz.w, sz.h, f.fmt, src, luma);
+      jpeg_enc_t e;
+      jpegEncInit(&e, sz.w, sz.h, f.fmt, quality);
+
+      std::vector<uint8_t> one, two;
+      t0 = clk::now();
+      for (int r = 0; r < reps; r++) one = encode(e, src.data(), 1);
+      double ms1 = msSince(t0) / reps;
+      t0 = clk::now();
+      for (int r = 0; r < reps; r++) two = encode(e, src.data(), 2);
+      double ms2 = msSince(t0) / reps;
+
+      std::vector<uint8_t> y;
+      int dw, dh;
+      bool ok = !one.empty() && one == two &&
+                libjpegDecode(one.data(), one.size(), JCS_GRAYSCALE, &dw, &dh, y) &&
+                dw == sz.w && dh == sz.h;
+      double p = ok ? psnr(y, luma) : 0;
+      all_ok &= ok;
+      printf("%-5s %-7s %9zu %8.2f %7.2f %9.1f %9.1f %7.2fx %.1f%s\n", sz.name, f.name, one.size(), p,
+             ms1, 1000 / ms1, 1000 / ms2, ms1 / ms2, 1000 / lib_ms, ok ? "" : "  FAIL");
+    }
+  }
+  return all_ok ? 0 : 1;
+}
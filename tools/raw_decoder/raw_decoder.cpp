@@ -0,0 +1,132 @@
+/**
+ * NozzleCAM /raw reference decoder (host side).
+ *
+ * Reads the length-prefixed LZ4 frame stream produced by /raw, decodes every
+ * frame and optionally writes the luma plane as PGM files. Prints per-second
+ * stats: achieved fps, device-side LZ4 MB/s (from the header), compression
+ * ratio and host decode MB/s.
+ *
+ * Build:  g++ -O2 -I../../include raw_decoder.cpp ../../src/lz4block.cpp -o raw_decoder
+ * Use:    curl -sN "http://192.168.4.1/raw?fmt=gray&size=qvga" | ./raw_decoder - frames/ 10
+ *         (args: <input|-> [pgm output dir] [write every Nth frame])
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "lz4block.h"
+
+#define RAW_HDR_LEN 28
+#define PIXFORMAT_YUV422 1   // esp32-camera pixformat_t values used by /raw
+#define PIXFORMAT_GRAYSCALE 3
+
+struct RawHeader {
+  uint16_t width, height;
+  uint8_t  format, bpp;
+  uint32_t seq, raw_len, lz4_len, lz4_us;
+};
+
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool readExact(FILE* f, uint8_t* dst, size_t n) {
+  return fread(dst, 1, n, f) == n;
+}
+
+static bool readHeader(FILE* f, RawHeader& h) {
+  uint8_t b[RAW_HDR_LEN];
+  if (!readExact(f, b, sizeof(b))) return false;
+  if (memcmp(b, "NZR1", 4) != 0) {
+    fprintf(stderr, "bad frame magic\n");
+    return false;
+  }
+  h.width   = get16(b + 4);
+  h.height  = get16(b + 6);
+  h.format  = b[8];
+  h.bpp     = b[9];
+  h.seq     = get32(b + 12);
+  h.raw_len = get32(b + 16);
+  h.lz4_len = get32(b + 20);
+  h.lz4_us  = get32(b + 24);
+  return true;
+}
+
+static void writePgm(const std::string& dir, const RawHeader& h, const uint8_t* px) {
+  char name[64];
+  snprintf(name, sizeof(name), "/frame_%06u.pgm", (unsigned)h.seq);
+  FILE* f = fopen((dir + name).c_str(), "wb");
+  if (!f) { perror("pgm"); return; }
+  fprintf(f, "P5\n%u %u\n255\n", h.width, h.height);
+  if (h.bpp == 1) {
+    fwrite(px, 1, (size_t)h.width * h.height, f);
+  } else {
+    // YUV422 is Y0 U Y1 V: luma on even bytes
+    std::vector<uint8_t> y((size_t)h.width * h.height);
+    for (size_t i = 0; i < y.size(); i++) y[i] = px[i * 2];
+    fwrite(y.data(), 1, y.size(), f);
+  }
+  fclose(f);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <input|-> [pgm_dir] [every_n]\n", argv[0]);
+    return 2;
+  }
+  FILE* in = strcmp(argv[1], "-") ? fopen(argv[1], "rb") : stdin;
+  if (!in) { perror(argv[1]); return 1; }
+  std::string outdir = argc > 2 ? argv[2] : "";
+  unsigned every = argc > 3 ? (unsigned)atoi(argv[3]) : 1;
+  if (!every) every = 1;
+
+  using clock = std::chrono::steady_clock;
+  std::vector<uint8_t> comp, pixels;
+  RawHeader h;
+  uint32_t frames = 0, total = 0, last_seq = 0, gaps = 0;
+  uint64_t raw_bytes = 0, lz4_bytes = 0, dev_us = 0;
+  double host_s = 0;
+  auto win_start = clock::now();
+
+  while (readHeader(in, h)) {
+    comp.resize(h.lz4_len);
+    pixels.resize(h.raw_len);
+    if (!readExact(in, comp.data(), h.lz4_len)) break;
+
+    auto t0 = clock::now();
+    long n = lz4Decompress(comp.data(), comp.size(), pixels.data(), pixels.size());
+    host_s += std::chrono::duration<double>(clock::now() - t0).count();
+    if (n != (long)h.raw_len) {
+      fprintf(stderr, "frame %u: corrupt LZ4 block\n", (unsigned)h.seq);
+      return 1;
+    }
+
+    if (total && h.seq != last_seq + 1) gaps++;
+    last_seq = h.seq;
+    if (!outdir.empty() && h.seq % every == 0) writePgm(outdir, h, pixels.data());
+
+    frames++; total++;
+    raw_bytes += h.raw_len; lz4_bytes += h.lz4_len; dev_us += h.lz4_us;
+
+    double secs = std::chrono::duration<double>(clock::now() - win_start).count();
+    if (secs >= 1.0) {
+      printf("%ux%u %s fps=%.1f device_lz4=%.1fMB/s ratio=%.2f host_decode=%.0fMB/s gaps=%u\n",
+             h.width, h.height, h.bpp == 2 ? "yuv422" : "gray",
+             frames / secs,
+             dev_us ? (double)raw_bytes / dev_us : 0.0,
+             lz4_bytes ? (double)raw_bytes / lz4_bytes : 0.0,
+             host_s > 0 ? raw_bytes / host_s / 1e6 : 0.0,
+             gaps);
+      fflush(stdout);
+      frames = 0; raw_bytes = lz4_bytes = dev_us = 0; host_s = 0;
+      win_start = clock::now();
+    }
+  }
+  fprintf(stderr, "%u frames decoded\n", (unsigned)total);
+  return 0;
+}
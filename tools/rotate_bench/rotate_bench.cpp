@@ -0,0 +1,116 @@
+/**
+ * NozzleCAM lossless rotation benchmark (host side).
+ *
+ * Encodes a synthetic frame with libjpeg the way the sensor does (4:2:2,
+ * standard Huffman tables), rotates it 90/180/270 degrees with
+ * src/jpeg_rot.cpp and checks each result: it must decode with libjpeg and
+ * match the decoded original rotated pixel by pixel (max |diff| of Y; only
+ * IDCT rounding may differ). A case with restart markers and a grayscale
+ * one cover the other layouts. Rotation time per frame is compared with the
+ * lossy way round: libjpeg decode + pixel rotate + encode.
+ *
+ * Build:  g++ -O2 -I../../include -I../common rotate_bench.cpp ../../src/jpeg_rot.cpp ../../src/jpeg_scan.cpp ../../src/jpeg_enc.cpp -ljpeg -o rotate_bench
+ * Use:    ./rotate_bench [quality=80] [reps=10]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bench_fixture.h"
+#include "jpeg_rot.h"
+#include "jpeg_scan.h"
+
+// An off-centre dark nozzle on top of the scene, so it is asymmetric and a
+// wrong rotation can't pass.
+static void addNozzle(int w, int h, std::vector<uint8_t>& rgb) {
+  for (int y = 0; (double)y / h < 0.5; y++)
+    for (int x = 0; x < w; x++)
+      if (fabs((double)x / w - 0.3) < 0.04) memset(&rgb[((size_t)y * w + x) * 3], 20, 3);
+}
+
+// Pixel rotation (clockwise) of the top-left tw x th of an n-channel image.
+static void rotatePixels(const std::vector<uint8_t>& s, int w, int tw, int th, int n, int deg,
+                         std::vector<uint8_t>& d) {
+  int dw = deg == 180 ? tw : th, dh = deg == 180 ? th : tw;
+  d.resize((size_t)dw * dh * n);
+  for (int y = 0; y < dh; y++)
+    for (int x = 0; x < dw; x++) {
+      int sx = deg == 90 ? y : deg == 270 ? tw - 1 - y : tw - 1 - x;
+      int sy = deg == 90 ? th - 1 - x : deg == 270 ? x : th - 1 - y;
+      memcpy(&d[((size_t)y * dw + x) * n], &s[((size_t)sy * w + sx) * n], n);
+    }
+}
+
+int main(int argc, char** argv) {
+  int quality = argc > 1 ? atoi(argv[1]) : 80;
+  int reps = argc > 2 ? atoi(argv[2]) : 10;
+  if (reps < 1) reps = 1;
+  struct { const char* name; int w, h, ncomp, restart_rows; } cases[] = {
+    { "qvga", 320, 240, 3, 0 }, { "vga", 640, 480, 3, 0 }, { "svga", 800, 600, 3, 0 },
+    { "xga", 1024, 768, 3, 0 }, { "uxga", 1600, 1200, 3, 0 },
+    { "vga-rst", 640, 480, 3, 1 }, { "vga-gray", 640, 480, 1, 0 }, { "odd", 333, 117, 3, 0 },
+  };
+  const int degs[] = { 90, 180, 270 };
+
+  printf("quality=%d reps=%d\n", quality, reps);
+  printf("%-8s %4s %9s %9s %8s %8s %10s %s\n", "case", "deg", "bytes_in", "bytes_out", "max_dy",
+         "ms", "lossy_ms", "out");
+  bool all_ok = true;
+  for (auto& cs : cases) {
+    std::vector<uint8_t> rgb, src;
+    scene(cs.w, cs.h, rgb);
+    addNozzle(cs.w, cs.h, rgb);
+    if (cs.ncomp == 1) {
+      src.resize((size_t)cs.w * cs.h);
+      for (size_t i = 0; i < src.size(); i++) src[i] = rgb[3 * i + 1];
+    } else {
+      src = rgb;
+    }
+    std::vector<uint8_t> jpg = libjpegEncode(src.data(), cs.w, cs.h, cs.ncomp, quality, cs.restart_rows);
+
+    int w, h;
+    std::vector<uint8_t> y0;
+    libjpegDecode(jpg.data(), jpg.size(), JCS_GRAYSCALE, &w, &h, y0);
+    int mw = cs.ncomp == 3 ? 16 : 8;
+    int tw = w / mw * mw, th = h / 8 * 8;                  // what survives the trim
+
+    for (int deg : degs) {
+      std::vector<uint8_t> out(jpegRotateBound(jpg.size()));
+      long n = 0;
+      auto t0 = clk::now();
+      for (int r = 0; r < reps; r++) n = jpegRotate(jpg.data(), jpg.size(), deg, out.data(), out.size());
+      double ms = msSince(t0) / reps;
+
+      // lossy reference: decode, rotate pixels, encode again
+      t0 = clk::now();
+      for (int r = 0; r < reps; r++) {
+        std::vector<uint8_t> px, rp;
+        int dw, dh;
+        libjpegDecode(jpg.data(), jpg.size(), cs.ncomp == 3 ? JCS_RGB : JCS_GRAYSCALE, &dw, &dh, px);
+        rotatePixels(px, dw, tw, th, cs.ncomp, deg, rp);
+        libjpegEncode(rp.data(), deg == 180 ? tw : th, deg == 180 ? th : tw, cs.ncomp, quality, 0);
+      }
+      double lossy_ms = msSince(t0) / reps;
+
+      std::vector<uint8_t> want, got;
+      rotatePixels(y0, w, tw, th, 1, deg, want);
+      int gw = 0, gh = 0, maxd = -1;
+      bool ok = n > 0 && libjpegDecode(out.data(), n, JCS_GRAYSCALE, &gw, &gh, got) &&
+                gw == (deg == 180 ? tw : th) && gh == (deg == 180 ? th : tw);
+      if (ok) {
+        maxd = 0;
+        for (size_t i = 0; i < want.size(); i++) {
+          int dd = abs(want[i] - got[i]);
+          if (dd > maxd) maxd = dd;
+        }
+        ok = maxd <= 2;
+      }
+      all_ok &= ok;
+      printf("%-8s %4d %9zu %9ld %8d %8.2f %10.2f %dx%d%s\n", cs.name, deg, jpg.size(), n, maxd, ms,
+             lossy_ms, gw, gh, ok ? "" : "  FAIL");
+    }
+  }
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/**
+ * NozzleCAM Arduino vs. ESP-IDF build comparison (host side).
+ *
+ * Flash one env, reset the board with a serial monitor logging, join the AP
+ * and run this; then the same for the other env. Each run prints one row:
+ *
+ *   boot     BOOT line from the serial log (runtime, ms from reset to server
+ *            up, internal heap free / low-water mark, PSRAM free)
+ *   stream   one /stream client for <seconds>: time to the first complete
+ *            frame, fps and kB/s
+ *   load     internal heap free / low-water mark from /tcp while streaming
+ *
+ * Build:  g++ -O2 runtime_bench.cpp -o runtime_bench
+ * Use:    pio device monitor -e ttgo-tjournal > boot.log   (reset the board, then Ctrl+C)
+ *         ./runtime_bench 192.168.4.1 20 boot.log
+ *         (args: <host> [seconds=20] [serial log with the BOOT line])
+ */
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+
+using clk = std::chrono::steady_clock;
+
+static double msSince(clk::time_point t0) {
+  return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+static int openHttp(const char* host, const char* path) {
+  addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, "80", &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, 0);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return -1;
+  timeval tv = { 5, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  char req[256];
+  int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
+  if (send(fd, req, n, 0) != n) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Whole response of a short request (the server closes after it).
+static std::string fetch(const char* host, const char* path) {
+  std::string body;
+  int fd = openHttp(host, path);
+  if (fd < 0) return body;
+  char buf[4096];
+  ssize_t r;
+  while ((r = recv(fd, buf, sizeof(buf), 0)) > 0) body.append(buf, r);
+  close(fd);
+  return body;
+}
+
+static long jsonInt(const std::string& s, const char* key) {
+  std::string k = std::string("\"") + key + "\":";
+  size_t p = s.find(k);
+  return p == std::string::npos ? -1 : atol(s.c_str() + p + k.size());
+}
+
+// key=value from the last BOOT line of a serial log ("" if absent).
+static std::string bootField(const char* log, const char* key) {
+  FILE* f = log ? fopen(log, "r") : NULL;
+  if (!f) return "";
+  char line[512], last[512] = "";
+  while (fgets(line, sizeof(line), f))
+    if (const char* b = strstr(line, "BOOT runtime=")) snprintf(last, sizeof(last), "%s", b);
+  fclose(f);
+  std::string k = std::string(" ") + key + "=";
+  const char* p = strstr(last, k.c_str());
+  if (!p) return "";
+  p += k.size();
+  return std::string(p, strcspn(p, " \r\n"));
+}
+
+struct StreamResult {
+  double first_ms = -1;
+  int    frames = 0;
+  size_t bytes = 0;
+  double secs = 0;
+  long   heap_free = -1, heap_min = -1;
+};
+
+// Reads multipart parts ("--frame", headers, Content-Length bytes) for `secs`.
+static bool runStream(const char* host, int secs, StreamResult* r) {
+  auto t0 = clk::now();
+  int fd = openHttp(host, "/stream");
+  if (fd < 0) return false;
+  std::string buf;
+  bool head_done = false;
+  clk::time_point first;
+  char chunk[16384];
+  bool sampled = false;
+  while (true) {
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) break;
+    r->bytes += n;
+    buf.append(chunk, n);
+    for (;;) {
+      size_t eoh = buf.find("\r\n\r\n");
+      if (eoh == std::string::npos) break;
+      if (!head_done) {                                // HTTP response header
+        head_done = true;
+        buf.erase(0, eoh + 4);
+        continue;
+      }
+      size_t cl = buf.find("Content-Length:");
+      if (cl == std::string::npos || cl > eoh) {
+        buf.erase(0, eoh + 4);
+        continue;
+      }
+      size_t len = strtoul(buf.c_str() + cl + 15, NULL, 10);
+      if (buf.size() < eoh + 4 + len + 2) break;      // rest of the JPEG still coming
+      buf.erase(0, eoh + 4 + len + 2);
+      if (r->frames++ == 0) {
+        first = clk::now();
+        r->first_ms = msSince(t0);
+      }
+    }
+    if (r->frames && !sampled && msSince(first) > secs * 500.0) {   // halfway: heap under load
+      std::string tcp = fetch(host, "/tcp");
+      r->heap_free = jsonInt(tcp, "heap_free");
+      r->heap_min = jsonInt(tcp, "heap_min");
+      sampled = true;
+    }
+    if (r->frames && msSince(first) >= secs * 1000.0) break;
+  }
+  close(fd);
+  if (r->frames > 1) r->secs = msSince(first) / 1000;
+  return r->frames > 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <host> [seconds=20] [serial.log]\n", argv[0]);
+    return 2;
+  }
+  const char* host = argv[1];
+  int secs = argc > 2 ? atoi(argv[2]) : 20;
+  if (secs < 2) secs = 2;
+  const char* log = argc > 3 ? argv[3] : NULL;
+
+  StreamResult r;
+  bool ok = runStream(host, secs, &r);
+  if (!ok) fprintf(stderr, "no frames from http://%s/stream\n", host);
+
+  std::string runtime = bootField(log, "runtime");
+  auto field = [&](const char* k) { std::string v = bootField(log, k); return v.empty() ? "-" : v; };
+  double fps = r.secs > 0 ? (r.frames - 1) / r.secs : 0;
+  double kbs = r.secs > 0 ? r.bytes / 1024.0 / r.secs : 0;
+
+  printf("%-8s %8s %9s %9s %10s %9s %8s %8s %9s %9s\n", "runtime", "boot_ms", "heap_boot",
+         "heap_min", "psram_free", "first_ms", "fps", "kB/s", "heap_load", "min_load");
+  printf("%-8s %8s %9s %9s %10s %9.0f %8.2f %8.1f %9ld %9ld\n",
+         runtime.empty() ? "?" : runtime.c_str(), field("boot_ms").c_str(),
+         field("heap_free").c_str(), field("heap_min").c_str(), field("psram_free").c_str(),
+         r.first_ms, fps, kbs, r.heap_free, r.heap_min);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+/**
+ * NozzleCAM shared-memory frame ring (host side).
+ *
+ * shm_ringd holds one /stream connection and publishes every JPEG into a
+ * POSIX shared-memory segment; any number of local processes map it and
+ * read frames in place, without locks and without registering.
+ *
+ * Layout: one header page, then `slots` slots of `slot_size` bytes (slot
+ * header + JPEG). Frame n = 1, 2, ... goes into slot n % slots. The slot's
+ * seq is cleared while the writer fills it and set to n once the frame is
+ * complete, then the ring's head becomes n. Readers check seq before and
+ * after using the data (a seqlock): a frame the writer lapped meanwhile is
+ * reported by valid(), never silently torn. The writer is filling slot
+ * head+1, so a reader has slots-2 frame times to finish with a frame.
+ *
+ * Waiting readers sleep on a futex on the head (Linux); elsewhere they poll
+ * every millisecond.
+ *
+ * Header-only, C++17, POSIX. Link with -lrt on older glibc.
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SHM_RING_NAME      "/nozzlecam"
+#define SHM_RING_MAGIC     0x4E5A5247u           // "NZRG"
+#define SHM_RING_VERSION   1
+#define SHM_RING_HDR_SIZE  4096
+#define SHM_RING_SLOT_HDR  64                    // data starts cache-line aligned
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+struct shm_ring_hdr_t {
+  uint32_t              magic, version;
+  uint32_t              slots, slot_size;        // slot_size includes the slot header
+  int32_t               writer_pid;
+  std::atomic<uint32_t> closed;                  // writer gone; reopen to follow a new one
+  std::atomic<uint32_t> wake;                    // futex word: low 32 bits of head
+  std::atomic<uint32_t> waiters;
+  std::atomic<uint64_t> head;                    // last complete frame, 0 = none yet
+  char                  source[256];             // what the writer reads, e.g. the stream URL
+};
+
+struct shm_ring_slot_t {
+  std::atomic<uint64_t> seq;                     // frame number once complete, 0 while written
+  uint64_t              t_ns;                    // CLOCK_MONOTONIC at commit
+  uint32_t              len;
+};
+
+static_assert(sizeof(shm_ring_hdr_t) <= SHM_RING_HDR_SIZE, "header page");
+static_assert(sizeof(shm_ring_slot_t) <= SHM_RING_SLOT_HDR, "slot header");
+
+// A frame in the ring, valid while valid(frame) says so.
+struct ShmFrame {
+  const uint8_t* data;
+  uint32_t       len;
+  uint64_t       seq;
+  uint64_t       t_ns;
+};
+
+inline uint64_t shmRingNowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+namespace shm_ring_detail {
+
+inline void wakeAll(std::atomic<uint32_t>* w) {
+#ifdef __linux__
+  syscall(SYS_futex, (uint32_t*)w, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+  (void)w;
+#endif
+}
+
+// Sleeps while *w == expect, at most timeout_ms (< 0: no limit). Spurious returns are fine.
+inline void waitOn(std::atomic<uint32_t>* w, uint32_t expect, int timeout_ms) {
+#ifdef __linux__
+  timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+  syscall(SYS_futex, (uint32_t*)w, FUTEX_WAIT, expect, timeout_ms < 0 ? nullptr : &ts, nullptr, 0);
+#else
+  (void)w; (void)expect; (void)timeout_ms;
+  timespec ts = { 0, 1000000L };
+  nanosleep(&ts, nullptr);
+#endif
+}
+
+}  // namespace shm_ring_detail
+
+class ShmRingWriter {
+ public:
+  ShmRingWriter() = default;
+  ShmRingWriter(const ShmRingWriter&) = delete;
+  ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+  ~ShmRingWriter() { close(); }
+
+  // Replaces any ring of that name. max_frame is the largest JPEG a slot takes.
+  bool create(const char* name, uint32_t slots, uint32_t max_frame, const char* source) {
+    close();
+    if (slots < 3) slots = 3;
+    uint32_t slot_size = (SHM_RING_SLOT_HDR + max_frame + 63) & ~63u;
+    size_ = SHM_RING_HDR_SIZE + (size_t)slots * slot_size;
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) return false;
+    void* p = ftruncate(fd, size_) == 0 ? mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                        : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      shm_unlink(name);
+      return false;
+    }
+    base_ = (uint8_t*)p;
+    hdr_ = new (base_) shm_ring_hdr_t();         // zero-filled by ftruncate
+    hdr_->slots = slots;
+    hdr_->slot_size = slot_size;
+    hdr_->writer_pid = getpid();
+    snprintf(hdr_->source, sizeof(hdr_->source), "%s", source ? source : "");
+    for (uint32_t i = 0; i < slots; i++) new (slot(i)) shm_ring_slot_t();
+    snprintf(name_, sizeof(name_), "%s", name);
+    hdr_->version = SHM_RING_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr_->magic = SHM_RING_MAGIC;                // readers accept the ring from here on
+    return true;
+  }
+
+  // Marks the ring closed, wakes readers and removes the name.
+  void close() {
+    if (!hdr_) return;
+    hdr_->closed.store(1);
+    hdr_->wake.fetch_add(1);
+    shm_ring_detail::wakeAll(&hdr_->wake);
+    munmap(base_, size_);
+    shm_unlink(name_);
+    hdr_ = nullptr;
+    base_ = nullptr;
+  }
+
+  uint32_t capacity() const { return hdr_ ? hdr_->slot_size - SHM_RING_SLOT_HDR : 0; }
+  uint64_t head() const { return hdr_ ? hdr_->head.load(std::memory_order_relaxed) : 0; }
+
+  // Slot for the next frame, capacity() bytes. Calling it again without
+  // commit() reuses the same slot (a frame that was cut off).
+  uint8_t* begin() {
+    shm_ring_slot_t* s = slot(next());
+    s->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return (uint8_t*)s + SHM_RING_SLOT_HDR;
+  }
+
+  // Publishes the frame written since begin().
+  void commit(uint32_t len) {
+    uint64_t n = next();
+    shm_ring_slot_t* s = slot(n);
+    s->len = len;
+    s->t_ns = shmRingNowNs();
+    s->seq.store(n, std::memory_order_release);
+    hdr_->head.store(n, std::memory_order_release);
+    hdr_->wake.store((uint32_t)n);
+    if (hdr_->waiters.load()) shm_ring_detail::wakeAll(&hdr_->wake);
+  }
+
+ private:
+  uint64_t next() const { return hdr_->head.load(std::memory_order_relaxed) + 1; }
+  shm_ring_slot_t* slot(uint64_t n) const {
+    return (shm_ring_slot_t*)(base_ + SHM_RING_HDR_SIZE + (size_t)(n % hdr_->slots) * hdr_->slot_size);
+  }
+
+  uint8_t*        base_ = nullptr;
+  shm_ring_hdr_t* hdr_ = nullptr;
+  size_t          size_ = 0;
+  char            name_[64] = "";
+};
+
+class ShmRingReader {
+ public:
+  ShmRingReader() = default;
+  ShmRingReader(const ShmRingReader&) = delete;
+  ShmRingReader& operator=(const ShmRingReader&) = delete;
+  ~ShmRingReader() { close(); }
+
+  // Maps an existing ring: the header page read-write (wait counter), the
+  // slots read-only. Starts at the ring's newest frame.
+  bool open(const char* name = SHM_RING_NAME) {
+    close();
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size > SHM_RING_HDR_SIZE;
+    void* h = ok ? mmap(nullptr, SHM_RING_HDR_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    void* p = h != MAP_FAILED ? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      if (h != MAP_FAILED) munmap(h, SHM_RING_HDR_SIZE);
+      return false;
+    }
+    base_ = (const uint8_t*)p;
+    size_ = st.st_size;
+    hdr_ = (shm_ring_hdr_t*)h;
+    ok = hdr_->magic == SHM_RING_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ok = ok && hdr_->version == SHM_RING_VERSION &&
+         SHM_RING_HDR_SIZE + (size_t)hdr_->slots * hdr_->slot_size <= size_;
+    if (!ok) {
+      close();
+      return false;
+    }
+    last_ = hdr_->head.load(std::memory_order_acquire);
+    last_ = last_ > 0 ? last_ - 1 : 0;           // the newest frame is the first next()
+    skipped_ = 0;
+    return true;
+  }
+
+  void close() {
+    if (base_) munmap((void*)base_, size_);
+    if (hdr_) munmap(hdr_, SHM_RING_HDR_SIZE);
+    base_ = nullptr;
+    hdr_ = nullptr;
+  }
+
+  // Oldest unread frame still in the ring, waiting up to timeout_ms for one
+  // (< 0: no limit). Frames the writer overwrote before we got to them count
+  // in skipped(). false on timeout or when the writer has closed the ring.
+  bool next(ShmFrame* f, int timeout_ms = -1) { return take(f, timeout_ms, false); }
+
+  // Newest frame not seen yet; everything older is skipped.
+  bool latest(ShmFrame* f, int timeout_ms = -1) { return take(f, timeout_ms, true); }
+
+  // True while f's slot still holds f: everything read from f.data before
+  // this call is good. Check it after using a frame, not before.
+  bool valid(const ShmFrame& f) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slotAt(f.seq)->seq.load(std::memory_order_relaxed) == f.seq;
+  }
+
+  bool closed() const { return !hdr_ || hdr_->closed.load(); }
+  uint64_t skipped() const { return skipped_; }
+  uint32_t slots() const { return hdr_ ? hdr_->slots : 0; }
+  const char* source() const { return hdr_ ? hdr_->source : ""; }
+
+ private:
+  bool take(ShmFrame* f, int timeout_ms, bool newest) {
+    if (!hdr_) return false;
+    uint64_t deadline = timeout_ms < 0 ? 0 : shmRingNowNs() + (uint64_t)timeout_ms * 1000000ull;
+    for (;;) {
+      uint64_t h = hdr_->head.load(std::memory_order_acquire);
+      if (h > last_) {
+        uint64_t want = newest ? h : last_ + 1;
+        uint64_t oldest = h + 2 > hdr_->slots ? h + 2 - hdr_->slots : 1;
+        if (want < oldest) want = oldest;
+        const shm_ring_slot_t* s = slotAt(want);
+        if (s->seq.load(std::memory_order_acquire) == want) {
+          uint32_t len = s->len;
+          uint64_t t = s->t_ns;
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (s->seq.load(std::memory_order_relaxed) == want && len <= hdr_->slot_size - SHM_RING_SLOT_HDR) {
+            skipped_ += want - last_ - 1;
+            last_ = want;
+            *f = { (const uint8_t*)s + SHM_RING_SLOT_HDR, len, want, t };
+            return true;
+          }
+        }
+        continue;                                // lapped while looking: take the new oldest
+      }
+      if (hdr_->closed.load()) return false;
+      int wait_ms = -1;
+      if (timeout_ms >= 0) {
+        uint64_t now = shmRingNowNs();
+        if (now >= deadline) return false;
+        wait_ms = (int)((deadline - now + 999999) / 1000000);
+      }
+      hdr_->waiters.fetch_add(1);
+      if (hdr_->head.load() == h && !hdr_->closed.load())
+        shm_ring_detail::waitOn(&hdr_->wake, (uint32_t)h, wait_ms);
+      hdr_->waiters.fetch_sub(1);
+    }
+  }
+
+  const shm_ring_slot_t* slotAt(uint64_t n) const {
+    return (const shm_ring_slot_t*)(base_ + SHM_RING_HDR_SIZE + (size_t)(n % hdr_->slots) * hdr_->slot_size);
+  }
+
+  const uint8_t*  base_ = nullptr;
+  shm_ring_hdr_t* hdr_ = nullptr;
+  size_t          size_ = 0;
+  uint64_t        last_ = 0;
+  uint64_t        skipped_ = 0;
+};
@@ -0,0 +1,192 @@
+/**
+ * NozzleCAM shared-memory frame ring benchmark (host side).
+ *
+ * Synthetic mode: one writer process publishes frames of a fixed size into
+ * a private ring (one memcpy per frame, as shm_ringd's receive into the
+ * slot) while N reader processes take every frame with next(), read all of
+ * it (checksum) and then check valid(). Each frame carries its number at
+ * both ends, so a torn frame that valid() let through would show up as
+ * "corrupt" (must be 0). Per reader: frames, skipped (lapped by the writer),
+ * discarded (valid() false after reading), commit-to-read latency and CPU.
+ *
+ * Attach mode reads a live ring (shm_ringd) the same way; there "corrupt"
+ * counts frames that don't run from SOI to EOI.
+ *
+ * Build:  g++ -O2 -std=c++17 shm_ring_bench.cpp -o shm_ring_bench
+ * Use:    ./shm_ring_bench [readers=4] [seconds=5] [frame kB=64] [fps=0 (as fast as possible)]
+ *         ./shm_ring_bench attach [ring name=/nozzlecam] [seconds=10]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "shm_ring.h"
+
+#define BENCH_SLOTS  16
+#define PATTERN_TAG  0x5A5A5A5A5A5A5A5Aull
+
+struct ReaderResult {
+  uint64_t frames, skipped, discarded, corrupt, bytes;
+  double   lat_p50_us, lat_p99_us, lat_max_us;
+  double   cpu_s;
+  uint64_t sum;                                      // keeps the read from being optimized out
+};
+
+static double cpuSeconds() {
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static uint64_t checksum(const uint8_t* p, uint32_t len) {
+  uint64_t s = 0, w;
+  uint32_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    memcpy(&w, p + i, 8);
+    s += w;
+  }
+  for (; i < len; i++) s += p[i];
+  return s;
+}
+
+// Reads until the ring closes (or `secs` in attach mode).
+static void readLoop(const char* name, bool check, double secs, ReaderResult* r) {
+  memset(r, 0, sizeof(*r));
+  ShmRingReader ring;
+  for (int i = 0; i < 100 && !ring.open(name); i++) usleep(10000);
+  if (ring.closed()) return;
+  std::vector<double> lat;
+  lat.reserve(1 << 20);
+  double cpu0 = cpuSeconds();
+  uint64_t t_end = secs > 0 ? shmRingNowNs() + (uint64_t)(secs * 1e9) : 0;
+  ShmFrame f;
+  while (ring.next(&f, 1000)) {
+    uint64_t s = checksum(f.data, f.len);
+    uint64_t now = shmRingNowNs();
+    if (!ring.valid(f)) {
+      r->discarded++;
+      continue;
+    }
+    if (check) {
+      uint64_t a, b;
+      memcpy(&a, f.data, 8);
+      memcpy(&b, f.data + f.len - 8, 8);
+      if (a != f.seq || b != (f.seq ^ PATTERN_TAG)) r->corrupt++;
+    } else if (f.len < 4 || f.data[0] != 0xFF || f.data[1] != 0xD8 ||
+               f.data[f.len - 2] != 0xFF || f.data[f.len - 1] != 0xD9) {
+      r->corrupt++;                                  // live ring: not SOI .. EOI
+    }
+    r->sum += s;
+    r->frames++;
+    r->bytes += f.len;
+    lat.push_back((now - f.t_ns) / 1e3);
+    if (t_end && now >= t_end) break;
+  }
+  r->skipped = ring.skipped();
+  r->cpu_s = cpuSeconds() - cpu0;
+  if (!lat.empty()) {
+    std::sort(lat.begin(), lat.end());
+    r->lat_p50_us = lat[lat.size() / 2];
+    r->lat_p99_us = lat[lat.size() * 99 / 100];
+    r->lat_max_us = lat.back();
+  }
+}
+
+static void printReaders(const ReaderResult* r, int n, double secs) {
+  printf("%-6s %9s %9s %8s %9s %8s %9s %9s %9s %8s %s\n", "reader", "frames", "fps", "skipped",
+         "discarded", "corrupt", "p50_us", "p99_us", "max_us", "cpu_%", "MB/s");
+  for (int i = 0; i < n; i++)
+    printf("%-6d %9llu %9.1f %8llu %9llu %8llu %9.1f %9.1f %9.1f %8.1f %.0f\n", i,
+           (unsigned long long)r[i].frames, r[i].frames / secs, (unsigned long long)r[i].skipped,
+           (unsigned long long)r[i].discarded, (unsigned long long)r[i].corrupt, r[i].lat_p50_us,
+           r[i].lat_p99_us, r[i].lat_max_us, 100 * r[i].cpu_s / secs, r[i].bytes / 1048576.0 / secs);
+}
+
+static int attach(int argc, char** argv) {
+  const char* name = argc > 2 ? argv[2] : SHM_RING_NAME;
+  double secs = argc > 3 ? atof(argv[3]) : 10;
+  ShmRingReader probe;
+  if (!probe.open(name)) {
+    fprintf(stderr, "no ring %s (is shm_ringd running?)\n", name);
+    return 1;
+  }
+  printf("ring %s: %u slots, source %s, %.0f s\n", name, probe.slots(), probe.source(), secs);
+  probe.close();
+  ReaderResult r;
+  uint64_t t0 = shmRingNowNs();
+  readLoop(name, false, secs, &r);
+  printReaders(&r, 1, (shmRingNowNs() - t0) / 1e9);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && !strcmp(argv[1], "attach")) return attach(argc, argv);
+  int readers = argc > 1 ? atoi(argv[1]) : 4;
+  double secs = argc > 2 ? atof(argv[2]) : 5;
+  int frame_kb = argc > 3 ? atoi(argv[3]) : 64;
+  double fps = argc > 4 ? atof(argv[4]) : 0;
+  if (readers < 1) readers = 1;
+  if (frame_kb < 1) frame_kb = 1;
+  uint32_t len = (uint32_t)frame_kb * 1024;
+
+  char name[64];
+  snprintf(name, sizeof(name), "/nozzlecam-bench-%d", (int)getpid());
+  ShmRingWriter ring;
+  if (!ring.create(name, BENCH_SLOTS, len, "synthetic")) {
+    perror("create ring");
+    return 1;
+  }
+  auto* res = (ReaderResult*)mmap(NULL, sizeof(ReaderResult) * readers, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  std::vector<pid_t> kids;
+  for (int i = 0; i < readers; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      readLoop(name, true, 0, &res[i]);
+      _exit(0);
+    }
+    kids.push_back(pid);
+  }
+  usleep(100000);                                    // let the readers map the ring
+
+  std::vector<uint8_t> pattern(len);
+  for (uint32_t i = 0; i < len; i++) pattern[i] = (uint8_t)(i * 131 + (i >> 8));
+  printf("readers=%d seconds=%.0f frame=%d kB slots=%d fps=%s\n", readers, secs, frame_kb, BENCH_SLOTS,
+         fps > 0 ? argv[4] : "max");
+
+  double cpu0 = cpuSeconds();
+  uint64_t t0 = shmRingNowNs(), t_end = t0 + (uint64_t)(secs * 1e9), n = 0;
+  for (uint64_t now = t0; now < t_end; now = shmRingNowNs()) {
+    if (fps > 0) {
+      uint64_t due = t0 + (uint64_t)(n * 1e9 / fps);
+      if (due > now) {
+        usleep((due - now) / 1000);
+        continue;
+      }
+    }
+    uint64_t seq = ring.head() + 1, tail = seq ^ PATTERN_TAG;
+    uint8_t* p = ring.begin();
+    memcpy(p, pattern.data(), len);
+    memcpy(p, &seq, 8);
+    memcpy(p + len - 8, &tail, 8);
+    ring.commit(len);
+    n++;
+  }
+  double wsecs = (shmRingNowNs() - t0) / 1e9, wcpu = cpuSeconds() - cpu0;
+  ring.close();                                      // readers see closed and finish
+  for (pid_t k : kids) waitpid(k, NULL, 0);
+
+  printf("writer: %llu frames, %.0f fps, %.0f MB/s, cpu %.1f%%\n", (unsigned long long)n, n / wsecs,
+         n * (double)len / 1048576.0 / wsecs, 100 * wcpu / wsecs);
+  printReaders(res, readers, wsecs);
+  bool ok = true;
+  for (int i = 0; i < readers; i++) ok &= res[i].corrupt == 0 && res[i].frames > 0;
+  if (!ok) printf("FAIL\n");
+  return ok ? 0 : 1;
+}
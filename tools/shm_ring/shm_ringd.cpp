@@ -0,0 +1,193 @@
+/**
+ * NozzleCAM shared-memory frame ring daemon (host side).
+ *
+ * Holds one /stream connection and publishes every JPEG into the ring of
+ * shm_ring.h, so any number of local programs share one stream (one
+ * client's worth of device airtime, one multipart parser). The JPEG body is
+ * received straight into its ring slot. Reconnects when the stream drops;
+ * readers keep their mapping across that. Prints stats every 5 s.
+ *
+ * Build:  g++ -O2 -std=c++17 shm_ringd.cpp -o shm_ringd
+ * Use:    ./shm_ringd 192.168.4.1 "/stream?fps=10" 16 512 /nozzlecam
+ *         (args: <host> [path=/stream] [slots=16] [max frame kB=512] [ring name=/nozzlecam])
+ */
+#include <netdb.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "shm_ring.h"
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int) { stop = 1; }
+
+// Buffered HTTP reader that can hand a body straight to a destination buffer.
+struct Conn {
+  int fd = -1;
+  std::vector<uint8_t> buf = std::vector<uint8_t>(16384);
+  size_t lo = 0, hi = 0;
+
+  bool fill() {
+    if (lo == hi) lo = hi = 0;
+    if (hi == buf.size()) {
+      if (lo == 0) return false;                   // header larger than the buffer
+      memmove(buf.data(), buf.data() + lo, hi - lo);
+      hi -= lo;
+      lo = 0;
+    }
+    ssize_t n = recv(fd, buf.data() + hi, buf.size() - hi, 0);
+    if (n <= 0) return false;
+    hi += n;
+    return true;
+  }
+
+  // Up to and including the blank line; text is the header block.
+  bool header(std::string* text) {
+    for (;;) {
+      const char* b = (const char*)buf.data() + lo;
+      const char* e = (const char*)memmem(b, hi - lo, "\r\n\r\n", 4);
+      if (e) {
+        text->assign(b, e - b);
+        lo += e - b + 4;
+        return true;
+      }
+      if (stop || !fill()) return false;
+    }
+  }
+
+  // len bytes into dst (NULL: discard).
+  bool body(uint8_t* dst, size_t len) {
+    size_t n = hi - lo < len ? hi - lo : len;
+    if (dst) memcpy(dst, buf.data() + lo, n);
+    lo += n;
+    len -= n;
+    while (len && !stop) {
+      if (!dst) {
+        lo = hi = 0;
+        if (!fill()) return false;
+        size_t k = hi < len ? hi : len;
+        lo = k;
+        len -= k;
+        continue;
+      }
+      dst += n;
+      ssize_t r = recv(fd, dst, len, 0);
+      if (r <= 0) return false;
+      n = r;
+      len -= r;
+    }
+    return !len;
+  }
+};
+
+static int openStream(const char* host, const char* path) {
+  addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, "80", &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, 0);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return -1;
+  timeval tv = { 5, 0 };                           // a stalled stream counts as dropped
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  char req[512];
+  int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", path, host);
+  if (send(fd, req, n, 0) != n) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static size_t contentLength(const std::string& h) {
+  size_t p = h.find("Content-Length:");
+  if (p == std::string::npos) p = h.find("content-length:");
+  return p == std::string::npos ? (size_t)-1 : strtoul(h.c_str() + p + 15, NULL, 10);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <host> [path=/stream] [slots=16] [max frame kB=512] [ring name=%s]\n",
+            argv[0], SHM_RING_NAME);
+    return 2;
+  }
+  const char* host = argv[1];
+  const char* path = argc > 2 ? argv[2] : "/stream";
+  int slots = argc > 3 ? atoi(argv[3]) : 16;
+  int frame_kb = argc > 4 ? atoi(argv[4]) : 512;
+  const char* name = argc > 5 ? argv[5] : SHM_RING_NAME;
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  char source[256];
+  snprintf(source, sizeof(source), "http://%s%s", host, path);
+  ShmRingWriter ring;
+  if (!ring.create(name, slots, (uint32_t)frame_kb * 1024, source)) {
+    perror("shm_ringd: create ring");
+    return 1;
+  }
+  printf("shm_ringd: %s -> %s (%d slots x %d kB)\n", source, name, slots, frame_kb);
+
+  uint64_t frames = 0, bytes = 0, oversize = 0, reconnects = 0;
+  uint64_t win_t = shmRingNowNs(), win_frames = 0, win_bytes = 0;
+  int backoff_ms = 500;
+  while (!stop) {
+    Conn c;
+    c.fd = openStream(host, path);
+    std::string h;
+    if (c.fd < 0 || !c.header(&h) || h.find(" 200 ") == std::string::npos) {
+      if (c.fd >= 0) close(c.fd);
+      fprintf(stderr, "shm_ringd: %s unavailable, retry in %d ms\n", source, backoff_ms);
+      usleep(backoff_ms * 1000);
+      backoff_ms = backoff_ms < 5000 ? backoff_ms * 2 : 5000;
+      continue;
+    }
+    backoff_ms = 500;
+
+    while (!stop && c.header(&h)) {                // part header: --frame, Content-Type, Content-Length
+      size_t len = contentLength(h);
+      if (len == (size_t)-1) continue;
+      bool fits = len + 2 <= ring.capacity();
+      if (!c.body(fits ? ring.begin() : NULL, len + 2)) break;   // + CRLF after the JPEG
+      if (!fits) {
+        oversize++;
+        continue;
+      }
+      ring.commit((uint32_t)len);
+      frames++;
+      bytes += len;
+      win_frames++;
+      win_bytes += len;
+      uint64_t now = shmRingNowNs();
+      if (now - win_t >= 5000000000ull) {
+        double s = (now - win_t) / 1e9;
+        printf("shm_ringd: fps=%.1f kB/s=%.0f frames=%llu oversize=%llu reconnects=%llu\n",
+               win_frames / s, win_bytes / 1024.0 / s, (unsigned long long)frames,
+               (unsigned long long)oversize, (unsigned long long)reconnects);
+        fflush(stdout);
+        win_t = now;
+        win_frames = win_bytes = 0;
+      }
+    }
+    close(c.fd);
+    if (!stop) {
+      reconnects++;
+      fprintf(stderr, "shm_ringd: stream dropped after frame %llu, reconnecting\n",
+              (unsigned long long)ring.head());
+    }
+  }
+  printf("shm_ringd: %llu frames, %.1f MB\n", (unsigned long long)frames, bytes / 1048576.0);
+  return 0;
+}
@@ -0,0 +1,602 @@
+/**
+ * NozzleCAM multi-camera analytics engine (host side).
+ *
+ * Ingests N MJPEG feeds and runs one analytics job per frame on a
+ * work-stealing thread pool: each worker has its own deque and serves it
+ * in order (a camera's next frame is queued behind the other cameras', so
+ * none of them starves), and a worker that runs dry steals from the far end
+ * of another's deque. A job decodes the JPEG to luma with libjpeg-turbo (SIMD IDCT and
+ * upsampling; chroma is never reconstructed for gray output) and measures
+ * mean brightness and motion against the camera's previous frame.
+ *
+ * Per camera at most one job is queued or running. A frame that arrives
+ * meanwhile waits in a one-frame mailbox, and a newer frame replaces it
+ * (latest frame wins): a camera the pool can't keep up with drops stale
+ * frames instead of building a backlog, and its results stay current.
+ *
+ * Sources are live /stream connections or simulated cameras that replay
+ * frames encoded with src/jpeg_enc.cpp (4:2:2, as the sensor sends them) at
+ * a fixed rate, so the engine can be measured without hardware. Simulated
+ * runs sweep the worker count (1, 2, 4 .. host threads) and report
+ * processed frames/s, frames/s per worker and per CPU-second, shed frames,
+ * steals and arrival-to-result latency.
+ *
+ * Build:  g++ -O2 -std=c++17 -pthread -I../../include stream_engine.cpp ../../src/jpeg_enc.cpp -ljpeg -o stream_engine
+ * Use:    ./stream_engine sim [cams=16] [fps=25] [size=vga] [seconds=5] [workers=0 (sweep)] [scale=1]
+ *         ./stream_engine live <seconds> <workers> <host>[/path] ...
+ *         (scale 1|2|4|8 decodes at 1/scale size via DCT scaling;
+ *          JSIMD_FORCENONE=1 in the environment turns libjpeg-turbo's SIMD off for comparison)
+ */
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jpeglib.h>
+
+#include "jpeg_enc.h"
+
+using clk = std::chrono::steady_clock;
+using Jpeg = std::shared_ptr<const std::vector<uint8_t>>;
+
+#define MOTION_DIFF  24               // luma step that counts a pixel as changed
+
+static double cpuSeconds() {
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// ---------- work-stealing pool ----------
+
+class StealPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit StealPool(int n) : q_(n) {
+    for (int i = 0; i < n; i++) q_[i].reset(new Queue);
+    for (int i = 0; i < n; i++) th_.emplace_back([this, i] { run(i); });
+  }
+
+  ~StealPool() {
+    {
+      std::lock_guard<std::mutex> l(sleep_m_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : th_) t.join();
+  }
+
+  // From a worker: onto its own deque. From outside: round robin.
+  void submit(Task t) {
+    int i = self_ >= 0 && pool_ == this ? self_ : (int)(rr_++ % q_.size());
+    {
+      std::lock_guard<std::mutex> l(q_[i]->m);
+      q_[i]->d.push_back(std::move(t));
+    }
+    queued_.fetch_add(1);
+    if (sleeping_.load()) {
+      std::lock_guard<std::mutex> l(sleep_m_);    // pairs with the check under sleep_m_ in run()
+      cv_.notify_one();
+    }
+  }
+
+  int size() const { return (int)q_.size(); }
+  uint64_t steals() const { return steals_.load(); }
+
+ private:
+  struct Queue {
+    std::mutex        m;
+    std::deque<Task>  d;
+  };
+
+  bool popLocal(int i, Task* t) {
+    std::lock_guard<std::mutex> l(q_[i]->m);
+    if (q_[i]->d.empty()) return false;
+    *t = std::move(q_[i]->d.front());
+    q_[i]->d.pop_front();
+    return true;
+  }
+
+  bool steal(int i, Task* t) {
+    int n = (int)q_.size();
+    for (int k = 1; k < n; k++) {
+      Queue& v = *q_[(i + k) % n];
+      std::lock_guard<std::mutex> l(v.m);
+      if (v.d.empty()) continue;
+      *t = std::move(v.d.back());
+      v.d.pop_back();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void run(int i) {
+    self_ = i;
+    pool_ = this;
+    Task t;
+    for (;;) {
+      if (popLocal(i, &t) || steal(i, &t)) {
+        queued_.fetch_sub(1);
+        t();
+        t = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> l(sleep_m_);
+      sleeping_.fetch_add(1);
+      cv_.wait(l, [this] { return stop_ || queued_.load() > 0; });
+      sleeping_.fetch_sub(1);
+      if (stop_ && queued_.load() == 0) return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> q_;
+  std::vector<std::thread>            th_;
+  std::mutex                          sleep_m_;
+  std::condition_variable             cv_;
+  std::atomic<int>                    queued_{0}, sleeping_{0};
+  std::atomic<uint64_t>               rr_{0}, steals_{0};
+  bool                                stop_ = false;
+  static thread_local int             self_;
+  static thread_local StealPool*      pool_;
+};
+
+thread_local int StealPool::self_ = -1;
+thread_local StealPool* StealPool::pool_ = nullptr;
+
+// ---------- decoding ----------
+
+struct DecodeError {
+  jpeg_error_mgr pub;
+  jmp_buf        jb;
+};
+
+static void onJpegError(j_common_ptr c) {
+  longjmp(((DecodeError*)c->err)->jb, 1);
+}
+
+// One decompressor per worker thread, reused across frames.
+struct Decoder {
+  jpeg_decompress_struct d;
+  DecodeError            err;
+
+  Decoder() {
+    d.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = onJpegError;
+    err.pub.emit_message = [](j_common_ptr, int) {};
+    jpeg_create_decompress(&d);
+  }
+  ~Decoder() { jpeg_destroy_decompress(&d); }
+
+  bool gray(const uint8_t* jpg, size_t len, int scale, std::vector<uint8_t>* y, int* w, int* h) {
+    if (setjmp(err.jb)) {
+      jpeg_abort_decompress(&d);
+      return false;
+    }
+    jpeg_mem_src(&d, jpg, len);
+    if (jpeg_read_header(&d, TRUE) != JPEG_HEADER_OK) return false;
+    d.out_color_space = JCS_GRAYSCALE;
+    d.scale_num = 1;
+    d.scale_denom = scale;
+    d.dct_method = JDCT_ISLOW;                      // the SIMD path in libjpeg-turbo
+    jpeg_start_decompress(&d);
+    *w = d.output_width;
+    *h = d.output_height;
+    y->resize((size_t)*w * *h);
+    while (d.output_scanline < d.output_height) {
+      JSAMPROW row = &(*y)[(size_t)d.output_scanline * *w];
+      jpeg_read_scanlines(&d, &row, 1);
+    }
+    jpeg_finish_decompress(&d);
+    return true;
+  }
+};
+
+// ---------- cameras ----------
+
+struct Frame {
+  Jpeg              jpg;
+  clk::time_point   arrived;
+};
+
+struct Camera {
+  int         id;
+  std::string name;
+
+  std::mutex  m;
+  bool        busy = false;                         // a job is queued or running
+  bool        waiting = false;                      // mailbox holds a frame
+  Frame       mailbox;
+
+  // touched only by the camera's one job in flight
+  std::vector<uint8_t> prev;
+  float       mean = 0, motion = 0;
+
+  std::atomic<uint64_t> arrived{0}, processed{0}, shed{0}, errors{0};
+};
+
+struct WorkerStats {
+  std::vector<float> latency_ms;
+  uint64_t           jobs = 0;
+  double             decode_ms = 0;
+};
+
+class Engine {
+ public:
+  Engine(int workers, int scale, int cams) : scale_(scale), stats_(workers), pool_(workers) {
+    for (int i = 0; i < cams; i++) {
+      cam_.emplace_back(new Camera);
+      cam_.back()->id = i;
+    }
+  }
+
+  Camera& camera(int i) { return *cam_[i]; }
+  int cameras() const { return (int)cam_.size(); }
+  int workers() const { return pool_.size(); }
+  uint64_t steals() const { return pool_.steals(); }
+  const std::vector<WorkerStats>& workerStats() const { return stats_; }
+
+  // Waits until no camera has a job queued or running (sources stopped).
+  void drain() {
+    for (auto& c : cam_)
+      for (;;) {
+        {
+          std::lock_guard<std::mutex> l(c->m);
+          if (!c->busy) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+  }
+
+  // A new frame from camera c (any thread).
+  void offer(int c, Jpeg jpg) {
+    Camera& cam = *cam_[c];
+    cam.arrived.fetch_add(1, std::memory_order_relaxed);
+    Frame f{ std::move(jpg), clk::now() };
+    std::lock_guard<std::mutex> l(cam.m);
+    if (!cam.busy) {
+      cam.busy = true;
+      pool_.submit([this, &cam, f] { job(cam, f); });
+      return;
+    }
+    if (cam.waiting) cam.shed.fetch_add(1, std::memory_order_relaxed);   // latest frame wins
+    cam.mailbox = std::move(f);
+    cam.waiting = true;
+  }
+
+ private:
+  void job(Camera& cam, const Frame& f) {
+    thread_local Decoder dec;
+    thread_local std::vector<uint8_t> y;
+    thread_local int worker = -1;
+    if (worker < 0) worker = next_worker_.fetch_add(1);
+    WorkerStats& ws = stats_[worker];
+
+    auto t0 = clk::now();
+    int w = 0, h = 0;
+    if (dec.gray(f.jpg->data(), f.jpg->size(), scale_, &y, &w, &h)) {
+      ws.decode_ms += std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+      analyse(cam, y.data(), (size_t)w * h);
+      cam.processed.fetch_add(1, std::memory_order_relaxed);
+      ws.latency_ms.push_back(std::chrono::duration<float, std::milli>(clk::now() - f.arrived).count());
+    } else {
+      cam.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    ws.jobs++;
+
+    std::unique_lock<std::mutex> l(cam.m);
+    if (!cam.waiting) {
+      cam.busy = false;
+      return;
+    }
+    Frame next = std::move(cam.mailbox);
+    cam.waiting = false;
+    l.unlock();
+    pool_.submit([this, &cam, next] { job(cam, next); });   // own deque, behind the other cameras
+  }
+
+  static void analyse(Camera& cam, const uint8_t* y, size_t n) {
+    uint64_t sum = 0;
+    size_t changed = 0;
+    bool have_prev = cam.prev.size() == n;
+    const uint8_t* p = cam.prev.data();
+    for (size_t i = 0; i < n; i++) {
+      sum += y[i];
+      if (have_prev) changed += (unsigned)abs((int)y[i] - (int)p[i]) > MOTION_DIFF;
+    }
+    cam.mean = (float)sum / n;
+    cam.motion = have_prev ? (float)changed / n : 0;
+    cam.prev.assign(y, y + n);
+  }
+
+  int                                  scale_;
+  std::vector<WorkerStats>             stats_;
+  std::vector<std::unique_ptr<Camera>> cam_;
+  std::atomic<int>                     next_worker_{0};
+  StealPool                            pool_;             // last: joins before the rest goes away
+};
+
+// ---------- simulated sources ----------
+
+// Moving bright blob (a lit nozzle) over texture and noise, 4:2:2 JPEG via jpeg_enc.
+static std::vector<Jpeg> simFrames(int w, int h, int count) {
+  jpeg_enc_t e;
+  jpegEncInit(&e, w, h, JPEG_ENC_YUV422, 80);
+  std::vector<uint8_t> src((size_t)w * h * 2), out((size_t)w * h * 2 + 4096);
+  std::vector<Jpeg> frames;
+  srand(11);
+  for (int f = 0; f < count; f++) {
+    double cx = w * (0.3 + 0.4 * f / count), cy = h * (0.5 + 0.1 * sin(f * 0.4));
+    for (int yy = 0; yy < h; yy++)
+      for (int x = 0; x < w; x++) {
+        double d2 = ((x - cx) * (x - cx) + (yy - cy) * (yy - cy)) / (w * w * 0.002);
+        int v = (int)(70 + 40 * sin(x * 0.07) * cos(yy * 0.05) + 150 * exp(-d2) + rand() % 10);
+        uint8_t* p = &src[((size_t)yy * w + x) * 2];
+        p[0] = v < 0 ? 0 : v > 255 ? 255 : v;
+        p[1] = (uint8_t)(128 + ((x >> 4) & 7));
+      }
+    size_t n = jpegEncHeader(&e, out.data(), out.size());
+    long r = jpegEncRows(&e, src.data(), 0, e.mcus_y, out.data() + n, out.size() - n - 2);
+    if (r < 0) break;
+    n += r;
+    out[n++] = 0xFF;
+    out[n++] = 0xD9;
+    frames.push_back(std::make_shared<const std::vector<uint8_t>>(out.begin(), out.begin() + n));
+  }
+  return frames;
+}
+
+// One thread drives all simulated cameras, arrivals spread over the frame period.
+static void simRun(Engine& eng, const std::vector<Jpeg>& frames, double fps, double secs) {
+  int n = eng.cameras();
+  auto period = std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(1.0 / fps));
+  auto t0 = clk::now(), t_end = t0 + std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(secs));
+  std::vector<clk::time_point> due(n);
+  std::vector<size_t> idx(n);
+  for (int c = 0; c < n; c++) {
+    due[c] = t0 + period * c / n;
+    idx[c] = (size_t)c * 7 % frames.size();          // cameras out of step with each other
+  }
+  for (;;) {
+    int c = (int)(std::min_element(due.begin(), due.end()) - due.begin());
+    if (due[c] >= t_end) break;
+    std::this_thread::sleep_until(due[c]);
+    eng.offer(c, frames[idx[c]]);
+    idx[c] = (idx[c] + 1) % frames.size();
+    due[c] += period;
+  }
+}
+
+// ---------- live sources ----------
+
+static int openStream(const std::string& host, const std::string& path) {
+  addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), "80", &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, 0);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return -1;
+  timeval tv = { 1, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\n\r\n";
+  if (send(fd, req.data(), req.size(), 0) != (ssize_t)req.size()) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Multipart parts (headers + Content-Length body) until stop.
+static void liveRun(Engine& eng, int c, std::string url, const std::atomic<bool>& stop) {
+  size_t slash = url.find('/');
+  std::string host = url.substr(0, slash), path = slash == std::string::npos ? "/stream" : url.substr(slash);
+  eng.camera(c).name = url;
+  while (!stop) {
+    int fd = openStream(host, path);
+    if (fd < 0) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      continue;
+    }
+    std::string buf;
+    bool head = true;
+    char chunk[16384];
+    while (!stop) {
+      ssize_t r = recv(fd, chunk, sizeof(chunk), 0);
+      if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) break;
+      if (r > 0) buf.append(chunk, r);
+      for (;;) {
+        size_t eoh = buf.find("\r\n\r\n");
+        if (eoh == std::string::npos) break;
+        size_t cl = buf.find("Content-Length:");
+        if (head || cl == std::string::npos || cl > eoh) {
+          head = false;
+          buf.erase(0, eoh + 4);
+          continue;
+        }
+        size_t len = strtoul(buf.c_str() + cl + 15, NULL, 10);
+        if (buf.size() < eoh + 4 + len) break;
+        eng.offer(c, std::make_shared<const std::vector<uint8_t>>(buf.begin() + eoh + 4, buf.begin() + eoh + 4 + len));
+        buf.erase(0, eoh + 4 + len);
+      }
+    }
+    close(fd);
+  }
+}
+
+// ---------- report ----------
+
+struct RunResult {
+  uint64_t arrived = 0, processed = 0, shed = 0, errors = 0;
+  double   secs = 0, cpu_s = 0, decode_ms = 0;
+  float    p50 = 0, p99 = 0;
+};
+
+static RunResult collect(Engine& eng, double secs, double cpu_s) {
+  RunResult r;
+  r.secs = secs;
+  r.cpu_s = cpu_s;
+  for (int c = 0; c < eng.cameras(); c++) {
+    Camera& cam = eng.camera(c);
+    r.arrived += cam.arrived;
+    r.processed += cam.processed;
+    r.shed += cam.shed;
+    r.errors += cam.errors;
+  }
+  std::vector<float> lat;
+  for (auto& w : eng.workerStats()) {
+    lat.insert(lat.end(), w.latency_ms.begin(), w.latency_ms.end());
+    r.decode_ms += w.decode_ms;
+  }
+  if (!lat.empty()) {
+    std::sort(lat.begin(), lat.end());
+    r.p50 = lat[lat.size() / 2];
+    r.p99 = lat[lat.size() * 99 / 100];
+  }
+  return r;
+}
+
+static void printHeader() {
+  printf("%7s %9s %9s %8s %9s %10s %8s %8s %8s %8s %8s\n", "workers", "offered", "fps", "shed_%",
+         "fps/wkr", "fps/cpu_s", "dec_ms", "steals", "p50_ms", "p99_ms", "errors");
+}
+
+static void printRow(int workers, const RunResult& r, uint64_t steals) {
+  double fps = r.processed / r.secs;
+  printf("%7d %9.0f %9.1f %8.1f %9.1f %10.1f %8.2f %8llu %8.1f %8.1f %8llu\n", workers, r.arrived / r.secs,
+         fps, r.arrived ? 100.0 * r.shed / r.arrived : 0, fps / workers,
+         r.cpu_s > 0 ? r.processed / r.cpu_s : 0, r.processed ? r.decode_ms / r.processed : 0,
+         (unsigned long long)steals, r.p50, r.p99, (unsigned long long)r.errors);
+  fflush(stdout);
+}
+
+static bool parseSize(const char* s, int* w, int* h) {
+  struct { const char* name; int w, h; } sizes[] = {
+    { "qvga", 320, 240 }, { "vga", 640, 480 }, { "svga", 800, 600 }, { "xga", 1024, 768 },
+    { "hd", 1280, 720 }, { "sxga", 1280, 1024 }, { "uxga", 1600, 1200 },
+  };
+  for (auto& z : sizes)
+    if (!strcmp(s, z.name)) {
+      *w = z.w;
+      *h = z.h;
+      return true;
+    }
+  return false;
+}
+
+static const char* decoderName() {
+#ifdef LIBJPEG_TURBO_VERSION
+  return getenv("JSIMD_FORCENONE") ? "libjpeg-turbo (SIMD off)" : "libjpeg-turbo (SIMD)";
+#else
+  return "libjpeg (no SIMD)";
+#endif
+}
+
+static int simMain(int argc, char** argv) {
+  int cams = argc > 2 ? atoi(argv[2]) : 16;
+  double fps = argc > 3 ? atof(argv[3]) : 25;
+  const char* size = argc > 4 ? argv[4] : "vga";
+  double secs = argc > 5 ? atof(argv[5]) : 5;
+  int workers = argc > 6 ? atoi(argv[6]) : 0;
+  int scale = argc > 7 ? atoi(argv[7]) : 1;
+  int w, h;
+  if (cams < 1 || fps <= 0 || secs <= 0 || !parseSize(size, &w, &h) ||
+      (scale != 1 && scale != 2 && scale != 4 && scale != 8)) {
+    fprintf(stderr, "bad arguments (size: qvga|vga|svga|xga|hd|sxga|uxga, scale: 1|2|4|8)\n");
+    return 2;
+  }
+
+  std::vector<Jpeg> frames = simFrames(w, h, 32);
+  size_t bytes = 0;
+  for (auto& f : frames) bytes += f->size();
+  int hw = (int)std::thread::hardware_concurrency();
+  std::vector<int> counts;
+  if (workers > 0) {
+    counts.push_back(workers);
+  } else {
+    for (int k = 1; k < hw; k *= 2) counts.push_back(k);
+    counts.push_back(hw > 0 ? hw : 1);
+  }
+  printf("sim: %d cameras x %.0f fps, %s %dx%d (avg %zu B/frame), scale 1/%d, %.0f s per run\n", cams, fps,
+         size, w, h, bytes / frames.size(), scale, secs);
+  printf("decoder: %s, host threads: %d\n", decoderName(), hw);
+  printHeader();
+  bool ok = true;
+  for (int k : counts) {
+    Engine eng(k, scale, cams);
+    double cpu0 = cpuSeconds();
+    auto t0 = clk::now();
+    simRun(eng, frames, fps, secs);
+    eng.drain();
+    double s = std::chrono::duration<double>(clk::now() - t0).count();
+    RunResult r = collect(eng, s, cpuSeconds() - cpu0);
+    printRow(k, r, eng.steals());
+    ok &= r.errors == 0 && r.processed > 0;
+  }
+  return ok ? 0 : 1;
+}
+
+static int liveMain(int argc, char** argv) {
+  if (argc < 5) {
+    fprintf(stderr, "usage: %s live <seconds> <workers> <host>[/path] ...\n", argv[0]);
+    return 2;
+  }
+  double secs = atof(argv[2]);
+  int workers = atoi(argv[3]);
+  if (workers < 1) workers = (int)std::thread::hardware_concurrency();
+  int cams = argc - 4;
+  Engine eng(workers, 1, cams);
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> src;
+  double cpu0 = cpuSeconds();
+  auto t0 = clk::now();
+  for (int c = 0; c < cams; c++) src.emplace_back(liveRun, std::ref(eng), c, std::string(argv[4 + c]), std::cref(stop));
+  std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : src) t.join();
+  eng.drain();
+  double s = std::chrono::duration<double>(clk::now() - t0).count();
+
+  printf("live: %d cameras, %.0f s, decoder: %s\n", cams, secs, decoderName());
+  printf("%-28s %8s %8s %8s %8s %8s %7s\n", "camera", "arrived", "fps", "shed", "errors", "mean_y", "motion");
+  for (int c = 0; c < cams; c++) {
+    Camera& cam = eng.camera(c);
+    printf("%-28s %8llu %8.1f %8llu %8llu %8.1f %6.1f%%\n", cam.name.c_str(), (unsigned long long)cam.arrived.load(),
+           cam.processed / s, (unsigned long long)cam.shed.load(), (unsigned long long)cam.errors.load(),
+           cam.mean, 100 * cam.motion);
+  }
+  printHeader();
+  printRow(workers, collect(eng, s, cpuSeconds() - cpu0), eng.steals());
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && !strcmp(argv[1], "sim")) return simMain(argc, argv);
+  if (argc > 1 && !strcmp(argv[1], "live")) return liveMain(argc, argv);
+  fprintf(stderr,
+          "usage: %s sim [cams=16] [fps=25] [size=vga] [seconds=5] [workers=0 (sweep)] [scale=1]\n"
+          "       %s live <seconds> <workers> <host>[/path] ...\n", argv[0], argv[0]);
+  return 2;
+}
@@ -0,0 +1,310 @@
+/**
+ * NozzleCAM tip locator benchmark (host side).
+ *
+ * Synthetic: a nozzle silhouette (a cone ending in a rounded tip, dark on a
+ * bright bed) is rendered 8x8 supersampled with its tip at known sub-pixel
+ * positions, plus Gaussian sensor noise, and located with
+ * src/tip_locate.cpp. Reports bias and rms/max error per noise level in ROI
+ * pixels (the firmware decodes at 1/scale, so full-frame error is scale
+ * times that), and the locate time per ROI size.
+ *
+ * End to end: the same nozzle in a full frame per framesize, JPEG-encoded
+ * (libjpeg, 4:2:2 like the sensor), then what tipStage does per frame:
+ * src/jpeg_roi.cpp decodes the default ROI at 1/scale and the locator runs
+ * on it. The decoded ROI is checked against libjpeg's own scaled decode.
+ *
+ * Recorded: JPEG frames of a nozzle that doesn't move (e.g. saved from
+ * /capture) are decoded and located the same way; with no ground truth the
+ * frame-to-frame spread of the result is the error that matters.
+ *
+ * Build:  g++ -O2 -I../../include tip_bench.cpp ../../src/tip_locate.cpp ../../src/jpeg_roi.cpp ../../src/jpeg_scan.cpp -ljpeg -o tip_bench
+ * Use:    ./tip_bench [scale=4] [frame.jpg ...]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+
+#include "jpeg_roi.h"
+#include "jpeg_scan.h"
+#include "tip_locate.h"
+
+using clk = std::chrono::steady_clock;
+
+static const int ROI_X0 = 250, ROI_Y0 = 0, ROI_X1 = 750, ROI_Y1 = 600;   // tip.cpp defaults
+static const uint8_t MIN_STRENGTH = 24;
+
+// Nozzle with its lowest point at (tx, ty): a cone opening upwards with a
+// round end of radius r. Pixel i covers [i - 0.5, i + 0.5).
+static bool inNozzle(double x, double y, double tx, double ty, double r) {
+  double cy = ty - r;
+  if (y >= cy) return (x - tx) * (x - tx) + (y - cy) * (y - cy) < r * r;
+  return fabs(x - tx) < r + (cy - y) * 0.6;
+}
+
+static void render(std::vector<uint8_t>& img, int w, int h, double tx, double ty,
+                   float sigma, std::mt19937& rng) {
+  std::normal_distribution<float> noise(0.0f, sigma > 0 ? sigma : 1.0f);
+  const int ss = 8;
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      int inside = 0;
+      for (int sy = 0; sy < ss; sy++)
+        for (int sx = 0; sx < ss; sx++)
+          inside += inNozzle(x - 0.5 + (sx + 0.5) / ss, y - 0.5 + (sy + 0.5) / ss, tx, ty, 6.0);
+      float v = 200.0f - 170.0f * inside / (ss * ss) + (sigma > 0 ? noise(rng) : 0.0f);
+      img[(size_t)y * w + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : lrintf(v));
+    }
+}
+
+static void synthetic() {
+  const int w = 96, h = 72;
+  std::vector<uint8_t> img((size_t)w * h), mag((size_t)w * h);
+  std::mt19937 rng(1);
+  printf("synthetic %dx%d ROI, tip on an 8x8 sub-pixel grid, errors in ROI pixels\n", w, h);
+  for (float sigma : { 0.0f, 2.0f, 4.0f, 8.0f }) {
+    double sx = 0, sy = 0, sxx = 0, syy = 0, mx = 0, my = 0;
+    int n = 0, missed = 0;
+    for (int j = 0; j < 8; j++)
+      for (int i = 0; i < 8; i++) {
+        double tx = w / 2 + i / 8.0, ty = h * 2 / 3 + j / 8.0;
+        render(img, w, h, tx, ty, sigma, rng);
+        int32_t xq, yq;
+        uint16_t strength;
+        if (!tipLocate(img.data(), w, h, w, MIN_STRENGTH, mag.data(), &xq, &yq, &strength)) {
+          missed++;
+          continue;
+        }
+        double ex = xq / 256.0 - tx, ey = yq / 256.0 - ty;
+        sx += ex; sy += ey; sxx += ex * ex; syy += ey * ey;
+        mx = fmax(mx, fabs(ex)); my = fmax(my, fabs(ey));
+        n++;
+      }
+    if (!n) { printf("  noise %4.1f  not found\n", sigma); continue; }
+    printf("  noise %4.1f  x bias %+.3f rms %.3f max %.3f  y bias %+.3f rms %.3f max %.3f  missed %d\n",
+           sigma, sx / n, sqrt(sxx / n), mx, sy / n, sqrt(syy / n), my, missed);
+  }
+
+  printf("locate time per ROI\n");
+  for (auto sz : { std::make_pair(100, 75), std::make_pair(200, 150), std::make_pair(400, 300),
+                   std::make_pair(512, 384) }) {
+    int rw = sz.first, rh = sz.second;
+    std::vector<uint8_t> roi((size_t)rw * rh), m((size_t)rw * rh);
+    render(roi, rw, rh, rw / 2 + 0.3, rh * 2 / 3 + 0.6, 4.0f, rng);
+    int reps = (int)(2000000 / ((size_t)rw * rh)) + 5;
+    int32_t xq, yq;
+    uint16_t strength;
+    auto t0 = clk::now();
+    for (int k = 0; k < reps; k++)
+      tipLocate(roi.data(), rw, rh, rw, MIN_STRENGTH, m.data(), &xq, &yq, &strength);
+    double us = std::chrono::duration<double, std::micro>(clk::now() - t0).count() / reps;
+    printf("  %3dx%-3d  %7.1f us  (%.2f ns/px)\n", rw, rh, us, us * 1000 / ((size_t)rw * rh));
+  }
+}
+
+// Full frame with the nozzle tip in the default ROI, 2x2 supersampled.
+static void renderFrame(std::vector<uint8_t>& img, int w, int h, std::mt19937& rng) {
+  std::normal_distribution<float> noise(0.0f, 3.0f);
+  double tx = w * 0.503, ty = h * 0.37, r = w / 60.0;
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      int inside = 0;
+      for (int sy = 0; sy < 2; sy++)
+        for (int sx = 0; sx < 2; sx++)
+          inside += inNozzle(x - 0.25 + sx * 0.5, y - 0.25 + sy * 0.5, tx, ty, r);
+      float v = 200.0f - 170.0f * inside / 4 + noise(rng);
+      img[(size_t)y * w + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : lrintf(v));
+    }
+}
+
+// Gray -> YCbCr 4:2:2 JPEG, the sensor's layout.
+static std::string encode(const std::vector<uint8_t>& img, int w, int h, int quality) {
+  jpeg_compress_struct c;
+  jpeg_error_mgr err;
+  c.err = jpeg_std_error(&err);
+  jpeg_create_compress(&c);
+  unsigned char* out = NULL;
+  unsigned long len = 0;
+  jpeg_mem_dest(&c, &out, &len);
+  c.image_width = w;
+  c.image_height = h;
+  c.input_components = 3;
+  c.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&c);
+  jpeg_set_quality(&c, quality, TRUE);
+  c.comp_info[0].h_samp_factor = 2;
+  c.comp_info[0].v_samp_factor = 1;
+  jpeg_start_compress(&c, TRUE);
+  std::vector<uint8_t> row((size_t)w * 3);
+  while (c.next_scanline < c.image_height) {
+    const uint8_t* g = img.data() + (size_t)c.next_scanline * w;
+    for (int x = 0; x < w; x++) row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = g[x];
+    JSAMPROW r = row.data();
+    jpeg_write_scanlines(&c, &r, 1);
+  }
+  jpeg_finish_compress(&c);
+  jpeg_destroy_compress(&c);
+  std::string jpg((const char*)out, len);
+  free(out);
+  return jpg;
+}
+
+static bool readFile(const char* path, std::string* data) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[65536];
+  size_t n;
+  data->clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data->append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// Whole frame at 1/scale to gray with libjpeg: the reference for jpeg_roi.
+static bool decodeGray(const std::string& jpg, int scale, std::vector<uint8_t>* gray, int* w, int* h) {
+  jpeg_decompress_struct d;
+  jpeg_error_mgr err;
+  d.err = jpeg_std_error(&err);
+  jpeg_create_decompress(&d);
+  jpeg_mem_src(&d, (const unsigned char*)jpg.data(), jpg.size());
+  if (jpeg_read_header(&d, TRUE) != JPEG_HEADER_OK) {
+    jpeg_destroy_decompress(&d);
+    return false;
+  }
+  d.out_color_space = JCS_GRAYSCALE;
+  d.scale_num = 1;
+  d.scale_denom = scale;
+  jpeg_start_decompress(&d);
+  *w = d.output_width;
+  *h = d.output_height;
+  gray->resize((size_t)*w * *h);
+  while (d.output_scanline < d.output_height) {
+    JSAMPROW row = gray->data() + (size_t)d.output_scanline * *w;
+    jpeg_read_scanlines(&d, &row, 1);
+  }
+  jpeg_finish_decompress(&d);
+  jpeg_destroy_decompress(&d);
+  return true;
+}
+
+// The default ROI of a 1/scale frame, as tipStage cuts it.
+static void roiOf(int fw, int fh, int* rx0, int* ry0, int* rw, int* rh) {
+  *rx0 = fw * ROI_X0 / 1000;
+  *ry0 = fh * ROI_Y0 / 1000;
+  *rw = fw * ROI_X1 / 1000 - *rx0;
+  *rh = fh * ROI_Y1 / 1000 - *ry0;
+  if (*rw > TIP_MAX_W) *rw = TIP_MAX_W;
+}
+
+static void endToEnd(int scale) {
+  static const struct { const char* name; int w, h; } sizes[] = {
+    { "qvga", 320, 240 }, { "vga", 640, 480 }, { "svga", 800, 600 },
+    { "xga", 1024, 768 }, { "sxga", 1280, 1024 }, { "uxga", 1600, 1200 },
+  };
+  std::mt19937 rng(2);
+  printf("end to end, scale 1/%d, default ROI, q85 4:2:2: ROI decode + locate per frame\n", scale);
+  for (const auto& sz : sizes) {
+    std::vector<uint8_t> img((size_t)sz.w * sz.h);
+    renderFrame(img, sz.w, sz.h, rng);
+    std::string jpg = encode(img, sz.w, sz.h, 85);
+    int fw = (sz.w + scale - 1) / scale, fh = (sz.h + scale - 1) / scale;
+    int rx0, ry0, rw, rh;
+    roiOf(fw, fh, &rx0, &ry0, &rw, &rh);
+    std::vector<uint8_t> roi((size_t)rw * rh), mag((size_t)rw * rh), ref;
+    int rfw, rfh, diff = 0;
+    if (decodeGray(jpg, scale, &ref, &rfw, &rfh) &&
+        jpegDecodeGray((const uint8_t*)jpg.data(), jpg.size(), scale, rx0, ry0, rw, rh,
+                       roi.data()) == JPEG_SCAN_OK) {
+      for (int y = 0; y < rh; y++)
+        for (int x = 0; x < rw; x++)
+          diff = std::max(diff, abs(roi[(size_t)y * rw + x] - ref[(size_t)(ry0 + y) * rfw + rx0 + x]));
+    } else {
+      printf("  %-5s decode failed\n", sz.name);
+      continue;
+    }
+
+    int reps = (int)(20000000 / ((size_t)sz.w * sz.h)) + 3;
+    double dec_us = 0, loc_us = 0;
+    int32_t xq = 0, yq = 0;
+    uint16_t strength = 0;
+    bool found = false;
+    for (int k = 0; k < reps; k++) {
+      auto t0 = clk::now();
+      jpegDecodeGray((const uint8_t*)jpg.data(), jpg.size(), scale, rx0, ry0, rw, rh, roi.data());
+      auto t1 = clk::now();
+      found = tipLocate(roi.data(), rw, rh, rw, MIN_STRENGTH, mag.data(), &xq, &yq, &strength);
+      auto t2 = clk::now();
+      dec_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+      loc_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+    }
+    printf("  %-5s %4dx%-4d %6zu B  ROI %3dx%-3d  decode %7.1f us  locate %6.1f us  total %7.1f us"
+           "  max |diff| vs libjpeg %d  %s\n",
+           sz.name, sz.w, sz.h, jpg.size(), rw, rh, dec_us / reps, loc_us / reps,
+           (dec_us + loc_us) / reps, diff, found ? "found" : "NOT FOUND");
+  }
+}
+
+static void recorded(int scale, int count, char** paths) {
+  printf("recorded, scale 1/%d, ROI %d,%d,%d,%d permille\n", scale, ROI_X0, ROI_Y0, ROI_X1, ROI_Y1);
+  std::vector<double> xs, ys;
+  double dec_us = 0, loc_us = 0;
+  for (int i = 0; i < count; i++) {
+    std::string jpg;
+    jpeg_info_t info;
+    if (!readFile(paths[i], &jpg) ||
+        jpegScanHeaders((const uint8_t*)jpg.data(), jpg.size(), &info) != JPEG_SCAN_OK) {
+      printf("  %s: unreadable\n", paths[i]);
+      continue;
+    }
+    int fw = (info.width + scale - 1) / scale, fh = (info.height + scale - 1) / scale;
+    int rx0, ry0, rw, rh;
+    roiOf(fw, fh, &rx0, &ry0, &rw, &rh);
+    std::vector<uint8_t> gray((size_t)rw * rh), mag((size_t)rw * rh);
+    auto t0 = clk::now();
+    if (jpegDecodeGray((const uint8_t*)jpg.data(), jpg.size(), scale, rx0, ry0, rw, rh,
+                       gray.data()) != JPEG_SCAN_OK) {
+      printf("  %s: undecodable\n", paths[i]);
+      continue;
+    }
+    dec_us += std::chrono::duration<double, std::micro>(clk::now() - t0).count();
+    int32_t xq, yq;
+    uint16_t strength;
+    t0 = clk::now();
+    bool found = tipLocate(gray.data(), rw, rh, rw, MIN_STRENGTH, mag.data(), &xq, &yq, &strength);
+    loc_us += std::chrono::duration<double, std::micro>(clk::now() - t0).count();
+    if (!found) {
+      printf("  %s: no tip\n", paths[i]);
+      continue;
+    }
+    // same mapping as tipStage: ROI pixels -> full-frame pixel centres
+    double x = (((rx0 << 8) + xq) * scale + (scale - 1) * 128) / 256.0;
+    double y = (((ry0 << 8) + yq) * scale + (scale - 1) * 128) / 256.0;
+    printf("  %s: x %.2f y %.2f strength %u\n", paths[i], x, y, strength);
+    xs.push_back(x);
+    ys.push_back(y);
+  }
+  if (xs.empty()) return;
+  size_t n = xs.size();
+  double mx = 0, my = 0, vx = 0, vy = 0;
+  for (size_t i = 0; i < n; i++) { mx += xs[i]; my += ys[i]; }
+  mx /= n; my /= n;
+  for (size_t i = 0; i < n; i++) { vx += (xs[i] - mx) * (xs[i] - mx); vy += (ys[i] - my) * (ys[i] - my); }
+  printf("  %zu/%d located  mean %.2f,%.2f  spread (sd) x %.3f y %.3f full-frame px\n",
+         n, count, mx, my, sqrt(vx / n), sqrt(vy / n));
+  printf("  ROI decode %.0f us/frame, locate %.1f us/ROI\n", dec_us / count, loc_us / count);
+}
+
+int main(int argc, char** argv) {
+  int scale = argc > 1 ? atoi(argv[1]) : 4;
+  if (scale != 1 && scale != 2 && scale != 4 && scale != 8) scale = 4;
+  synthetic();
+  endToEnd(scale);
+  if (argc > 2) recorded(scale, argc - 2, argv + 2);
+  return 0;
+}